@@ -0,0 +1,106 @@
+#!/usr/bin/env bash
+
+# Builds the simulator libraries once per PD_UTILS_OPTIMIZATION value, with and without PD_UTILS_LTO,
+# and prints, as Markdown, the code size of each library and of the linked bench_all,
+# and the speed of bench_inline_library / bench_inline_header.
+#
+# Usage: bench/compare_variants.sh [runs]
+#   runs: how many times each benchmark is run; the fastest run is kept (default 7).
+
+set -e
+
+SCRIPT_DIR=$( cd -- "$( dirname -- "${BASH_SOURCE[0]}" )" &> /dev/null && pwd )
+ROOT_DIR="${SCRIPT_DIR:?}/.."
+
+RUNS=${1:-7}
+VARIANTS=("" "O3" "Os")
+LTO_MODES=(OFF ON)
+LIBRARIES=(pd_shorthand pd_text pd_scene_engine)
+BENCHMARKS=("malloc+free" "realloc")
+
+BUILD_ROOT=$(mktemp -d)
+trap '/bin/rm -rf "${BUILD_ROOT:?}"' EXIT
+
+function variant_label()
+{
+  if [ -z "$1" ]; then
+    echo "(empty, \`-O2\`)"
+  else
+    echo "\`$1\`"
+  fi
+}
+
+# Fastest ns/op of benchmark $2 over $RUNS runs of executable $1 (the table goes to stderr).
+function best_ns_per_op()
+{
+  local best=""
+  for ((i = 0; i < RUNS; i++)); do
+    local value
+    value=$("$1" 2>&1 >/dev/null | awk -v name="$2" '{ split($1, parts, "/") } parts[2] == name { print $(NF - 1) }')
+    if [ -z "$best" ] || awk -v a="$value" -v b="$best" 'BEGIN { exit !(a < b) }'; then
+      best=$value
+    fi
+  done
+  echo "$best"
+}
+
+declare -A SIZES
+declare -A SPEEDS
+for variant in "${VARIANTS[@]}"; do
+  for lto in "${LTO_MODES[@]}"; do
+    dir="$BUILD_ROOT/variant_${variant:-O2}_lto_$lto"
+    echo "-- Building the ${variant:-O2} variant, LTO $lto --" >&2
+    cmake -S "$ROOT_DIR" -B "$dir" -DCMAKE_BUILD_TYPE=Release -DPD_UTILS_OPTIMIZATION="$variant" \
+      -DPD_UTILS_LTO="$lto" > /dev/null
+    cmake --build "$dir" -j "$(nproc 2> /dev/null || echo 4)" \
+      --target pd_shorthand_Sim pd_text_Sim pd_scene_engine_Sim bench_all bench_inline_library bench_inline_header \
+      > /dev/null
+    # With fat LTO objects, the archives hold the same regular code either way; the gain shows once linked.
+    for library in "${LIBRARIES[@]}"; do
+      SIZES[$variant,$lto,$library]=$(size -t "$dir/$library/lib${library}_Sim.a" | awk 'END { print $1 }')
+    done
+    SIZES[$variant,$lto,bench_all]=$(size "$dir/bench/bench_all" | awk 'END { print $1 }')
+    for benchmark in "${BENCHMARKS[@]}"; do
+      SPEEDS[$variant,$lto,$benchmark,library]=$(best_ns_per_op "$dir/bench/bench_inline_library" "$benchmark")
+      SPEEDS[$variant,$lto,$benchmark,inline]=$(best_ns_per_op "$dir/bench/bench_inline_header" "$benchmark")
+    done
+  done
+done
+
+commit=$(git -C "$ROOT_DIR" rev-parse --short HEAD 2> /dev/null || echo "unknown")
+if [ -n "$(git -C "$ROOT_DIR" status --porcelain -- '*.c' '*.h' '*CMakeLists.txt' '*.cmake' 2> /dev/null)" ]; then
+  commit="$commit (with local changes)"
+fi
+echo "Measured at commit $commit with $(${CC:-cc} --version | head -n 1) on $(uname -sm)"
+echo "(simulator libraries, \`size -t\` of the archives and \`size\` of the linked \`bench_all\`, best of $RUNS runs)."
+echo
+
+header="| \`PD_UTILS_OPTIMIZATION\` | \`PD_UTILS_LTO\` |"
+rule="|-------------------------|----------------|"
+for library in "${LIBRARIES[@]}" bench_all; do
+  header="$header \`$library\` text |"
+  rule="$rule$(printf -- '-%.0s' $(seq 1 $((${#library} + 9))))|"
+done
+echo "$header"
+echo "$rule"
+for variant in "${VARIANTS[@]}"; do
+  for lto in "${LTO_MODES[@]}"; do
+    row="| $(variant_label "$variant") | $lto |"
+    for library in "${LIBRARIES[@]}" bench_all; do
+      row="$row ${SIZES[$variant,$lto,$library]} B |"
+    done
+    echo "$row"
+  done
+done
+echo
+
+echo "| \`PD_UTILS_OPTIMIZATION\` | \`PD_UTILS_LTO\` | Benchmark | library | inline |"
+echo "|-------------------------|----------------|-----------|---------|--------|"
+for variant in "${VARIANTS[@]}"; do
+  for lto in "${LTO_MODES[@]}"; do
+    for benchmark in "${BENCHMARKS[@]}"; do
+      echo "| $(variant_label "$variant") | $lto | \`$benchmark\` | ${SPEEDS[$variant,$lto,$benchmark,library]} ns/op" \
+        "| ${SPEEDS[$variant,$lto,$benchmark,inline]} ns/op |"
+    done
+  done
+done
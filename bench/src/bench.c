@@ -0,0 +1,101 @@
+#include "bench.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <pd_shorthand.h>
+
+#define MAX_RESULTS 256
+
+typedef struct BenchResultTag {
+    const char *name;
+    uint64_t operations;
+    uint64_t bestNs;
+    uint64_t medianNs;
+} BenchResult;
+
+static BenchResult s_results[MAX_RESULTS];
+static uint32_t s_result_count = 0;
+
+uint64_t bench_NowNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000u + (uint64_t) ts.tv_nsec;
+}
+
+static void record_result(const char *name, uint64_t bestNs, uint64_t medianNs, uint64_t operations) {
+    fprintf(
+        stderr,
+        "%-40s %12.3f ms %10.2f ns/op\n",
+        name,
+        (double) bestNs / 1e6,
+        operations == 0 ? 0.0 : (double) bestNs / (double) operations
+    );
+    if (s_result_count == MAX_RESULTS) return;
+    s_results[s_result_count++] = (BenchResult) {name, operations, bestNs, medianNs};
+}
+
+void bench_Report(const char *name, uint64_t elapsedNs, uint64_t operations) {
+    record_result(name, elapsedNs, elapsedNs, operations);
+}
+
+static int compare_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *) a;
+    uint64_t y = *(const uint64_t *) b;
+    return x < y ? -1 : x > y;
+}
+
+void bench_Measure(const char *name, BenchFunction function, void *ctx, uint64_t operations) {
+    uint64_t runs[BENCH_REPETITIONS];
+    for (int i = 0; i < BENCH_REPETITIONS; i++) {
+        uint64_t start = bench_NowNs();
+        function(ctx);
+        runs[i] = bench_NowNs() - start;
+    }
+    qsort(runs, BENCH_REPETITIONS, sizeof(uint64_t), compare_u64);
+    record_result(name, runs[0], runs[BENCH_REPETITIONS / 2], operations);
+}
+
+static void write_json_string(FILE *out, const char *text) {
+    fputc('"', out);
+    for (const char *c = text; *c != '\0'; c++) {
+        if (*c == '"' || *c == '\\') {
+            fputc('\\', out);
+        }
+        fputc(*c, out);
+    }
+    fputc('"', out);
+}
+
+void bench_WriteJson(FILE *out) {
+    PDMemoryStats stats;
+    pd_GetMemoryStats(&stats);
+    fprintf(out, "{\n  \"schema\": 1,\n");
+    fprintf(out, "  \"build\": {\"allocationTracking\": %s},\n", stats.tracked ? "true" : "false");
+    fprintf(out, "  \"results\": [\n");
+    for (uint32_t i = 0; i < s_result_count; i++) {
+        const BenchResult *result = &s_results[i];
+        fprintf(out, "    {\"name\": ");
+        write_json_string(out, result->name);
+        fprintf(
+            out, ", \"operations\": %llu, \"bestNs\": %llu, \"medianNs\": %llu, \"nsPerOp\": %.2f}%s\n",
+            (unsigned long long) result->operations,
+            (unsigned long long) result->bestNs,
+            (unsigned long long) result->medianNs,
+            result->operations == 0 ? 0.0 : (double) result->bestNs / (double) result->operations,
+            i + 1 < s_result_count ? "," : ""
+        );
+    }
+    fprintf(out, "  ]\n}\n");
+}
+
+uint32_t bench_Random(uint32_t *state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
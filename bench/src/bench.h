@@ -0,0 +1,115 @@
+/**
+ * @file bench.h
+ *
+ * @brief Helpers for the host benchmarks.
+ *
+ * The benchmarks run on the development machine (not on Playdate)
+ * against a stand-in PlaydateAPI whose allocator is the host's @c malloc(3).
+ * Compare numbers between builds on the same machine, not against the device.
+ */
+
+#ifndef PD_UTILS_BENCH_H
+#define PD_UTILS_BENCH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <pd_api.h>
+
+/**
+ * @def BENCH_REPETITIONS
+ * @brief Number of times bench_Measure runs a benchmark.
+ */
+#define BENCH_REPETITIONS 5
+
+/**
+ * @brief A benchmark body for bench_Measure.
+ *
+ * @param[in] ctx Context passed to bench_Measure.
+ */
+typedef void (*BenchFunction)(void *ctx);
+
+/**
+ * @brief Gets the stand-in PlaydateAPI object.
+ *
+ * Besides @c system, it provides:
+ * - @c graphics, whose @c getTextWidth uses a fixed per-glyph width model (see bench_GlyphWidth);
+ *   fonts are dummies and drawing does nothing.
+ * - @c file, backed by the host filesystem (paths are relative to the working directory).
+ *
+ * @returns PlaydateAPI* object to pass to the initialization functions of the libraries.
+ */
+PlaydateAPI *bench_GetFakePd(void);
+
+/**
+ * @brief Width of a glyph in the stand-in font.
+ *
+ * Space is 4 pixels, narrow ASCII glyphs (e.g., @c i, @c l, @c .) 3, wide ones (e.g., @c m, @c W) 9,
+ * other ASCII glyphs 6, and anything outside ASCII 12 (full width).
+ *
+ * @param[in] codepoint Unicode code point.
+ * @returns Width in pixels, without tracking.
+ */
+int bench_GlyphWidth(uint32_t codepoint);
+
+/**
+ * @brief Makes the stand-in @c logToConsole discard messages (e.g., when flushing a benchmark's log buffer).
+ *
+ * @param[in] muted true to discard messages, false to print them to stderr again.
+ */
+void bench_SetConsoleMuted(bool muted);
+
+/**
+ * @brief Monotonic clock in nanoseconds.
+ */
+uint64_t bench_NowNs(void);
+
+/**
+ * @brief Prints the result of a benchmark to stderr and records it for bench_WriteJson.
+ *
+ * @param[in] name       Name of the benchmark.
+ * @param[in] elapsedNs  Time it took, in nanoseconds.
+ * @param[in] operations Number of operations done in that time.
+ */
+void bench_Report(const char *name, uint64_t elapsedNs, uint64_t operations);
+
+/**
+ * @brief Runs a benchmark #BENCH_REPETITIONS times and reports the fastest run.
+ *
+ * The median run is recorded for bench_WriteJson as well.
+ *
+ * @param[in] name       Name of the benchmark.
+ * @param[in] function   Benchmark body. Must do the same work every time it is called.
+ * @param[in] ctx        Passed to @c function.
+ * @param[in] operations Number of operations done by one call of @c function.
+ */
+void bench_Measure(const char *name, BenchFunction function, void *ctx, uint64_t operations);
+
+/**
+ * @brief Writes every result recorded so far as a JSON document.
+ *
+ * @c allocationTracking tells whether pd_shorthand was built with PD_SHORTHAND_DEBUG or PD_SHORTHAND_STATS.
+ * Times are in nanoseconds; @c nsPerOp is computed from the fastest run.
+ *
+ * @code{.json}
+ * {
+ *   "schema": 1,
+ *   "build": {"allocationTracking": false},
+ *   "results": [
+ *     {"name": "wrap/1024", "operations": 100, "bestNs": 1234567, "medianNs": 1250000, "nsPerOp": 12345.67}
+ *   ]
+ * }
+ * @endcode
+ *
+ * @param[in] out Stream to write to.
+ */
+void bench_WriteJson(FILE *out);
+
+/**
+ * @brief Deterministic xorshift32 random number generator, so that every run does the same work.
+ *
+ * @param[in,out] state Generator state. Must not be 0.
+ */
+uint32_t bench_Random(uint32_t *state);
+
+#endif /* PD_UTILS_BENCH_H */
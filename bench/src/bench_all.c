@@ -0,0 +1,735 @@
+#include "bench.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <pd_utils.h>
+
+#define WRAP_WIDTH 200
+#define WRAP_CALLS 200
+#define WRAP_CHECK_TEXTS 500
+#define ALLOC_LIVE_BLOCKS 4096
+#define ALLOC_CHURN_STEPS 200000
+#define SCENE_COUNT 1000
+#define SCENE_REGISTER_ROUNDS 50
+#define SCENE_LOADS 20000
+#define FORMAT_CALLS 200000
+#define MEASURE_CALLS 100000
+#define PREWRAP_LENGTH 1024
+#define TRUNCATE_CALLS 20000
+#define TRUNCATE_WIDTH 120
+#define LAYOUT_APPENDS 2000
+#define LAYOUT_DRAWS 100000
+#define RICH_SETS 20000
+#define BITMAP_CACHE_DRAWS 100000
+#define BITMAP_CACHE_LABELS 64
+#define HUD_FRAMES 10000
+#define HUD_TEXTS 48
+#define TYPEWRITER_LENGTH 256
+#define COUNTER_FRAMES 10000
+#define COUNTER_COUNT 16
+
+static const char *const s_words[] = {
+    "the", "quick", "brown", "fox", "jumps", "over", "a", "lazy", "dog", "while",
+    "Playdate", "crank", "spins", "slowly", "under", "yellow", "light", "and", "wind", "sings",
+};
+
+static const size_t s_wrap_lengths[] = {64, 256, 1024, 4096};
+static char s_wrap_names[sizeof(s_wrap_lengths) / sizeof(s_wrap_lengths[0])][32];
+
+typedef struct WrapCaseTag {
+    const Font *font;
+    char *text;
+} WrapCase;
+
+/* Deterministic text of roughly the requested length. */
+static char *make_text(size_t length) {
+    char *text = pd_Malloc(length + 16);
+    uint32_t rng = 0xC0FFEEu;
+    size_t used = 0;
+    while (used < length) {
+        const char *word = s_words[bench_Random(&rng) % (sizeof(s_words) / sizeof(s_words[0]))];
+        size_t wordLength = strlen(word);
+        if (used + wordLength + 1 > length + 15) break;
+        if (used > 0) {
+            text[used++] = ' ';
+        }
+        memcpy(text + used, word, wordLength);
+        used += wordLength;
+    }
+    text[used] = '\0';
+    return text;
+}
+
+static void bench_wrap(void *ctx) {
+    WrapCase *wrapCase = ctx;
+    for (int i = 0; i < WRAP_CALLS; i++) {
+        char *out = NULL;
+        pdText_GetWrappedText(&out, wrapCase->font, 10000, WRAP_WIDTH, kASCIIEncoding, "%s", wrapCase->text);
+        bench_GetFakePd()->system->realloc(out, 0);
+    }
+}
+
+static void bench_wrap_utf8(void *ctx) {
+    WrapCase *wrapCase = ctx;
+    for (int i = 0; i < WRAP_CALLS; i++) {
+        char *out = NULL;
+        pdText_GetWrappedText(&out, wrapCase->font, 10000, WRAP_WIDTH, kUTF8Encoding, "%s", wrapCase->text);
+        bench_GetFakePd()->system->realloc(out, 0);
+    }
+}
+
+/* Japanese without spaces, about 1 KiB of UTF-8. */
+static char *make_cjk_text(void) {
+    static const char sentence[] = "吾輩は猫である。名前はまだ無い。「どこで生れたか」とんと見当がつかぬ。";
+    size_t repeats = 1024 / (sizeof(sentence) - 1) + 1;
+    char *text = pd_Malloc(repeats * (sizeof(sentence) - 1) + 1);
+    for (size_t i = 0; i < repeats; i++) {
+        memcpy(text + i * (sizeof(sentence) - 1), sentence, sizeof(sentence) - 1);
+    }
+    text[repeats * (sizeof(sentence) - 1)] = '\0';
+    return text;
+}
+
+static void run_wrap_suite(void) {
+    Font font;
+    const char *err = NULL;
+    pdText_LoadFont("fonts/bench", 2, &font, &err);
+    for (size_t i = 0; i < sizeof(s_wrap_lengths) / sizeof(s_wrap_lengths[0]); i++) {
+        snprintf(s_wrap_names[i], sizeof(s_wrap_names[i]), "wrap/%zu", s_wrap_lengths[i]);
+        WrapCase wrapCase = {&font, make_text(s_wrap_lengths[i])};
+        bench_Measure(s_wrap_names[i], bench_wrap, &wrapCase, WRAP_CALLS);
+        pd_Free(wrapCase.text);
+    }
+    WrapCase cjkCase = {&font, make_cjk_text()};
+    bench_Measure("wrap/cjk", bench_wrap_utf8, &cjkCase, WRAP_CALLS);
+    pd_Free(cjkCase.text);
+    pdText_FreeFont(&font);
+}
+
+/* ASCII words with the punctuation and brackets the Unicode rules know about, but no hyphens. */
+static char *make_punctuated_text(uint32_t *rng) {
+    static const char marks[] = ",.;:!?()[]{}\"'";
+    char *text = pd_Malloc(256);
+    size_t used = 0;
+    while (used < 200) {
+        const char *word = s_words[bench_Random(rng) % (sizeof(s_words) / sizeof(s_words[0]))];
+        size_t wordLength = strlen(word);
+        memcpy(text + used, word, wordLength);
+        used += wordLength;
+        uint32_t roll = bench_Random(rng) % 8;
+        if (roll < 3) {
+            text[used++] = marks[bench_Random(rng) % (sizeof(marks) - 1)];
+        }
+        if (roll == 0) {
+            text[used++] = marks[bench_Random(rng) % (sizeof(marks) - 1)];
+        }
+        text[used++] = roll == 7 ? '\n' : ' ';
+    }
+    text[used] = '\0';
+    return text;
+}
+
+/*
+ * The Unicode rules may break ASCII text after hyphens and nowhere else but at spaces,
+ * so without hyphens kUTF8Encoding has to wrap it exactly like the spaces-only rules of kASCIIEncoding.
+ */
+static bool check_ascii_wrap(void) {
+    Font font;
+    const char *err = NULL;
+    pdText_LoadFont("fonts/bench", 2, &font, &err);
+    uint32_t rng = 0x5EEDu;
+    bool same = true;
+    for (int i = 0; i < WRAP_CHECK_TEXTS && same; i++) {
+        char *text = make_punctuated_text(&rng);
+        uint16_t width = (uint16_t) (20 + bench_Random(&rng) % 200);
+        char *spaces = NULL;
+        char *unicode = NULL;
+        pdText_GetWrappedText(&spaces, &font, 10000, width, kASCIIEncoding, "%s", text);
+        pdText_GetWrappedText(&unicode, &font, 10000, width, kUTF8Encoding, "%s", text);
+        if (strcmp(spaces, unicode) != 0) {
+            fprintf(stderr, "ASCII text wraps differently in UTF-8 at %u px:\n%s\n---\n%s\n", width, spaces, unicode);
+            same = false;
+        }
+        bench_GetFakePd()->system->realloc(spaces, 0);
+        bench_GetFakePd()->system->realloc(unicode, 0);
+        pd_Free(text);
+    }
+    pdText_FreeFont(&font);
+    return same;
+}
+
+typedef struct PrewrapCaseTag {
+    const Font *font;
+    const char *text;
+    size_t length;
+    PDTextBreaks breaks;
+} PrewrapCase;
+
+/* The breaks pd_prewrap would write for the text, kept in memory instead of a file. */
+static void collect_break(void *userdata, size_t line_end, size_t next_line_start) {
+    PrewrapCase *prewrapCase = userdata;
+    uint32_t *breaks = (uint32_t *) prewrapCase->breaks.breaks;
+    breaks[prewrapCase->breaks.entries[3]++] = (uint32_t) (line_end << 2 | (next_line_start - line_end));
+}
+
+static void bench_prewrap(void *ctx) {
+    PrewrapCase *prewrapCase = ctx;
+    PDStrBuf sb;
+    pd_StrBufInit(&sb, NULL, 0);
+    for (int i = 0; i < WRAP_CALLS; i++) {
+        pd_StrBufClear(&sb);
+        pdText_WrapWithBreaks(&sb, &prewrapCase->breaks, 0, prewrapCase->text, prewrapCase->length);
+    }
+    pd_StrBufRelease(&sb);
+}
+
+static void bench_prewrap_measured(void *ctx) {
+    PrewrapCase *prewrapCase = ctx;
+    PDStrBuf sb;
+    pd_StrBufInit(&sb, NULL, 0);
+    for (int i = 0; i < WRAP_CALLS; i++) {
+        pd_StrBufClear(&sb);
+        pdText_WrapTextToBuf(&sb, prewrapCase->text, prewrapCase->length, prewrapCase->font, 10000, WRAP_WIDTH,
+                             kUTF8Encoding);
+    }
+    pd_StrBufRelease(&sb);
+}
+
+static void run_prewrap_suite(void) {
+    Font font;
+    const char *err = NULL;
+    pdText_LoadFont("fonts/bench", 2, &font, &err);
+    char *text = make_text(PREWRAP_LENGTH);
+    PrewrapCase prewrapCase = {&font, text, strlen(text)};
+    uint32_t entries[6] = {0, (uint32_t) prewrapCase.length, 0, 0, 0, 0};
+    prewrapCase.breaks.entries = entries;
+    prewrapCase.breaks.breaks = pd_Malloc(sizeof(uint32_t) * prewrapCase.length);
+    prewrapCase.breaks.count = 1;
+    entries[2] = pdText_BreakLines(text, prewrapCase.length, &font, 10000, WRAP_WIDTH, kUTF8Encoding,
+                                   kPDTextLineBreakUnicode, collect_break, &prewrapCase);
+    bench_Measure("prewrap/pdText_WrapWithBreaks", bench_prewrap, &prewrapCase, WRAP_CALLS);
+    bench_Measure("prewrap/pdText_WrapTextToBuf (reference)", bench_prewrap_measured, &prewrapCase, WRAP_CALLS);
+    pd_Free((void *) prewrapCase.breaks.breaks);
+    pd_Free(text);
+    pdText_FreeFont(&font);
+}
+
+static void bench_measure(void *ctx) {
+    const Font *font = ctx;
+    for (int i = 0; i < MEASURE_CALLS; i++) {
+        pdText_GetStringWidth(font, kASCIIEncoding, "To the AVALANCHE, 1234 steps: quick fox!");
+    }
+}
+
+static void run_measure_suite(void) {
+    Font font;
+    const char *err = NULL;
+    pdText_LoadFont("fonts/bench", 2, &font, &err);
+    pdText_WarmGlyphCache(&font, kASCIIEncoding, "To the AVALANCHE, 1234 steps: quick fox!");
+    bench_Measure("measure/pdText_GetStringWidth", bench_measure, &font, MEASURE_CALLS);
+    pdText_FreeGlyphCache(&font);
+    bench_Measure("measure/pdText_GetStringWidth (no cache)", bench_measure, &font, MEASURE_CALLS);
+    pdText_FreeFont(&font);
+}
+
+/* A list item cut to fit its row, with an ellipsis. */
+static void bench_truncate(void *ctx) {
+    const Font *font = ctx;
+    static const char item[] = "To the AVALANCHE, 1234 steps: quick fox!";
+    char storage[64];
+    PDStrBuf sb;
+    pd_StrBufInit(&sb, storage, sizeof(storage));
+    for (int i = 0; i < TRUNCATE_CALLS; i++) {
+        pd_StrBufClear(&sb);
+        pdText_Truncate(font, kASCIIEncoding, item, sizeof(item) - 1, TRUNCATE_WIDTH, "...", &sb);
+    }
+    pd_StrBufRelease(&sb);
+}
+
+/* The same, dropping one character at a time until the text and the ellipsis fit. */
+static void bench_truncate_probe(void *ctx) {
+    const Font *font = ctx;
+    static const char item[] = "To the AVALANCHE, 1234 steps: quick fox!";
+    char storage[64];
+    PDStrBuf sb;
+    pd_StrBufInit(&sb, storage, sizeof(storage));
+    for (int i = 0; i < TRUNCATE_CALLS; i++) {
+        size_t length = sizeof(item) - 1;
+        pd_StrBufClear(&sb);
+        pd_StrBufAppendN(&sb, item, length);
+        while (length > 0
+               && pdText_GetTextWidthN(font, kASCIIEncoding, pd_StrBufCStr(&sb), sb.length) > TRUNCATE_WIDTH) {
+            pd_StrBufClear(&sb);
+            pd_StrBufAppendN(&sb, item, --length);
+            pd_StrBufAppend(&sb, "...");
+        }
+    }
+    pd_StrBufRelease(&sb);
+}
+
+static void run_truncate_suite(void) {
+    Font font;
+    const char *err = NULL;
+    pdText_LoadFont("fonts/bench", 2, &font, &err);
+    bench_Measure("truncate/pdText_Truncate", bench_truncate, &font, TRUNCATE_CALLS);
+    bench_Measure("truncate/probe (reference)", bench_truncate_probe, &font, TRUNCATE_CALLS);
+    pdText_FreeFont(&font);
+}
+
+/* A chat log: every append only lays out the last lines again. */
+static void bench_layout_append(void *ctx) {
+    const Font *font = ctx;
+    PDTextLayout layout;
+    pdText_LayoutInit(&layout, font, kUTF8Encoding, WRAP_WIDTH, LAYOUT_APPENDS * 4, kPDTextAlignLeft);
+    for (int i = 0; i < LAYOUT_APPENDS; i++) {
+        static const char line[] = "player two: the quick brown fox jumps over the lazy dog\n";
+        pdText_LayoutAppend(&layout, line, sizeof(line) - 1);
+    }
+    pdText_LayoutRelease(&layout);
+}
+
+static void bench_layout_draw(void *ctx) {
+    const PDTextLayout *layout = ctx;
+    for (int i = 0; i < LAYOUT_DRAWS; i++) {
+        pdText_LayoutDraw(layout, 0, 0);
+    }
+}
+
+static void run_layout_suite(void) {
+    Font font;
+    const char *err = NULL;
+    pdText_LoadFont("fonts/bench", 2, &font, &err);
+    bench_Measure("layout/Append", bench_layout_append, &font, LAYOUT_APPENDS);
+    PDTextLayout layout;
+    pdText_LayoutInit(&layout, &font, kUTF8Encoding, WRAP_WIDTH, 16, kPDTextAlignCenter);
+    char *text = make_text(256);
+    pdText_LayoutSetText(&layout, text, strlen(text));
+    bench_Measure("layout/Draw", bench_layout_draw, &layout, LAYOUT_DRAWS);
+    pd_Free(text);
+    pdText_LayoutRelease(&layout);
+    pdText_FreeFont(&font);
+}
+
+/* A dialogue box with a name in bold and a highlighted item. */
+static const char s_rich_markup[] =
+    "{f1}Mayor:{/f} the {inv}rusty key{/inv} opens the old mill by the river. Bring it back before the {f1}crank{/f} "
+    "turns twice, or the wind will sing under the yellow light again.";
+
+static void bench_rich_set_text(void *ctx) {
+    PDTextRichText *rich = ctx;
+    for (int i = 0; i < RICH_SETS; i++) {
+        pdText_RichTextSetText(rich, s_rich_markup, sizeof(s_rich_markup) - 1);
+    }
+}
+
+static void bench_rich_draw(void *ctx) {
+    const PDTextRichText *rich = ctx;
+    for (int i = 0; i < LAYOUT_DRAWS; i++) {
+        pdText_RichTextDraw(rich, 0, 0);
+    }
+}
+
+static void run_rich_suite(void) {
+    Font fonts[2];
+    const char *err = NULL;
+    pdText_LoadFont("fonts/bench", 2, &fonts[0], &err);
+    pdText_LoadFont("fonts/bench-bold", 2, &fonts[1], &err);
+    const Font *fontList[] = {&fonts[0], &fonts[1]};
+    PDTextRichText rich;
+    pdText_RichTextInit(&rich, fontList, 2, kUTF8Encoding, WRAP_WIDTH, 16, kPDTextAlignLeft);
+    bench_Measure("rich/SetText", bench_rich_set_text, &rich, RICH_SETS);
+    bench_Measure("rich/Draw", bench_rich_draw, &rich, LAYOUT_DRAWS);
+    pdText_RichTextRelease(&rich);
+    pdText_FreeFont(&fonts[0]);
+    pdText_FreeFont(&fonts[1]);
+}
+
+/* A menu: the same few labels drawn every frame. */
+static void bench_bitmap_cache(void *ctx) {
+    const Font *font = ctx;
+    static const char *const labels[] = {"New Game", "Continue", "Options", "Credits"};
+    for (int i = 0; i < BITMAP_CACHE_DRAWS; i++) {
+        const char *label = labels[i & 3];
+        pdText_DisplayCachedText(font, kASCIIEncoding, 10, 10 + (i & 3) * 20, label, strlen(label));
+    }
+}
+
+static void bench_bitmap_cache_direct(void *ctx) {
+    const Font *font = ctx;
+    static const char *const labels[] = {"New Game", "Continue", "Options", "Credits"};
+    PlaydateAPI *pd = pd_getPd();
+    for (int i = 0; i < BITMAP_CACHE_DRAWS; i++) {
+        const char *label = labels[i & 3];
+        pd->graphics->setFont(font->font);
+        pd->graphics->drawText(label, strlen(label), kASCIIEncoding, 10, 10 + (i & 3) * 20);
+    }
+}
+
+/* More labels than the budget holds, so every draw renders and evicts. */
+static void bench_bitmap_cache_churn(void *ctx) {
+    const Font *font = ctx;
+    char label[16];
+    for (int i = 0; i < BITMAP_CACHE_DRAWS; i++) {
+        int length = pd_Format(label, sizeof(label), "Item %d", i % BITMAP_CACHE_LABELS);
+        pdText_DisplayCachedText(font, kASCIIEncoding, 10, 10, label, (size_t) length);
+    }
+}
+
+static void run_bitmap_cache_suite(void) {
+    Font font;
+    const char *err = NULL;
+    pdText_LoadFont("fonts/bench", 2, &font, &err);
+    bench_Measure("bitmap_cache/hit", bench_bitmap_cache, &font, BITMAP_CACHE_DRAWS);
+    bench_Measure("bitmap_cache/drawText (reference)", bench_bitmap_cache_direct, &font, BITMAP_CACHE_DRAWS);
+    pdText_SetBitmapCacheBudget(4096);
+    bench_Measure("bitmap_cache/churn", bench_bitmap_cache_churn, &font, BITMAP_CACHE_DRAWS);
+    pdText_SetBitmapCacheBudget(PD_TEXT_BITMAP_CACHE_DEFAULT_BUDGET);
+    pdText_FreeFont(&font);
+}
+
+typedef struct HudCaseTag {
+    Font fonts[3];
+    PDTextDrawQueue queue;
+} HudCase;
+
+/* A HUD that mixes three fonts, some of it scrolled off the screen. */
+static void bench_hud_queue(void *ctx) {
+    HudCase *hud = ctx;
+    for (int frame = 0; frame < HUD_FRAMES; frame++) {
+        for (int i = 0; i < HUD_TEXTS; i++) {
+            int32_t x = (i * 37) % 480;
+            int32_t y = (i * 11) % 260;
+            pdText_DrawQueueAddF(&hud->queue, &hud->fonts[i % 3], kASCIIEncoding, x, y, "Value %d", i + frame);
+        }
+        pdText_DrawQueueFlush(&hud->queue);
+    }
+}
+
+static void bench_hud_direct(void *ctx) {
+    HudCase *hud = ctx;
+    for (int frame = 0; frame < HUD_FRAMES; frame++) {
+        for (int i = 0; i < HUD_TEXTS; i++) {
+            int32_t x = (i * 37) % 480;
+            int32_t y = (i * 11) % 260;
+            pdText_DisplayStringWithFont(&hud->fonts[i % 3], kASCIIEncoding, x, y, "Value %d", i + frame);
+        }
+    }
+}
+
+static void run_draw_queue_suite(void) {
+    static PDTextDrawEntry entries[HUD_TEXTS];
+    static char text[HUD_TEXTS * 16];
+    HudCase hud;
+    const char *err = NULL;
+    for (int i = 0; i < 3; i++) {
+        pdText_LoadFont("fonts/bench", 2, &hud.fonts[i], &err);
+    }
+    pdText_DrawQueueInit(&hud.queue, entries, HUD_TEXTS, text, sizeof(text));
+    bench_Measure("draw_queue/HUD", bench_hud_queue, &hud, (uint64_t) HUD_FRAMES * HUD_TEXTS);
+    bench_Measure(
+        "draw_queue/DisplayStringWithFont (reference)", bench_hud_direct, &hud, (uint64_t) HUD_FRAMES * HUD_TEXTS
+    );
+    pdText_DrawQueueRelease(&hud.queue);
+    for (int i = 0; i < 3; i++) {
+        pdText_FreeFont(&hud.fonts[i]);
+    }
+}
+
+/* A dialogue page revealed one character per frame, until the whole page is shown. */
+static void bench_typewriter(void *ctx) {
+    PDTextTypewriter *typewriter = ctx;
+    const char *text = pd_StrBufCStr(&typewriter->layout.text);
+    pdText_TypewriterSetText(typewriter, text, typewriter->layout.text.length);
+    while (!typewriter->finished) {
+        pdText_TypewriterUpdate(typewriter, 10, 10);
+    }
+}
+
+/* The same page, wrapped once but drawn again up to the current character every frame. */
+static void bench_typewriter_redraw(void *ctx) {
+    const PDTextTypewriter *typewriter = ctx;
+    char *wrapped = NULL;
+    pdText_GetWrappedText(
+        &wrapped, typewriter->layout.font, 16, WRAP_WIDTH, kUTF8Encoding, "%s", pd_StrBufCStr(&typewriter->layout.text)
+    );
+    size_t length = strlen(wrapped);
+    PlaydateAPI *pd = pd_getPd();
+    for (size_t shown = 1; shown <= length; shown++) {
+        pd->graphics->setFont(typewriter->layout.font->font);
+        pd->graphics->drawText(wrapped, shown, kUTF8Encoding, 10, 10);
+    }
+    pd->system->realloc(wrapped, 0);
+}
+
+static void run_typewriter_suite(void) {
+    Font font;
+    const char *err = NULL;
+    pdText_LoadFont("fonts/bench", 2, &font, &err);
+    PDTextTypewriter typewriter;
+    pdText_TypewriterInit(&typewriter, &font, kUTF8Encoding, WRAP_WIDTH, 16, kPDTextAlignLeft);
+    char *text = make_text(TYPEWRITER_LENGTH);
+    pdText_TypewriterSetText(&typewriter, text, strlen(text));
+    bench_Measure("typewriter/Update", bench_typewriter, &typewriter, TYPEWRITER_LENGTH);
+    bench_Measure("typewriter/redraw (reference)", bench_typewriter_redraw, &typewriter, TYPEWRITER_LENGTH);
+    pd_Free(text);
+    pdText_TypewriterRelease(&typewriter);
+    pdText_FreeFont(&font);
+}
+
+typedef struct CounterCaseTag {
+    Font font;
+    PDTextCounter counters[COUNTER_COUNT];
+} CounterCase;
+
+/* A HUD of counters where only one value changes per frame, like a score next to mostly idle stats. */
+static void bench_counter(void *ctx) {
+    CounterCase *hud = ctx;
+    for (int i = 0; i < COUNTER_COUNT; i++) {
+        pdText_CounterInvalidate(&hud->counters[i]);
+    }
+    for (int frame = 0; frame < COUNTER_FRAMES; frame++) {
+        for (int i = 0; i < COUNTER_COUNT; i++) {
+            pdText_CounterUpdate(&hud->counters[i], i == frame % COUNTER_COUNT ? frame * 10 : i);
+        }
+    }
+}
+
+static void bench_counter_direct(void *ctx) {
+    CounterCase *hud = ctx;
+    for (int frame = 0; frame < COUNTER_FRAMES; frame++) {
+        for (int i = 0; i < COUNTER_COUNT; i++) {
+            int value = i == frame % COUNTER_COUNT ? frame * 10 : i;
+            pdText_DisplayStringWithFont(&hud->font, kASCIIEncoding, 300, i * 14, "Score %06d", value);
+        }
+    }
+}
+
+static void run_counter_suite(void) {
+    CounterCase hud;
+    const char *err = NULL;
+    pdText_LoadFont("fonts/bench", 2, &hud.font, &err);
+    for (int i = 0; i < COUNTER_COUNT; i++) {
+        pdText_CounterInit(&hud.counters[i], &hud.font, 390, i * 14, kPDTextAlignRight);
+        hud.counters[i].prefix = "Score ";
+        hud.counters[i].minDigits = 6;
+    }
+    bench_Measure("counter/Update", bench_counter, &hud, (uint64_t) COUNTER_FRAMES * COUNTER_COUNT);
+    bench_Measure(
+        "counter/DisplayStringWithFont (reference)", bench_counter_direct, &hud,
+        (uint64_t) COUNTER_FRAMES * COUNTER_COUNT
+    );
+    pdText_FreeFont(&hud.font);
+}
+
+static void *s_blocks[ALLOC_LIVE_BLOCKS];
+
+/* Keeps a few thousand blocks alive and replaces random ones; with PD_SHORTHAND_DEBUG, every call updates the table. */
+static void bench_alloc_churn(void *ctx) {
+    (void) ctx;
+    uint32_t rng = 0x12345678u;
+    for (int i = 0; i < ALLOC_LIVE_BLOCKS; i++) {
+        s_blocks[i] = pd_Malloc(16 + bench_Random(&rng) % 240);
+    }
+    for (int step = 0; step < ALLOC_CHURN_STEPS; step++) {
+        uint32_t index = bench_Random(&rng) % ALLOC_LIVE_BLOCKS;
+        if (step % 4 == 0) {
+            void *grown = pd_Realloc(s_blocks[index], 16 + bench_Random(&rng) % 480);
+            if (grown != NULL) {
+                s_blocks[index] = grown;
+            }
+        } else {
+            pd_Free(s_blocks[index]);
+            s_blocks[index] = pd_Malloc(16 + bench_Random(&rng) % 240);
+        }
+    }
+    for (int i = 0; i < ALLOC_LIVE_BLOCKS; i++) {
+        pd_Free(s_blocks[i]);
+    }
+}
+
+static void bench_alloc_stats(void *ctx) {
+    (void) ctx;
+    PDMemoryStats stats;
+    for (int i = 0; i < FORMAT_CALLS; i++) {
+        pd_GetMemoryStats(&stats);
+    }
+}
+
+static void run_alloc_suite(void) {
+    bench_Measure(
+        "alloc/churn", bench_alloc_churn, NULL, (uint64_t) ALLOC_LIVE_BLOCKS * 2 + ALLOC_CHURN_STEPS * 7 / 4
+    );
+    bench_Measure("alloc/GetMemoryStats", bench_alloc_stats, NULL, FORMAT_CALLS);
+}
+
+static Scene *s_scenes;
+static void *s_scene_pointers[SCENE_COUNT];
+
+static void bench_scene_register(void *ctx) {
+    (void) ctx;
+    for (int round = 0; round < SCENE_REGISTER_ROUNDS; round++) {
+        pdScene_Finalize();
+        pdScene_Initialize(bench_GetFakePd());
+        for (int i = 0; i < SCENE_COUNT; i++) {
+            pdScene_Register(s_scene_pointers[i]);
+        }
+    }
+}
+
+static void bench_scene_load(void *ctx) {
+    (void) ctx;
+    uint32_t rng = 0xBADC0DEu;
+    for (int i = 0; i < SCENE_LOADS; i++) {
+        pdScene_Load(bench_Random(&rng) % SCENE_COUNT, NULL);
+    }
+}
+
+/* The same scenes as a static table would give them; only the lookup slots get filled. */
+static void bench_scene_register_table(void *ctx) {
+    const PDSceneTable *table = ctx;
+    for (int round = 0; round < SCENE_REGISTER_ROUNDS; round++) {
+        pdScene_Finalize();
+        pdScene_Initialize(bench_GetFakePd());
+        pdScene_RegisterTable(table);
+    }
+}
+
+static void run_scene_suite(void) {
+    /* Scene members are const, so the scenes are built in place. */
+    s_scenes = pd_Malloc(sizeof(Scene) * SCENE_COUNT);
+    for (int i = 0; i < SCENE_COUNT; i++) {
+        Scene scene = {(SceneIdentifier) i, NULL, NULL, NULL, NULL};
+        memcpy(&s_scenes[i], &scene, sizeof(Scene));
+        s_scene_pointers[i] = &s_scenes[i];
+    }
+    bench_Measure("scene/Register", bench_scene_register, NULL, (uint64_t) SCENE_COUNT * SCENE_REGISTER_ROUNDS);
+    bench_Measure("scene/Load", bench_scene_load, NULL, SCENE_LOADS);
+
+    static const Scene *tableScenes[SCENE_COUNT];
+    static const Scene *tableSlots[SCENE_COUNT * 2];
+    for (int i = 0; i < SCENE_COUNT; i++) {
+        tableScenes[i] = &s_scenes[i];
+    }
+    PDSceneTable table = {tableScenes, SCENE_COUNT, tableSlots};
+    bench_Measure(
+        "scene/RegisterTable", bench_scene_register_table, &table, (uint64_t) SCENE_COUNT * SCENE_REGISTER_ROUNDS
+    );
+    bench_Measure("scene/Load (table)", bench_scene_load, NULL, SCENE_LOADS);
+    /* The table does not outlive this function. */
+    pdScene_Finalize();
+    pdScene_Initialize(bench_GetFakePd());
+    pd_Free(s_scenes);
+}
+
+static void bench_format(void *ctx) {
+    (void) ctx;
+    char out[64];
+    for (int i = 0; i < FORMAT_CALLS; i++) {
+        pd_Format(out, sizeof(out), "Score %6d  x%d  %s", i * 10, i & 7, "COMBO");
+    }
+}
+
+static void bench_format_snprintf(void *ctx) {
+    (void) ctx;
+    char out[64];
+    for (int i = 0; i < FORMAT_CALLS; i++) {
+        snprintf(out, sizeof(out), "Score %6d  x%d  %s", i * 10, i & 7, "COMBO");
+    }
+}
+
+static void bench_format_float(void *ctx) {
+    (void) ctx;
+    char out[64];
+    for (int i = 0; i < FORMAT_CALLS; i++) {
+        pd_Format(out, sizeof(out), "%.2f m/s", (double) i * 0.37);
+    }
+}
+
+static void bench_strbuf(void *ctx) {
+    (void) ctx;
+    char storage[64];
+    PDStrBuf sb;
+    pd_StrBufInit(&sb, storage, sizeof(storage));
+    for (int i = 0; i < FORMAT_CALLS; i++) {
+        pd_StrBufClear(&sb);
+        pd_StrBufAppend(&sb, "Score ");
+        pd_StrBufAppendInt(&sb, i * 10);
+        pd_StrBufAppend(&sb, "  ");
+        pd_StrBufAppendFixed(&sb, (float) i * 0.37f, 2);
+    }
+    pd_StrBufRelease(&sb);
+}
+
+static void bench_display_string(void *ctx) {
+    (void) ctx;
+    for (int i = 0; i < FORMAT_CALLS; i++) {
+        pdText_DisplayString(kASCIIEncoding, 0, 0, "Score %6d", i * 10);
+    }
+}
+
+static void bench_display_string_buf(void *ctx) {
+    (void) ctx;
+    char storage[32];
+    PDStrBuf sb;
+    pd_StrBufInit(&sb, storage, sizeof(storage));
+    for (int i = 0; i < FORMAT_CALLS; i++) {
+        pd_StrBufClear(&sb);
+        pd_StrBufAppend(&sb, "Score ");
+        pd_StrBufAppendInt(&sb, i * 10);
+        pdText_DisplayStringBuf(kASCIIEncoding, 0, 0, &sb);
+    }
+    pd_StrBufRelease(&sb);
+}
+
+static void run_format_suite(void) {
+    bench_Measure("format/pd_Format", bench_format, NULL, FORMAT_CALLS);
+    bench_Measure("format/snprintf (host reference)", bench_format_snprintf, NULL, FORMAT_CALLS);
+    bench_Measure("format/pd_Format %.2f", bench_format_float, NULL, FORMAT_CALLS);
+    bench_Measure("format/PDStrBuf", bench_strbuf, NULL, FORMAT_CALLS);
+    bench_Measure("format/pdText_DisplayString", bench_display_string, NULL, FORMAT_CALLS);
+    bench_Measure("format/pdText_DisplayStringBuf", bench_display_string_buf, NULL, FORMAT_CALLS);
+}
+
+/**
+ * Usage: bench_all [output.json]
+ *
+ * The human-readable table goes to stderr, the JSON to the given file or to stdout.
+ */
+int main(int argc, char **argv) {
+    pdUtil_InitializeAll(bench_GetFakePd());
+
+    if (!check_ascii_wrap()) {
+        pdUtil_FinalizeAll();
+        return 1;
+    }
+    run_wrap_suite();
+    run_prewrap_suite();
+    run_measure_suite();
+    run_truncate_suite();
+    run_layout_suite();
+    run_rich_suite();
+    run_bitmap_cache_suite();
+    run_draw_queue_suite();
+    run_typewriter_suite();
+    run_counter_suite();
+    run_alloc_suite();
+    run_scene_suite();
+    run_format_suite();
+
+    int result = 0;
+    if (argc > 1) {
+        FILE *out = fopen(argv[1], "w");
+        if (out == NULL) {
+            fprintf(stderr, "Cannot open %s\n", argv[1]);
+            result = 1;
+        } else {
+            bench_WriteJson(out);
+            fclose(out);
+        }
+    } else {
+        bench_WriteJson(stdout);
+    }
+
+    pdUtil_FinalizeAll();
+    return result;
+}
@@ -0,0 +1,79 @@
+/*
+ * Compares two result files of bench_all.
+ *
+ * Usage: bench_compare baseline.json current.json [threshold_percent]
+ *
+ * Prints the change of every benchmark found in both files
+ * and exits with 1 if any of them got slower by more than the threshold (10% by default).
+ * Only the layout written by bench_WriteJson (one result per line) is understood.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_RESULTS 256
+#define MAX_NAME 64
+
+typedef struct ResultTag {
+    char name[MAX_NAME];
+    double nsPerOp;
+} Result;
+
+static int load_results(const char *path, Result *results) {
+    FILE *file = fopen(path, "r");
+    if (file == NULL) {
+        fprintf(stderr, "Cannot open %s\n", path);
+        return -1;
+    }
+    int count = 0;
+    char line[512];
+    while (fgets(line, sizeof(line), file) != NULL && count < MAX_RESULTS) {
+        const char *name = strstr(line, "\"name\": \"");
+        const char *nsPerOp = strstr(line, "\"nsPerOp\": ");
+        if (name == NULL || nsPerOp == NULL) continue;
+        name += strlen("\"name\": \"");
+        const char *end = strchr(name, '"');
+        if (end == NULL || end - name >= MAX_NAME) continue;
+        memcpy(results[count].name, name, (size_t) (end - name));
+        results[count].name[end - name] = '\0';
+        results[count].nsPerOp = strtod(nsPerOp + strlen("\"nsPerOp\": "), NULL);
+        count++;
+    }
+    fclose(file);
+    return count;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        fprintf(stderr, "Usage: %s baseline.json current.json [threshold_percent]\n", argv[0]);
+        return 2;
+    }
+    double threshold = argc > 3 ? strtod(argv[3], NULL) : 10.0;
+
+    static Result baseline[MAX_RESULTS];
+    static Result current[MAX_RESULTS];
+    int baselineCount = load_results(argv[1], baseline);
+    int currentCount = load_results(argv[2], current);
+    if (baselineCount < 0 || currentCount < 0) return 2;
+
+    int regressions = 0;
+    printf("%-40s %12s %12s %9s\n", "benchmark", "baseline", "current", "change");
+    for (int i = 0; i < currentCount; i++) {
+        for (int j = 0; j < baselineCount; j++) {
+            if (strcmp(current[i].name, baseline[j].name) != 0) continue;
+            double change = baseline[j].nsPerOp > 0.0
+                            ? (current[i].nsPerOp / baseline[j].nsPerOp - 1.0) * 100.0
+                            : 0.0;
+            bool regressed = change > threshold;
+            printf(
+                "%-40s %12.2f %12.2f %+8.1f%%%s\n",
+                current[i].name, baseline[j].nsPerOp, current[i].nsPerOp, change, regressed ? "  <- slower" : ""
+            );
+            regressions += regressed ? 1 : 0;
+            break;
+        }
+    }
+    return regressions > 0 ? 1 : 0;
+}
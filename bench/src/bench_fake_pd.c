@@ -0,0 +1,301 @@
+#include "bench.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define FAKE_FONT_HEIGHT 14
+
+static bool s_console_muted = false;
+static int s_text_tracking = 0;
+static LCDBitmapDrawMode s_draw_mode = kDrawModeCopy;
+static uint64_t s_start_ns = 0;
+static uint64_t s_elapsed_reset_ns = 0;
+
+/* System */
+
+static void *fake_realloc(void *ptr, size_t size) {
+    if (size == 0) {
+        free(ptr);
+        return NULL;
+    }
+    return realloc(ptr, size);
+}
+
+static int fake_vaFormatString(char **out, const char *fmt, va_list args) {
+    va_list copy;
+    va_copy(copy, args);
+    int length = vsnprintf(NULL, 0, fmt, copy);
+    va_end(copy);
+    *out = malloc((size_t) length + 1);
+    if (*out == NULL) return -1;
+    vsnprintf(*out, (size_t) length + 1, fmt, args);
+    return length;
+}
+
+static int fake_formatString(char **out, const char *fmt, ...) {
+    va_list v_list;
+    va_start(v_list, fmt);
+    int length = fake_vaFormatString(out, fmt, v_list);
+    va_end(v_list);
+    return length;
+}
+
+static void fake_logToConsole(const char *fmt, ...) {
+    if (s_console_muted) return;
+    va_list v_list;
+    va_start(v_list, fmt);
+    vfprintf(stderr, fmt, v_list);
+    va_end(v_list);
+    fputc('\n', stderr);
+}
+
+static void fake_error(const char *fmt, ...) {
+    va_list v_list;
+    va_start(v_list, fmt);
+    fputs("error: ", stderr);
+    vfprintf(stderr, fmt, v_list);
+    va_end(v_list);
+    fputc('\n', stderr);
+    /* The device would stop here as well. */
+    abort();
+}
+
+static unsigned int fake_getCurrentTimeMilliseconds(void) {
+    return (unsigned int) ((bench_NowNs() - s_start_ns) / 1000000u);
+}
+
+static float fake_getElapsedTime(void) {
+    return (float) ((double) (bench_NowNs() - s_elapsed_reset_ns) / 1e9);
+}
+
+static void fake_resetElapsedTime(void) {
+    s_elapsed_reset_ns = bench_NowNs();
+}
+
+/* Graphics */
+
+int bench_GlyphWidth(uint32_t codepoint) {
+    if (codepoint == ' ') return 4;
+    if (codepoint >= 0x80) return 12;
+    if (strchr("il.,:;'!|1", (int) codepoint) != NULL) return 3;
+    if (strchr("mwMW@", (int) codepoint) != NULL) return 9;
+    return 6;
+}
+
+/* A few kerning pairs so that text measurement has to get pairs right. */
+static int glyph_kerning(uint32_t left, uint32_t right) {
+    if ((left == 'A' && right == 'V') || (left == 'V' && right == 'A')) return -2;
+    if (left == 'T' && (right == 'o' || right == 'y')) return -1;
+    return 0;
+}
+
+/* Decodes one UTF-8 sequence; returns its length in bytes (0 at the NUL terminator). */
+static size_t decode_utf8(const uint8_t *text, uint32_t *codepoint) {
+    if (text[0] == 0) return 0;
+    if (text[0] < 0x80) {
+        *codepoint = text[0];
+        return 1;
+    }
+    size_t length = text[0] >= 0xF0 ? 4 : text[0] >= 0xE0 ? 3 : 2;
+    *codepoint = text[0] & (0x3F >> (length - 1));
+    for (size_t i = 1; i < length; i++) {
+        if ((text[i] & 0xC0) != 0x80) {
+            *codepoint = 0xFFFD;
+            return i;
+        }
+        *codepoint = (*codepoint << 6) | (text[i] & 0x3F);
+    }
+    return length;
+}
+
+/* Like the real thing, len is a number of characters, and the text ends at a NUL terminator anyway. */
+static int fake_getTextWidth(LCDFont *font, const void *text, size_t len, PDStringEncoding encoding, int tracking) {
+    (void) font;
+    const uint8_t *cursor = text;
+    int width = 0;
+    size_t count = 0;
+    uint32_t previous = 0;
+    while (count < len) {
+        uint32_t codepoint;
+        size_t bytes;
+        if (encoding == kUTF8Encoding) {
+            bytes = decode_utf8(cursor, &codepoint);
+        } else {
+            codepoint = *cursor;
+            bytes = codepoint == 0 ? 0 : 1;
+        }
+        if (bytes == 0) break;
+        if (codepoint != '\n') {
+            width += bench_GlyphWidth(codepoint) + (count > 0 ? tracking : 0) + glyph_kerning(previous, codepoint);
+        }
+        previous = codepoint;
+        cursor += bytes;
+        count++;
+    }
+    return width;
+}
+
+static int fake_drawText(const void *text, size_t len, PDStringEncoding encoding, int x, int y) {
+    (void) x;
+    (void) y;
+    return fake_getTextWidth(NULL, text, len, encoding, s_text_tracking);
+}
+
+static LCDBitmapDrawMode fake_setDrawMode(LCDBitmapDrawMode mode) {
+    LCDBitmapDrawMode previous = s_draw_mode;
+    s_draw_mode = mode;
+    return previous;
+}
+
+static void fake_pushContext(LCDBitmap *target) {
+    (void) target;
+}
+
+static void fake_popContext(void) {
+}
+
+static LCDBitmap *fake_newBitmap(int width, int height, LCDColor bgcolor) {
+    (void) bgcolor;
+    /* Same size as the real thing (rows padded to 32 bits, plus a mask), to be fair to the allocator. */
+    return malloc((size_t) (width + 31) / 32 * 4 * (size_t) height * 2);
+}
+
+static void fake_freeBitmap(LCDBitmap *bitmap) {
+    free(bitmap);
+}
+
+static void fake_drawBitmap(LCDBitmap *bitmap, int x, int y, LCDBitmapFlip flip) {
+    (void) bitmap;
+    (void) x;
+    (void) y;
+    (void) flip;
+}
+
+static void fake_fillRect(int x, int y, int width, int height, LCDColor color) {
+    (void) x;
+    (void) y;
+    (void) width;
+    (void) height;
+    (void) color;
+}
+
+static LCDFont *fake_loadFont(const char *path, const char **outErr) {
+    (void) path;
+    *outErr = NULL;
+    /* Fonts are freed with system->realloc, so this has to be a heap block. */
+    return malloc(16);
+}
+
+static uint8_t fake_getFontHeight(LCDFont *font) {
+    (void) font;
+    return FAKE_FONT_HEIGHT;
+}
+
+static void fake_setFont(LCDFont *font) {
+    (void) font;
+}
+
+static void fake_setTextTracking(int tracking) {
+    s_text_tracking = tracking;
+}
+
+static int fake_getTextTracking(void) {
+    return s_text_tracking;
+}
+
+/* File */
+
+static const char *fake_geterr(void) {
+    return "host file operation failed";
+}
+
+static SDFile *fake_open(const char *name, FileOptions mode) {
+    const char *fopenMode = (mode & kFileAppend) ? "ab" : (mode & kFileWrite) ? "wb" : "rb";
+    return fopen(name, fopenMode);
+}
+
+static int fake_close(SDFile *file) {
+    return fclose(file);
+}
+
+static int fake_read(SDFile *file, void *buf, unsigned int len) {
+    size_t read = fread(buf, 1, len, file);
+    return ferror((FILE *) file) ? -1 : (int) read;
+}
+
+static int fake_write(SDFile *file, const void *buf, unsigned int len) {
+    size_t written = fwrite(buf, 1, len, file);
+    return written < len ? -1 : (int) written;
+}
+
+static int fake_flush(SDFile *file) {
+    return fflush(file);
+}
+
+static int fake_tell(SDFile *file) {
+    return (int) ftell(file);
+}
+
+static int fake_seek(SDFile *file, int pos, int whence) {
+    return fseek(file, pos, whence);
+}
+
+static const struct playdate_sys s_fake_sys = {
+    .realloc = fake_realloc,
+    .formatString = fake_formatString,
+    .logToConsole = fake_logToConsole,
+    .error = fake_error,
+    .getCurrentTimeMilliseconds = fake_getCurrentTimeMilliseconds,
+    .getElapsedTime = fake_getElapsedTime,
+    .resetElapsedTime = fake_resetElapsedTime,
+    .vaFormatString = fake_vaFormatString,
+};
+
+static const struct playdate_graphics s_fake_graphics = {
+    .setFont = fake_setFont,
+    .setTextTracking = fake_setTextTracking,
+    .drawText = fake_drawText,
+    .setDrawMode = fake_setDrawMode,
+    .pushContext = fake_pushContext,
+    .popContext = fake_popContext,
+    .newBitmap = fake_newBitmap,
+    .freeBitmap = fake_freeBitmap,
+    .drawBitmap = fake_drawBitmap,
+    .fillRect = fake_fillRect,
+    .loadFont = fake_loadFont,
+    .getTextWidth = fake_getTextWidth,
+    .getFontHeight = fake_getFontHeight,
+    .getTextTracking = fake_getTextTracking,
+};
+
+static const struct playdate_file s_fake_file = {
+    .geterr = fake_geterr,
+    .open = fake_open,
+    .close = fake_close,
+    .read = fake_read,
+    .write = fake_write,
+    .flush = fake_flush,
+    .tell = fake_tell,
+    .seek = fake_seek,
+};
+
+static PlaydateAPI s_fake_pd = {
+    .system = &s_fake_sys,
+    .file = &s_fake_file,
+    .graphics = &s_fake_graphics,
+};
+
+PlaydateAPI *bench_GetFakePd(void) {
+    if (s_start_ns == 0) {
+        s_start_ns = bench_NowNs();
+        s_elapsed_reset_ns = s_start_ns;
+    }
+    return &s_fake_pd;
+}
+
+void bench_SetConsoleMuted(bool muted) {
+    s_console_muted = muted;
+}
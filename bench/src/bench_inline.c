@@ -0,0 +1,63 @@
+#include "bench.h"
+
+#include <pd_shorthand.h>
+
+/* Built twice: once calling into the library, once with PD_SHORTHAND_INLINE. */
+#if defined(PD_SHORTHAND_INLINE)
+#define VARIANT "inline"
+#else
+#define VARIANT "library"
+#endif
+
+#define PAIRS 4000000
+#define GROW_ROUNDS 20000
+#define GROW_STEPS 64
+#define LOG_LINES 2000000
+
+static char s_log_storage[64 * 1024];
+
+/* Allocation immediately followed by a free: measures the call overhead more than the allocator. */
+static void run_pairs(void) {
+    uint64_t start = bench_NowNs();
+    for (int i = 0; i < PAIRS; i++) {
+        void *volatile ptr = pd_Malloc(32);
+        pd_Free(ptr);
+    }
+    bench_Report(VARIANT "/malloc+free", bench_NowNs() - start, (uint64_t) PAIRS * 2);
+}
+
+/* Growing a buffer step by step, like a string being appended to. */
+static void run_grow(void) {
+    uint64_t start = bench_NowNs();
+    for (int round = 0; round < GROW_ROUNDS; round++) {
+        void *ptr = NULL;
+        for (int step = 1; step <= GROW_STEPS; step++) {
+            ptr = pd_Realloc(ptr, (size_t) step * 16);
+        }
+        pd_Free(ptr);
+    }
+    bench_Report(VARIANT "/realloc", bench_NowNs() - start, (uint64_t) GROW_ROUNDS * (GROW_STEPS + 1));
+}
+
+/* Logging into the log buffer, so that the console isn't what's being measured. */
+static void run_log(void) {
+    pd_LogBufferEnable(s_log_storage, sizeof(s_log_storage), 0);
+    uint64_t start = bench_NowNs();
+    for (int i = 0; i < LOG_LINES; i++) {
+        pd_Log("enemy spawned");
+    }
+    uint64_t elapsed = bench_NowNs() - start;
+    bench_SetConsoleMuted(true);
+    pd_LogBufferDisable();
+    bench_SetConsoleMuted(false);
+    bench_Report(VARIANT "/pd_Log (buffered)", elapsed, LOG_LINES);
+}
+
+int main(void) {
+    pd_Initialize(bench_GetFakePd());
+    run_pairs();
+    run_grow();
+    run_log();
+    pd_Finalize();
+    return 0;
+}
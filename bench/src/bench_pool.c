@@ -0,0 +1,88 @@
+#include "bench.h"
+
+#include <stdio.h>
+#include <pd_shorthand.h>
+
+#define OBJECT_SIZE 32
+#define LIVE_OBJECTS 1024
+#define ROUNDS 2000
+#define CHURN_STEPS (LIVE_OBJECTS * ROUNDS)
+
+typedef void *(*AllocFunction)(void *ctx);
+
+typedef void (*FreeFunction)(void *ctx, void *ptr);
+
+static void *s_objects[LIVE_OBJECTS];
+
+static void *malloc_alloc(void *ctx) {
+    (void) ctx;
+    return pd_Malloc(OBJECT_SIZE);
+}
+
+static void malloc_free(void *ctx, void *ptr) {
+    (void) ctx;
+    pd_Free(ptr);
+}
+
+static void *pool_alloc(void *ctx) {
+    return pd_PoolAlloc(ctx);
+}
+
+static void pool_free(void *ctx, void *ptr) {
+    pd_PoolFree(ctx, ptr);
+}
+
+/* Allocate a whole wave of objects, then free all of them (e.g., a bullet pattern ending). */
+static void run_burst(const char *name, AllocFunction alloc, FreeFunction release, void *ctx) {
+    uint64_t start = bench_NowNs();
+    for (int round = 0; round < ROUNDS; round++) {
+        for (int i = 0; i < LIVE_OBJECTS; i++) {
+            s_objects[i] = alloc(ctx);
+        }
+        for (int i = 0; i < LIVE_OBJECTS; i++) {
+            release(ctx, s_objects[i]);
+        }
+    }
+    bench_Report(name, bench_NowNs() - start, (uint64_t) ROUNDS * LIVE_OBJECTS * 2);
+}
+
+/* Keep a steady number of objects alive, replacing a random one each step (e.g., particles). */
+static void run_churn(const char *name, AllocFunction alloc, FreeFunction release, void *ctx) {
+    uint32_t rng = 0x12345678u;
+    for (int i = 0; i < LIVE_OBJECTS; i++) {
+        s_objects[i] = alloc(ctx);
+    }
+    uint64_t start = bench_NowNs();
+    for (int step = 0; step < CHURN_STEPS; step++) {
+        uint32_t index = bench_Random(&rng) % LIVE_OBJECTS;
+        release(ctx, s_objects[index]);
+        s_objects[index] = alloc(ctx);
+    }
+    uint64_t elapsed = bench_NowNs() - start;
+    for (int i = 0; i < LIVE_OBJECTS; i++) {
+        release(ctx, s_objects[i]);
+    }
+    bench_Report(name, elapsed, (uint64_t) CHURN_STEPS * 2);
+}
+
+int main(void) {
+    pd_Initialize(bench_GetFakePd());
+
+    PDPool pool;
+    PDPool debugPool;
+    pd_PoolInit(&pool, OBJECT_SIZE, 0, 128, false);
+    pd_PoolInit(&debugPool, OBJECT_SIZE, 0, 128, true);
+
+    run_burst("burst/pd_Malloc", malloc_alloc, malloc_free, NULL);
+    run_burst("burst/pd_Pool", pool_alloc, pool_free, &pool);
+    run_burst("burst/pd_Pool (debug)", pool_alloc, pool_free, &debugPool);
+
+    run_churn("churn/pd_Malloc", malloc_alloc, malloc_free, NULL);
+    run_churn("churn/pd_Pool", pool_alloc, pool_free, &pool);
+    run_churn("churn/pd_Pool (debug)", pool_alloc, pool_free, &debugPool);
+
+    pd_PoolRelease(&pool);
+    pd_PoolRelease(&debugPool);
+    pd_Finalize();
+    return 0;
+}
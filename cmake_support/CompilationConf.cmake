@@ -11,6 +11,29 @@ if (NOT DEFINED SOURCES)
     message(FATAL_ERROR "No sources given, set SOURCES prior to including CompilationConf.cmake.")
 endif ()
 
+# Build variants, so that games can pick throughput or code size.
+# Meant for device builds; they apply to the simulator build too so the host benchmarks can compare them.
+set(PD_UTILS_OPTIMIZATION "" CACHE STRING
+        "Optimization level of Release builds: empty (-O2), O3 (throughput) or Os (size)")
+set_property(CACHE PD_UTILS_OPTIMIZATION PROPERTY STRINGS "" O3 Os)
+option(PD_UTILS_LTO "Build the libraries with link-time optimization (-flto)" OFF)
+
+set(VARIANT_CXX_FLAGS)
+if (NOT CMAKE_BUILD_TYPE STREQUAL "Debug")
+    if (PD_UTILS_OPTIMIZATION STREQUAL "O3")
+        list(APPEND VARIANT_CXX_FLAGS -O3)
+    elseif (PD_UTILS_OPTIMIZATION STREQUAL "Os")
+        list(APPEND VARIANT_CXX_FLAGS -Os)
+    elseif (NOT PD_UTILS_OPTIMIZATION STREQUAL "")
+        message(FATAL_ERROR "PD_UTILS_OPTIMIZATION must be empty, O3 or Os (got ${PD_UTILS_OPTIMIZATION}).")
+    endif ()
+endif ()
+if (PD_UTILS_LTO)
+    # Fat objects keep regular code next to the LTO bytecode,
+    # so games that don't link with -flto can still use the libraries.
+    list(APPEND VARIANT_CXX_FLAGS -flto -ffat-lto-objects)
+endif ()
+
 set(GENERAL_INCLUDE ${CMAKE_SOURCE_DIR}/include)
 set(SELF_INCLUDE ${CMAKE_CURRENT_SOURCE_DIR}/src)
 file(GLOB INC_FILES ${CMAKE_CURRENT_SOURCE_DIR}/src/*.h)
@@ -22,7 +45,7 @@ if (TOOLCHAIN STREQUAL "armgcc")
     if (DEFINED DEPENDENCIES)
         target_link_libraries(${LIB_NAME} PRIVATE ${DEPENDENCIES})
     endif ()
-    target_compile_options(${LIB_NAME} PRIVATE ${BASE_CXX_FLAGS} ${EXTRA_CXX_FLAGS})
+    target_compile_options(${LIB_NAME} PRIVATE ${BASE_CXX_FLAGS} ${EXTRA_CXX_FLAGS} ${VARIANT_CXX_FLAGS})
     install(FILES ${INC_FILES} DESTINATION include PERMISSIONS OWNER_READ OWNER_WRITE GROUP_READ WORLD_READ)
     install(TARGETS ${LIB_NAME} LIBRARY DESTINATION lib)
 else ()
@@ -37,7 +60,7 @@ else ()
         endforeach ()
         target_link_libraries(${LIB_NAME_SIM} PRIVATE ${DEPENDENCIES_SIM})
     endif ()
-    target_compile_options(${LIB_NAME_SIM} PRIVATE ${BASE_CXX_FLAGS} ${EXTRA_CXX_FLAGS})
+    target_compile_options(${LIB_NAME_SIM} PRIVATE ${BASE_CXX_FLAGS} ${EXTRA_CXX_FLAGS} ${VARIANT_CXX_FLAGS})
     install(FILES ${INC_FILES} DESTINATION include PERMISSIONS OWNER_READ OWNER_WRITE GROUP_READ WORLD_READ)
     install(TARGETS ${LIB_NAME_SIM} LIBRARY DESTINATION lib)
 endif ()
@@ -2,6 +2,7 @@
 
 #include <pd_api.h>
 #include <pd_shorthand.h>
+#include <string.h>
 
 
 /**
@@ -14,12 +15,23 @@ static Scene invalid_scene = {PD_SCENE_INVALID_SCENE_ID, NULL, NULL, NULL, NULL}
 /**
  * @brief Scene registration struct
  *
- * Implemented as an appendable array
+ * Scenes are either appended to an array on the heap, or taken from a static table (pdScene_RegisterTable).
+ * Lookup goes through @c slots , an open-addressed table of twice as many entries as scenes indexed by
+ * the identifier modulo its size, so scenes numbered from 0 land in their own slot.
  */
 typedef struct SceneRegistrationTag {
-    Scene **scenes;
+    const Scene *const *scenes;
     int32_t count;
     int32_t capacity;
+    /* Scenes registered one by one, the same array as scenes; NULL with a static table */
+    const Scene **owned;
+    const Scene **slots;
+    uint32_t slotCount;
+    /* Whether slots matches the scenes; registering a scene clears it */
+    bool sealed;
+    /* Whether the scenes and slots come from a static table */
+    bool fromTable;
+    bool initialized;
 } SceneRegistration;
 
 /**
@@ -31,14 +43,44 @@ typedef union SceneLoaderTag {
 } SceneLoader;
 
 static PlaydateAPI *s_pd;
-static Scene *s_currentScene = &invalid_scene;
+static const Scene *s_currentScene = &invalid_scene;
 static SceneRegistration s_registrations = {0};
 
 void pdScene_Initialize(void *pd) {
     s_pd = pd;
-    s_registrations.scenes = pd_Malloc(sizeof(Scene *));
-    s_registrations.count = 0;
-    s_registrations.capacity = 1;
+    /* Nothing is allocated until the first scene is registered. */
+    memset(&s_registrations, 0, sizeof(SceneRegistration));
+    s_registrations.initialized = true;
+}
+
+/* Makes room for the given number of scenes in one allocation. */
+static bool reserve(int32_t capacity) {
+    if (capacity <= s_registrations.capacity) return true;
+    void *newPtr = pd_Realloc(s_registrations.owned, sizeof(Scene *) * capacity);
+    if (newPtr == NULL) {
+        /* Honestly, if you trigger this, you REALLY need to consider how to manager RAM usage... */
+        s_pd->system->error("Allocation failure during scene registration... (registration capacity %d)", capacity);
+        return false;
+    }
+    s_registrations.owned = newPtr;
+    s_registrations.scenes = s_registrations.owned;
+    s_registrations.capacity = capacity;
+    return true;
+}
+
+static bool can_register(void) {
+    if (!s_registrations.initialized) {
+        /* NOTE: This error message wouldn't be shown if the user forgets to initialize us, because s_pd is NULL */
+        s_pd->system->error(
+            "Scene registration is closed - did you initialize this library or accidentally finalize it?"
+        );
+        return false;
+    }
+    if (s_registrations.fromTable) {
+        s_pd->system->error("Scenes come from a static table; add this scene to the table instead.");
+        return false;
+    }
+    return true;
 }
 
 void pdScene_RegisterBulk(void **scenes, size_t count) {
@@ -46,6 +88,7 @@ void pdScene_RegisterBulk(void **scenes, size_t count) {
         s_pd->system->error("Invalid scene count passed.");
         return;
     }
+    if (!can_register() || !reserve(s_registrations.count + (int32_t) count)) return;
 
     for (int i = 0; i < count; i++) {
         pdScene_Register(scenes[i]);
@@ -53,13 +96,7 @@ void pdScene_RegisterBulk(void **scenes, size_t count) {
 }
 
 void pdScene_Register(void *rawScene) {
-    if (s_registrations.capacity == 0) {
-        /* NOTE: This error message wouldn't be shown if the user forgets to initialize us, because s_pd is NULL */
-        s_pd->system->error(
-            "Registration capacity is set to 0 - did you initialize this library or accidentally finalize it?"
-        );
-        return;
-    }
+    if (!can_register()) return;
 
     SceneLoader loader = {rawScene};
     Scene *scene = loader.scene;
@@ -68,23 +105,80 @@ void pdScene_Register(void *rawScene) {
         return;
     }
     if (s_registrations.count == s_registrations.capacity) {
-        s_registrations.capacity *= 2;
-        void *newPtr = pd_Realloc(s_registrations.scenes, sizeof(Scene *) * s_registrations.capacity);
+        int32_t capacity = s_registrations.capacity == 0 ? PD_SCENE_INITIAL_CAPACITY : s_registrations.capacity * 2;
+        if (!reserve(capacity)) return;
+    }
+    s_registrations.owned[s_registrations.count] = scene;
+    s_registrations.count++;
+    s_registrations.sealed = false;
+}
+
+/* Fills the lookup slots, failing on the first identifier that is registered twice. */
+static bool fill_slots(void) {
+    memset(s_registrations.slots, 0, sizeof(Scene *) * s_registrations.slotCount);
+    for (int32_t i = 0; i < s_registrations.count; i++) {
+        const Scene *scene = s_registrations.scenes[i];
+        uint32_t slot = scene->sceneIdentifier % s_registrations.slotCount;
+        while (s_registrations.slots[slot] != NULL) {
+            if (s_registrations.slots[slot]->sceneIdentifier == scene->sceneIdentifier) {
+                s_pd->system->error("Scene identifier %u is registered twice.", (unsigned) scene->sceneIdentifier);
+                return false;
+            }
+            slot = slot + 1 == s_registrations.slotCount ? 0 : slot + 1;
+        }
+        s_registrations.slots[slot] = scene;
+    }
+    return true;
+}
+
+void pdScene_Seal(void) {
+    if (s_registrations.sealed || s_registrations.count == 0) return;
+    /* Tables have their slots already; only scenes registered one by one get theirs allocated. */
+    uint32_t slotCount = (uint32_t) s_registrations.count * 2;
+    if (slotCount > s_registrations.slotCount) {
+        void *newPtr = pd_Realloc(s_registrations.slots, sizeof(Scene *) * slotCount);
         if (newPtr == NULL) {
-            /* Honestly, if you trigger this, you REALLY need to consider how to manager RAM usage... */
-            s_pd->system->error(
-                "Allocation failure during scene registration... (tried to register ID %d, registration capacity %d)",
-                scene->sceneIdentifier,
-                s_registrations.capacity
-            );
+            s_pd->system->error("Allocation failure while sealing %d scenes.", s_registrations.count);
             return;
         }
-        s_registrations.scenes = newPtr;
+        s_registrations.slots = newPtr;
+        s_registrations.slotCount = slotCount;
     }
-    s_registrations.scenes[s_registrations.count] = scene;
-    s_registrations.count++;
+    s_registrations.sealed = fill_slots();
 }
 
+void pdScene_RegisterTable(const PDSceneTable *table) {
+    if (!can_register()) return;
+    if (s_registrations.count > 0) {
+        s_pd->system->error("Scenes have been registered already; put all of them in the static table.");
+        return;
+    }
+    for (size_t i = 0; i < table->count; i++) {
+        if (table->scenes[i]->sceneIdentifier == PD_SCENE_INVALID_SCENE_ID) {
+            s_pd->system->error("%d is reserved as invalid scene ID. Please don't use it.", PD_SCENE_INVALID_SCENE_ID);
+            return;
+        }
+    }
+    s_registrations.scenes = table->scenes;
+    s_registrations.count = (int32_t) table->count;
+    s_registrations.slots = table->slots;
+    s_registrations.slotCount = (uint32_t) table->count * 2;
+    s_registrations.fromTable = true;
+    s_registrations.sealed = fill_slots();
+}
+
+static const Scene *find_scene(SceneIdentifier sceneIdentifier) {
+    if (!s_registrations.sealed) {
+        pdScene_Seal();
+        if (!s_registrations.sealed) return NULL;
+    }
+    uint32_t slot = sceneIdentifier % s_registrations.slotCount;
+    while (s_registrations.slots[slot] != NULL) {
+        if (s_registrations.slots[slot]->sceneIdentifier == sceneIdentifier) return s_registrations.slots[slot];
+        slot = slot + 1 == s_registrations.slotCount ? 0 : slot + 1;
+    }
+    return NULL;
+}
 
 void pdScene_Load(const SceneIdentifier sceneIdentifier, const void *data) {
     pdScene_Unload();
@@ -94,41 +188,60 @@ void pdScene_Load(const SceneIdentifier sceneIdentifier, const void *data) {
         return;
     }
 
-    for (int i = 0; i < s_registrations.count; i++) {
-        Scene *scene = s_registrations.scenes[i];
-        if (sceneIdentifier == scene->sceneIdentifier) {
-            s_currentScene = scene;
-            if (s_currentScene->initFunction != NULL) {
-                s_currentScene->initFunction(s_pd, data);
-            }
-            return;
-        }
+    const Scene *scene = find_scene(sceneIdentifier);
+    if (scene == NULL) {
+        s_pd->system->error("Scene with identifier %d not found...", sceneIdentifier);
+        s_currentScene = &invalid_scene;
+        return;
+    }
+    s_currentScene = scene;
+    pd_SetAllocationTag(sceneIdentifier);
+    if (s_currentScene->initFunction != NULL) {
+        pd_ProfileBegin("scene/init");
+        s_currentScene->initFunction(s_pd, data);
+        pd_ProfileEnd();
     }
-
-    s_pd->system->error("Scene with identifier %d not found...", sceneIdentifier);
-    s_currentScene = &invalid_scene;
 }
 
 void pdScene_Unload(void) {
     if (s_currentScene->unloadFunction != NULL) {
+        pd_ProfileBegin("scene/unload");
         s_currentScene->unloadFunction();
+        pd_ProfileEnd();
     }
+    pd_ArenaRelease(pd_GetSceneArena());
+    pd_SetAllocationTag(PD_MEMORY_UNTAGGED);
     s_currentScene = &invalid_scene;
 }
 
 int32_t pdScene_Update(void) {
-    if (s_currentScene->updateFunction == NULL) return 0;
-    return s_currentScene->updateFunction();
+    int32_t result = 0;
+    if (s_currentScene->updateFunction != NULL) {
+        pd_ProfileBegin("scene/update");
+        result = s_currentScene->updateFunction();
+        pd_ProfileEnd();
+    }
+    pd_ArenaReset(pd_GetFrameArena());
+    pd_TraceNextFrame();
+    pd_LogBufferNextFrame();
+    pd_ProfileDrawOverlay();
+    pd_ProfileNextFrame();
+    return result;
 }
 
 int32_t pdScene_EventHandler(uint32_t eventType, uint32_t arg) {
     if (s_currentScene->eventFunction == NULL) return 0;
-    return s_currentScene->eventFunction(eventType, arg);
+    pd_ProfileBegin("scene/event");
+    int32_t result = s_currentScene->eventFunction(eventType, arg);
+    pd_ProfileEnd();
+    return result;
 }
 
 void pdScene_Finalize(void) {
     pdScene_Unload();
-    pd_Free(s_registrations.scenes);
-    s_registrations.count = 0;
-    s_registrations.capacity = 0;
+    if (!s_registrations.fromTable) {
+        pd_Free(s_registrations.owned);
+        pd_Free(s_registrations.slots);
+    }
+    memset(&s_registrations, 0, sizeof(SceneRegistration));
 }
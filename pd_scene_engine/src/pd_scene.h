@@ -81,8 +81,9 @@
 /**
  * @brief An unsigned integer to identify given scene.
  *
- * This value must be unique throughout the game.
- * Having scenes with the same identifier value leads to undefined behavior.
+ * This value must be unique throughout the game;
+ * two scenes with the same identifier cause an e1 crash when the scenes are sealed (see pdScene_Seal()).
+ * Numbering scenes from 0 up makes their lookup a single array access.
  *
  * @remarks UINT32_MAX cannot be used because it is reserved as an 'invalid scene' identifier.
  */
@@ -152,6 +153,48 @@ typedef struct SceneTag {
     const SceneEventFunction eventFunction;
 } Scene;
 
+/**
+ * @brief A list of scenes fixed at compile time, declared with #PD_SCENE_TABLE.
+ *
+ * Registering it with pdScene_RegisterTable(const PDSceneTable*) uses the table in place, without heap allocation.
+ */
+typedef struct PDSceneTableTag {
+    /** @brief The scenes. */
+    const Scene *const *scenes;
+    size_t count;
+    /** @brief Lookup slots filled at registration, twice as many as scenes. */
+    const Scene **slots;
+} PDSceneTable;
+
+/**
+ * @def PD_SCENE_TABLE
+ * @brief Declares a static #PDSceneTable of the given scene pointers, along with the storage for its lookup slots.
+ *
+ * @code
+ * extern const Scene title_scene; // defined in title.c
+ * extern const Scene game_scene;
+ *
+ * PD_SCENE_TABLE(s_scenes, &title_scene, &game_scene);
+ *
+ * pdScene_RegisterTable(&s_scenes);
+ * @endcode
+ */
+#define PD_SCENE_TABLE(name, ...) \
+    static const Scene *const name##Scenes[] = {__VA_ARGS__}; \
+    static const Scene *name##Slots[2 * (sizeof(name##Scenes) / sizeof(name##Scenes[0]))]; \
+    static const PDSceneTable name = {name##Scenes, sizeof(name##Scenes) / sizeof(name##Scenes[0]), name##Slots}
+
+#ifndef PD_SCENE_INITIAL_CAPACITY
+/**
+ * @def PD_SCENE_INITIAL_CAPACITY
+ * @brief Number of scenes pdScene_Register(void*) makes room for the first time; the room doubles when full.
+ *
+ * Define this when building the library to change it. pdScene_RegisterBulk(void**, size_t) makes room for all
+ * of its scenes at once.
+ */
+#define PD_SCENE_INITIAL_CAPACITY 16
+#endif
+
 /**
  * @brief Initialize scene switcher engine.
  *
@@ -160,6 +203,7 @@ typedef struct SceneTag {
  * preferably at the kEventInit stage.
  *
  * @param[in] pd Playdate API context object
+ * @remarks Nothing is allocated until the first scene is registered.
  */
 void pdScene_Initialize(void *pd);
 
@@ -183,6 +227,31 @@ void pdScene_Register(void *scene);
  */
 void pdScene_RegisterBulk(void **scene, size_t count);
 
+/**
+ * @brief Registers the scenes of a static table declared with #PD_SCENE_TABLE, without allocating anything.
+ *
+ * The table is sealed right away (see pdScene_Seal()).
+ * It must be the only registration: pdScene_Register(void*) and pdScene_RegisterBulk(void**, size_t)
+ * cause an e1 crash afterward, as does this if scenes have been registered before.
+ *
+ * @param[in] table Table of scenes; it must stay valid until pdScene_Finalize().
+ * @warning A scene with the identifier #PD_SCENE_INVALID_SCENE_ID, or two scenes with the same identifier,
+ *          cause an e1 crash.
+ */
+void pdScene_RegisterTable(const PDSceneTable *table);
+
+/**
+ * @brief Builds the lookup table of the registered scenes, so that pdScene_Load(SceneIdentifier, const void*)
+ *        finds any of them in constant time.
+ *
+ * The first pdScene_Load(SceneIdentifier, const void*) seals the scenes if this has not been called;
+ * call this after registering them all to do it at startup instead.
+ * Registering another scene afterward unseals them, and they are sealed again on the next load.
+ *
+ * @warning Two scenes with the same identifier cause an e1 crash.
+ */
+void pdScene_Seal(void);
+
 /**
  * @brief Load a scene while passing a data.
  *
@@ -192,6 +261,7 @@ void pdScene_RegisterBulk(void **scene, size_t count);
  *
  * @param[in] sceneIdentifier identifier assigned to Scene registered using pdScene_Register(void*).
  * @param[in] data            data to pass to the scene.
+ * @remarks The scene is found in constant time; the first load after registering seals the scenes (see pdScene_Seal()).
  * @warning If the scene with sceneIdentifier isn't registered, this will trigger an e1 crash.
  * @see pdScene_Register
  */
@@ -204,6 +274,8 @@ void pdScene_Load(SceneIdentifier sceneIdentifier, const void *data);
  * as it will cause a softlock unless you call pdScene_Load immediately after,
  * but if a memory consumption can be an issue,
  * this can be called to trigger the unloading function of the current scene.
+ *
+ * After the unloading function returns, the scene arena (@c pd_GetSceneArena) is released.
  */
 void pdScene_Unload(void);
 
@@ -216,6 +288,12 @@ void pdScene_Unload(void);
  * @remarks Playdate API context object will not be available here.
  *          To reference it, you must have assigned it to a static variable
  *          during the initialization function of the scene.
+ * @remarks The frame arena (@c pd_GetFrameArena) is reset after the update function returns.
+ *          The frame number of the allocation trace (@c pd_TraceNextFrame)
+ *          and the frame counter of the log buffer (@c pd_LogBufferNextFrame) are advanced as well.
+ * @remarks The update function is timed as the @c "scene/update" profiler scope.
+ *          Afterward, the profiler overlay is drawn (if visible) and the profiler frame ends
+ *          (@c pd_ProfileNextFrame).
  */
 int32_t pdScene_Update(void);
 
@@ -0,0 +1,123 @@
+#include "pd_shorthand.h"
+
+#include <stdint.h>
+
+/**
+ * @brief A chunk of memory the arena bumps through.
+ *
+ * The usable area starts right after this header.
+ */
+struct PDArenaBlockTag {
+    PDArenaBlock *next;
+    size_t capacity;
+    size_t used;
+};
+
+static PDArena s_frame_arena = {NULL, NULL, PD_FRAME_ARENA_BLOCK_SIZE};
+static PDArena s_scene_arena = {NULL, NULL, PD_SCENE_ARENA_BLOCK_SIZE};
+
+static uint8_t *block_data(PDArenaBlock *block) {
+    return (uint8_t *) (block + 1);
+}
+
+/**
+ * @brief Tries to carve @c size bytes out of @c block.
+ *
+ * @returns The aligned pointer, or NULL if the block doesn't have enough room left.
+ */
+static void *block_alloc(PDArenaBlock *block, size_t size, size_t alignment) {
+    uintptr_t base = (uintptr_t) block_data(block);
+    uintptr_t start = (base + block->used + (alignment - 1)) & ~((uintptr_t) alignment - 1);
+    if (start + size > base + block->capacity) return NULL;
+    block->used = (size_t) (start - base) + size;
+    return (void *) start;
+}
+
+void pd_ArenaInit(PDArena *arena, size_t blockSize) {
+    arena->head = NULL;
+    arena->current = NULL;
+    arena->blockSize = blockSize == 0 ? PD_ARENA_DEFAULT_BLOCK_SIZE : blockSize;
+}
+
+void *pd_ArenaAlloc(PDArena *arena, size_t size) {
+    return pd_ArenaAllocAligned(arena, size, PD_ARENA_ALIGNMENT);
+}
+
+void *pd_ArenaAllocAligned(PDArena *arena, size_t size, size_t alignment) {
+    if (alignment == 0 || (alignment & (alignment - 1)) != 0) {
+        pd_ErrorF("Arena alignment must be a power of two (got %d).", (int) alignment);
+        return NULL;
+    }
+
+    /* Blocks after the current one are left over from before a reset/rewind and are free to reuse. */
+    PDArenaBlock *last = arena->current;
+    for (PDArenaBlock *block = arena->current; block != NULL; block = block->next) {
+        if (block != arena->current) {
+            block->used = 0;
+        }
+        void *ptr = block_alloc(block, size, alignment);
+        if (ptr != NULL) {
+            arena->current = block;
+            return ptr;
+        }
+        last = block;
+    }
+
+    size_t capacity = size + alignment - 1;
+    if (capacity < arena->blockSize) {
+        capacity = arena->blockSize;
+    }
+    PDArenaBlock *block = pd_Malloc(sizeof(PDArenaBlock) + capacity);
+    if (block == NULL) return NULL;
+    block->next = NULL;
+    block->capacity = capacity;
+    block->used = 0;
+
+    if (last == NULL) {
+        arena->head = block;
+    } else {
+        last->next = block;
+    }
+    arena->current = block;
+    return block_alloc(block, size, alignment);
+}
+
+PDArenaMark pd_ArenaGetMark(const PDArena *arena) {
+    PDArenaMark mark = {arena->current, arena->current != NULL ? arena->current->used : 0};
+    return mark;
+}
+
+void pd_ArenaRewind(PDArena *arena, PDArenaMark mark) {
+    if (mark.block == NULL) {
+        pd_ArenaReset(arena);
+        return;
+    }
+    arena->current = mark.block;
+    arena->current->used = mark.offset;
+}
+
+void pd_ArenaReset(PDArena *arena) {
+    arena->current = arena->head;
+    if (arena->current != NULL) {
+        arena->current->used = 0;
+    }
+}
+
+void pd_ArenaRelease(PDArena *arena) {
+    PDArenaBlock *block = arena->head;
+    while (block != NULL) {
+        PDArenaBlock *next = block->next;
+        pd_Free(block);
+        block = next;
+    }
+    arena->head = NULL;
+    arena->current = NULL;
+}
+
+PDArena *pd_GetFrameArena(void) {
+    return &s_frame_arena;
+}
+
+PDArena *pd_GetSceneArena(void) {
+    return &s_scene_arena;
+}
@@ -0,0 +1,724 @@
+#include "pd_shorthand.h"
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/* Layout of an IEEE 754 double */
+#define FORMAT_DOUBLE_MANTISSA_BITS 52
+#define FORMAT_DOUBLE_EXPONENT_BIAS 1023
+#define FORMAT_DOUBLE_MAX_EXP 1024
+/* Hexadecimal digits after the point in %a, and decimal digits of precision of a double (rounded up) */
+#define FORMAT_DOUBLE_HEX_DIGITS 13
+#define FORMAT_DOUBLE_DIGITS 17
+
+/* Base of the words a double is expanded into for %f, %e and %g */
+#define FORMAT_WORD_BASE 1000000000u
+/*
+ * The 53-bit mantissa takes 2 words; shifting it right by up to 1074 bits adds at most one word per 9 bits,
+ * and the largest double (309 digits) needs 35.
+ */
+#define FORMAT_FLOAT_WORDS (2 + (1074 + 8) / 9 + 2)
+
+typedef struct FormatOutputTag {
+    char *out;
+    size_t capacity;
+    size_t length;
+} FormatOutput;
+
+typedef struct FormatSpecTag {
+    bool leftAlign;
+    bool zeroPad;
+    bool alternate;
+    char sign;
+    int width;
+    int precision;
+} FormatSpec;
+
+static void put_char(FormatOutput *output, char c) {
+    if (output->length + 1 < output->capacity) {
+        output->out[output->length] = c;
+    }
+    output->length++;
+}
+
+static void put_padding(FormatOutput *output, char c, int count) {
+    for (int i = 0; i < count; i++) {
+        put_char(output, c);
+    }
+}
+
+/**
+ * @brief Writes a number whose digits are already rendered, applying sign, prefix, precision and width.
+ */
+static void put_number(FormatOutput *output, const FormatSpec *spec, const char *prefix, const char *digits, int count) {
+    int prefixLength = (int) strlen(prefix);
+    int zeros = spec->precision > count ? spec->precision - count : 0;
+    int padding = spec->width - prefixLength - zeros - count;
+    if (padding < 0) {
+        padding = 0;
+    }
+    /* As in printf, '0' is ignored when a precision is given. */
+    bool zeroPad = spec->zeroPad && !spec->leftAlign && spec->precision < 0;
+    if (zeroPad) {
+        zeros += padding;
+        padding = 0;
+    }
+
+    if (!spec->leftAlign) {
+        put_padding(output, ' ', padding);
+    }
+    for (int i = 0; i < prefixLength; i++) {
+        put_char(output, prefix[i]);
+    }
+    put_padding(output, '0', zeros);
+    for (int i = 0; i < count; i++) {
+        put_char(output, digits[i]);
+    }
+    if (spec->leftAlign) {
+        put_padding(output, ' ', padding);
+    }
+}
+
+static int render_unsigned(char *buf, uint64_t value, unsigned base, bool upper) {
+    const char *table = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+    char reversed[24];
+    int count = 0;
+    do {
+        reversed[count++] = table[value % base];
+        value /= base;
+    } while (value != 0);
+    for (int i = 0; i < count; i++) {
+        buf[i] = reversed[count - 1 - i];
+    }
+    return count;
+}
+
+static void put_integer(FormatOutput *output, FormatSpec *spec, uint64_t magnitude, bool negative, unsigned base, bool upper) {
+    char digits[24];
+    int count = render_unsigned(digits, magnitude, base, upper);
+    /* printf prints nothing for a zero with an explicit precision of zero. */
+    if (magnitude == 0 && spec->precision == 0) {
+        count = 0;
+    }
+
+    char prefix[4] = {0};
+    int p = 0;
+    if (negative) {
+        prefix[p++] = '-';
+    } else if (spec->sign != 0) {
+        prefix[p++] = spec->sign;
+    }
+    if (spec->alternate && base == 16 && magnitude != 0) {
+        prefix[p++] = '0';
+        prefix[p++] = upper ? 'X' : 'x';
+    } else if (spec->alternate && base == 8) {
+        /* '#' only makes sure the first octal digit is a zero, even for a zero with a precision of zero. */
+        if (count == 0) {
+            digits[count++] = '0';
+        } else if (magnitude != 0 && spec->precision <= count) {
+            prefix[p++] = '0';
+        }
+    }
+    put_number(output, spec, prefix, digits, count);
+}
+
+/**
+ * @brief Writes the padding and the sign or prefix in front of a float of @c length characters.
+ *
+ * Unlike for integers, '0' still applies when a precision is given.
+ *
+ * @returns Padding still to be written after the number (when left-aligned).
+ */
+static int put_float_start(FormatOutput *output, const FormatSpec *spec, const char *prefix, int length) {
+    int prefixLength = (int) strlen(prefix);
+    int padding = spec->width - prefixLength - length;
+    if (padding < 0) {
+        padding = 0;
+    }
+    if (!spec->leftAlign && !spec->zeroPad) {
+        put_padding(output, ' ', padding);
+        padding = 0;
+    }
+    for (int i = 0; i < prefixLength; i++) {
+        put_char(output, prefix[i]);
+    }
+    if (!spec->leftAlign) {
+        put_padding(output, '0', padding);
+        padding = 0;
+    }
+    return padding;
+}
+
+static void put_chars(FormatOutput *output, const char *chars, int count) {
+    for (int i = 0; i < count; i++) {
+        put_char(output, chars[i]);
+    }
+}
+
+/**
+ * @brief Renders a base 10^9 word as exactly 9 digits.
+ */
+static void render_word(char *buf, uint32_t word) {
+    for (int i = 8; i >= 0; i--) {
+        buf[i] = (char) ('0' + word % 10);
+        word /= 10;
+    }
+}
+
+/**
+ * @brief Writes the exponent of @c e and @c a conversions ("e+05", "p-3") into @c buf and returns its length.
+ */
+static int render_exponent(char *buf, char letter, int exponent, int minDigits) {
+    int count = 0;
+    buf[count++] = letter;
+    buf[count++] = exponent < 0 ? '-' : '+';
+    char digits[12];
+    int digitCount = render_unsigned(digits, (uint64_t) (exponent < 0 ? -exponent : exponent), 10, false);
+    for (int i = digitCount; i < minDigits; i++) {
+        buf[count++] = '0';
+    }
+    memcpy(buf + count, digits, digitCount);
+    return count + digitCount;
+}
+
+/**
+ * @brief Writes mantissa * 2^exponent2 for the @c a and @c A conversions, like glibc (normalized, "0x1.8p+1").
+ */
+static void put_hex_float(
+    FormatOutput *output,
+    const FormatSpec *spec,
+    const char *sign,
+    uint64_t mantissa,
+    int exponentBits,
+    char conversion
+) {
+    bool upper = conversion == 'A';
+    /* Subnormals are written as "0x0.xxxp-1022", as glibc does. */
+    uint32_t lead = exponentBits != 0 ? 1 : 0;
+    int exponent = exponentBits != 0 ? exponentBits - FORMAT_DOUBLE_EXPONENT_BIAS
+                                     : (mantissa != 0 ? 1 - FORMAT_DOUBLE_EXPONENT_BIAS : 0);
+    int digitCount = FORMAT_DOUBLE_HEX_DIGITS;
+    int extraZeros = 0;
+    if (spec->precision < 0) {
+        /* Shortest exact representation */
+        while (digitCount > 0 && (mantissa & 0xF) == 0) {
+            mantissa >>= 4;
+            digitCount--;
+        }
+    } else if (spec->precision < FORMAT_DOUBLE_HEX_DIGITS) {
+        /* Round half to even, carrying into the leading digit ("0x2p+0") as glibc does */
+        int dropped = (FORMAT_DOUBLE_HEX_DIGITS - spec->precision) * 4;
+        uint64_t rest = mantissa & ((UINT64_C(1) << dropped) - 1);
+        uint64_t half = UINT64_C(1) << (dropped - 1);
+        digitCount = spec->precision;
+        mantissa >>= dropped;
+        uint64_t last = digitCount > 0 ? mantissa : lead;
+        if (rest > half || (rest == half && (last & 1) != 0)) {
+            mantissa++;
+            if (mantissa >> (digitCount * 4) != 0) {
+                lead++;
+                mantissa = 0;
+            }
+        }
+    } else {
+        extraZeros = spec->precision - FORMAT_DOUBLE_HEX_DIGITS;
+    }
+
+    char prefix[4] = {0};
+    int p = 0;
+    if (sign[0] != '\0') {
+        prefix[p++] = sign[0];
+    }
+    prefix[p++] = '0';
+    prefix[p++] = upper ? 'X' : 'x';
+
+    char body[FORMAT_DOUBLE_HEX_DIGITS + 24];
+    int count = render_unsigned(body, lead, 16, upper);
+    if (digitCount > 0 || extraZeros > 0 || spec->alternate) {
+        body[count++] = '.';
+    }
+    const char *table = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+    for (int i = digitCount - 1; i >= 0; i--) {
+        body[count++] = table[(mantissa >> (i * 4)) & 0xF];
+    }
+    char exponentBuf[8];
+    int exponentLength = render_exponent(exponentBuf, upper ? 'P' : 'p', exponent, 1);
+
+    int padding = put_float_start(output, spec, prefix, count + extraZeros + exponentLength);
+    put_chars(output, body, count);
+    put_padding(output, '0', extraZeros);
+    put_chars(output, exponentBuf, exponentLength);
+    put_padding(output, ' ', padding);
+}
+
+/*
+ * put_decimal_float is derived from fmt_fp in src/stdio/vfprintf.c of musl libc:
+ *
+ * Copyright © 2005-2020 Rich Felker, et al.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @brief Writes mantissa * 2^exponent2 for the @c f, @c e and @c g conversions, correctly rounded like printf.
+ *
+ * The value is expanded exactly into base 10^9 words, as musl's fmt_fp does, so that every double prints
+ * with any precision, without floating-point arithmetic or heap allocation.
+ */
+static void put_decimal_float(
+    FormatOutput *output,
+    const FormatSpec *spec,
+    const char *prefix,
+    uint64_t mantissa,
+    int exponent2,
+    char conversion
+) {
+    uint32_t words[FORMAT_FLOAT_WORDS];
+    char lower = (char) (conversion | 32);
+    int precision = spec->precision < 0 ? 6 : spec->precision;
+    if (mantissa == 0) {
+        exponent2 = 0;
+    }
+
+    /*
+     * Words a..z-1 hold the digits, most significant first; r is the word holding the units.
+     * Integers are built at the end of the array, as they only grow towards the front.
+     */
+    uint32_t *a = exponent2 < 0 ? words : words + FORMAT_FLOAT_WORDS - 2;
+    a[0] = (uint32_t) (mantissa / FORMAT_WORD_BASE);
+    a[1] = (uint32_t) (mantissa % FORMAT_WORD_BASE);
+    uint32_t *r = a + 1;
+    uint32_t *z = a + 2;
+    uint32_t *d;
+    if (a[0] == 0) {
+        a++;
+    }
+
+    while (exponent2 > 0) {
+        uint32_t carry = 0;
+        int shift = exponent2 < 29 ? exponent2 : 29;
+        for (d = z - 1; d >= a; d--) {
+            uint64_t x = ((uint64_t) *d << shift) + carry;
+            *d = (uint32_t) (x % FORMAT_WORD_BASE);
+            carry = (uint32_t) (x / FORMAT_WORD_BASE);
+        }
+        if (carry != 0) {
+            *--a = carry;
+        }
+        while (z > a && z[-1] == 0) {
+            z--;
+        }
+        exponent2 -= shift;
+    }
+    while (exponent2 < 0) {
+        uint32_t carry = 0;
+        int shift = -exponent2 < 9 ? -exponent2 : 9;
+        for (d = a; d < z; d++) {
+            uint32_t rest = *d & ((1u << shift) - 1);
+            *d = (*d >> shift) + carry;
+            carry = (FORMAT_WORD_BASE >> shift) * rest;
+        }
+        if (a < z && *a == 0) {
+            a++;
+        }
+        if (carry != 0) {
+            *z++ = carry;
+        }
+        /* Digits far past the precision can't change the rounding, so they aren't computed. */
+        uint32_t *b = lower == 'f' ? r : a;
+        int need = 1 + (precision + FORMAT_DOUBLE_DIGITS + 8) / 9;
+        if (z - b > need) {
+            z = b + need;
+        }
+        exponent2 += shift;
+    }
+    if (a == z) {
+        /* Too small to show at this precision; the words passed over are all zero. */
+        a = r;
+        z = r + 1;
+    }
+
+    /* Decimal exponent of the leading digit */
+    int e = 0;
+    uint32_t i;
+    if (a < z) {
+        for (i = 10, e = 9 * (int) (r - a); *a >= i; i *= 10, e++) {
+        }
+    }
+
+    /* Round to nearest, ties to even: j is the number of digits kept after the decimal point (possibly negative). */
+    int j = precision - (lower != 'f') * e - (lower == 'g' && precision != 0);
+    if (j < 9 * (int) (z - r - 1)) {
+        /* Division rounding towards negative infinity, for negative j */
+        d = r + 1 + ((j + 9 * FORMAT_DOUBLE_MAX_EXP) / 9 - FORMAT_DOUBLE_MAX_EXP);
+        j = (j + 9 * FORMAT_DOUBLE_MAX_EXP) % 9;
+        for (i = 10, j++; j < 9; i *= 10, j++) {
+        }
+        uint32_t x = *d % i;
+        if (x != 0 || d + 1 != z) {
+            bool odd = ((*d / i) & 1) != 0 || (i == FORMAT_WORD_BASE && d > a && (d[-1] & 1) != 0);
+            bool roundUp = x > i / 2 || (x == i / 2 && (d + 1 != z || odd));
+            *d -= x;
+            if (roundUp) {
+                *d += i;
+                while (*d > FORMAT_WORD_BASE - 1) {
+                    *d-- = 0;
+                    if (d < a) {
+                        *--a = 0;
+                    }
+                    (*d)++;
+                }
+                for (i = 10, e = 9 * (int) (r - a); *a >= i; i *= 10, e++) {
+                }
+            }
+        }
+        if (z > d + 1) {
+            z = d + 1;
+        }
+    }
+    while (z > a && z[-1] == 0) {
+        z--;
+    }
+
+    if (lower == 'g') {
+        if (precision == 0) {
+            precision = 1;
+        }
+        if (precision > e && e >= -4) {
+            conversion--;
+            precision -= e + 1;
+        } else {
+            conversion -= 2;
+            precision--;
+        }
+        lower = (char) (conversion | 32);
+        if (!spec->alternate) {
+            /* Drop trailing zeros */
+            int zeros = 9;
+            if (z > a && z[-1] != 0) {
+                for (i = 10, zeros = 0; z[-1] % i == 0; i *= 10, zeros++) {
+                }
+            }
+            int significant = 9 * (int) (z - r - 1) - zeros + (lower == 'f' ? 0 : e);
+            if (precision > significant) {
+                precision = significant > 0 ? significant : 0;
+            }
+        }
+    }
+
+    bool point = precision > 0 || spec->alternate;
+    int length = 1 + precision + point;
+    char exponentBuf[8];
+    int exponentLength = 0;
+    if (lower == 'f') {
+        if (e > 0) {
+            length += e;
+        }
+    } else {
+        exponentLength = render_exponent(exponentBuf, conversion, e, 2);
+        length += exponentLength;
+    }
+
+    int padding = put_float_start(output, spec, prefix, length);
+    char buf[9];
+    if (lower == 'f') {
+        if (a > r) {
+            a = r;
+        }
+        for (d = a; d <= r; d++) {
+            render_word(buf, *d);
+            int skip = 0;
+            /* No leading zeros, but at least one digit */
+            while (d == a && skip < 8 && buf[skip] == '0') {
+                skip++;
+            }
+            put_chars(output, buf + skip, 9 - skip);
+        }
+        if (point) {
+            put_char(output, '.');
+        }
+        for (; d < z && precision > 0; d++, precision -= 9) {
+            render_word(buf, *d);
+            put_chars(output, buf, precision < 9 ? precision : 9);
+        }
+        put_padding(output, '0', precision);
+    } else {
+        if (z <= a) {
+            z = a + 1;
+        }
+        for (d = a; d < z && precision >= 0; d++) {
+            render_word(buf, *d);
+            int skip = 0;
+            if (d == a) {
+                while (skip < 8 && buf[skip] == '0') {
+                    skip++;
+                }
+                put_char(output, buf[skip++]);
+                if (point) {
+                    put_char(output, '.');
+                }
+            }
+            int count = 9 - skip;
+            put_chars(output, buf + skip, precision < count ? precision : count);
+            precision -= count;
+        }
+        put_padding(output, '0', precision);
+        put_chars(output, exponentBuf, exponentLength);
+    }
+    put_padding(output, ' ', padding);
+}
+
+static void put_float(FormatOutput *output, const FormatSpec *spec, double value, char conversion) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    uint64_t mantissa = bits & ((UINT64_C(1) << FORMAT_DOUBLE_MANTISSA_BITS) - 1);
+    int exponentBits = (int) ((bits >> FORMAT_DOUBLE_MANTISSA_BITS) & 0x7FF);
+
+    /* The sign of negative zero is kept, as printf does. */
+    char prefix[2] = {0};
+    if ((bits >> 63) != 0) {
+        prefix[0] = '-';
+    } else if (spec->sign != 0) {
+        prefix[0] = spec->sign;
+    }
+
+    bool upper = conversion >= 'A' && conversion <= 'Z';
+    if (exponentBits == 0x7FF) {
+        FormatSpec special = *spec;
+        special.zeroPad = false;
+        const char *text = mantissa != 0 ? (upper ? "NAN" : "nan") : (upper ? "INF" : "inf");
+        int padding = put_float_start(output, &special, prefix, 3);
+        put_chars(output, text, 3);
+        put_padding(output, ' ', padding);
+        return;
+    }
+    if ((conversion | 32) == 'a') {
+        put_hex_float(output, spec, prefix, mantissa, exponentBits, conversion);
+        return;
+    }
+    if (exponentBits != 0) {
+        put_decimal_float(output, spec, prefix, mantissa | (UINT64_C(1) << FORMAT_DOUBLE_MANTISSA_BITS),
+                          exponentBits - FORMAT_DOUBLE_EXPONENT_BIAS - FORMAT_DOUBLE_MANTISSA_BITS, conversion);
+    } else {
+        put_decimal_float(output, spec, prefix, mantissa,
+                          1 - FORMAT_DOUBLE_EXPONENT_BIAS - FORMAT_DOUBLE_MANTISSA_BITS, conversion);
+    }
+}
+
+static void put_string(FormatOutput *output, const FormatSpec *spec, const char *str) {
+    if (str == NULL) {
+        str = "(null)";
+    }
+    int length = 0;
+    while (str[length] != '\0' && (spec->precision < 0 || length < spec->precision)) {
+        length++;
+    }
+    int padding = spec->width > length ? spec->width - length : 0;
+    if (!spec->leftAlign) {
+        put_padding(output, ' ', padding);
+    }
+    for (int i = 0; i < length; i++) {
+        put_char(output, str[i]);
+    }
+    if (spec->leftAlign) {
+        put_padding(output, ' ', padding);
+    }
+}
+
+int pd_FormatV(char *out, size_t capacity, const char *fmt, va_list args) {
+    FormatOutput output = {out, capacity, 0};
+
+    /* Copy, so that va_arg can be used through a pointer regardless of how va_list is implemented. */
+    va_list v_list;
+    va_copy(v_list, args);
+
+    const char *c = fmt;
+    while (*c != '\0') {
+        if (*c != '%') {
+            put_char(&output, *c++);
+            continue;
+        }
+        const char *specStart = c++;
+
+        FormatSpec spec = {false, false, false, 0, 0, -1};
+        for (;; c++) {
+            if (*c == '-') spec.leftAlign = true;
+            else if (*c == '0') spec.zeroPad = true;
+            else if (*c == '#') spec.alternate = true;
+            else if (*c == '+') spec.sign = '+';
+            else if (*c == ' ') {
+                if (spec.sign == 0) spec.sign = ' ';
+            } else break;
+        }
+        if (*c == '*') {
+            spec.width = va_arg(v_list, int);
+            if (spec.width < 0) {
+                spec.leftAlign = true;
+                spec.width = -spec.width;
+            }
+            c++;
+        } else {
+            while (*c >= '0' && *c <= '9') {
+                spec.width = spec.width * 10 + (*c++ - '0');
+            }
+        }
+        if (*c == '.') {
+            c++;
+            spec.precision = 0;
+            if (*c == '*') {
+                spec.precision = va_arg(v_list, int);
+                c++;
+            } else {
+                while (*c >= '0' && *c <= '9') {
+                    spec.precision = spec.precision * 10 + (*c++ - '0');
+                }
+            }
+        }
+
+        /*
+         * Length modifiers: 0 = int, 1 = long, 2 = long long, 3 = size_t, 4 = ptrdiff_t, 5 = intmax_t,
+         * 6 = short, 7 = char, 8 = long double
+         */
+        int length = 0;
+        if (*c == 'h') {
+            c++;
+            length = 6;
+            if (*c == 'h') {
+                c++;
+                length = 7;
+            }
+        } else if (*c == 'l') {
+            c++;
+            length = 1;
+            if (*c == 'l') {
+                c++;
+                length = 2;
+            }
+        } else if (*c == 'z') {
+            c++;
+            length = 3;
+        } else if (*c == 't') {
+            c++;
+            length = 4;
+        } else if (*c == 'j') {
+            c++;
+            length = 5;
+        } else if (*c == 'L') {
+            c++;
+            length = 8;
+        }
+
+        char conversion = *c;
+        if (conversion == '\0') break;
+        c++;
+        switch (conversion) {
+            case 'd':
+            case 'i': {
+                int64_t value;
+                if (length == 1) value = va_arg(v_list, long);
+                else if (length == 2) value = va_arg(v_list, long long);
+                else if (length == 3 || length == 4) value = va_arg(v_list, ptrdiff_t);
+                else if (length == 5) value = va_arg(v_list, intmax_t);
+                else if (length == 6) value = (short) va_arg(v_list, int);
+                else if (length == 7) value = (signed char) va_arg(v_list, int);
+                else value = va_arg(v_list, int);
+                uint64_t magnitude = value < 0 ? (uint64_t) 0 - (uint64_t) value : (uint64_t) value;
+                put_integer(&output, &spec, magnitude, value < 0, 10, false);
+                break;
+            }
+            case 'u':
+            case 'x':
+            case 'X':
+            case 'o': {
+                uint64_t value;
+                if (length == 1) value = va_arg(v_list, unsigned long);
+                else if (length == 2) value = va_arg(v_list, unsigned long long);
+                else if (length == 3) value = va_arg(v_list, size_t);
+                else if (length == 4) value = (uint64_t) va_arg(v_list, ptrdiff_t);
+                else if (length == 5) value = va_arg(v_list, uintmax_t);
+                else if (length == 6) value = (unsigned short) va_arg(v_list, unsigned int);
+                else if (length == 7) value = (unsigned char) va_arg(v_list, unsigned int);
+                else value = va_arg(v_list, unsigned int);
+                unsigned base = conversion == 'u' ? 10 : (conversion == 'o' ? 8 : 16);
+                spec.sign = 0;
+                put_integer(&output, &spec, value, false, base, conversion == 'X');
+                break;
+            }
+            case 'f':
+            case 'F':
+            case 'g':
+            case 'G':
+            case 'e':
+            case 'E':
+            case 'a':
+            case 'A': {
+                /* long double is the same as double on the device; on the host it is narrowed. */
+                double value = length == 8 ? (double) va_arg(v_list, long double) : va_arg(v_list, double);
+                put_float(&output, &spec, value, conversion);
+                break;
+            }
+            case 'c': {
+                char character = (char) va_arg(v_list, int);
+                int padding = spec.width > 1 ? spec.width - 1 : 0;
+                if (!spec.leftAlign) {
+                    put_padding(&output, ' ', padding);
+                }
+                put_char(&output, character);
+                if (spec.leftAlign) {
+                    put_padding(&output, ' ', padding);
+                }
+                break;
+            }
+            case 's':
+                put_string(&output, &spec, va_arg(v_list, const char *));
+                break;
+            case 'p':
+                spec.alternate = true;
+                spec.sign = 0;
+                put_integer(&output, &spec, (uintptr_t) va_arg(v_list, void *), false, 16, false);
+                break;
+            case '%':
+                put_char(&output, '%');
+                break;
+            default:
+                /* Unknown conversion; print it as-is. */
+                while (specStart < c) {
+                    put_char(&output, *specStart++);
+                }
+                break;
+        }
+    }
+    va_end(v_list);
+
+    if (capacity > 0) {
+        out[output.length < capacity ? output.length : capacity - 1] = '\0';
+    }
+    return (int) output.length;
+}
+
+int pd_Format(char *out, size_t capacity, const char *fmt, ...) {
+    va_list v_list;
+    va_start(v_list, fmt);
+    int length = pd_FormatV(out, capacity, fmt, v_list);
+    va_end(v_list);
+    return length;
+}
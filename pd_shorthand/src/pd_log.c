@@ -0,0 +1,203 @@
+/* Keeps the logging macros from replacing the definitions below. */
+#define PD_SHORTHAND_INTERNAL
+
+#include "pd_shorthand.h"
+
+#include <stdarg.h>
+#include <string.h>
+
+typedef struct LogBufferTag {
+    char *storage;
+    size_t capacity;
+    /* Lines are stored back to back, each terminated by '\n'. */
+    size_t head;
+    size_t used;
+    uint32_t flushInterval;
+    uint32_t framesSinceFlush;
+    uint32_t dropped;
+    SDFile *file;
+    bool enabled;
+} LogBuffer;
+
+static LogBuffer s_log_buffer = {0};
+
+static const char *const s_level_prefixes[] = {
+    "[DEBUG] ",
+    "[INFO] ",
+    "[WARN] ",
+    "[ERROR] ",
+};
+
+static void drop_oldest_line(void) {
+    size_t tail = (s_log_buffer.head + s_log_buffer.capacity - s_log_buffer.used) % s_log_buffer.capacity;
+    /* The oldest line may wrap around the end of the storage. */
+    size_t firstPart = s_log_buffer.capacity - tail;
+    if (firstPart > s_log_buffer.used) {
+        firstPart = s_log_buffer.used;
+    }
+    const char *newline = memchr(s_log_buffer.storage + tail, '\n', firstPart);
+    size_t lineLength;
+    if (newline != NULL) {
+        lineLength = (size_t) (newline - (s_log_buffer.storage + tail)) + 1;
+    } else {
+        newline = memchr(s_log_buffer.storage, '\n', s_log_buffer.used - firstPart);
+        lineLength = newline != NULL
+                     ? firstPart + (size_t) (newline - s_log_buffer.storage) + 1
+                     : s_log_buffer.used;
+    }
+    s_log_buffer.used -= lineLength;
+    s_log_buffer.dropped++;
+}
+
+static void buffer_write(const char *data, size_t length) {
+    size_t firstPart = s_log_buffer.capacity - s_log_buffer.head;
+    if (firstPart > length) {
+        firstPart = length;
+    }
+    memcpy(s_log_buffer.storage + s_log_buffer.head, data, firstPart);
+    memcpy(s_log_buffer.storage, data + firstPart, length - firstPart);
+    s_log_buffer.head = (s_log_buffer.head + length) % s_log_buffer.capacity;
+}
+
+static void buffer_line(const char *line, size_t length) {
+    if (length + 1 > s_log_buffer.capacity) {
+        length = s_log_buffer.capacity - 1;
+    }
+    /* Keep the newest lines; whatever doesn't fit is dropped from the oldest end. */
+    while (s_log_buffer.used + length + 1 > s_log_buffer.capacity) {
+        drop_oldest_line();
+    }
+    buffer_write(line, length);
+    buffer_write("\n", 1);
+    s_log_buffer.used += length + 1;
+}
+
+static void output_line(const char *line, size_t length) {
+    if (s_log_buffer.enabled) {
+        buffer_line(line, length);
+    } else {
+        pd_getPd()->system->logToConsole("%s", line);
+    }
+}
+
+/* Stands in for logToConsole behind pd_cachedLogToConsole while the buffer is enabled. */
+static void log_to_buffer(const char *fmt, ...) {
+    char line[PD_LOG_LINE_SIZE];
+    va_list v_list;
+    va_start(v_list, fmt);
+    int length = pd_FormatV(line, sizeof(line), fmt, v_list);
+    va_end(v_list);
+    buffer_line(line, length < (int) sizeof(line) ? (size_t) length : sizeof(line) - 1);
+}
+
+void pd_Log(const char *msg) {
+    output_line(msg, strlen(msg));
+}
+
+void pd_LogF(const char *fmt, ...) {
+    char line[PD_LOG_LINE_SIZE];
+    va_list v_list;
+    va_start(v_list, fmt);
+    int length = pd_FormatV(line, sizeof(line), fmt, v_list);
+    va_end(v_list);
+    output_line(line, length < (int) sizeof(line) ? (size_t) length : sizeof(line) - 1);
+}
+
+void pd_LogLevelF(PDLogLevel level, const char *fmt, ...) {
+    char line[PD_LOG_LINE_SIZE];
+    const char *prefix = s_level_prefixes[level < PD_LOG_LEVEL_NONE ? level : PD_LOG_LEVEL_ERROR];
+    size_t prefixLength = strlen(prefix);
+    memcpy(line, prefix, prefixLength);
+
+    va_list v_list;
+    va_start(v_list, fmt);
+    int length = pd_FormatV(line + prefixLength, sizeof(line) - prefixLength, fmt, v_list);
+    va_end(v_list);
+
+    size_t total = prefixLength + (size_t) length;
+    output_line(line, total < sizeof(line) ? total : sizeof(line) - 1);
+}
+
+void pd_LogBufferEnable(void *storage, size_t size, uint32_t flushIntervalFrames) {
+    if (s_log_buffer.enabled) {
+        pd_LogBufferDisable();
+    }
+    if (storage == NULL || size < 2) return;
+    s_log_buffer.storage = storage;
+    s_log_buffer.capacity = size;
+    s_log_buffer.head = 0;
+    s_log_buffer.used = 0;
+    s_log_buffer.flushInterval = flushIntervalFrames;
+    s_log_buffer.framesSinceFlush = 0;
+    s_log_buffer.dropped = 0;
+    s_log_buffer.enabled = true;
+    pd_cachedLogToConsole = log_to_buffer;
+}
+
+bool pd_LogBufferSetFile(const char *path) {
+    PlaydateAPI *pd = pd_getPd();
+    if (s_log_buffer.file != NULL) {
+        pd->file->close(s_log_buffer.file);
+        s_log_buffer.file = NULL;
+    }
+    if (path == NULL) return true;
+    s_log_buffer.file = pd->file->open(path, kFileAppend);
+    return s_log_buffer.file != NULL;
+}
+
+void pd_LogBufferFlush(void) {
+    if (!s_log_buffer.enabled) return;
+    PlaydateAPI *pd = pd_getPd();
+    s_log_buffer.framesSinceFlush = 0;
+
+    if (s_log_buffer.dropped != 0) {
+        pd->system->logToConsole("[PD Shorthand Lib WARNING] %d log lines were dropped.", s_log_buffer.dropped);
+        s_log_buffer.dropped = 0;
+    }
+    if (s_log_buffer.used == 0) return;
+
+    size_t tail = (s_log_buffer.head + s_log_buffer.capacity - s_log_buffer.used) % s_log_buffer.capacity;
+
+    if (s_log_buffer.file != NULL) {
+        size_t firstPart = s_log_buffer.capacity - tail;
+        if (firstPart > s_log_buffer.used) {
+            firstPart = s_log_buffer.used;
+        }
+        pd->file->write(s_log_buffer.file, s_log_buffer.storage + tail, (unsigned int) firstPart);
+        if (firstPart < s_log_buffer.used) {
+            pd->file->write(s_log_buffer.file, s_log_buffer.storage, (unsigned int) (s_log_buffer.used - firstPart));
+        }
+        pd->file->flush(s_log_buffer.file);
+    }
+
+    /* logToConsole needs each line contiguous and NUL-terminated, and a line may wrap around. */
+    char line[PD_LOG_LINE_SIZE];
+    size_t length = 0;
+    for (size_t i = 0; i < s_log_buffer.used; i++) {
+        char c = s_log_buffer.storage[(tail + i) % s_log_buffer.capacity];
+        if (c == '\n') {
+            line[length] = '\0';
+            pd->system->logToConsole("%s", line);
+            length = 0;
+        } else if (length < sizeof(line) - 1) {
+            line[length++] = c;
+        }
+    }
+    s_log_buffer.used = 0;
+}
+
+void pd_LogBufferNextFrame(void) {
+    if (!s_log_buffer.enabled || s_log_buffer.flushInterval == 0) return;
+    s_log_buffer.framesSinceFlush++;
+    if (s_log_buffer.framesSinceFlush >= s_log_buffer.flushInterval) {
+        pd_LogBufferFlush();
+    }
+}
+
+void pd_LogBufferDisable(void) {
+    if (!s_log_buffer.enabled) return;
+    pd_LogBufferFlush();
+    pd_LogBufferSetFile(NULL);
+    s_log_buffer = (LogBuffer) {0};
+    pd_cachedLogToConsole = pd_getPd()->system->logToConsole;
+}
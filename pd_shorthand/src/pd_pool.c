@@ -0,0 +1,136 @@
+#include "pd_shorthand.h"
+
+#include <stdint.h>
+#include <string.h>
+
+/* Written after the object in each slot of a debug pool. */
+#define POOL_SLOT_LIVE 0x4C495645u
+#define POOL_SLOT_FREE 0x46524545u
+
+/* Byte pattern written over freed objects in a debug pool. */
+#define POOL_POISON 0xDD
+
+/**
+ * @brief A chunk of slots. The slots start at the first aligned address after this header.
+ */
+struct PDPoolChunkTag {
+    PDPoolChunk *next;
+};
+
+static size_t align_up(size_t value, size_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+static uint32_t *slot_state(const PDPool *pool, void *slot) {
+    return (uint32_t *) ((uint8_t *) slot + pool->stateOffset);
+}
+
+static bool pool_grow(PDPool *pool) {
+    size_t size = sizeof(PDPoolChunk) + pool->alignment - 1 + pool->slotSize * pool->objectsPerChunk;
+    PDPoolChunk *chunk = pd_Malloc(size);
+    if (chunk == NULL) return false;
+    chunk->next = pool->chunks;
+    pool->chunks = chunk;
+
+    uint8_t *first = (uint8_t *) align_up((uintptr_t) (chunk + 1), pool->alignment);
+    /* Thread the slots in reverse so that they are handed out in address order. */
+    for (uint32_t i = pool->objectsPerChunk; i > 0; i--) {
+        void *slot = first + pool->slotSize * (i - 1);
+        if (pool->debug) {
+            memset(slot, POOL_POISON, pool->objectSize);
+            *slot_state(pool, slot) = POOL_SLOT_FREE;
+        }
+        *(void **) slot = pool->freeList;
+        pool->freeList = slot;
+    }
+    return true;
+}
+
+void pd_PoolInit(PDPool *pool, size_t objectSize, size_t alignment, uint32_t objectsPerChunk, bool debug) {
+    if (alignment < sizeof(void *)) {
+        alignment = sizeof(void *);
+    }
+    if ((alignment & (alignment - 1)) != 0) {
+        pd_ErrorF("Pool alignment must be a power of two (got %d).", (int) alignment);
+        return;
+    }
+
+    /* A free slot stores the free-list link in place of the object. */
+    size_t slotSize = objectSize < sizeof(void *) ? sizeof(void *) : objectSize;
+    size_t stateOffset = 0;
+    if (debug) {
+        stateOffset = align_up(slotSize, sizeof(uint32_t));
+        slotSize = stateOffset + sizeof(uint32_t);
+    }
+
+    pool->chunks = NULL;
+    pool->freeList = NULL;
+    pool->objectSize = objectSize;
+    pool->slotSize = align_up(slotSize, alignment);
+    pool->alignment = alignment;
+    pool->stateOffset = stateOffset;
+    pool->objectsPerChunk = objectsPerChunk == 0 ? PD_POOL_DEFAULT_OBJECTS_PER_CHUNK : objectsPerChunk;
+    pool->liveCount = 0;
+    pool->debug = debug;
+}
+
+void *pd_PoolAlloc(PDPool *pool) {
+    if (pool->freeList == NULL && !pool_grow(pool)) {
+        return NULL;
+    }
+
+    void *slot = pool->freeList;
+    pool->freeList = *(void **) slot;
+    pool->liveCount++;
+
+    if (pool->debug) {
+        /* Everything but the free-list link should still be poisoned. */
+        const uint8_t *bytes = slot;
+        for (size_t i = sizeof(void *); i < pool->objectSize; i++) {
+            if (bytes[i] != POOL_POISON) {
+                pd_LogWarn("Pool slot %p was written to after being freed.", slot);
+                break;
+            }
+        }
+        *slot_state(pool, slot) = POOL_SLOT_LIVE;
+    }
+    return slot;
+}
+
+void pd_PoolFree(PDPool *pool, void *ptr) {
+    if (ptr == NULL) return;
+
+    if (pool->debug) {
+        uint32_t state = *slot_state(pool, ptr);
+        if (state == POOL_SLOT_FREE) {
+            pd_ErrorF("Double free of pool slot %p detected.", ptr);
+            return;
+        }
+        if (state != POOL_SLOT_LIVE) {
+            pd_ErrorF("Pointer %p does not belong to the pool, or its slot has been overrun.", ptr);
+            return;
+        }
+        memset(ptr, POOL_POISON, pool->objectSize);
+        *slot_state(pool, ptr) = POOL_SLOT_FREE;
+    }
+
+    *(void **) ptr = pool->freeList;
+    pool->freeList = ptr;
+    pool->liveCount--;
+}
+
+void pd_PoolRelease(PDPool *pool) {
+    if (pool->debug && pool->liveCount != 0) {
+        pd_LogWarn("Pool released with %u objects still allocated.", pool->liveCount);
+    }
+
+    PDPoolChunk *chunk = pool->chunks;
+    while (chunk != NULL) {
+        PDPoolChunk *next = chunk->next;
+        pd_Free(chunk);
+        chunk = next;
+    }
+    pool->chunks = NULL;
+    pool->freeList = NULL;
+    pool->liveCount = 0;
+}
@@ -0,0 +1,446 @@
+#include "pd_shorthand.h"
+
+#include <string.h>
+
+#define UNUSED(arg) (void)(arg)
+
+#if defined(PD_SHORTHAND_PROFILE)
+
+#define OVERLAY_MARGIN 2
+#define OVERLAY_DEFAULT_LINE_HEIGHT 16
+/* Elapsed time (in seconds) past which a float no longer resolves a few microseconds */
+#define PRECISE_ELAPSED_SECONDS 64.0f
+/* How far (in microseconds) the elapsed time may drift from the millisecond clock before the clock is re-anchored */
+#define CLOCK_TOLERANCE_MICROS 2000
+/* Time (in microseconds) after which the anchor of the clock moves to the current reading */
+#define CLOCK_ANCHOR_MICROS 1000000
+
+typedef struct ProfileSampleTag {
+    /* Frame the scope ended in */
+    uint32_t frame;
+    /* Microseconds since the start of that frame */
+    uint32_t startMicros;
+    uint32_t durationMicros;
+    uint8_t scope;
+    uint8_t depth;
+} ProfileSample;
+
+typedef struct ProfileWindowTag {
+    uint32_t calls;
+    uint32_t minMicros;
+    uint32_t maxMicros;
+    uint64_t totalMicros;
+} ProfileWindow;
+
+typedef struct ProfileScopeTag {
+    const char *name;
+    /* Figures of the window being collected */
+    ProfileWindow window;
+    /* Figures of the last complete window, which are what gets reported */
+    PDProfileScopeStats published;
+} ProfileScope;
+
+typedef struct ProfileOpenScopeTag {
+    uint32_t startMicros;
+    uint8_t scope;
+} ProfileOpenScope;
+
+typedef struct ProfileStateTag {
+    bool enabled;
+    PDProfileTimer timer;
+    /*
+     * Default clock: the millisecond clock, refined with the elapsed time read at the same moment.
+     * The anchor is where both clocks were last read together; lastMicros keeps the clock from going back.
+     */
+    uint32_t anchorMicros;
+    float anchorElapsed;
+    float lastElapsed;
+    uint32_t lastMicros;
+    bool clockStarted;
+    bool precisionWarned;
+
+    uint32_t frame;
+    uint32_t frameStartMicros;
+    uint32_t windowFrames;
+
+    ProfileScope scopes[PD_PROFILE_MAX_SCOPES];
+    uint32_t scopeCount;
+
+    ProfileOpenScope stack[PD_PROFILE_MAX_DEPTH];
+    uint32_t depth;
+    /* Scopes opened beyond PD_PROFILE_MAX_DEPTH (or past the scope table) that still have to be closed */
+    uint32_t ignoredDepth;
+
+    ProfileSample samples[PD_PROFILE_SAMPLE_CAPACITY];
+    uint32_t sampleHead;
+    uint32_t sampleCount;
+
+    uint32_t frameTimes[PD_PROFILE_FRAME_HISTORY];
+    uint32_t frameTimeHead;
+    uint32_t frameTimeCount;
+    ProfileWindow frameWindow;
+    PDProfileScopeStats frameStats;
+
+    bool overlayVisible;
+    PDProfileCorner overlayCorner;
+    LCDFont *overlayFont;
+} ProfileState;
+
+static ProfileState s_profile = {0};
+
+static uint32_t now_micros(void) {
+    if (s_profile.timer != NULL) {
+        return s_profile.timer();
+    }
+    /*
+     * getCurrentTimeMilliseconds is monotonic but coarse. The elapsed time adds the microseconds, but it belongs
+     * to the game, which may reset it at any time, so it is only trusted while it agrees with the millisecond clock.
+     */
+    PlaydateAPI *pd = pd_getPd();
+    uint32_t coarse = pd->system->getCurrentTimeMilliseconds() * 1000u;
+    float elapsed = pd->system->getElapsedTime();
+    int32_t expected = (int32_t) (coarse - s_profile.anchorMicros);
+    float fine = (elapsed - s_profile.anchorElapsed) * 1000000.0f;
+    bool started = s_profile.clockStarted;
+    uint32_t micros;
+    if (started && fine >= (float) expected - CLOCK_TOLERANCE_MICROS
+        && fine <= (float) expected + CLOCK_TOLERANCE_MICROS) {
+        micros = s_profile.anchorMicros + (uint32_t) (int32_t) fine;
+        if (expected > CLOCK_ANCHOR_MICROS) {
+            /* Moving the anchor along keeps the differences of floats small, hence precise. */
+            s_profile.anchorMicros = micros;
+            s_profile.anchorElapsed = elapsed;
+        }
+    } else {
+        /* First reading, or the game reset the elapsed time (whether it reads lower or higher since) */
+        s_profile.anchorMicros = coarse;
+        s_profile.anchorElapsed = elapsed;
+        s_profile.clockStarted = true;
+        micros = coarse;
+    }
+    s_profile.lastElapsed = elapsed;
+    if (started && (int32_t) (micros - s_profile.lastMicros) < 0) {
+        micros = s_profile.lastMicros;
+    }
+    s_profile.lastMicros = micros;
+    return micros;
+}
+
+static void window_add(ProfileWindow *window, uint32_t micros) {
+    if (window->calls == 0 || micros < window->minMicros) {
+        window->minMicros = micros;
+    }
+    if (micros > window->maxMicros) {
+        window->maxMicros = micros;
+    }
+    window->totalMicros += micros;
+    window->calls++;
+}
+
+static void window_publish(ProfileWindow *window, PDProfileScopeStats *stats) {
+    stats->calls = window->calls;
+    stats->minMicros = window->minMicros;
+    stats->maxMicros = window->maxMicros;
+    stats->avgMicros = window->calls == 0 ? 0 : (uint32_t) (window->totalMicros / window->calls);
+    *window = (ProfileWindow) {0};
+}
+
+static int32_t find_scope(const char *name) {
+    /* Names are usually string literals, so comparing pointers finds them first. */
+    for (uint32_t i = 0; i < s_profile.scopeCount; i++) {
+        if (s_profile.scopes[i].name == name) return (int32_t) i;
+    }
+    for (uint32_t i = 0; i < s_profile.scopeCount; i++) {
+        if (strcmp(s_profile.scopes[i].name, name) == 0) return (int32_t) i;
+    }
+    if (s_profile.scopeCount == PD_PROFILE_MAX_SCOPES) return -1;
+    ProfileScope *scope = &s_profile.scopes[s_profile.scopeCount];
+    *scope = (ProfileScope) {0};
+    scope->name = name;
+    scope->published.name = name;
+    return (int32_t) s_profile.scopeCount++;
+}
+
+void pd_ProfileSetEnabled(bool enabled) {
+    if (enabled == s_profile.enabled) return;
+    if (enabled) {
+        PDProfileTimer timer = s_profile.timer;
+        s_profile = (ProfileState) {0};
+        s_profile.timer = timer;
+        s_profile.frameStartMicros = now_micros();
+    }
+    s_profile.enabled = enabled;
+}
+
+void pd_ProfileSetTimer(PDProfileTimer timer) {
+    s_profile.timer = timer;
+}
+
+void pd_ProfileBegin(const char *name) {
+    if (!s_profile.enabled) return;
+    int32_t scope = s_profile.depth < PD_PROFILE_MAX_DEPTH && s_profile.ignoredDepth == 0 ? find_scope(name) : -1;
+    if (scope < 0) {
+        s_profile.ignoredDepth++;
+        return;
+    }
+    s_profile.stack[s_profile.depth++] = (ProfileOpenScope) {now_micros(), (uint8_t) scope};
+}
+
+void pd_ProfileEnd(void) {
+    if (!s_profile.enabled) return;
+    if (s_profile.ignoredDepth > 0) {
+        s_profile.ignoredDepth--;
+        return;
+    }
+    if (s_profile.depth == 0) {
+        pd_LogWarn("pd_ProfileEnd called without a matching pd_ProfileBegin.");
+        return;
+    }
+    uint32_t end = now_micros();
+    ProfileOpenScope *open = &s_profile.stack[--s_profile.depth];
+    /* A custom timer may wrap around in between. */
+    uint32_t duration = end > open->startMicros ? end - open->startMicros : 0;
+    window_add(&s_profile.scopes[open->scope].window, duration);
+
+    ProfileSample *sample = &s_profile.samples[s_profile.sampleHead];
+    sample->frame = s_profile.frame;
+    sample->startMicros = open->startMicros > s_profile.frameStartMicros
+                          ? open->startMicros - s_profile.frameStartMicros
+                          : 0;
+    sample->durationMicros = duration;
+    sample->scope = open->scope;
+    sample->depth = (uint8_t) s_profile.depth;
+    s_profile.sampleHead = (s_profile.sampleHead + 1) % PD_PROFILE_SAMPLE_CAPACITY;
+    if (s_profile.sampleCount < PD_PROFILE_SAMPLE_CAPACITY) {
+        s_profile.sampleCount++;
+    }
+}
+
+void pd_ProfileNextFrame(void) {
+    if (!s_profile.enabled) return;
+    uint32_t now = now_micros();
+    uint32_t frameTime = now > s_profile.frameStartMicros ? now - s_profile.frameStartMicros : 0;
+    if (s_profile.timer == NULL && !s_profile.precisionWarned && s_profile.lastElapsed >= PRECISE_ELAPSED_SECONDS) {
+        /* A float keeps 24 bits, so its step grows with the elapsed time. */
+        s_profile.precisionWarned = true;
+        pd_LogWarn("PD Profile: the elapsed time hasn't been reset for %d s, so scopes are only timed to within %d us. "
+                   "Set a finer clock with pd_ProfileSetTimer.",
+                   (int) s_profile.lastElapsed, (int) (s_profile.lastElapsed * 1000000.0f / 8388608.0f) + 1);
+    }
+    s_profile.frameStartMicros = now;
+    s_profile.frame++;
+
+    s_profile.frameTimes[s_profile.frameTimeHead] = frameTime;
+    s_profile.frameTimeHead = (s_profile.frameTimeHead + 1) % PD_PROFILE_FRAME_HISTORY;
+    if (s_profile.frameTimeCount < PD_PROFILE_FRAME_HISTORY) {
+        s_profile.frameTimeCount++;
+    }
+    window_add(&s_profile.frameWindow, frameTime);
+
+    if (++s_profile.windowFrames >= PD_PROFILE_WINDOW_FRAMES) {
+        s_profile.windowFrames = 0;
+        window_publish(&s_profile.frameWindow, &s_profile.frameStats);
+        for (uint32_t i = 0; i < s_profile.scopeCount; i++) {
+            window_publish(&s_profile.scopes[i].window, &s_profile.scopes[i].published);
+        }
+    }
+}
+
+uint32_t pd_ProfileGetScopeStats(PDProfileScopeStats *stats, uint32_t capacity) {
+    uint32_t count = s_profile.scopeCount < capacity ? s_profile.scopeCount : capacity;
+    for (uint32_t i = 0; i < count; i++) {
+        stats[i] = s_profile.scopes[i].published;
+    }
+    return count;
+}
+
+void pd_ProfileGetFrameStats(PDProfileScopeStats *stats) {
+    *stats = s_profile.frameStats;
+    stats->name = "frame";
+}
+
+void pd_ProfileSetOverlay(bool visible, PDProfileCorner corner, LCDFont *font) {
+    s_profile.overlayVisible = visible;
+    s_profile.overlayCorner = corner;
+    s_profile.overlayFont = font;
+}
+
+static void draw_line_of_text(const char *text, int x, int y) {
+    pd_getPd()->graphics->drawText(text, strlen(text), kASCIIEncoding, x, y);
+}
+
+void pd_ProfileDrawOverlay(void) {
+    if (!s_profile.enabled || !s_profile.overlayVisible) return;
+    PlaydateAPI *pd = pd_getPd();
+
+    int lineHeight = s_profile.overlayFont != NULL
+                     ? pd->graphics->getFontHeight(s_profile.overlayFont)
+                     : OVERLAY_DEFAULT_LINE_HEIGHT;
+    int lines = 1 + (int) s_profile.scopeCount;
+    int maxLines = (LCD_HEIGHT - PD_PROFILE_GRAPH_HEIGHT - 3 * OVERLAY_MARGIN) / lineHeight;
+    if (lines > maxLines) {
+        lines = maxLines;
+    }
+    int width = PD_PROFILE_OVERLAY_WIDTH;
+    int height = lines * lineHeight + PD_PROFILE_GRAPH_HEIGHT + 3 * OVERLAY_MARGIN;
+    bool right = s_profile.overlayCorner == kPDProfileTopRight || s_profile.overlayCorner == kPDProfileBottomRight;
+    bool bottom = s_profile.overlayCorner == kPDProfileBottomLeft || s_profile.overlayCorner == kPDProfileBottomRight;
+    int left = right ? LCD_WIDTH - width : 0;
+    int top = bottom ? LCD_HEIGHT - height : 0;
+
+    LCDBitmapDrawMode previousMode = pd->graphics->setDrawMode(kDrawModeCopy);
+    if (s_profile.overlayFont != NULL) {
+        pd->graphics->setFont(s_profile.overlayFont);
+    }
+    pd->graphics->fillRect(left, top, width, height, kColorWhite);
+    pd->graphics->drawRect(left, top, width, height, kColorBlack);
+
+    /* min/avg/max in milliseconds */
+    char line[64];
+    int y = top + OVERLAY_MARGIN;
+    const PDProfileScopeStats *frame = &s_profile.frameStats;
+    pd_Format(
+        line, sizeof(line), "frame %.1f/%.1f/%.1f",
+        frame->minMicros / 1000.0, frame->avgMicros / 1000.0, frame->maxMicros / 1000.0
+    );
+    draw_line_of_text(line, left + OVERLAY_MARGIN, y);
+    y += lineHeight;
+    for (int i = 0; i < lines - 1; i++) {
+        const PDProfileScopeStats *scope = &s_profile.scopes[i].published;
+        pd_Format(
+            line, sizeof(line), "%s %.1f/%.1f/%.1f",
+            scope->name, scope->minMicros / 1000.0, scope->avgMicros / 1000.0, scope->maxMicros / 1000.0
+        );
+        draw_line_of_text(line, left + OVERLAY_MARGIN, y);
+        y += lineHeight;
+    }
+
+    /* Frame-time graph, oldest frame on the left, with a line at the frame budget. */
+    int graphTop = y + OVERLAY_MARGIN;
+    int graphBottom = graphTop + PD_PROFILE_GRAPH_HEIGHT - 1;
+    int graphWidth = width - 2 * OVERLAY_MARGIN;
+    int barWidth = graphWidth / PD_PROFILE_FRAME_HISTORY > 0 ? graphWidth / PD_PROFILE_FRAME_HISTORY : 1;
+    uint32_t scale = PD_PROFILE_FRAME_BUDGET_MICROS * 2;
+    for (uint32_t i = 0; i < s_profile.frameTimeCount; i++) {
+        uint32_t index = (s_profile.frameTimeHead + PD_PROFILE_FRAME_HISTORY - s_profile.frameTimeCount + i)
+                         % PD_PROFILE_FRAME_HISTORY;
+        uint32_t micros = s_profile.frameTimes[index] < scale ? s_profile.frameTimes[index] : scale;
+        int barHeight = (int) ((uint64_t) micros * PD_PROFILE_GRAPH_HEIGHT / scale);
+        int x = left + OVERLAY_MARGIN + (int) i * barWidth;
+        if (x + barWidth > left + width - OVERLAY_MARGIN) break;
+        if (barHeight > 0) {
+            pd->graphics->fillRect(x, graphBottom - barHeight + 1, barWidth, barHeight, kColorBlack);
+        }
+    }
+    int budgetY = graphBottom - PD_PROFILE_GRAPH_HEIGHT / 2;
+    pd->graphics->drawLine(left + OVERLAY_MARGIN, budgetY, left + width - OVERLAY_MARGIN, budgetY, 1, kColorXOR);
+
+    pd->graphics->setDrawMode(previousMode);
+}
+
+static bool write_line(SDFile *file, const char *fmt, ...) {
+    char line[160];
+    va_list v_list;
+    va_start(v_list, fmt);
+    int length = pd_FormatV(line, sizeof(line), fmt, v_list);
+    va_end(v_list);
+    if (length >= (int) sizeof(line)) {
+        length = (int) sizeof(line) - 1;
+    }
+    return pd_getPd()->file->write(file, line, (unsigned int) length) == length;
+}
+
+bool pd_ProfileDump(const char *path) {
+    PlaydateAPI *pd = pd_getPd();
+    SDFile *file = pd->file->open(path, kFileWrite);
+    if (file == NULL) {
+        pd_LogWarn("Cannot open %s to dump the profile: %s", path, pd->file->geterr());
+        return false;
+    }
+
+    bool ok = write_line(file, "[scopes]\nname,calls,min_us,avg_us,max_us\n");
+    const PDProfileScopeStats *frame = &s_profile.frameStats;
+    ok = ok && write_line(
+        file, "frame,%u,%u,%u,%u\n", frame->calls, frame->minMicros, frame->avgMicros, frame->maxMicros
+    );
+    for (uint32_t i = 0; ok && i < s_profile.scopeCount; i++) {
+        const PDProfileScopeStats *scope = &s_profile.scopes[i].published;
+        ok = write_line(
+            file, "%s,%u,%u,%u,%u\n",
+            scope->name, scope->calls, scope->minMicros, scope->avgMicros, scope->maxMicros
+        );
+    }
+
+    ok = ok && write_line(file, "\n[frames]\nframe,duration_us\n");
+    for (uint32_t i = 0; ok && i < s_profile.frameTimeCount; i++) {
+        uint32_t index = (s_profile.frameTimeHead + PD_PROFILE_FRAME_HISTORY - s_profile.frameTimeCount + i)
+                         % PD_PROFILE_FRAME_HISTORY;
+        ok = write_line(file, "%u,%u\n", s_profile.frame - s_profile.frameTimeCount + i, s_profile.frameTimes[index]);
+    }
+
+    ok = ok && write_line(file, "\n[samples]\nframe,scope,depth,start_us,duration_us\n");
+    for (uint32_t i = 0; ok && i < s_profile.sampleCount; i++) {
+        uint32_t index = (s_profile.sampleHead + PD_PROFILE_SAMPLE_CAPACITY - s_profile.sampleCount + i)
+                         % PD_PROFILE_SAMPLE_CAPACITY;
+        const ProfileSample *sample = &s_profile.samples[index];
+        ok = write_line(
+            file, "%u,%s,%u,%u,%u\n",
+            sample->frame, s_profile.scopes[sample->scope].name, sample->depth,
+            sample->startMicros, sample->durationMicros
+        );
+    }
+
+    pd->file->close(file);
+    if (!ok) {
+        pd_LogWarn("Failed to write the profile to %s.", path);
+    }
+    return ok;
+}
+
+#else
+
+void pd_ProfileSetEnabled(bool enabled) {
+    if (enabled) {
+        pd_LogWarn("Profiler is unavailable; build the library with PD_SHORTHAND_PROFILE.");
+    }
+}
+
+void pd_ProfileSetTimer(PDProfileTimer timer) {
+    UNUSED(timer);
+}
+
+void pd_ProfileBegin(const char *name) {
+    UNUSED(name);
+}
+
+void pd_ProfileEnd(void) {
+}
+
+void pd_ProfileNextFrame(void) {
+}
+
+uint32_t pd_ProfileGetScopeStats(PDProfileScopeStats *stats, uint32_t capacity) {
+    UNUSED(stats);
+    UNUSED(capacity);
+    return 0;
+}
+
+void pd_ProfileGetFrameStats(PDProfileScopeStats *stats) {
+    *stats = (PDProfileScopeStats) {"frame", 0, 0, 0, 0};
+}
+
+void pd_ProfileSetOverlay(bool visible, PDProfileCorner corner, LCDFont *font) {
+    UNUSED(visible);
+    UNUSED(corner);
+    UNUSED(font);
+}
+
+void pd_ProfileDrawOverlay(void) {
+}
+
+bool pd_ProfileDump(const char *path) {
+    UNUSED(path);
+    return false;
+}
+
+#endif
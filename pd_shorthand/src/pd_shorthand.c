@@ -1,3 +1,6 @@
+/* Keeps the call-site capturing macros from replacing the definitions below. */
+#define PD_SHORTHAND_INTERNAL
+
 #include "pd_shorthand.h"
 
 #include <stdlib.h>
@@ -5,86 +8,195 @@
 #include <string.h>
 #include <pd_api.h>
 
+#include "pd_trace_format.h"
+
 #define UNUSED(arg) (void)(arg)
 
-#if defined(PD_SHORTHAND_DEBUG)
+#if defined(PD_SHORTHAND_DEBUG) || defined(PD_SHORTHAND_STATS)
+/* The size of each live block is needed both for the leak report and for the statistics. */
+#define TRACK_ALLOCATIONS
+#endif
+
+#if defined(TRACK_ALLOCATIONS)
+/**
+ * @brief Initial slot count of the allocation table. Must be a power of two.
+ */
+#define ALLOC_TABLE_INITIAL_CAPACITY 256
+
+/**
+ * @brief Marker for a slot whose allocation has been freed.
+ *
+ * Probing must continue past these slots, while insertion can reuse them.
+ */
+#define ALLOC_TABLE_TOMBSTONE ((void *) UINTPTR_MAX)
+
 typedef struct AllocInfoTag {
     void *ptr;
     size_t size;
+    const char *file;
+    const char *func;
+    uint32_t line;
+    /* Allocation tag (scene) that was active when the block was allocated */
+    uint32_t tag;
 } AllocInfo;
 
-typedef struct AllocInfoArrayTag {
-    AllocInfo **info;
+/**
+ * @brief Open-addressed (linear probing) hash table keyed on the allocated pointer.
+ *
+ * All the slots live in one contiguous block so that lookups don't chase pointers.
+ */
+typedef struct AllocInfoTableTag {
+    AllocInfo *slots;
+    /* Number of live allocations */
     uint32_t count;
+    /* Number of live allocations plus tombstones */
+    uint32_t used;
     uint32_t capacity;
-} AllocInfoArray;
-
-static AllocInfoArray allocInfo = {0};
-#endif
+} AllocInfoTable;
 
-static PlaydateAPI *s_pd;
+static AllocInfoTable s_alloc_table = {0};
+/* Bytes in the blocks recorded in the table */
 static size_t s_total_allocation;
+#endif
 
-static void add_alloc_info(void *ptr, size_t size);
+#if defined(PD_SHORTHAND_TRACE)
+/**
+ * @brief Number of call sites the trace recorder can tell apart. Must be a power of two.
+ *
+ * Call sites beyond this are written with ID 0 (unknown).
+ */
+#define TRACE_SITE_CAPACITY 1024
+
+typedef struct TraceSiteTag {
+    const char *file;
+    uint32_t line;
+    uint16_t id;
+} TraceSite;
+
+typedef struct TraceStateTag {
+    SDFile *file;
+    /* Ring buffer of records that haven't been written to the file yet */
+    uint8_t *buffer;
+    size_t capacity;
+    size_t head;
+    size_t pending;
+    uint32_t frame;
+    /* Hash table of call sites that have been assigned an ID */
+    TraceSite *sites;
+    uint16_t siteCount;
+    bool active;
+} TraceState;
+
+static TraceState s_trace = {0};
+#endif
 
-static size_t edit_alloc_info(void *ptr, void *newPtr, size_t size);
+void *(*pd_cachedRealloc)(void *ptr, size_t size) = NULL;
+void (*pd_cachedLogToConsole)(const char *fmt, ...) = NULL;
+void (*pd_cachedError)(const char *fmt, ...) = NULL;
 
-static size_t free_alloc_info(void *ptr);
+static PlaydateAPI *s_pd;
+static uint32_t s_allocation_tag = PD_MEMORY_UNTAGGED;
+static PDMemoryStats s_stats = {.peakTag = PD_MEMORY_UNTAGGED};
 
-#if defined(PD_SHORTHAND_DEBUG)
 static void setup_alloc_info(void);
 
 static void assert_memory_leak(void);
 
-static int find_empty_entry_and_add(void *ptr, size_t size);
-#endif
+static void add_alloc_info(void *ptr, size_t size, const char *file, uint32_t line, const char *func);
+
+static void edit_alloc_info(void *ptr, void *newPtr, size_t size, const char *file, uint32_t line, const char *func);
+
+static void free_alloc_info(void *ptr);
+
+static void trace_record(PDTraceOp op, const void *ptr, size_t size, const char *file, uint32_t line, const char *func);
 
 void pd_Initialize(void *ctx) {
     PDContextLoader ld = {ctx};
     s_pd = ld.pd;
+    pd_cachedRealloc = s_pd->system->realloc;
+    pd_cachedLogToConsole = s_pd->system->logToConsole;
+    pd_cachedError = s_pd->system->error;
+    setup_alloc_info();
 }
 
 void pd_Finalize(void) {
+    pd_LogBufferDisable();
+    pd_TraceEnd();
+    pd_ArenaRelease(pd_GetFrameArena());
+    pd_ArenaRelease(pd_GetSceneArena());
+    assert_memory_leak();
     s_pd = NULL;
 }
 
 void *pd_Malloc(size_t size) {
+    return pd_MallocAt(size, NULL, 0, NULL);
+}
+
+void *pd_MallocAt(size_t size, const char *file, uint32_t line, const char *func) {
     void *ptr = s_pd->system->realloc(NULL, size);
     if (ptr != NULL) {
-        s_total_allocation += size;
-        add_alloc_info(ptr, size);
+        s_stats.allocationCount++;
+        add_alloc_info(ptr, size, file, line, func);
+        trace_record(kPDTraceOpAlloc, ptr, size, file, line, func);
     }
     return ptr;
 }
 
 void *pd_Realloc(void *ptr, size_t size) {
+    return pd_ReallocAt(ptr, size, NULL, 0, NULL);
+}
+
+void *pd_ReallocAt(void *ptr, size_t size, const char *file, uint32_t line, const char *func) {
+    if (ptr == NULL) {
+        return pd_MallocAt(size, file, line, func);
+    }
+    if (size == 0) {
+        pd_Free(ptr);
+        return NULL;
+    }
+
     void *newPtr = s_pd->system->realloc(ptr, size);
 
     if (newPtr != NULL) {
-        s_total_allocation += edit_alloc_info(ptr, newPtr, size);
+        edit_alloc_info(ptr, newPtr, size, file, line, func);
+        trace_record(kPDTraceOpReallocFrom, ptr, 0, NULL, 0, NULL);
+        trace_record(kPDTraceOpReallocTo, newPtr, size, file, line, func);
     }
 
     return newPtr;
 }
 
 void pd_Free(void *ptr) {
+    if (ptr == NULL) return;
     s_pd->system->realloc(ptr, 0);
-    s_total_allocation -= free_alloc_info(ptr);
+    s_stats.freeCount++;
+    free_alloc_info(ptr);
+    trace_record(kPDTraceOpFree, ptr, 0, NULL, 0, NULL);
 }
 
-void pd_Log(const char *msg) {
-    s_pd->system->logToConsole(msg);
+void pd_SetAllocationTag(uint32_t tag) {
+    s_allocation_tag = tag;
 }
 
-void pd_LogF(const char *fmt, ...) {
-    va_list v_list;
-    va_start(v_list, fmt);
-    char *out;
-    s_pd->system->vaFormatString(&out, fmt, v_list);
-    va_end(v_list);
+uint32_t pd_GetAllocationTag(void) {
+    return s_allocation_tag;
+}
 
-    s_pd->system->logToConsole(out);
-    s_pd->system->realloc(out, 0);
+void pd_GetMemoryStats(PDMemoryStats *stats) {
+    *stats = s_stats;
+#if defined(TRACK_ALLOCATIONS)
+    stats->tracked = true;
+#else
+    stats->tracked = false;
+#endif
+}
+
+void pd_ResetMemoryPeak(void) {
+    s_stats.peakBytes = s_stats.currentBytes;
+    s_stats.peakTag = s_allocation_tag;
+    for (uint32_t i = 0; i < s_stats.tagCount; i++) {
+        s_stats.tags[i].peakBytes = s_stats.tags[i].currentBytes;
+    }
 }
 
 void pd_Error(const char *msg) {
@@ -92,129 +204,508 @@ void pd_Error(const char *msg) {
 }
 
 void pd_ErrorF(const char *fmt, ...) {
+    char storage[PD_LOG_LINE_SIZE];
+    PDStrBuf sb;
+    pd_StrBufInit(&sb, storage, sizeof(storage));
     va_list v_list;
     va_start(v_list, fmt);
-    char *out;
-    s_pd->system->vaFormatString(&out, fmt, v_list);
+    /* Longer messages move to the heap rather than being cut short. */
+    pd_StrBufAppendFV(&sb, fmt, v_list);
     va_end(v_list);
 
-    s_pd->system->error(out);
+    s_pd->system->error("%s", pd_StrBufCStr(&sb));
     /* On devices, we don't actually get here, but still. */
-    s_pd->system->realloc(out, 0);
+    pd_StrBufRelease(&sb);
 }
 
 PlaydateAPI *pd_getPd(void) {
     return s_pd;
 }
 
-#if defined(PD_SHORTHAND_DEBUG)
-// I really would like to believe this part works, but I don't have 100% certainity
+#if defined(TRACK_ALLOCATIONS)
+
+static uint32_t size_class_of(size_t size) {
+    uint32_t sizeClass = 0;
+    while (size > 1 && sizeClass < PD_MEMORY_SIZE_CLASS_COUNT - 1) {
+        size >>= 1;
+        sizeClass++;
+    }
+    return sizeClass;
+}
+
+static PDMemoryTagStats *tag_stats_of(uint32_t tag) {
+    /* Scenes are few, and consecutive allocations almost always share a tag. */
+    static uint32_t s_last_index = 0;
+    if (s_last_index < s_stats.tagCount && s_stats.tags[s_last_index].tag == tag) {
+        return &s_stats.tags[s_last_index];
+    }
+    for (uint32_t i = 0; i < s_stats.tagCount; i++) {
+        if (s_stats.tags[i].tag != tag) continue;
+        s_last_index = i;
+        return &s_stats.tags[i];
+    }
+    if (s_stats.tagCount == PD_MEMORY_STATS_MAX_TAGS) {
+        return NULL;
+    }
+    PDMemoryTagStats *tagStats = &s_stats.tags[s_stats.tagCount];
+    tagStats->tag = tag;
+    tagStats->currentBytes = 0;
+    tagStats->peakBytes = 0;
+    tagStats->liveBlocks = 0;
+    s_last_index = s_stats.tagCount;
+    s_stats.tagCount++;
+    return tagStats;
+}
+
+/* The leak check counts tracked blocks only, so that a block the table could not record is not reported as leaked. */
+static void stats_add_block(size_t size, uint32_t tag) {
+    s_total_allocation += size;
+    s_stats.currentBytes += size;
+    s_stats.liveBlocks++;
+    s_stats.sizeClasses[size_class_of(size)]++;
+    if (s_stats.currentBytes > s_stats.peakBytes) {
+        s_stats.peakBytes = s_stats.currentBytes;
+        s_stats.peakTag = tag;
+    }
+
+    PDMemoryTagStats *tagStats = tag_stats_of(tag);
+    if (tagStats == NULL) return;
+    tagStats->currentBytes += size;
+    tagStats->liveBlocks++;
+    if (tagStats->currentBytes > tagStats->peakBytes) {
+        tagStats->peakBytes = tagStats->currentBytes;
+    }
+}
+
+static void stats_remove_block(size_t size, uint32_t tag) {
+    s_total_allocation -= size;
+    s_stats.currentBytes -= size;
+    s_stats.liveBlocks--;
+    s_stats.sizeClasses[size_class_of(size)]--;
+
+    PDMemoryTagStats *tagStats = tag_stats_of(tag);
+    if (tagStats == NULL) return;
+    tagStats->currentBytes -= size;
+    tagStats->liveBlocks--;
+}
+
+static uint32_t alloc_table_hash(const void *ptr) {
+    /* Allocations are at least 4-byte aligned, so the low bits carry no information. */
+    uint32_t key = (uint32_t) ((uintptr_t) ptr >> 2);
+    /* Fibonacci hashing */
+    return key * 2654435769u;
+}
+
+static AllocInfo *alloc_table_find(const void *ptr) {
+    uint32_t mask = s_alloc_table.capacity - 1;
+    uint32_t i = alloc_table_hash(ptr) & mask;
+    while (s_alloc_table.slots[i].ptr != NULL) {
+        if (s_alloc_table.slots[i].ptr == ptr) return &s_alloc_table.slots[i];
+        i = (i + 1) & mask;
+    }
+    return NULL;
+}
+
+static bool alloc_table_resize(uint32_t capacity) {
+    AllocInfo *oldSlots = s_alloc_table.slots;
+    uint32_t oldCapacity = s_alloc_table.capacity;
+
+    /* The table itself is not tracked, otherwise it would report itself as a leak. */
+    AllocInfo *newSlots = s_pd->system->realloc(NULL, sizeof(AllocInfo) * capacity);
+    if (newSlots == NULL) return false;
+    memset(newSlots, 0, sizeof(AllocInfo) * capacity);
+
+    uint32_t mask = capacity - 1;
+    for (uint32_t i = 0; i < oldCapacity; i++) {
+        AllocInfo *info = &oldSlots[i];
+        if (info->ptr == NULL || info->ptr == ALLOC_TABLE_TOMBSTONE) continue;
+        uint32_t j = alloc_table_hash(info->ptr) & mask;
+        while (newSlots[j].ptr != NULL) {
+            j = (j + 1) & mask;
+        }
+        newSlots[j] = *info;
+    }
+
+    s_alloc_table.slots = newSlots;
+    s_alloc_table.capacity = capacity;
+    s_alloc_table.used = s_alloc_table.count;
+    if (oldSlots != NULL) {
+        s_pd->system->realloc(oldSlots, 0);
+    }
+    return true;
+}
+
 static void assert_memory_leak(void) {
-    if (total_allocation != 0) {
-        pd->system->logToConsole(
+#if defined(PD_SHORTHAND_DEBUG)
+    if (s_total_allocation != 0) {
+        s_pd->system->logToConsole(
                 "[PD Shorthand Lib WARNING] Memory leak of %d bytes detected.",
-                total_allocation
+                s_total_allocation
         );
-        for (int i = 0; i < allocInfo.capacity; i++) {
-            if (allocInfo.info[i]->ptr == NULL) continue;
-            pd->system->logToConsole(
-                    "[PD Shorthand Lib WARNING] Memory addr %p with %d bytes appears left allocated",
-                    allocInfo.info[i]->ptr,
-                    allocInfo.info[i]->size
-            );
+        for (uint32_t i = 0; i < s_alloc_table.capacity; i++) {
+            AllocInfo *info = &s_alloc_table.slots[i];
+            if (info->ptr == NULL || info->ptr == ALLOC_TABLE_TOMBSTONE) continue;
+            if (info->file != NULL) {
+                s_pd->system->logToConsole(
+                        "[PD Shorthand Lib WARNING] Memory addr %p with %d bytes appears left allocated (allocated at %s:%d in %s)",
+                        info->ptr,
+                        info->size,
+                        info->file,
+                        info->line,
+                        info->func
+                );
+            } else {
+                s_pd->system->logToConsole(
+                        "[PD Shorthand Lib WARNING] Memory addr %p with %d bytes appears left allocated",
+                        info->ptr,
+                        info->size
+                );
+            }
         }
     } else {
-        pd->system->logToConsole("[PD Shorthand Lib INFO] Allocated memory cleanly freed!");
+        s_pd->system->logToConsole("[PD Shorthand Lib INFO] Allocated memory cleanly freed!");
     }
+#endif
 
-    for (int i = 0; i < allocInfo.capacity; i++) {
-        pd->system->realloc(allocInfo.info[i], 0);
+    s_pd->system->realloc(s_alloc_table.slots, 0);
+    s_alloc_table.slots = NULL;
+    s_alloc_table.count = 0;
+    s_alloc_table.used = 0;
+    s_alloc_table.capacity = 0;
+}
+
+static void setup_alloc_info(void) {
+    s_total_allocation = 0;
+    s_alloc_table.count = 0;
+    s_alloc_table.used = 0;
+    s_alloc_table.capacity = 0;
+    s_alloc_table.slots = NULL;
+    if (!alloc_table_resize(ALLOC_TABLE_INITIAL_CAPACITY)) {
+        s_pd->system->error("PD shorthand library startup failed");
     }
-    pd->system->realloc(allocInfo.info, 0);
 }
 
-static void setup_alloc_info(void)
-{
-    total_allocation = 0;
-    allocInfo.info = pd->system->realloc(NULL, sizeof(AllocInfo *) * 128);
-    if (allocInfo.info == NULL) {
-        pd->system->error("PD shorthand library startup failed");
+static bool alloc_table_insert(
+    void *ptr,
+    size_t size,
+    const char *file,
+    uint32_t line,
+    const char *func,
+    uint32_t tag
+) {
+    /* Keep the load factor (including tombstones) under 3/4 so that probe sequences stay short. */
+    if ((s_alloc_table.used + 1) * 4 > s_alloc_table.capacity * 3) {
+        /* If the table is mostly tombstones, rehashing at the same size is enough. */
+        uint32_t capacity = (s_alloc_table.count + 1) * 2 > s_alloc_table.capacity
+                            ? s_alloc_table.capacity * 2
+                            : s_alloc_table.capacity;
+        if (!alloc_table_resize(capacity)) {
+            s_pd->system->logToConsole(
+                    "[PD Shorthand Lib WARNING] Failed to allocate memory for allocation debug info, info might be inaccurate");
+            return false;
+        }
+    }
+
+    uint32_t mask = s_alloc_table.capacity - 1;
+    uint32_t i = alloc_table_hash(ptr) & mask;
+    AllocInfo *slot = NULL;
+    while (s_alloc_table.slots[i].ptr != NULL) {
+        if (s_alloc_table.slots[i].ptr == ALLOC_TABLE_TOMBSTONE && slot == NULL) {
+            slot = &s_alloc_table.slots[i];
+        }
+        i = (i + 1) & mask;
     }
-    for (int i = 0; i < 128; i++) {
-        allocInfo.info[i] = pd->system->realloc(NULL, sizeof(AllocInfo));
+    if (slot == NULL) {
+        slot = &s_alloc_table.slots[i];
+        s_alloc_table.used++;
     }
-    allocInfo.count = 0;
-    allocInfo.capacity = 128;
+
+    slot->ptr = ptr;
+    slot->size = size;
+    slot->file = file;
+    slot->line = line;
+    slot->func = func;
+    slot->tag = tag;
+    s_alloc_table.count++;
+    return true;
 }
 
-static int find_empty_entry_and_add(void *ptr, size_t size) {
-    for (int i = 0; i < allocInfo.capacity; i++) {
-        if (allocInfo.info[i]->ptr != NULL) continue;
-        allocInfo.info[i]->ptr = ptr;
-        allocInfo.info[i]->size = size;
-        allocInfo.count++;
-        return 1;
+static void add_alloc_info(void *ptr, size_t size, const char *file, uint32_t line, const char *func) {
+    if (alloc_table_insert(ptr, size, file, line, func, s_allocation_tag)) {
+        stats_add_block(size, s_allocation_tag);
+    }
+}
+
+static void edit_alloc_info(void *ptr, void *newPtr, size_t size, const char *file, uint32_t line, const char *func) {
+    AllocInfo *info = alloc_table_find(ptr);
+    if (info == NULL) {
+        /* Not tracked (e.g., allocated before initialization); start tracking it now. */
+        add_alloc_info(newPtr, size, file, line, func);
+        return;
+    }
+
+    /* The block stays attributed to whoever allocated it first. */
+    uint32_t tag = info->tag;
+    size_t prevSize = info->size;
+    stats_remove_block(prevSize, tag);
+    stats_add_block(size, tag);
+    if (newPtr == ptr) {
+        info->size = size;
+        if (file != NULL) {
+            info->file = file;
+            info->line = line;
+            info->func = func;
+        }
+        return;
+    }
+
+    /* The block has moved, so it has to be re-hashed under its new address. */
+    if (file == NULL) {
+        file = info->file;
+        line = info->line;
+        func = info->func;
     }
+    info->ptr = ALLOC_TABLE_TOMBSTONE;
+    s_alloc_table.count--;
+    if (!alloc_table_insert(newPtr, size, file, line, func, tag)) {
+        stats_remove_block(size, tag);
+    }
+}
 
-    return 0;
+static void free_alloc_info(void *ptr) {
+    AllocInfo *info = alloc_table_find(ptr);
+    if (info == NULL) return;
+    stats_remove_block(info->size, info->tag);
+    info->ptr = ALLOC_TABLE_TOMBSTONE;
+    info->size = 0;
+    s_alloc_table.count--;
 }
+#else
 
-static void add_alloc_info(void *ptr, size_t size) {
-    if (find_empty_entry_and_add(ptr, size)) return;
-    if (allocInfo.count == allocInfo.capacity) {
-        allocInfo.capacity *= 2;
-        void *newPtr = pd->system->realloc(allocInfo.info, sizeof(AllocInfo *) * allocInfo.capacity);
-        if (newPtr == NULL) {
-            pd->system->logToConsole(
-                    "[PD Shorthand Lib WARNING] Failed to allocate memory for allocation debug info, info might be inaccurate");
+static void setup_alloc_info(void) {
+}
+
+static void assert_memory_leak(void) {
+}
+
+static void add_alloc_info(void *ptr, size_t size, const char *file, uint32_t line, const char *func) {
+    UNUSED(ptr);
+    UNUSED(size);
+    UNUSED(file);
+    UNUSED(line);
+    UNUSED(func);
+}
+
+static void edit_alloc_info(void *ptr, void *newPtr, size_t size, const char *file, uint32_t line, const char *func) {
+    UNUSED(ptr);
+    UNUSED(newPtr);
+    UNUSED(size);
+    UNUSED(file);
+    UNUSED(line);
+    UNUSED(func);
+}
+
+static void free_alloc_info(void *ptr) {
+    UNUSED(ptr);
+}
+
+#endif
+
+#if defined(PD_SHORTHAND_TRACE)
+
+static void trace_flush(void) {
+    if (s_trace.pending == 0) return;
+    size_t tail = (s_trace.head + s_trace.capacity - s_trace.pending) % s_trace.capacity;
+    size_t firstPart = s_trace.capacity - tail;
+    if (firstPart > s_trace.pending) {
+        firstPart = s_trace.pending;
+    }
+    s_pd->file->write(s_trace.file, s_trace.buffer + tail, (unsigned int) firstPart);
+    if (firstPart < s_trace.pending) {
+        s_pd->file->write(s_trace.file, s_trace.buffer, (unsigned int) (s_trace.pending - firstPart));
+    }
+    s_trace.pending = 0;
+}
+
+static void trace_write(const uint8_t *data, size_t length) {
+    if (length == 0) return;
+    if (s_trace.pending + length > s_trace.capacity) {
+        /* Out of room before the end of the frame; this one will show up in the timing. */
+        trace_flush();
+        if (length > s_trace.capacity) {
+            /* Doesn't fit even in the empty buffer (a very long file name), so it goes straight to the file. */
+            s_pd->file->write(s_trace.file, data, (unsigned int) length);
             return;
         }
-        for (int i = allocInfo.capacity / 2; i < allocInfo.capacity; i++) {
-            allocInfo.info[i] = pd->system->realloc(NULL, sizeof(AllocInfo));
+    }
+    size_t firstPart = s_trace.capacity - s_trace.head;
+    if (firstPart > length) {
+        firstPart = length;
+    }
+    memcpy(s_trace.buffer + s_trace.head, data, firstPart);
+    memcpy(s_trace.buffer, data + firstPart, length - firstPart);
+    s_trace.head = (s_trace.head + length) % s_trace.capacity;
+    s_trace.pending += length;
+}
+
+static void put_u16(uint8_t *out, uint16_t value) {
+    out[0] = (uint8_t) value;
+    out[1] = (uint8_t) (value >> 8);
+}
+
+static void put_u32(uint8_t *out, uint32_t value) {
+    put_u16(out, (uint16_t) value);
+    put_u16(out + 2, (uint16_t) (value >> 16));
+}
+
+static void put_u64(uint8_t *out, uint64_t value) {
+    put_u32(out, (uint32_t) value);
+    put_u32(out + 4, (uint32_t) (value >> 32));
+}
+
+static void trace_write_record(PDTraceOp op, uint16_t site, size_t size, const void *ptr) {
+    uint8_t record[PD_TRACE_RECORD_SIZE];
+    record[0] = (uint8_t) op;
+    record[1] = 0;
+    put_u16(record + 2, site);
+    put_u32(record + 4, s_trace.frame);
+    put_u32(record + 8, (uint32_t) size);
+    put_u64(record + 12, (uint64_t) (uintptr_t) ptr);
+    trace_write(record, sizeof(record));
+}
+
+static void trace_write_string(const char *str) {
+    uint8_t length[2];
+    size_t len = str != NULL ? strlen(str) : 0;
+    if (len > UINT16_MAX) {
+        len = UINT16_MAX;
+    }
+    put_u16(length, (uint16_t) len);
+    trace_write(length, sizeof(length));
+    trace_write((const uint8_t *) str, len);
+}
+
+/**
+ * @brief Gets the ID of a call site, writing a site record the first time it's seen.
+ */
+static uint16_t trace_site_id(const char *file, uint32_t line, const char *func) {
+    if (file == NULL) return 0;
+
+    uint32_t mask = TRACE_SITE_CAPACITY - 1;
+    uint32_t i = ((uint32_t) ((uintptr_t) file >> 2) * 2654435769u ^ line * 40503u) & mask;
+    while (s_trace.sites[i].file != NULL) {
+        if (s_trace.sites[i].file == file && s_trace.sites[i].line == line) {
+            return s_trace.sites[i].id;
         }
+        i = (i + 1) & mask;
     }
-    find_empty_entry_and_add(ptr, size);
+    /* Keep a quarter of the table empty so that lookups of unknown sites terminate quickly. */
+    if ((uint32_t) (s_trace.siteCount + 1) * 4 > TRACE_SITE_CAPACITY * 3) return 0;
+
+    s_trace.siteCount++;
+    s_trace.sites[i].file = file;
+    s_trace.sites[i].line = line;
+    s_trace.sites[i].id = s_trace.siteCount;
+
+    trace_write_record(kPDTraceOpSite, s_trace.siteCount, line, NULL);
+    trace_write_string(file);
+    trace_write_string(func);
+    return s_trace.siteCount;
+}
+
+static void trace_record(PDTraceOp op, const void *ptr, size_t size, const char *file, uint32_t line, const char *func) {
+    if (!s_trace.active) return;
+    uint16_t site = trace_site_id(file, line, func);
+    trace_write_record(op, site, size, ptr);
 }
 
-static ssize_t edit_alloc_info(void *ptr, void *newPtr, size_t size) {
-    for (int i = 0; i < allocInfo.capacity; i++) {
-        if (allocInfo.info[i]->ptr != ptr) continue;
-        allocInfo.info[i]->ptr = newPtr;
-        ssize_t prevSize = (ssize_t) allocInfo.info[i]->size;
-        allocInfo.info[i]->size = size;
-        return (ssize_t) size - prevSize;
+bool pd_TraceBegin(const char *path, size_t bufferSize) {
+    if (s_trace.active) {
+        pd_TraceEnd();
     }
-    return 0;
+
+    if (bufferSize < PD_TRACE_RECORD_SIZE * 64) {
+        bufferSize = PD_TRACE_RECORD_SIZE * 64;
+    }
+    /* The recorder's own memory bypasses pd_Malloc so that it doesn't show up in the trace or the stats. */
+    s_trace.buffer = s_pd->system->realloc(NULL, bufferSize);
+    s_trace.sites = s_pd->system->realloc(NULL, sizeof(TraceSite) * TRACE_SITE_CAPACITY);
+    s_trace.file = s_pd->file->open(path, kFileWrite);
+    if (s_trace.buffer == NULL || s_trace.sites == NULL || s_trace.file == NULL) {
+        s_pd->system->logToConsole("[PD Shorthand Lib WARNING] Failed to start allocation trace to %s", path);
+        if (s_trace.file != NULL) {
+            s_pd->file->close(s_trace.file);
+        }
+        s_pd->system->realloc(s_trace.buffer, 0);
+        s_pd->system->realloc(s_trace.sites, 0);
+        s_trace = (TraceState) {0};
+        return false;
+    }
+    memset(s_trace.sites, 0, sizeof(TraceSite) * TRACE_SITE_CAPACITY);
+    s_trace.capacity = bufferSize;
+    s_trace.head = 0;
+    s_trace.pending = 0;
+    s_trace.frame = 0;
+    s_trace.siteCount = 0;
+    s_trace.active = true;
+
+    uint8_t header[PD_TRACE_HEADER_SIZE];
+    memcpy(header, PD_TRACE_MAGIC, 4);
+    put_u16(header + 4, PD_TRACE_VERSION);
+    put_u16(header + 6, PD_TRACE_RECORD_SIZE);
+    trace_write(header, sizeof(header));
+    return true;
 }
 
-static size_t free_alloc_info(void *ptr) {
-    for (int i = 0; i < allocInfo.capacity; i++) {
-        if (allocInfo.info[i]->ptr != ptr) continue;
-        allocInfo.info[i]->ptr = NULL;
-        size_t size = allocInfo.info[i]->size;
-        allocInfo.info[i]->size = 0;
-        allocInfo.count--;
-        return size;
+void pd_TraceNextFrame(void) {
+    if (!s_trace.active) return;
+    s_trace.frame++;
+    /* Flush between frames rather than in the middle of one, before the buffer fills up. */
+    if (s_trace.pending * 2 >= s_trace.capacity) {
+        trace_flush();
     }
-    return 0;
 }
+
+void pd_TraceFlush(void) {
+    if (!s_trace.active) return;
+    trace_flush();
+}
+
+void pd_TraceEnd(void) {
+    if (!s_trace.active) return;
+    trace_flush();
+    s_pd->file->close(s_trace.file);
+    s_pd->system->realloc(s_trace.buffer, 0);
+    s_pd->system->realloc(s_trace.sites, 0);
+    s_trace = (TraceState) {0};
+}
+
 #else
 
-static void add_alloc_info(void *ptr, size_t size) {
+static void trace_record(PDTraceOp op, const void *ptr, size_t size, const char *file, uint32_t line, const char *func) {
+    UNUSED(op);
     UNUSED(ptr);
     UNUSED(size);
+    UNUSED(file);
+    UNUSED(line);
+    UNUSED(func);
 }
 
-static size_t edit_alloc_info(void *ptr, void *newPtr, size_t size) {
-    UNUSED(ptr);
-    UNUSED(newPtr);
-    UNUSED(size);
-    return 0;
+bool pd_TraceBegin(const char *path, size_t bufferSize) {
+    UNUSED(path);
+    UNUSED(bufferSize);
+    s_pd->system->logToConsole(
+            "[PD Shorthand Lib WARNING] Allocation trace is unavailable; build the library with PD_SHORTHAND_TRACE.");
+    return false;
 }
 
-static size_t free_alloc_info(void *ptr) {
-    UNUSED(ptr);
-    return 0;
+void pd_TraceNextFrame(void) {
+}
+
+void pd_TraceFlush(void) {
+}
+
+void pd_TraceEnd(void) {
 }
 
 #endif
@@ -8,6 +8,16 @@
  *
  * @remarks If you define PD_SHORTHAND_DEBUG,
  *          this library will report memory leak when finalizing.
+ *          Define it for your game as well so that pd_Malloc(size_t) and pd_Realloc(void*, size_t)
+ *          record where each allocation was made.
+ * @remarks If you define PD_SHORTHAND_DEBUG or PD_SHORTHAND_STATS,
+ *          pd_GetMemoryStats(PDMemoryStats*) reports byte-level statistics.
+ * @remarks If you define PD_SHORTHAND_TRACE,
+ *          allocations can be recorded to a file with pd_TraceBegin(const char*, size_t).
+ * @remarks If you define PD_SHORTHAND_PROFILE,
+ *          frames can be profiled with pd_ProfileBegin(const char*) and pd_ProfileEnd(void).
+ * @remarks If you define PD_SHORTHAND_INLINE for your game,
+ *          the thin wrappers are inlined (see #PD_SHORTHAND_INLINE).
  *
  * @author  Clpsplug \<clpsplug\@clpsplug.com>
  * @license MIT
@@ -17,6 +27,7 @@
 #define PD_SHORTHAND_H
 
 #include <stdlib.h>
+#include <stdarg.h>
 #include <stdbool.h>
 #include <pd_api.h>
 
@@ -120,6 +131,37 @@ void *pd_Malloc(size_t size);
  */
 void *pd_Realloc(void *ptr, size_t size);
 
+/**
+ * @brief pd_Malloc(size_t) that also records where the allocation was made.
+ *
+ * You don't usually call this directly; when PD_SHORTHAND_DEBUG is defined,
+ * pd_Malloc(size_t) is replaced with this API with the call site filled in.
+ *
+ * @param[in] size Memory allocation size to request.
+ * @param[in] file Source file of the call site. Must be a string literal (or outlive the allocation).
+ * @param[in] line Line number of the call site.
+ * @param[in] func Function name of the call site. Must be a string literal (or outlive the allocation).
+ * @returns Pointer to the allocated memory, or NULL if allocation fails.
+ * @remarks The call site is only kept if the library itself is built with PD_SHORTHAND_DEBUG.
+ */
+void *pd_MallocAt(size_t size, const char *file, uint32_t line, const char *func);
+
+/**
+ * @brief pd_Realloc(void*, size_t) that also records where the re-allocation was made.
+ *
+ * You don't usually call this directly; when PD_SHORTHAND_DEBUG is defined,
+ * pd_Realloc(void*, size_t) is replaced with this API with the call site filled in.
+ *
+ * @param[in] ptr  Pointer to the original memory location.
+ * @param[in] size New requested size.
+ * @param[in] file Source file of the call site. Must be a string literal (or outlive the allocation).
+ * @param[in] line Line number of the call site.
+ * @param[in] func Function name of the call site. Must be a string literal (or outlive the allocation).
+ * @returns Pointer to the re-allocated memory, or NULL if allocation fails.
+ * @see pd_Realloc
+ */
+void *pd_ReallocAt(void *ptr, size_t size, const char *file, uint32_t line, const char *func);
+
 /**
  * @brief API that replicates @c free(3).
  *
@@ -127,6 +169,99 @@ void *pd_Realloc(void *ptr, size_t size);
  */
 void pd_Free(void *ptr);
 
+/**
+ * @brief Gets the PlaydateAPI* object passed to pd_Initialize(void*).
+ *
+ * @returns PlaydateAPI* object, or NULL if the library isn't initialized.
+ */
+PlaydateAPI *pd_getPd(void);
+
+/**
+ * @def PD_LOG_LEVEL_DEBUG
+ * @brief Log level for pd_LogDebug.
+ */
+#define PD_LOG_LEVEL_DEBUG 0
+/**
+ * @def PD_LOG_LEVEL_INFO
+ * @brief Log level for pd_LogInfo, pd_Log(const char*) and pd_LogF(const char*, ...).
+ */
+#define PD_LOG_LEVEL_INFO 1
+/**
+ * @def PD_LOG_LEVEL_WARN
+ * @brief Log level for pd_LogWarn.
+ */
+#define PD_LOG_LEVEL_WARN 2
+/**
+ * @def PD_LOG_LEVEL_ERROR
+ * @brief Log level for pd_LogError.
+ */
+#define PD_LOG_LEVEL_ERROR 3
+/**
+ * @def PD_LOG_LEVEL_NONE
+ * @brief Set #PD_LOG_LEVEL to this to remove all the logging calls.
+ */
+#define PD_LOG_LEVEL_NONE 4
+
+#ifndef PD_LOG_LEVEL
+/**
+ * @def PD_LOG_LEVEL
+ * @brief Compile-time log threshold.
+ *
+ * Logging calls below this level are removed by the preprocessor,
+ * arguments included, so they cost nothing at runtime.
+ * Define it (e.g., @c -DPD_LOG_LEVEL=PD_LOG_LEVEL_WARN) for release builds.
+ */
+#define PD_LOG_LEVEL PD_LOG_LEVEL_DEBUG
+#endif
+
+#ifndef PD_LOG_LINE_SIZE
+/**
+ * @def PD_LOG_LINE_SIZE
+ * @brief Maximum length of a formatted log line, including the terminating NUL.
+ *
+ * pd_LogF(const char*, ...) and pd_LogLevelF format their line on the stack and cut it to
+ * #PD_LOG_LINE_SIZE - 1 characters, so that logging never allocates.
+ * While the log buffer is enabled, the same limit applies to every line, pd_Log(const char*) included.
+ * Raise it (e.g., @c -DPD_LOG_LINE_SIZE=1024) if longer lines must be logged whole.
+ */
+#define PD_LOG_LINE_SIZE 256
+#endif
+
+/**
+ * @brief One of the @c PD_LOG_LEVEL_* values.
+ */
+typedef uint32_t PDLogLevel;
+
+/**
+ * @brief Formats a string into a caller-provided buffer, like @c vsnprintf(3).
+ *
+ * Unlike @c playdate->system->vaFormatString, this never allocates.
+ *
+ * Supports the flags @c -+ #0, width and precision (including @c *),
+ * the length modifiers @c hh h l ll z t j L,
+ * and the conversions @c d i u x X o c s p %% f F e E g G a A.
+ * Floating-point values are rounded exactly as printf does, over the whole range of @c double.
+ *
+ * @param[out] out      Buffer to write to. Always NUL-terminated if @c capacity is not 0.
+ * @param[in]  capacity Size of @c out in bytes.
+ * @param[in]  fmt      Format string.
+ * @param[in]  args     Format variables.
+ * @returns Length the formatted string would have without truncation (excluding the NUL).
+ */
+int pd_FormatV(char *out, size_t capacity, const char *fmt, va_list args);
+
+/**
+ * @brief Formats a string into a caller-provided buffer, like @c snprintf(3).
+ *
+ * @param[out] out      Buffer to write to. Always NUL-terminated if @c capacity is not 0.
+ * @param[in]  capacity Size of @c out in bytes.
+ * @param[in]  fmt      Format string.
+ * @param[in]  ...      Format variables.
+ * @returns Length the formatted string would have without truncation (excluding the NUL).
+ * @see pd_FormatV
+ */
+int pd_Format(char *out, size_t capacity, const char *fmt, ...);
+
 /**
  * @brief Equivalent of @c playdate->system->logToConsole
  * but without an ability to format.
@@ -140,12 +275,70 @@ void pd_Log(const char *msg);
  * @brief Shorthand for @c playdate->system->logToConsole.
  *
  * This API can format the log.
+ * The message is formatted on the stack with pd_FormatV(char*, size_t, const char*, va_list),
+ * and is truncated to #PD_LOG_LINE_SIZE - 1 characters (255 by default), without notice.
+ * Unlike pd_ErrorF(const char*, ...), it never moves longer messages to the heap.
  *
  * @param[in] fmt Format string
  * @param[in] ... Format variables
  */
 void pd_LogF(const char *fmt, ...);
 
+/**
+ * @brief Logs a formatted message with a level prefix (e.g., @c "[WARN] ").
+ *
+ * Use the pd_LogDebug, pd_LogInfo, pd_LogWarn and pd_LogError macros instead,
+ * so that the calls below #PD_LOG_LEVEL are removed at compile time.
+ * Like pd_LogF(const char*, ...), the line, prefix included, is truncated to #PD_LOG_LINE_SIZE - 1 characters.
+ *
+ * @param[in] level One of the @c PD_LOG_LEVEL_* values.
+ * @param[in] fmt   Format string
+ * @param[in] ...   Format variables
+ */
+void pd_LogLevelF(PDLogLevel level, const char *fmt, ...);
+
+/**
+ * @brief Sends log lines to a RAM ring buffer instead of straight to the console.
+ *
+ * Lines are formatted into @c storage and only handed to @c logToConsole
+ * (and to the file set with pd_LogBufferSetFile(const char*)) when the buffer is flushed.
+ * If the buffer fills up before then, the oldest lines are dropped,
+ * and the number of dropped lines is reported at the next flush.
+ *
+ * @param[in] storage             Memory for the buffer. Must stay valid until pd_LogBufferDisable(void).
+ * @param[in] size                Size of @c storage in bytes.
+ * @param[in] flushIntervalFrames Flush every this many frames (see pd_LogBufferNextFrame(void)).
+ *                                0 means only flush with pd_LogBufferFlush(void).
+ */
+void pd_LogBufferEnable(void *storage, size_t size, uint32_t flushIntervalFrames);
+
+/**
+ * @brief Also writes flushed log lines to a file.
+ *
+ * @param[in] path Path of the file to append to, or NULL to stop writing to a file.
+ * @returns false if the file couldn't be opened.
+ */
+bool pd_LogBufferSetFile(const char *path);
+
+/**
+ * @brief Writes all the buffered log lines out.
+ */
+void pd_LogBufferFlush(void);
+
+/**
+ * @brief Counts a frame and flushes the log buffer if the interval has elapsed.
+ *
+ * The scene engine calls this at the end of every pdScene_Update.
+ */
+void pd_LogBufferNextFrame(void);
+
+/**
+ * @brief Flushes the log buffer, closes its file and goes back to logging straight to the console.
+ *
+ * Called by pd_Finalize(void) as well.
+ */
+void pd_LogBufferDisable(void);
+
 /**
  * @brief Equivalent of @c playdate->system->error
  * but without an ability to format.
@@ -163,7 +356,9 @@ void pd_Error(const char *msg);
 /**
  * @brief Shorthand for @c playdate->system->error.
  *
- * This API can format the error.
+ * This API can format the error, with pd_FormatV(char*, size_t, const char*, va_list).
+ * Messages shorter than @c PD_LOG_LINE_SIZE bytes are formatted on the stack;
+ * longer ones are formatted on the heap rather than truncated, since the game stops right after.
  *
  * @param[in] fmt Format string
  * @param[in] ... Format variables
@@ -175,4 +370,930 @@ void pd_Error(const char *msg);
  */
 void pd_ErrorF(const char *fmt, ...);
 
+/**
+ * @def PD_MEMORY_UNTAGGED
+ * @brief Allocation tag used when no tag (scene) is active.
+ *
+ * Same value as @c PD_SCENE_INVALID_SCENE_ID of the scene engine.
+ */
+#define PD_MEMORY_UNTAGGED UINT32_MAX
+
+/**
+ * @def PD_MEMORY_SIZE_CLASS_COUNT
+ * @brief Number of buckets in PDMemoryStats::sizeClasses.
+ */
+#define PD_MEMORY_SIZE_CLASS_COUNT 24
+
+#ifndef PD_MEMORY_STATS_MAX_TAGS
+/**
+ * @def PD_MEMORY_STATS_MAX_TAGS
+ * @brief Maximum number of allocation tags (scenes) that get their own statistics.
+ *
+ * Allocations with tags beyond this count are only counted in the totals.
+ */
+#define PD_MEMORY_STATS_MAX_TAGS 16
+#endif
+
+/**
+ * @brief Memory statistics of allocations made with a given tag.
+ *
+ * @see pd_SetAllocationTag
+ */
+typedef struct PDMemoryTagStatsTag {
+    /**
+     * @brief The allocation tag. The scene engine uses the Scene::sceneIdentifier.
+     */
+    uint32_t tag;
+    /**
+     * @brief Bytes currently allocated with this tag.
+     */
+    size_t currentBytes;
+    /**
+     * @brief Highest value PDMemoryTagStats::currentBytes has reached.
+     */
+    size_t peakBytes;
+    /**
+     * @brief Number of blocks currently allocated with this tag.
+     */
+    uint32_t liveBlocks;
+} PDMemoryTagStats;
+
+/**
+ * @brief Memory statistics of pd_Malloc(size_t), pd_Realloc(void*, size_t) and pd_Free(void*).
+ *
+ * @see pd_GetMemoryStats
+ */
+typedef struct PDMemoryStatsTag {
+    /**
+     * @brief Whether the byte-level figures below are available.
+     *
+     * Only PDMemoryStats::allocationCount and PDMemoryStats::freeCount are available
+     * unless the library is built with PD_SHORTHAND_DEBUG or PD_SHORTHAND_STATS.
+     */
+    bool tracked;
+    /**
+     * @brief Bytes currently allocated.
+     */
+    size_t currentBytes;
+    /**
+     * @brief Highest value PDMemoryStats::currentBytes has reached.
+     */
+    size_t peakBytes;
+    /**
+     * @brief Allocation tag that was active when PDMemoryStats::peakBytes was reached.
+     */
+    uint32_t peakTag;
+    /**
+     * @brief Number of blocks currently allocated.
+     */
+    uint32_t liveBlocks;
+    /**
+     * @brief Number of successful allocations (including pd_Realloc(void*, size_t) with NULL) so far.
+     */
+    uint32_t allocationCount;
+    /**
+     * @brief Number of calls to pd_Free(void*) with a non-NULL pointer so far.
+     */
+    uint32_t freeCount;
+    /**
+     * @brief Number of live blocks per size class.
+     *
+     * Bucket @c i counts blocks whose size is in [2^i, 2^(i+1)),
+     * except for the last bucket which counts everything larger as well.
+     */
+    uint32_t sizeClasses[PD_MEMORY_SIZE_CLASS_COUNT];
+    /**
+     * @brief Statistics per allocation tag, in the order the tags were first seen.
+     */
+    PDMemoryTagStats tags[PD_MEMORY_STATS_MAX_TAGS];
+    /**
+     * @brief Number of valid entries in PDMemoryStats::tags.
+     */
+    uint32_t tagCount;
+} PDMemoryStats;
+
+/**
+ * @brief Sets the tag attributed to subsequent allocations.
+ *
+ * The scene engine sets this to the Scene::sceneIdentifier of the scene being loaded,
+ * and back to #PD_MEMORY_UNTAGGED after unloading it.
+ * Memory stays attributed to the tag it was allocated with, even if it is freed or re-allocated later.
+ *
+ * @param[in] tag Tag to set.
+ */
+void pd_SetAllocationTag(uint32_t tag);
+
+/**
+ * @brief Gets the tag attributed to allocations.
+ *
+ * @returns Current allocation tag, or #PD_MEMORY_UNTAGGED.
+ */
+uint32_t pd_GetAllocationTag(void);
+
+/**
+ * @brief Gets the current memory statistics.
+ *
+ * Cheap enough to call every frame.
+ *
+ * @param[out] stats Where to write the statistics.
+ * @remarks Only covers memory allocated through this library, not through @c playdate->system->realloc directly.
+ */
+void pd_GetMemoryStats(PDMemoryStats *stats);
+
+/**
+ * @brief Resets the peak values (overall and per tag) to the current values.
+ */
+void pd_ResetMemoryPeak(void);
+
+/**
+ * @def PD_ARENA_ALIGNMENT
+ * @brief Alignment of the memory returned by pd_ArenaAlloc(PDArena*, size_t).
+ */
+#define PD_ARENA_ALIGNMENT 8
+
+#ifndef PD_ARENA_DEFAULT_BLOCK_SIZE
+/**
+ * @def PD_ARENA_DEFAULT_BLOCK_SIZE
+ * @brief Block size used when pd_ArenaInit(PDArena*, size_t) is given 0.
+ */
+#define PD_ARENA_DEFAULT_BLOCK_SIZE 4096
+#endif
+
+#ifndef PD_FRAME_ARENA_BLOCK_SIZE
+/**
+ * @def PD_FRAME_ARENA_BLOCK_SIZE
+ * @brief Block size of the arena returned by pd_GetFrameArena(void).
+ *
+ * Define this when building the library to change it.
+ */
+#define PD_FRAME_ARENA_BLOCK_SIZE 8192
+#endif
+
+#ifndef PD_SCENE_ARENA_BLOCK_SIZE
+/**
+ * @def PD_SCENE_ARENA_BLOCK_SIZE
+ * @brief Block size of the arena returned by pd_GetSceneArena(void).
+ *
+ * Define this when building the library to change it.
+ */
+#define PD_SCENE_ARENA_BLOCK_SIZE 8192
+#endif
+
+/**
+ * @brief A chunk of memory owned by a #PDArena. Opaque.
+ */
+typedef struct PDArenaBlockTag PDArenaBlock;
+
+/**
+ * @brief Region (bump) allocator.
+ *
+ * Allocating from an arena only moves a cursor forward,
+ * and everything allocated from it is thrown away at once with pd_ArenaReset(PDArena*)
+ * or pd_ArenaRewind(PDArena*, PDArenaMark).
+ * Individual allocations cannot be freed.
+ *
+ * The memory is requested from pd_Malloc(size_t) in blocks of PDArena::blockSize bytes,
+ * so it is included in the leak report.
+ *
+ * @code
+ * PDArena arena;
+ * pd_ArenaInit(&arena, 0);
+ * Particle *particles = pd_ArenaAlloc(&arena, sizeof(Particle) * 64);
+ * // ...
+ * pd_ArenaRelease(&arena);
+ * @endcode
+ */
+typedef struct PDArenaTag {
+    /**
+     * @brief First block of the arena. NULL until the first allocation.
+     */
+    PDArenaBlock *head;
+    /**
+     * @brief Block currently being allocated from.
+     */
+    PDArenaBlock *current;
+    /**
+     * @brief Minimum size of a block. Larger requests get a block of their own size.
+     */
+    size_t blockSize;
+} PDArena;
+
+/**
+ * @brief Saved position of a #PDArena, used to roll back temporary allocations.
+ *
+ * @see pd_ArenaGetMark
+ * @see pd_ArenaRewind
+ */
+typedef struct PDArenaMarkTag {
+    PDArenaBlock *block;
+    size_t offset;
+} PDArenaMark;
+
+/**
+ * @brief Initializes an arena.
+ *
+ * No memory is allocated until the first pd_ArenaAlloc(PDArena*, size_t).
+ *
+ * @param[out] arena     Arena to initialize.
+ * @param[in]  blockSize Size of each block. Pass 0 to use #PD_ARENA_DEFAULT_BLOCK_SIZE.
+ */
+void pd_ArenaInit(PDArena *arena, size_t blockSize);
+
+/**
+ * @brief Allocates memory from an arena, aligned to #PD_ARENA_ALIGNMENT.
+ *
+ * @param[in] arena Arena to allocate from.
+ * @param[in] size  Number of bytes to allocate.
+ * @returns Pointer to the memory, or NULL if a new block was needed and its allocation failed.
+ */
+void *pd_ArenaAlloc(PDArena *arena, size_t size);
+
+/**
+ * @brief Allocates memory from an arena with a specific alignment.
+ *
+ * @param[in] arena     Arena to allocate from.
+ * @param[in] size      Number of bytes to allocate.
+ * @param[in] alignment Alignment of the returned pointer. Must be a power of two.
+ * @returns Pointer to the memory, or NULL if a new block was needed and its allocation failed.
+ */
+void *pd_ArenaAllocAligned(PDArena *arena, size_t size, size_t alignment);
+
+/**
+ * @brief Saves the current position of an arena.
+ *
+ * @param[in] arena Arena to save the position of.
+ * @returns Position that can be passed to pd_ArenaRewind(PDArena*, PDArenaMark).
+ */
+PDArenaMark pd_ArenaGetMark(const PDArena *arena);
+
+/**
+ * @brief Discards everything allocated after @c mark was taken.
+ *
+ * @param[in] arena Arena to rewind.
+ * @param[in] mark  Position returned by pd_ArenaGetMark(const PDArena*) on the same arena.
+ * @warning Rewinding to a mark taken before a pd_ArenaReset(PDArena*) is undefined behavior.
+ */
+void pd_ArenaRewind(PDArena *arena, PDArenaMark mark);
+
+/**
+ * @brief Discards everything allocated from an arena, but keeps its blocks for reuse.
+ *
+ * @param[in] arena Arena to reset.
+ */
+void pd_ArenaReset(PDArena *arena);
+
+/**
+ * @brief Discards everything allocated from an arena and frees its blocks.
+ *
+ * The arena can still be used afterward.
+ *
+ * @param[in] arena Arena to release.
+ */
+void pd_ArenaRelease(PDArena *arena);
+
+/**
+ * @brief Gets the built-in arena for per-frame allocations.
+ *
+ * The scene engine resets this arena every time pdScene_Update returns,
+ * so anything allocated from it is valid until the end of the current update.
+ *
+ * @returns The frame arena.
+ */
+PDArena *pd_GetFrameArena(void);
+
+/**
+ * @brief Gets the built-in arena for per-scene allocations.
+ *
+ * The scene engine releases this arena in pdScene_Unload,
+ * right after the unload function of the scene returns.
+ *
+ * @returns The scene arena.
+ */
+PDArena *pd_GetSceneArena(void);
+
+#ifndef PD_POOL_DEFAULT_OBJECTS_PER_CHUNK
+/**
+ * @def PD_POOL_DEFAULT_OBJECTS_PER_CHUNK
+ * @brief Number of objects per chunk used when pd_PoolInit is given 0.
+ */
+#define PD_POOL_DEFAULT_OBJECTS_PER_CHUNK 64
+#endif
+
+/**
+ * @brief A chunk of slots owned by a #PDPool. Opaque.
+ */
+typedef struct PDPoolChunkTag PDPoolChunk;
+
+/**
+ * @brief Fixed-size object pool.
+ *
+ * Hands out same-sized slots from chunks allocated with pd_Malloc(size_t).
+ * Freed slots go onto a free list that is stored inside the slots themselves,
+ * so both pd_PoolAlloc(PDPool*) and pd_PoolFree(PDPool*, void*) are O(1)
+ * and never call the system allocator unless the pool needs another chunk.
+ * Chunks are only returned to the system by pd_PoolRelease(PDPool*).
+ *
+ * @code
+ * PDPool bullets;
+ * pd_PoolInit(&bullets, sizeof(Bullet), 0, 128, false);
+ * Bullet *b = pd_PoolAlloc(&bullets);
+ * // ...
+ * pd_PoolFree(&bullets, b);
+ * pd_PoolRelease(&bullets);
+ * @endcode
+ *
+ * @remarks Treat the members as read-only.
+ */
+typedef struct PDPoolTag {
+    /**
+     * @brief Chunks allocated so far, most recent first.
+     */
+    PDPoolChunk *chunks;
+    /**
+     * @brief First free slot.
+     */
+    void *freeList;
+    /**
+     * @brief Size of an object, as passed to pd_PoolInit.
+     */
+    size_t objectSize;
+    /**
+     * @brief Distance between two slots.
+     */
+    size_t slotSize;
+    /**
+     * @brief Alignment of each slot.
+     */
+    size_t alignment;
+    /**
+     * @brief Offset of the slot state word in debug mode.
+     */
+    size_t stateOffset;
+    /**
+     * @brief Number of slots added each time the pool runs out.
+     */
+    uint32_t objectsPerChunk;
+    /**
+     * @brief Number of slots currently handed out.
+     */
+    uint32_t liveCount;
+    /**
+     * @brief Whether freed slots are poisoned and double frees are checked.
+     */
+    bool debug;
+} PDPool;
+
+/**
+ * @brief Initializes a pool.
+ *
+ * No memory is allocated until the first pd_PoolAlloc(PDPool*).
+ *
+ * @param[out] pool            Pool to initialize.
+ * @param[in]  objectSize      Size of each object.
+ * @param[in]  alignment       Alignment of each object. Must be a power of two.
+ *                             Values smaller than @c sizeof(void*) (including 0) are rounded up to it.
+ * @param[in]  objectsPerChunk Number of objects per chunk. Pass 0 to use #PD_POOL_DEFAULT_OBJECTS_PER_CHUNK.
+ * @param[in]  debug           If true, freed slots are filled with @c 0xDD,
+ *                             writes to freed slots are reported when the slot is handed out again,
+ *                             and double frees or foreign pointers trigger pd_ErrorF(const char*, ...).
+ *                             This adds 4 bytes to each slot.
+ */
+void pd_PoolInit(PDPool *pool, size_t objectSize, size_t alignment, uint32_t objectsPerChunk, bool debug);
+
+/**
+ * @brief Takes an object out of the pool.
+ *
+ * @param[in] pool Pool to allocate from.
+ * @returns Pointer to an uninitialized object, or NULL if the pool needed a new chunk and its allocation failed.
+ */
+void *pd_PoolAlloc(PDPool *pool);
+
+/**
+ * @brief Returns an object to the pool.
+ *
+ * @param[in] pool Pool the object was allocated from.
+ * @param[in] ptr  Object to return. NULL is ignored.
+ * @warning Passing an object from another pool is undefined behavior (detected in debug mode).
+ */
+void pd_PoolFree(PDPool *pool, void *ptr);
+
+/**
+ * @brief Frees all the chunks of the pool.
+ *
+ * Every object allocated from the pool becomes invalid.
+ * The pool can still be used afterward.
+ *
+ * @param[in] pool Pool to release.
+ */
+void pd_PoolRelease(PDPool *pool);
+
+/**
+ * @brief String builder that formats without going through @c vaFormatString.
+ *
+ * Text is written to caller-provided storage (typically a stack array) first.
+ * Only if that runs out is the text moved to a heap block from pd_Malloc(size_t),
+ * which then grows by doubling through pd_Realloc(void*, size_t).
+ * The text is always NUL-terminated.
+ *
+ * @code
+ * char storage[64];
+ * PDStrBuf sb;
+ * pd_StrBufInit(&sb, storage, sizeof(storage));
+ * pd_StrBufAppend(&sb, "Score: ");
+ * pd_StrBufAppendInt(&sb, score);
+ * pdText_DisplayStringBuf(kASCIIEncoding, 10, 10, &sb);
+ * pd_StrBufRelease(&sb); // Only frees something if the text outgrew storage
+ * @endcode
+ */
+typedef struct PDStrBufTag {
+    /**
+     * @brief Current text. Either the caller's storage or a heap block.
+     */
+    char *data;
+    /**
+     * @brief Length of the text, excluding the NUL.
+     */
+    size_t length;
+    /**
+     * @brief Size of @c data in bytes.
+     */
+    size_t capacity;
+    /**
+     * @brief Caller-provided storage, as passed to pd_StrBufInit.
+     */
+    char *storage;
+    /**
+     * @brief Size of @c storage in bytes.
+     */
+    size_t storageCapacity;
+    /**
+     * @brief Whether @c data is a heap block owned by the builder.
+     */
+    bool owned;
+    /**
+     * @brief Whether growing has failed. The text has been truncated if this is true.
+     */
+    bool failed;
+} PDStrBuf;
+
+/**
+ * @brief Initializes a string builder over caller-provided storage.
+ *
+ * @param[out] sb       Builder to initialize.
+ * @param[in]  storage  Initial storage, or NULL to start on the heap at the first append.
+ *                      Must outlive the builder.
+ * @param[in]  capacity Size of @c storage in bytes.
+ */
+void pd_StrBufInit(PDStrBuf *sb, char *storage, size_t capacity);
+
+/**
+ * @brief Empties the text. Any heap block is kept for reuse.
+ *
+ * @param[in] sb Builder to clear.
+ */
+void pd_StrBufClear(PDStrBuf *sb);
+
+/**
+ * @brief Shortens the text to its first @c length bytes. Does nothing if the text is not longer than that.
+ *
+ * @param[in] sb     Builder to shorten.
+ * @param[in] length New length in bytes.
+ */
+void pd_StrBufTruncate(PDStrBuf *sb, size_t length);
+
+/**
+ * @brief Frees the heap block, if any, and goes back to the caller-provided storage, empty.
+ *
+ * @param[in] sb Builder to release.
+ */
+void pd_StrBufRelease(PDStrBuf *sb);
+
+/**
+ * @brief Gets the NUL-terminated text.
+ *
+ * @param[in] sb Builder.
+ * @returns The text. Valid until the next append, clear or release.
+ */
+const char *pd_StrBufCStr(const PDStrBuf *sb);
+
+/**
+ * @brief Appends a NUL-terminated string.
+ *
+ * @param[in] sb   Builder.
+ * @param[in] text Text to append.
+ * @returns false if the text had to be truncated because growing failed.
+ */
+bool pd_StrBufAppend(PDStrBuf *sb, const char *text);
+
+/**
+ * @brief Appends @c length characters of @c text.
+ *
+ * @param[in] sb     Builder.
+ * @param[in] text   Text to append. Does not need to be NUL-terminated.
+ * @param[in] length Number of characters to append.
+ * @returns false if the text had to be truncated because growing failed.
+ */
+bool pd_StrBufAppendN(PDStrBuf *sb, const char *text, size_t length);
+
+/**
+ * @brief Appends a character.
+ *
+ * @param[in] sb Builder.
+ * @param[in] c  Character to append.
+ * @returns false if growing failed.
+ */
+bool pd_StrBufAppendChar(PDStrBuf *sb, char c);
+
+/**
+ * @brief Appends formatted text (see pd_FormatV(char*, size_t, const char*, va_list) for the supported format).
+ *
+ * @param[in] sb  Builder.
+ * @param[in] fmt Format string.
+ * @param[in] ... Format variables.
+ * @returns false if the text had to be truncated because growing failed.
+ */
+bool pd_StrBufAppendF(PDStrBuf *sb, const char *fmt, ...);
+
+/**
+ * @brief @c va_list version of pd_StrBufAppendF(PDStrBuf*, const char*, ...).
+ *
+ * @param[in] sb   Builder.
+ * @param[in] fmt  Format string.
+ * @param[in] args Format variables.
+ * @returns false if the text had to be truncated because growing failed.
+ */
+bool pd_StrBufAppendFV(PDStrBuf *sb, const char *fmt, va_list args);
+
+/**
+ * @brief Appends an integer in decimal. Faster than pd_StrBufAppendF with @c "%d".
+ *
+ * @param[in] sb    Builder.
+ * @param[in] value Value to append.
+ * @returns false if growing failed.
+ */
+bool pd_StrBufAppendInt(PDStrBuf *sb, int32_t value);
+
+/**
+ * @brief Appends a number with a fixed number of decimals, rounded half away from zero.
+ *
+ * Faster than pd_StrBufAppendF with @c "%.*f".
+ *
+ * @param[in] sb       Builder.
+ * @param[in] value    Value to append.
+ * @param[in] decimals Number of digits after the decimal point (up to 9).
+ * @returns false if growing failed.
+ */
+bool pd_StrBufAppendFixed(PDStrBuf *sb, float value, uint32_t decimals);
+
+/**
+ * @brief Starts recording every pd_Malloc(size_t), pd_Realloc(void*, size_t) and pd_Free(void*) to a file.
+ *
+ * Records are kept in a RAM ring buffer and written to the file in large blocks,
+ * either at a frame boundary (pd_TraceNextFrame(void)) once the buffer is half full,
+ * or whenever the buffer is about to overflow.
+ * The format is described in pd_trace_format.h;
+ * use the @c pd_trace_analyze host tool to read the file.
+ *
+ * @param[in] path       Path of the file to write (in the game's data folder).
+ * @param[in] bufferSize Size of the ring buffer in bytes. Larger buffers mean fewer, larger writes.
+ * @returns true if recording has started.
+ * @remarks Only available if the library is built with PD_SHORTHAND_TRACE; otherwise this always returns false.
+ *          Define PD_SHORTHAND_TRACE for your game as well to record call sites.
+ */
+bool pd_TraceBegin(const char *path, size_t bufferSize);
+
+/**
+ * @brief Advances the frame number written to the trace.
+ *
+ * The scene engine calls this at the end of every pdScene_Update.
+ * This is also where buffered records are written to the file.
+ */
+void pd_TraceNextFrame(void);
+
+/**
+ * @brief Writes all the buffered records to the file.
+ *
+ * Call this at a point where a hitch doesn't matter (e.g., a loading screen).
+ */
+void pd_TraceFlush(void);
+
+/**
+ * @brief Stops recording and closes the trace file.
+ *
+ * Called by pd_Finalize(void) as well.
+ */
+void pd_TraceEnd(void);
+
+#ifndef PD_PROFILE_MAX_SCOPES
+/**
+ * @def PD_PROFILE_MAX_SCOPES
+ * @brief Number of distinct scope names the profiler can tell apart. Further names are ignored.
+ */
+#define PD_PROFILE_MAX_SCOPES 32
+#endif
+
+#ifndef PD_PROFILE_MAX_DEPTH
+/**
+ * @def PD_PROFILE_MAX_DEPTH
+ * @brief Number of scopes that can be open at once. Deeper scopes are ignored.
+ */
+#define PD_PROFILE_MAX_DEPTH 16
+#endif
+
+#ifndef PD_PROFILE_SAMPLE_CAPACITY
+/**
+ * @def PD_PROFILE_SAMPLE_CAPACITY
+ * @brief Number of closed scopes kept for pd_ProfileDump. Older ones are overwritten.
+ */
+#define PD_PROFILE_SAMPLE_CAPACITY 512
+#endif
+
+#ifndef PD_PROFILE_FRAME_HISTORY
+/**
+ * @def PD_PROFILE_FRAME_HISTORY
+ * @brief Number of frame times kept for the overlay graph and pd_ProfileDump.
+ */
+#define PD_PROFILE_FRAME_HISTORY 64
+#endif
+
+#ifndef PD_PROFILE_WINDOW_FRAMES
+/**
+ * @def PD_PROFILE_WINDOW_FRAMES
+ * @brief Number of frames the min/avg/max figures are collected over before they are updated.
+ */
+#define PD_PROFILE_WINDOW_FRAMES 30
+#endif
+
+#ifndef PD_PROFILE_FRAME_BUDGET_MICROS
+/**
+ * @def PD_PROFILE_FRAME_BUDGET_MICROS
+ * @brief Frame time the overlay graph draws a line at (30 FPS by default). The graph goes up to twice this.
+ */
+#define PD_PROFILE_FRAME_BUDGET_MICROS 33333
+#endif
+
+/**
+ * @def PD_PROFILE_OVERLAY_WIDTH
+ * @brief Width of the profiler overlay in pixels.
+ */
+#define PD_PROFILE_OVERLAY_WIDTH 192
+
+/**
+ * @def PD_PROFILE_GRAPH_HEIGHT
+ * @brief Height of the frame-time graph of the profiler overlay in pixels.
+ */
+#define PD_PROFILE_GRAPH_HEIGHT 32
+
+/**
+ * @brief Corner of the screen to draw the profiler overlay in.
+ */
+typedef enum PDProfileCornerTag {
+    kPDProfileTopLeft,
+    kPDProfileTopRight,
+    kPDProfileBottomLeft,
+    kPDProfileBottomRight,
+} PDProfileCorner;
+
+/**
+ * @brief Timing figures of a profiler scope over the last complete window of #PD_PROFILE_WINDOW_FRAMES frames.
+ */
+typedef struct PDProfileScopeStatsTag {
+    /**
+     * @brief Scope name, as passed to pd_ProfileBegin.
+     */
+    const char *name;
+    /**
+     * @brief Number of times the scope was closed during the window.
+     */
+    uint32_t calls;
+    /**
+     * @brief Shortest time spent in the scope, in microseconds.
+     */
+    uint32_t minMicros;
+    /**
+     * @brief Average time spent in the scope, in microseconds.
+     */
+    uint32_t avgMicros;
+    /**
+     * @brief Longest time spent in the scope, in microseconds.
+     */
+    uint32_t maxMicros;
+} PDProfileScopeStats;
+
+/**
+ * @brief Clock for the profiler, in microseconds.
+ */
+typedef uint32_t (*PDProfileTimer)(void);
+
+/**
+ * @brief Starts or stops profiling.
+ *
+ * Everything is kept in fixed-size static buffers; the profiler never allocates.
+ *
+ * @param[in] enabled true to start (clearing previous figures), false to stop.
+ * @remarks Only available if the library is built with PD_SHORTHAND_PROFILE;
+ *          otherwise every profiler function does nothing.
+ * @remarks Unless a timer is set with pd_ProfileSetTimer(PDProfileTimer),
+ *          the profiler times scopes with @c playdate->system->getCurrentTimeMilliseconds,
+ *          refined to the microsecond with @c getElapsedTime, which it only reads:
+ *          the game can keep using (and resetting) the elapsed time, and the profiler notices every reset
+ *          since the elapsed time then stops agreeing with the millisecond clock
+ *          (only the scopes spanning a reset are timed to the millisecond rather than the microsecond).
+ *          Being a float, the elapsed time resolves microseconds only while it is small; if the game doesn't
+ *          reset it and it passes 64 seconds, the profiler logs a warning once.
+ */
+void pd_ProfileSetEnabled(bool enabled);
+
+/**
+ * @brief Uses another clock for the profiler instead of @c getCurrentTimeMilliseconds and @c getElapsedTime.
+ *
+ * @param[in] timer Function returning the current time in microseconds, or NULL for the default clock.
+ *                  Set it before pd_ProfileSetEnabled(bool).
+ */
+void pd_ProfileSetTimer(PDProfileTimer timer);
+
+/**
+ * @brief Opens a profiler scope.
+ *
+ * Scopes nest; close each with pd_ProfileEnd(void).
+ * The scene engine opens @c "scene/update", @c "scene/event", @c "scene/init" and @c "scene/unload" by itself.
+ *
+ * @param[in] name Scope name. Must stay valid while profiling; string literals are best.
+ */
+void pd_ProfileBegin(const char *name);
+
+/**
+ * @brief Closes the last scope opened with pd_ProfileBegin(const char*).
+ */
+void pd_ProfileEnd(void);
+
+/**
+ * @brief Marks a frame boundary: records the frame time and, every #PD_PROFILE_WINDOW_FRAMES frames,
+ * updates the min/avg/max figures.
+ *
+ * The scene engine calls this at the end of every pdScene_Update.
+ */
+void pd_ProfileNextFrame(void);
+
+/**
+ * @brief Gets the figures of every scope seen so far.
+ *
+ * @param[out] stats    Array to write to.
+ * @param[in]  capacity Number of elements of @c stats.
+ * @returns Number of elements written.
+ */
+uint32_t pd_ProfileGetScopeStats(PDProfileScopeStats *stats, uint32_t capacity);
+
+/**
+ * @brief Gets the frame-time figures (time between two pd_ProfileNextFrame(void) calls).
+ *
+ * @param[out] stats Figures. Its @c name is @c "frame".
+ */
+void pd_ProfileGetFrameStats(PDProfileScopeStats *stats);
+
+/**
+ * @brief Shows or hides the profiler overlay.
+ *
+ * The overlay shows the min/avg/max time (in milliseconds) of the frame and of every scope,
+ * and a graph of the last #PD_PROFILE_FRAME_HISTORY frame times.
+ * The scene engine draws it at the end of every pdScene_Update.
+ *
+ * @param[in] visible Whether to draw the overlay.
+ * @param[in] corner  Corner of the screen to draw it in.
+ * @param[in] font    Font to draw the figures with, or NULL to use the current font.
+ */
+void pd_ProfileSetOverlay(bool visible, PDProfileCorner corner, LCDFont *font);
+
+/**
+ * @brief Draws the profiler overlay if it is visible.
+ *
+ * Only needed if you don't use the scene engine.
+ */
+void pd_ProfileDrawOverlay(void);
+
+/**
+ * @brief Writes the figures, the frame-time history and the recent scope samples to a text file.
+ *
+ * The file has three comma-separated sections:
+ * @c [scopes] (name, calls, min_us, avg_us, max_us),
+ * @c [frames] (frame, duration_us) and
+ * @c [samples] (frame, scope, depth, start_us, duration_us; @c start_us is relative to the frame start).
+ *
+ * @param[in] path Path of the file to write (in the game's data folder).
+ * @returns false if the file couldn't be written.
+ */
+bool pd_ProfileDump(const char *path);
+
+/**
+ * @brief @c playdate->system->realloc, cached by pd_Initialize(void*) for the inline wrappers.
+ *
+ * @see PD_SHORTHAND_INLINE
+ */
+extern void *(*pd_cachedRealloc)(void *ptr, size_t size);
+
+/**
+ * @brief @c playdate->system->logToConsole, cached by pd_Initialize(void*) for the inline wrappers.
+ *
+ * Points to the log buffer instead while it is enabled (see pd_LogBufferEnable(void*, size_t, uint32_t)).
+ *
+ * @see PD_SHORTHAND_INLINE
+ */
+extern void (*pd_cachedLogToConsole)(const char *fmt, ...);
+
+/**
+ * @brief @c playdate->system->error, cached by pd_Initialize(void*) for the inline wrappers.
+ *
+ * @see PD_SHORTHAND_INLINE
+ */
+extern void (*pd_cachedError)(const char *fmt, ...);
+
+/**
+ * @def pd_LogDebug
+ * @brief Logs a formatted message at #PD_LOG_LEVEL_DEBUG. Removed if #PD_LOG_LEVEL is higher.
+ */
+/**
+ * @def pd_LogInfo
+ * @brief Logs a formatted message at #PD_LOG_LEVEL_INFO. Removed if #PD_LOG_LEVEL is higher.
+ */
+/**
+ * @def pd_LogWarn
+ * @brief Logs a formatted message at #PD_LOG_LEVEL_WARN. Removed if #PD_LOG_LEVEL is higher.
+ */
+/**
+ * @def pd_LogError
+ * @brief Logs a formatted message at #PD_LOG_LEVEL_ERROR. Removed if #PD_LOG_LEVEL is higher.
+ *
+ * Unlike pd_ErrorF(const char*, ...), this does not stop the game.
+ */
+#if PD_LOG_LEVEL <= PD_LOG_LEVEL_DEBUG
+#define pd_LogDebug(...) pd_LogLevelF(PD_LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define pd_LogDebug(...) ((void) 0)
+#endif
+#if PD_LOG_LEVEL <= PD_LOG_LEVEL_INFO
+#define pd_LogInfo(...) pd_LogLevelF(PD_LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+#define pd_LogInfo(...) ((void) 0)
+#endif
+#if PD_LOG_LEVEL <= PD_LOG_LEVEL_WARN
+#define pd_LogWarn(...) pd_LogLevelF(PD_LOG_LEVEL_WARN, __VA_ARGS__)
+#else
+#define pd_LogWarn(...) ((void) 0)
+#endif
+#if PD_LOG_LEVEL <= PD_LOG_LEVEL_ERROR
+#define pd_LogError(...) pd_LogLevelF(PD_LOG_LEVEL_ERROR, __VA_ARGS__)
+#else
+#define pd_LogError(...) ((void) 0)
+#endif
+
+/* pd_Log and pd_LogF count as info-level logs. */
+#if PD_LOG_LEVEL > PD_LOG_LEVEL_INFO && !defined(PD_SHORTHAND_INTERNAL)
+#define pd_Log(msg) ((void) 0)
+#define pd_LogF(...) ((void) 0)
+#endif
+
+#if (defined(PD_SHORTHAND_DEBUG) || defined(PD_SHORTHAND_TRACE)) && !defined(PD_SHORTHAND_INTERNAL)
+#define pd_Malloc(size) pd_MallocAt((size), __FILE__, __LINE__, __func__)
+#define pd_Realloc(ptr, size) pd_ReallocAt((ptr), (size), __FILE__, __LINE__, __func__)
+#endif
+
+/**
+ * @def PD_SHORTHAND_INLINE
+ * @brief Define this (for your game) to inline the thin wrappers.
+ *
+ * pd_Malloc(size_t), pd_Realloc(void*, size_t), pd_Free(void*), pd_Log(const char*) and pd_Error(const char*)
+ * become @c static @c inline functions that make a single indirect call through a function pointer
+ * cached by pd_Initialize(void*), instead of an out-of-line call into the library
+ * followed by another one through @c playdate->system.
+ *
+ * @remarks Ignored if PD_SHORTHAND_DEBUG, PD_SHORTHAND_STATS or PD_SHORTHAND_TRACE is defined,
+ *          because those need every call to go through the library.
+ *          Build the library without them as well;
+ *          inlined calls are not counted in pd_GetMemoryStats(PDMemoryStats*).
+ */
+#if defined(PD_SHORTHAND_INLINE) && !defined(PD_SHORTHAND_INTERNAL) \
+    && !defined(PD_SHORTHAND_DEBUG) && !defined(PD_SHORTHAND_STATS) && !defined(PD_SHORTHAND_TRACE)
+static inline void *pd_MallocInline(size_t size) {
+    return pd_cachedRealloc(NULL, size);
+}
+
+static inline void *pd_ReallocInline(void *ptr, size_t size) {
+    return pd_cachedRealloc(ptr, size);
+}
+
+static inline void pd_FreeInline(void *ptr) {
+    if (ptr != NULL) {
+        pd_cachedRealloc(ptr, 0);
+    }
+}
+
+#define pd_Malloc(size) pd_MallocInline(size)
+#define pd_Realloc(ptr, size) pd_ReallocInline((ptr), (size))
+#define pd_Free(ptr) pd_FreeInline(ptr)
+#define pd_Error(msg) pd_cachedError("%s", (msg))
+#if PD_LOG_LEVEL <= PD_LOG_LEVEL_INFO
+#define pd_Log(msg) pd_cachedLogToConsole("%s", (msg))
+#endif
+#endif
+
 #endif /* PD_SHORTHAND_H */
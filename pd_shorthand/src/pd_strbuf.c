@@ -0,0 +1,211 @@
+#include "pd_shorthand.h"
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <string.h>
+
+#define STRBUF_MIN_HEAP_CAPACITY 32
+#define STRBUF_MAX_DECIMALS 9
+
+/**
+ * @brief Makes sure @c extra more characters (plus the NUL) fit.
+ *
+ * The first growth copies out of the caller's storage; after that, the heap block is re-allocated.
+ */
+static bool ensure_room(PDStrBuf *sb, size_t extra) {
+    size_t needed = sb->length + extra + 1;
+    if (needed <= sb->capacity) return true;
+    if (sb->failed) return false;
+
+    size_t newCapacity = sb->capacity * 2;
+    if (newCapacity < STRBUF_MIN_HEAP_CAPACITY) {
+        newCapacity = STRBUF_MIN_HEAP_CAPACITY;
+    }
+    if (newCapacity < needed) {
+        newCapacity = needed;
+    }
+
+    char *data;
+    if (sb->owned) {
+        data = pd_Realloc(sb->data, newCapacity);
+    } else {
+        data = pd_Malloc(newCapacity);
+        if (data != NULL && sb->length > 0) {
+            memcpy(data, sb->data, sb->length);
+        }
+    }
+    if (data == NULL) {
+        sb->failed = true;
+        return false;
+    }
+    sb->data = data;
+    sb->capacity = newCapacity;
+    sb->owned = true;
+    return true;
+}
+
+/* Copies as much of the text as fits; used once growing has failed. */
+static void append_truncated(PDStrBuf *sb, const char *text, size_t length) {
+    if (sb->capacity == 0) return;
+    size_t room = sb->capacity - 1 - sb->length;
+    if (length > room) {
+        length = room;
+    }
+    memcpy(sb->data + sb->length, text, length);
+    sb->length += length;
+    sb->data[sb->length] = '\0';
+}
+
+void pd_StrBufInit(PDStrBuf *sb, char *storage, size_t capacity) {
+    if (storage == NULL) {
+        capacity = 0;
+    }
+    sb->data = capacity > 0 ? storage : NULL;
+    sb->length = 0;
+    sb->capacity = capacity;
+    sb->owned = false;
+    sb->failed = false;
+    sb->storage = sb->data;
+    sb->storageCapacity = capacity;
+    if (capacity > 0) {
+        storage[0] = '\0';
+    }
+}
+
+void pd_StrBufClear(PDStrBuf *sb) {
+    sb->length = 0;
+    sb->failed = false;
+    if (sb->capacity > 0) {
+        sb->data[0] = '\0';
+    }
+}
+
+void pd_StrBufRelease(PDStrBuf *sb) {
+    if (sb->owned) {
+        pd_Free(sb->data);
+    }
+    pd_StrBufInit(sb, sb->storage, sb->storageCapacity);
+}
+
+void pd_StrBufTruncate(PDStrBuf *sb, size_t length) {
+    if (length >= sb->length) return;
+    sb->length = length;
+    sb->data[length] = '\0';
+}
+
+const char *pd_StrBufCStr(const PDStrBuf *sb) {
+    return sb->capacity > 0 ? sb->data : "";
+}
+
+bool pd_StrBufAppendN(PDStrBuf *sb, const char *text, size_t length) {
+    if (!ensure_room(sb, length)) {
+        append_truncated(sb, text, length);
+        return false;
+    }
+    memcpy(sb->data + sb->length, text, length);
+    sb->length += length;
+    sb->data[sb->length] = '\0';
+    return true;
+}
+
+bool pd_StrBufAppend(PDStrBuf *sb, const char *text) {
+    return pd_StrBufAppendN(sb, text, strlen(text));
+}
+
+bool pd_StrBufAppendChar(PDStrBuf *sb, char c) {
+    return pd_StrBufAppendN(sb, &c, 1);
+}
+
+bool pd_StrBufAppendFV(PDStrBuf *sb, const char *fmt, va_list args) {
+    va_list retry;
+    va_copy(retry, args);
+    size_t room = sb->capacity > sb->length ? sb->capacity - sb->length : 0;
+    int length = pd_FormatV(room > 0 ? sb->data + sb->length : NULL, room, fmt, args);
+    if (length < 0) {
+        va_end(retry);
+        return false;
+    }
+    if ((size_t) length < room) {
+        /* Fitted in the space we already had. */
+        sb->length += (size_t) length;
+        va_end(retry);
+        return true;
+    }
+
+    bool grown = ensure_room(sb, (size_t) length);
+    room = sb->capacity - sb->length;
+    if (room > 0) {
+        pd_FormatV(sb->data + sb->length, room, fmt, retry);
+        sb->length += grown ? (size_t) length : room - 1;
+    }
+    va_end(retry);
+    return grown;
+}
+
+bool pd_StrBufAppendF(PDStrBuf *sb, const char *fmt, ...) {
+    va_list v_list;
+    va_start(v_list, fmt);
+    bool result = pd_StrBufAppendFV(sb, fmt, v_list);
+    va_end(v_list);
+    return result;
+}
+
+static size_t render_decimal(char *end, uint32_t value) {
+    char *p = end;
+    do {
+        *--p = (char) ('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+    return (size_t) (end - p);
+}
+
+bool pd_StrBufAppendInt(PDStrBuf *sb, int32_t value) {
+    char digits[12];
+    uint32_t magnitude = value < 0 ? 0u - (uint32_t) value : (uint32_t) value;
+    size_t count = render_decimal(digits + sizeof(digits), magnitude);
+    if (value < 0) {
+        digits[sizeof(digits) - ++count] = '-';
+    }
+    return pd_StrBufAppendN(sb, digits + sizeof(digits) - count, count);
+}
+
+bool pd_StrBufAppendFixed(PDStrBuf *sb, float value, uint32_t decimals) {
+    if (decimals > STRBUF_MAX_DECIMALS) {
+        decimals = STRBUF_MAX_DECIMALS;
+    }
+    if (value != value) {
+        return pd_StrBufAppendN(sb, "nan", 3);
+    }
+    bool negative = value < 0.0f;
+    double magnitude = negative ? -(double) value : (double) value;
+    if (magnitude >= 4294967295.0) {
+        return pd_StrBufAppendF(sb, "%.*f", (int) decimals, (double) value);
+    }
+
+    uint64_t scale = 1;
+    for (uint32_t i = 0; i < decimals; i++) {
+        scale *= 10;
+    }
+    uint64_t scaled = (uint64_t) (magnitude * (double) scale + 0.5);
+    uint64_t whole = scaled / scale;
+    uint32_t fraction = (uint32_t) (scaled % scale);
+    if (whole > UINT32_MAX) {
+        return pd_StrBufAppendF(sb, "%.*f", (int) decimals, (double) value);
+    }
+
+    char digits[24];
+    char *end = digits + sizeof(digits);
+    size_t count = 0;
+    if (decimals > 0) {
+        count = render_decimal(end, fraction);
+        while (count < decimals) {
+            digits[sizeof(digits) - ++count] = '0';
+        }
+        digits[sizeof(digits) - ++count] = '.';
+    }
+    count += render_decimal(end - count, (uint32_t) whole);
+    if (negative && scaled != 0) {
+        digits[sizeof(digits) - ++count] = '-';
+    }
+    return pd_StrBufAppendN(sb, end - count, count);
+}
@@ -0,0 +1,42 @@
+/**
+ * @file pd_trace_format.h
+ *
+ * @brief Binary format of the allocation traces written by pd_TraceBegin.
+ *
+ * This header does not depend on the Playdate SDK,
+ * so that host-side tools can read traces with it.
+ *
+ * @par Layout:
+ * All integers are little-endian.
+ * @li File header (#PD_TRACE_HEADER_SIZE bytes): magic "PDTR", u16 version, u16 record size.
+ * @li Records (#PD_TRACE_RECORD_SIZE bytes each): u8 op, u8 reserved, u16 call site ID,
+ *     u32 frame number, u32 size, u64 pointer.
+ * @li A #kPDTraceOpSite record is followed by two strings (u16 length + bytes, not NUL-terminated):
+ *     the file name and the function name of the call site.
+ *     Its size field holds the line number.
+ *
+ * Call site ID 0 means the call site is unknown.
+ * pd_Realloc is written as a #kPDTraceOpReallocFrom record (old pointer)
+ * immediately followed by a #kPDTraceOpReallocTo record (new pointer and size).
+ */
+
+#ifndef PD_TRACE_FORMAT_H
+#define PD_TRACE_FORMAT_H
+
+#define PD_TRACE_MAGIC "PDTR"
+#define PD_TRACE_VERSION 1
+#define PD_TRACE_HEADER_SIZE 8
+#define PD_TRACE_RECORD_SIZE 20
+
+/**
+ * @brief Kind of a trace record.
+ */
+typedef enum PDTraceOpTag {
+    kPDTraceOpAlloc = 1,
+    kPDTraceOpFree = 2,
+    kPDTraceOpReallocFrom = 3,
+    kPDTraceOpReallocTo = 4,
+    kPDTraceOpSite = 5,
+} PDTraceOp;
+
+#endif /* PD_TRACE_FORMAT_H */
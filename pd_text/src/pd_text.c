@@ -1,15 +1,14 @@
 #include "pd_text.h"
 
 #include <pd_api.h>
+#include <pd_shorthand.h>
 #include <string.h>
 #include <math.h>
 
-#define max(a, b) ((a) > (b) ? (a) : (b))
-
-typedef union PDContextLoaderTag {
-    void *raw_ptr;
-    PlaydateAPI *pd;
-} PDContextLoader;
+/* Formatted strings shorter than this are drawn without touching the heap. */
+#define DISPLAY_STRING_STORAGE_SIZE 128
+/* Wrapped UTF-8 text shorter than this is built without touching the heap. */
+#define WRAP_STORAGE_SIZE 512
 
 static PlaydateAPI *s_pd;
 
@@ -23,11 +22,15 @@ bool pdText_LoadFont(const char *font_path, uint8_t height_margin, Font *font, c
     if ((*err != NULL) && (strlen(*err) != 0)) {
         font->font = NULL;
         font->height = 0;
+        font->glyphCache = NULL;
         return false;
     }
 
     font->font = ft;
     font->height = s_pd->graphics->getFontHeight(ft) + height_margin;
+    font->glyphCache = NULL;
+    /* Without a cache, text is still measured correctly, just slower. */
+    pdText_CreateGlyphCache(font);
     return true;
 }
 
@@ -53,81 +56,53 @@ uint32_t pdText_GetWrappedText(
     va_start(v_list, fmt);
     char *out;
     size_t len = s_pd->system->vaFormatString(&out, fmt, v_list);
+    va_end(v_list);
+    *out_str = out;
 
     /* If max_lines == 1, then there's no way we can wrap this text. */
     if (max_lines == 1) {
         s_pd->system->logToConsole(
             "PDText Warning: tried to generate wrapped text but only one line of text is allowed by parameter."
         );
-        *out_str = out;
         return 1;
     }
 
-    /* If there are no space characters, we cannot wrap this text. */
-    if (strchr(out, ' ') == NULL) {
-        *out_str = out;
-        return 1;
+    if (encoding != kUTF8Encoding) {
+        return pdText_WrapText(out, len, font, max_lines, max_width, encoding);
     }
 
-    /* Split by word (or space) */
-    uint32_t space_count = 0;
-    for (int i = 0; i < len; ++i) {
-        space_count += out[i] == ' ' ? 1 : 0;
-    }
-
-    uint32_t *split_points = s_pd->system->realloc(NULL, sizeof(uint32_t) * space_count);
-    uint32_t split_count = 0;
-    for (int i = 0; i < len; ++i) {
-        if (out[i] == ' ') {
-            split_points[split_count] = i;
-            split_count++;
-        }
-    }
-
-    char *buf = s_pd->system->realloc(NULL, sizeof(char) * len);
-    int line_count = 0;
-    uint32_t str_offset = 0;
-    int32_t split_point_index = 0;
-    int text_tracking = s_pd->graphics->getTextTracking();
-    while (line_count < max_lines) {
-        while (split_point_index < split_count) {
-            /* Expand this line until we go over the maximum width allowed */
-            uint32_t split_point = split_points[split_point_index];
-            memcpy(buf, out + str_offset, (split_point - str_offset) + 1);
-            buf[(int) (split_point - str_offset)] = '\0';
-            uint32_t text_width = s_pd->graphics->getTextWidth(
-                font->font, buf, strlen(buf), encoding, text_tracking
-            );
-            if (text_width > max_width) break;
-            split_point_index++;
-        }
-        /* If we go over the splittable locations, then we don't need to do anything further. */
-        if (split_point_index >= split_count) break;
-        /* If the very first word is super long, perform a wrap at first space character. */
-        uint32_t split_point = split_points[max(0, split_point_index - 1)];
-        out[split_point] = '\n';
-        /* The new string offset will be the split point + 1 */
-        str_offset = split_point + 1;
-        line_count++;
-        split_point_index++;
+    /* Breaks between ideographs add characters, so the text is wrapped into a buffer and copied back. */
+    char storage[WRAP_STORAGE_SIZE];
+    PDStrBuf sb;
+    pd_StrBufInit(&sb, storage, sizeof(storage));
+    uint32_t lines = pdText_WrapTextToBuf(&sb, out, len, font, max_lines, max_width, encoding);
+    char *grown = sb.failed ? NULL : sb.length > len ? s_pd->system->realloc(out, sb.length + 1) : out;
+    if (grown == NULL) {
+        /* Leave the text unwrapped rather than cut it short. */
+        pd_StrBufRelease(&sb);
+        return 1;
     }
-
+    out = grown;
     *out_str = out;
-
-    s_pd->system->realloc(buf, 0);
-    s_pd->system->realloc(split_points, 0);
-
-    return line_count + 1;
+    memcpy(out, pd_StrBufCStr(&sb), sb.length + 1);
+    pd_StrBufRelease(&sb);
+    return lines;
 }
 
 void pdText_DisplayString(PDStringEncoding encoding, int32_t x, int32_t y, const char *fmt, ...) {
+    char storage[DISPLAY_STRING_STORAGE_SIZE];
+    PDStrBuf sb;
+    pd_StrBufInit(&sb, storage, sizeof(storage));
     va_list v_list;
     va_start(v_list, fmt);
-    char *out;
-    size_t len = s_pd->system->vaFormatString(&out, fmt, v_list);
+    pd_StrBufAppendFV(&sb, fmt, v_list);
     va_end(v_list);
-    s_pd->graphics->drawText(out, len, encoding, x, y);
-    s_pd->system->realloc(out, 0);
+    pdText_DisplayStringBuf(encoding, x, y, &sb);
+    pd_StrBufRelease(&sb);
+}
+
+void pdText_DisplayStringBuf(PDStringEncoding encoding, int32_t x, int32_t y, const PDStrBuf *buf) {
+    s_pd->graphics->drawText(pd_StrBufCStr(buf), buf->length, encoding, x, y);
 }
 
 void pdText_DisplayStringWithFont(Font *font, uint32_t encoding, int32_t x, int32_t y, const char *fmt, ...) {
@@ -135,18 +110,28 @@ void pdText_DisplayStringWithFont(Font *font, uint32_t encoding, int32_t x, int3
         s_pd->system->error("Invalid font (NULL font passed).");
         return;
     }
-    s_pd->graphics->setFont(font->font);
+    char storage[DISPLAY_STRING_STORAGE_SIZE];
+    PDStrBuf sb;
+    pd_StrBufInit(&sb, storage, sizeof(storage));
     va_list v_list;
     va_start(v_list, fmt);
-    char *out;
-    size_t len = s_pd->system->vaFormatString(&out, fmt, v_list);
+    pd_StrBufAppendFV(&sb, fmt, v_list);
     va_end(v_list);
-    s_pd->graphics->drawText(out, len, (PDStringEncoding) encoding, x, y);
-    s_pd->system->realloc(out, 0);
+    pdText_DisplayStringWithFontBuf(font, encoding, x, y, &sb);
+    pd_StrBufRelease(&sb);
+}
+
+void pdText_DisplayStringWithFontBuf(Font *font, uint32_t encoding, int32_t x, int32_t y, const PDStrBuf *buf) {
+    if (font == NULL) {
+        s_pd->system->error("Invalid font (NULL font passed).");
+        return;
+    }
+    s_pd->graphics->setFont(font->font);
+    s_pd->graphics->drawText(pd_StrBufCStr(buf), buf->length, (PDStringEncoding) encoding, x, y);
 }
 
 uint16_t pdText_GetStringWidth(const Font *font, const uint32_t encoding, const char *text) {
-    return s_pd->graphics->getTextWidth(font->font, text, strlen(text), encoding, s_pd->graphics->getTextTracking());
+    return pdText_GetTextWidthN(font, (PDStringEncoding) encoding, text, strlen(text));
 }
 
 void pdText_FreeFont(Font *font) {
@@ -156,11 +141,15 @@ void pdText_FreeFont(Font *font) {
     if (font->font == NULL) {
         return;
     }
+    pdText_FreeGlyphCache(font);
+    pdText_InvalidateBitmapCache(font);
     s_pd->system->realloc(font->font, 0);
     font->font = NULL;
     font->height = 0;
 }
 
 void pdText_Finalize(void) {
+    pdText_ClearFontRegistry();
+    pdText_InvalidateBitmapCache(NULL);
     s_pd = NULL;
 }
@@ -8,8 +8,16 @@
 #define PD_TEXT_SHORTHAND_H
 
 #include <pd_api.h>
+#include <pd_shorthand.h>
 #include <stdbool.h>
 
+/**
+ * @brief Per-font cache of glyph advances and kerning pairs.
+ *
+ * Opaque; see pdText_CreateGlyphCache(Font*).
+ */
+typedef struct PDTextGlyphCacheTag PDTextGlyphCache;
+
 /**
  * @brief Font information.
  *
@@ -31,8 +39,530 @@ typedef struct FontTag {
      *          to the original height of the font.
      */
     uint8_t height;
+
+    /**
+     * @brief Cached glyph metrics used to measure text without asking the SDK for every string.
+     *
+     * Created by pdText_LoadFont(const char*, uint8_t, Font*, const char**).
+     * If you fill in a #Font yourself, set this to NULL or call pdText_CreateGlyphCache(Font*).
+     * When NULL, text is measured with @c playdate->graphics->getTextWidth .
+     */
+    PDTextGlyphCache *glyphCache;
 } Font;
 
+/**
+ * @brief Running width of a piece of text that is measured a bit at a time.
+ *
+ * Appending text to a measure costs as much as measuring the appended part alone,
+ * which lets layout code grow a line word by word without measuring the line again.
+ * The members are managed by the pdText_Measure* functions.
+ */
+typedef struct PDTextMeasureTag {
+    const Font *font;
+    PDStringEncoding encoding;
+    /** @brief Tracking value read when the measure began. */
+    int tracking;
+    /** @brief Sum of advances and kerning, without tracking. */
+    int32_t width;
+    /** @brief Number of characters measured so far. */
+    uint32_t count;
+    /** @brief Last character measured, for kerning against the next one. */
+    uint32_t previous;
+    /** @brief false once the text can no longer be measured from the glyph cache. */
+    bool cached;
+} PDTextMeasure;
+
+/**
+ * @brief Where lines may break when wrapping text.
+ *
+ * #kPDTextLineBreakNewlines and #kPDTextLineBreakWrapLast can be combined with either of the others using @c | .
+ */
+typedef enum PDTextLineBreakRulesTag {
+    /** @brief Only at spaces (' ', character 0x20), which are replaced by the line break. */
+    kPDTextLineBreakSpaces = 0,
+    /**
+     * @brief For @c kUTF8Encoding text, also between ideographs and kana and after hyphens,
+     *        following a subset of UAX #14 with kinsoku rules.
+     *
+     * Other encodings break at spaces only.
+     */
+    kPDTextLineBreakUnicode = 1,
+    /** @brief Line feeds in the text always break the line, and the next line is wrapped as if it started the text. */
+    kPDTextLineBreakNewlines = 2,
+    /**
+     * @brief Also measure the text after the last opportunity, and break before it if it does not fit.
+     *
+     * pdText_GetWrappedText() and the functions built like it leave the last word on the line as it is.
+     */
+    kPDTextLineBreakWrapLast = 4,
+} PDTextLineBreakRules;
+
+/**
+ * @brief A place where a line may break.
+ */
+typedef struct PDTextBreakOpportunityTag {
+    /** @brief The line ends before this byte offset. */
+    size_t end;
+    /** @brief The next line starts at this byte offset. */
+    size_t next;
+    /** @brief Whether this is a line feed, which always breaks the line. */
+    bool forced;
+} PDTextBreakOpportunity;
+
+/**
+ * @brief Everything a #PDTextLineBreaker needs to carry on from where it is.
+ *
+ * Only depends on the text before @c scanPosition, so it can be saved after a line break
+ * and used to resume wrapping after the text changes further on (see pdText_LineBreakerResume()).
+ */
+typedef struct PDTextLineBreakerStateTag {
+    /** @brief Start of the current line. */
+    size_t lineStart;
+    /** @brief Everything before this byte offset has been read. */
+    size_t scanPosition;
+    PDTextBreakOpportunity previous;
+    PDTextBreakOpportunity current;
+    uint32_t lineCount;
+    uint8_t previousClass;
+    bool hasCurrent;
+} PDTextLineBreakerState;
+
+/**
+ * @brief Measures part of the text being wrapped, in place of the font of a #PDTextLineBreaker.
+ *
+ * See pdText_LineBreakerSetWidthFunction().
+ *
+ * @param[in] userdata Pointer given to pdText_LineBreakerSetWidthFunction().
+ * @param[in] start    Byte offset of the start of the line.
+ * @param[in] end      The line ends before this byte offset.
+ * @returns Width of the text between @c start and @c end in pixels.
+ */
+typedef int (*PDTextWidthFunction)(void *userdata, size_t start, size_t end);
+
+/**
+ * @brief Finds line breaks one at a time; see pdText_LineBreakerInit().
+ *
+ * The members are managed by the pdText_LineBreaker* functions.
+ */
+typedef struct PDTextLineBreakerTag {
+    const char *text;
+    size_t length;
+    const Font *font;
+    uint32_t maxLines;
+    uint16_t maxWidth;
+    PDStringEncoding encoding;
+    bool unicode;
+    bool newlines;
+    bool wrapLast;
+    PDTextLineBreakerState state;
+    PDTextMeasure measure;
+    size_t measuredStart;
+    size_t measuredEnd;
+    PDTextWidthFunction widthFunction;
+    void *widthUserdata;
+} PDTextLineBreaker;
+
+/**
+ * @brief Called for each line break found by pdText_BreakLines().
+ *
+ * @param[in] userdata        Pointer given to pdText_BreakLines().
+ * @param[in] line_end        The line ends before this byte offset.
+ * @param[in] next_line_start The next line starts at this byte offset.
+ *                            It is <tt>line_end + 1</tt> when the line breaks at a space, which is dropped,
+ *                            and equal to @c line_end when it breaks between two characters.
+ */
+typedef void (*PDTextLineBreakFunction)(void *userdata, size_t line_end, size_t next_line_start);
+
+/**
+ * @brief Horizontal alignment of the lines of a #PDTextLayout within its width.
+ */
+typedef enum PDTextAlignmentTag {
+    kPDTextAlignLeft,
+    kPDTextAlignCenter,
+    kPDTextAlignRight,
+} PDTextAlignment;
+
+/**
+ * @brief One line of a #PDTextLayout.
+ */
+typedef struct PDTextLineTag {
+    /** @brief Byte offset of the line in the text of the layout. */
+    uint32_t start;
+    /** @brief Length of the line in bytes, without the space or line feed it broke at. */
+    uint32_t length;
+    /** @brief Length of the line in characters, as @c playdate->graphics->drawText takes it. */
+    uint32_t characters;
+    /** @brief Width of the line in pixels. */
+    uint16_t width;
+    /** @brief State of the line breaker right after this line, to lay out changes to the text after it. */
+    PDTextLineBreakerState breakState;
+} PDTextLine;
+
+/**
+ * @brief Text that has been wrapped and measured once, to be drawn any number of times.
+ *
+ * See pdText_LayoutInit(). The members can be read at any time;
+ * @c alignment can also be changed at any time.
+ */
+typedef struct PDTextLayoutTag {
+    const Font *font;
+    PDStringEncoding encoding;
+    PDTextAlignment alignment;
+    uint16_t maxWidth;
+    uint32_t maxLines;
+    /** @brief Copy of the text. */
+    PDStrBuf text;
+    PDTextLine *lines;
+    uint32_t lineCount;
+    uint32_t lineCapacity;
+    /** @brief Width of the widest line. */
+    uint16_t width;
+    /** @brief @c lineCount times the height of the font. */
+    uint32_t height;
+    /** @brief Whether the text needs more than @c maxLines lines; the lines after those are not laid out. */
+    bool truncated;
+} PDTextLayout;
+
+#ifndef PD_TEXT_RICH_MAX_FONTS
+/**
+ * @def PD_TEXT_RICH_MAX_FONTS
+ * @brief Number of fonts a #PDTextRichText can switch between.
+ *
+ * Define this when building the library to change it.
+ */
+#define PD_TEXT_RICH_MAX_FONTS 8
+#endif
+
+/**
+ * @brief A piece of a #PDTextRichText drawn in one style, within one line.
+ */
+typedef struct PDTextRunTag {
+    /** @brief Byte offset of the run in the text of the rich text, without markup. */
+    uint32_t start;
+    /** @brief Length of the run in bytes. */
+    uint32_t length;
+    /** @brief Length of the run in characters, as @c playdate->graphics->drawText takes it. */
+    uint32_t characters;
+    /** @brief Position of the run from the left edge of its line. */
+    uint16_t x;
+    /** @brief Width of the run in pixels. */
+    uint16_t width;
+    /** @brief Index of the font of the run in PDTextRichText::fonts. */
+    uint8_t font;
+    /** @brief Whether the run is drawn in white on a black box. */
+    bool inverted;
+} PDTextRun;
+
+/**
+ * @brief One line of a #PDTextRichText.
+ */
+typedef struct PDTextRichLineTag {
+    /** @brief Index of the first run of the line in PDTextRichText::runs. */
+    uint32_t firstRun;
+    uint32_t runCount;
+    /** @brief Distance from the top of the text to the top of the line. */
+    uint32_t y;
+    /** @brief Width of the line in pixels. */
+    uint16_t width;
+    /** @brief Height of the tallest font on the line; runs in smaller fonts sit on the bottom of the line. */
+    uint8_t height;
+} PDTextRichLine;
+
+/**
+ * @brief Text with inline font changes and inverted highlights, parsed, wrapped and measured once.
+ *
+ * See pdText_RichTextInit() for the markup. The members can be read at any time;
+ * @c alignment can also be changed at any time.
+ */
+typedef struct PDTextRichTextTag {
+    const Font *fonts[PD_TEXT_RICH_MAX_FONTS];
+    uint8_t fontCount;
+    PDStringEncoding encoding;
+    PDTextAlignment alignment;
+    uint16_t maxWidth;
+    uint32_t maxLines;
+    /** @brief Text without the markup. */
+    PDStrBuf text;
+    /** @brief The text split where its style changes, before wrapping. */
+    PDTextRun *spans;
+    uint32_t spanCount;
+    uint32_t spanCapacity;
+    /** @brief The spans split into lines, line by line. */
+    PDTextRun *runs;
+    uint32_t runCount;
+    uint32_t runCapacity;
+    PDTextRichLine *lines;
+    uint32_t lineCount;
+    uint32_t lineCapacity;
+    /** @brief Width of the widest line. */
+    uint16_t width;
+    /** @brief Sum of the heights of the lines. */
+    uint32_t height;
+    /** @brief Whether the text needs more than @c maxLines lines; the lines after those are not laid out. */
+    bool truncated;
+} PDTextRichText;
+
+#ifndef PD_TEXT_TYPEWRITER_PAUSE
+/**
+ * @def PD_TEXT_TYPEWRITER_PAUSE
+ * @brief Pause marker for #PDTextTypewriter text, as a string to paste into string literals.
+ *
+ * Each marker stops the reveal for PDTextTypewriter::pauseFrames frames; it is not drawn.
+ * @code
+ * "Well" PD_TEXT_TYPEWRITER_PAUSE PD_TEXT_TYPEWRITER_PAUSE "... no."
+ * @endcode
+ */
+#define PD_TEXT_TYPEWRITER_PAUSE "\x01"
+#endif
+
+/**
+ * @brief Rectangle in screen coordinates.
+ */
+typedef struct PDTextRectTag {
+    int32_t x;
+    int32_t y;
+    int32_t width;
+    int32_t height;
+} PDTextRect;
+
+/**
+ * @brief Text revealed a few characters per frame, as in a dialogue box.
+ *
+ * See pdText_TypewriterInit(). The members can be read at any time;
+ * @c speed and @c pauseFrames can also be changed at any time.
+ */
+typedef struct PDTextTypewriterTag {
+    /** @brief Layout of the text, without the pause markers. */
+    PDTextLayout layout;
+    /** @brief Characters revealed per frame; fractions carry over to the next frames. */
+    float speed;
+    /** @brief Frames each pause marker waits for. */
+    uint32_t pauseFrames;
+    /** @brief Byte offsets in the text of the layout where a pause marker was, in order. */
+    uint32_t *pauses;
+    uint32_t pauseCount;
+    uint32_t pauseCapacity;
+    /** @brief Index in @c pauses of the next pause to wait for. */
+    uint32_t nextPause;
+    /** @brief Frames left in the current pause. */
+    uint32_t pauseLeft;
+    /** @brief Characters to reveal that did not add up to a whole one yet. */
+    float pending;
+    /** @brief Line of the layout being revealed. */
+    uint32_t line;
+    /** @brief Bytes of that line revealed so far. */
+    uint32_t lineOffset;
+    /** @brief Width of what has been revealed of that line, to place the next characters. */
+    PDTextMeasure measure;
+    /** @brief Whether the whole text has been revealed. */
+    bool finished;
+    /** @brief Area drawn by the last update; empty (0 × 0) if nothing was drawn. */
+    PDTextRect dirty;
+} PDTextTypewriter;
+
+/**
+ * @brief An indexed script file, read one page at a time; see pdText_ScriptOpen().
+ *
+ * The members are managed by the pdText_Script* functions; @c pageCount and @c lineCount can be read at any time.
+ */
+typedef struct PDTextScriptTag {
+    SDFile *file;
+    uint32_t pageCount;
+    uint32_t lineCount;
+    /** @brief Page table: the offset of each page, then the first line of each page, @c pageCount + 1 of each. */
+    uint32_t *offsets;
+    uint32_t *firstLines;
+    /** @brief Length of the longest page, which is the size both buffers are allocated with. */
+    uint32_t maxPageLength;
+    /** @brief Page returned last, NUL-terminated in @c buffer ; UINT32_MAX if none. */
+    uint32_t page;
+    char *buffer;
+    /** @brief Page read ahead of time by pdText_ScriptPrefetch(), in @c prefetchBuffer ; UINT32_MAX if none. */
+    uint32_t prefetchPage;
+    char *prefetchBuffer;
+} PDTextScript;
+
+/**
+ * @brief The strings of one language of a compiled string table; see pdText_LoadStrings().
+ *
+ * The members are managed by the pdText_*Strings functions; @c count and @c language can be read at any time.
+ */
+typedef struct PDTextStringsTag {
+    /** @brief Offset in @c blob and length of each string; also the start of the block holding everything. */
+    uint32_t *entries;
+    /** @brief The NUL-terminated strings. */
+    const char *blob;
+    uint32_t blobSize;
+    /** @brief Number of strings; IDs go from 0 to @c count - 1. */
+    uint32_t count;
+    /** @brief Code of the loaded language, NUL-terminated. */
+    char language[9];
+} PDTextStrings;
+
+/**
+ * @brief Line breaks of the strings of one language, computed ahead of time; see pdText_LoadBreaks().
+ *
+ * The members are managed by the pdText_*Breaks functions; @c count , @c maxWidth , @c maxLines and @c language
+ * can be read at any time.
+ */
+typedef struct PDTextBreaksTag {
+    /** @brief Index of the first break, length of the wrapped text and number of lines of each string, and the end. */
+    uint32_t *entries;
+    /** @brief The breaks; see PD_TEXT_BREAK_END() and PD_TEXT_BREAK_NEXT(). */
+    const uint32_t *breaks;
+    /** @brief Number of strings; IDs go from 0 to @c count - 1. */
+    uint32_t count;
+    /** @brief Width and number of lines the strings were wrapped for. */
+    uint16_t maxWidth;
+    uint16_t maxLines;
+    /** @brief Code of the loaded language, NUL-terminated. */
+    char language[9];
+} PDTextBreaks;
+
+/**
+ * @def PD_TEXT_BREAK_END
+ * @brief Byte offset where the line of a break returned by pdText_GetBreaks() ends.
+ */
+#define PD_TEXT_BREAK_END(brk) ((size_t) ((brk) >> 2))
+
+/**
+ * @def PD_TEXT_BREAK_NEXT
+ * @brief Byte offset where the line after a break returned by pdText_GetBreaks() starts.
+ */
+#define PD_TEXT_BREAK_NEXT(brk) ((size_t) ((brk) >> 2) + ((brk) & 3))
+
+#ifndef PD_TEXT_COUNTER_TEXT_SIZE
+/**
+ * @def PD_TEXT_COUNTER_TEXT_SIZE
+ * @brief Size of the text buffer inside each #PDTextCounter, prefix and suffix included.
+ *
+ * Define this when building the library to change it.
+ */
+#define PD_TEXT_COUNTER_TEXT_SIZE 32
+#endif
+
+/**
+ * @brief A number on the screen, such as a score, a timer or an FPS counter, drawn only when it changes.
+ *
+ * See pdText_CounterInit(). @c prefix, @c suffix, @c decimals, @c minDigits and @c background
+ * can be changed after initializing; call pdText_CounterInvalidate() if it has been drawn already.
+ */
+typedef struct PDTextCounterTag {
+    const Font *font;
+    /** @brief Anchor of the text: its left edge, center or right edge depending on @c alignment . */
+    int32_t x;
+    /** @brief Top of the text. */
+    int32_t y;
+    PDTextAlignment alignment;
+    /** @brief Text drawn before the number, e.g. @c "Score " ; NULL for none. Not copied. */
+    const char *prefix;
+    /** @brief Text drawn after the number, e.g. @c "%" ; NULL for none. Not copied. */
+    const char *suffix;
+    /** @brief Number of digits after the decimal point: with 2, the value 1234 is shown as @c "12.34" . */
+    uint8_t decimals;
+    /** @brief The whole part is padded with zeros up to this many digits: with 6, 120 is shown as @c "000120" . */
+    uint8_t minDigits;
+    /** @brief Color the previous text is erased with; @c kColorClear to leave erasing to you. */
+    LCDColor background;
+    /** @brief Whether the text on the screen is up to date. */
+    bool drawn;
+    /** @brief Value on the screen. */
+    int32_t value;
+    /** @brief Area covered by the text on the screen, erased before drawing another value. */
+    PDTextRect bounds;
+    /** @brief Text on the screen. */
+    char text[PD_TEXT_COUNTER_TEXT_SIZE];
+    uint8_t length;
+} PDTextCounter;
+
+/**
+ * @brief A font to preload; see pdText_PreloadFonts(const PDTextFontSpec*, size_t).
+ */
+typedef struct PDTextFontSpecTag {
+    /** @brief Path to the font, as given to pdText_LoadFont(const char*, uint8_t, Font*, const char**). */
+    const char *path;
+    /** @brief Margin added to the height of the font. */
+    uint8_t heightMargin;
+} PDTextFontSpec;
+
+/**
+ * @brief One text of a #PDTextDrawQueue.
+ */
+typedef struct PDTextDrawEntryTag {
+    /** @brief Font to draw with; set to NULL while the queue is flushed. */
+    LCDFont *font;
+    /** @brief Byte offset of the text in the text of the queue. */
+    uint32_t offset;
+    /** @brief Length of the text in characters, as @c playdate->graphics->drawText takes it. */
+    uint32_t characters;
+    int32_t x;
+    int32_t y;
+    PDStringEncoding encoding;
+} PDTextDrawEntry;
+
+/**
+ * @brief Texts to be drawn together, so that each font is set only once.
+ *
+ * @code
+ * static PDTextDrawEntry hudEntries[32];
+ * static char hudText[512];
+ * PDTextDrawQueue hud;
+ * pdText_DrawQueueInit(&hud, hudEntries, 32, hudText, sizeof(hudText));
+ *
+ * // Every frame
+ * pdText_DrawQueueAddF(&hud, &smallFont, kASCIIEncoding, 4, 4, "HP %d", hp);
+ * pdText_DrawQueueAddF(&hud, &largeFont, kASCIIEncoding, 200, 4, "%06d", score);
+ * pdText_DrawQueueFlush(&hud);
+ * @endcode
+ *
+ * @remarks Treat the members as read-only.
+ */
+typedef struct PDTextDrawQueueTag {
+    /** @brief Queued texts, in the order they were added. Either the caller's storage or a heap block. */
+    PDTextDrawEntry *entries;
+    uint32_t count;
+    uint32_t capacity;
+    /** @brief Caller-provided entry storage, as passed to pdText_DrawQueueInit. */
+    PDTextDrawEntry *storage;
+    uint32_t storageCapacity;
+    /** @brief Whether @c entries is a heap block owned by the queue. */
+    bool owned;
+    /** @brief The queued texts, one after the other. */
+    PDStrBuf text;
+    /** @brief Texts left out since the last flush because they were entirely off the screen. */
+    uint32_t culled;
+} PDTextDrawQueue;
+
+#ifndef PD_TEXT_BITMAP_CACHE_DEFAULT_BUDGET
+/**
+ * @def PD_TEXT_BITMAP_CACHE_DEFAULT_BUDGET
+ * @brief Bytes the text bitmap cache may use until pdText_SetBitmapCacheBudget(size_t) is called.
+ *
+ * Define this when building the library to change it.
+ */
+#define PD_TEXT_BITMAP_CACHE_DEFAULT_BUDGET (64 * 1024)
+#endif
+
+/**
+ * @brief Statistics of the text bitmap cache.
+ *
+ * @see pdText_GetBitmapCacheStats
+ */
+typedef struct PDTextBitmapCacheStatsTag {
+    /** @brief Texts that were drawn from a cached bitmap. */
+    uint32_t hits;
+    /** @brief Texts that had to be rendered (or were drawn directly because they did not fit in the budget). */
+    uint32_t misses;
+    /** @brief Bitmaps freed to make room for others. */
+    uint32_t evictions;
+    /** @brief Bitmaps currently cached. */
+    uint32_t entryCount;
+    /** @brief Bytes currently used by the cached bitmaps and their keys. */
+    size_t bytes;
+    /** @brief Maximum value of PDTextBitmapCacheStats::bytes. */
+    size_t budget;
+} PDTextBitmapCacheStats;
+
 /**
  * @brief Initializes the text module.
  *
@@ -45,6 +575,7 @@ void pdText_Initialize(void *pd);
  *
  * This API loads a font from given @c font_path,
  * and also stores the height of the font for later use.
+ * It also attaches an empty glyph cache to the font (see pdText_CreateGlyphCache(Font*)).
  *
  * @param[in]  font_path     Path to the font.
  * @param[in]  height_margin This value will be added to the actual font height.
@@ -62,7 +593,9 @@ bool pdText_LoadFont(const char *font_path, uint8_t height_margin, Font *font, c
  * Since @c playdate->graphics->drawText draws text even if it's off the screen,
  * using this function will avoid unwanted cut-off texts.
  *
- * @note This function will only split at spaces (' ', character 0x20).
+ * @note This function splits at spaces (' ', character 0x20).
+ *       @c kUTF8Encoding text is also split between ideographs and kana and after hyphens,
+ *       without breaking kinsoku rules (see #kPDTextLineBreakUnicode).
  *
  * @param[out] out_str   Out buffer, can be supplied from outside.
  *                       If NULL, this function will perform a memory allocation,
@@ -79,10 +612,10 @@ bool pdText_LoadFont(const char *font_path, uint8_t height_margin, Font *font, c
  * @returns Number of valid lines returned from this function.
  *          Is always less than or equal to @c max_lines .
  *
- * @warning This function is potentially computationally costly.
- *          Use it wherever there's a lot of CPU time to spare,
- *          or a performance hit itself is acceptable (such as when loading).
- *          This function allocates some heap memory internally.
+ * @note The text is measured in a single pass using the glyph cache of the font (see pdText_CreateGlyphCache(Font*)),
+ *       so the cost grows linearly with the length of the text.
+ *       The only allocation is the formatted string itself; use pdText_WrapText(char*, size_t, const Font*, uint32_t, uint16_t, PDStringEncoding)
+ *       to wrap text in a buffer of your own.
  */
 uint32_t pdText_GetWrappedText(
     char **out_str,
@@ -94,6 +627,293 @@ uint32_t pdText_GetWrappedText(
     ...
 );
 
+/**
+ * @brief Starts finding the line breaks of a text, one at a time.
+ *
+ * pdText_BreakLines() in the form of an iterator:
+ * call pdText_LineBreakerNext() until it returns false to get the same breaks, in order.
+ *
+ * @param[out] breaker   Line breaker to initialize.
+ * @param[in]  text      Text to wrap. Must stay valid while the breaker is used.
+ * @param[in]  length    Length of the text in bytes.
+ * @param[in]  font      #Font object.
+ * @param[in]  max_lines Number of times to wrap at most. 0 or 1 finds nothing.
+ * @param[in]  max_width Maximum allowed width of the text.
+ * @param[in]  encoding  @c PDStringEncoding value.
+ * @param[in]  rules     Where lines may break.
+ */
+void pdText_LineBreakerInit(
+    PDTextLineBreaker *breaker,
+    const char *text,
+    size_t length,
+    const Font *font,
+    uint32_t max_lines,
+    uint16_t max_width,
+    PDStringEncoding encoding,
+    PDTextLineBreakRules rules
+);
+
+/**
+ * @brief Measures the lines with a function of your own instead of the font, e.g. for text in several fonts.
+ *
+ * The function is called with the same @c start for every opportunity on a line, with increasing @c end ,
+ * so it can carry on measuring from the previous call.
+ * Call this right after pdText_LineBreakerInit(), before the first pdText_LineBreakerNext().
+ *
+ * @param[in,out] breaker  Line breaker.
+ * @param[in]     function Function measuring the text; NULL to measure with the font again.
+ * @param[in]     userdata Passed to @c function as-is.
+ */
+void pdText_LineBreakerSetWidthFunction(PDTextLineBreaker *breaker, PDTextWidthFunction function, void *userdata);
+
+/**
+ * @brief Finds the next line break.
+ *
+ * @param[in,out] breaker         Line breaker.
+ * @param[out]    line_end        The line ends before this byte offset.
+ * @param[out]    next_line_start The next line starts at this byte offset.
+ * @returns false when there are no more line breaks.
+ */
+bool pdText_LineBreakerNext(PDTextLineBreaker *breaker, size_t *line_end, size_t *next_line_start);
+
+/**
+ * @brief Carries on from a saved state, possibly on a changed text.
+ *
+ * The result is the same as wrapping the new text from the start
+ * as long as the text before @c state->scanPosition has not changed
+ * and the state was saved with @c state->hasCurrent set.
+ * The other settings given to pdText_LineBreakerInit() are kept.
+ *
+ * @param[in,out] breaker Line breaker to resume.
+ * @param[in]     text    Text to wrap.
+ * @param[in]     length  Length of the text in bytes.
+ * @param[in]     state   State copied from @c breaker->state right after a line break.
+ */
+void pdText_LineBreakerResume(
+    PDTextLineBreaker *breaker,
+    const char *text,
+    size_t length,
+    const PDTextLineBreakerState *state
+);
+
+/**
+ * @brief Finds where text wraps, without modifying it.
+ *
+ * This is the engine behind the wrapping functions of this module.
+ * The text is scanned once and each word is measured about once, using the glyph cache of the font if it has one.
+ * Nothing is allocated.
+ *
+ * @param[in] text      Text to wrap.
+ * @param[in] length    Length of the text in bytes.
+ * @param[in] font      #Font object.
+ * @param[in] max_lines Number of times to wrap at most. 0 or 1 finds nothing.
+ * @param[in] max_width Maximum allowed width of the text.
+ * @param[in] encoding  @c PDStringEncoding value.
+ * @param[in] rules     Where lines may break.
+ * @param[in] on_break  Called for each line break, in order.
+ * @param[in] userdata  Passed to @c on_break .
+ * @returns Number of lines, counted the same way as pdText_GetWrappedText does.
+ */
+uint32_t pdText_BreakLines(
+    const char *text,
+    size_t length,
+    const Font *font,
+    uint32_t max_lines,
+    uint16_t max_width,
+    PDStringEncoding encoding,
+    PDTextLineBreakRules rules,
+    PDTextLineBreakFunction on_break,
+    void *userdata
+);
+
+/**
+ * @brief Wraps text in place by replacing spaces with line breaks.
+ *
+ * Produces the same result as pdText_GetWrappedText(char**, const Font*, uint32_t, uint16_t, PDStringEncoding, const char*, ...)
+ * does for non-UTF-8 text, for text you already have in a writable buffer.
+ * Since nothing can be inserted, this only breaks at spaces (#kPDTextLineBreakSpaces) whatever the encoding;
+ * use pdText_WrapTextToBuf(PDStrBuf*, const char*, size_t, const Font*, uint32_t, uint16_t, PDStringEncoding)
+ * to wrap CJK text. Nothing is allocated.
+ *
+ * @param[in,out] text      Text to wrap. Spaces are overwritten with @c '\n' where the text wraps.
+ * @param[in]     length    Length of the text in bytes.
+ * @param[in]     font      #Font object.
+ * @param[in]     max_lines Number of times to wrap at most. 0 or 1 leaves the text untouched.
+ * @param[in]     max_width Maximum allowed width of the text.
+ * @param[in]     encoding  @c PDStringEncoding value.
+ * @returns Number of lines, counted the same way as pdText_GetWrappedText does.
+ */
+uint32_t pdText_WrapText(
+    char *text,
+    size_t length,
+    const Font *font,
+    uint32_t max_lines,
+    uint16_t max_width,
+    PDStringEncoding encoding
+);
+
+/**
+ * @brief Appends wrapped text to a #PDStrBuf.
+ *
+ * Follows #kPDTextLineBreakUnicode, so @c kUTF8Encoding text also wraps between ideographs and kana
+ * (with line breaks inserted there) and after hyphens.
+ * With stack storage large enough for the result, nothing is allocated.
+ *
+ * @param[in,out] out       Buffer to append the wrapped text to.
+ * @param[in]     text      Text to wrap.
+ * @param[in]     length    Length of the text in bytes.
+ * @param[in]     font      #Font object.
+ * @param[in]     max_lines Number of times to wrap at most. 0 or 1 appends the text as it is.
+ * @param[in]     max_width Maximum allowed width of the text.
+ * @param[in]     encoding  @c PDStringEncoding value.
+ * @returns Number of lines, counted the same way as pdText_GetWrappedText does.
+ */
+uint32_t pdText_WrapTextToBuf(
+    PDStrBuf *out,
+    const char *text,
+    size_t length,
+    const Font *font,
+    uint32_t max_lines,
+    uint16_t max_width,
+    PDStringEncoding encoding
+);
+
+/**
+ * @brief Prepares an empty layout.
+ *
+ * A layout keeps a copy of its text, split into lines that are measured once.
+ * Drawing it does not format, measure or allocate anything.
+ * Lines break like pdText_WrapTextToBuf(PDStrBuf*, const char*, size_t, const Font*, uint32_t, uint16_t, PDStringEncoding)
+ * does, but also at line feeds in the text, and the last word is wrapped as well if it does not fit.
+ *
+ * @param[out] layout    Layout to initialize.
+ * @param[in]  font      #Font object. Must outlive the layout.
+ * @param[in]  encoding  @c PDStringEncoding value.
+ * @param[in]  max_width Maximum width of the lines, also used for alignment.
+ * @param[in]  max_lines Maximum number of lines; text after them is not shown.
+ * @param[in]  alignment Horizontal alignment of the lines.
+ *
+ * @note Widths are measured with the tracking value current when the text is set.
+ */
+void pdText_LayoutInit(
+    PDTextLayout *layout,
+    const Font *font,
+    PDStringEncoding encoding,
+    uint16_t max_width,
+    uint32_t max_lines,
+    PDTextAlignment alignment
+);
+
+/**
+ * @brief Replaces the text of the layout.
+ *
+ * Only the part of the text that changed is laid out again:
+ * lines that end well before the first changed byte are kept as they are.
+ * This makes updating the tail of the text, as in a counter or a chat log, cheap.
+ *
+ * @param[in,out] layout Layout to update.
+ * @param[in]     text   New text.
+ * @param[in]     length Length of the text in bytes.
+ * @returns false if memory ran out; the layout then shows as much of the text as it could keep.
+ */
+bool pdText_LayoutSetText(PDTextLayout *layout, const char *text, size_t length);
+
+/**
+ * @brief Formats the text (as in pd_Format()) and replaces the text of the layout with it.
+ *
+ * @param[in,out] layout Layout to update.
+ * @param[in]     fmt    Format string.
+ * @param[in]     ...    Variadic arguments, used to format @c fmt .
+ * @returns false if memory ran out.
+ */
+bool pdText_LayoutSetTextF(PDTextLayout *layout, const char *fmt, ...);
+
+/**
+ * @brief Appends text to the layout, laying out only the last lines again.
+ *
+ * @param[in,out] layout Layout to update.
+ * @param[in]     text   Text to append.
+ * @param[in]     length Length of the text in bytes.
+ * @returns false if memory ran out.
+ */
+bool pdText_LayoutAppend(PDTextLayout *layout, const char *text, size_t length);
+
+/**
+ * @brief Draws the layout with its top-left corner at the given coordinates.
+ *
+ * Sets the font of the layout, then draws each line, @c font->height pixels apart.
+ *
+ * @param[in] layout Layout to draw.
+ * @param[in] x      X-axis position of the left edge of the layout (not of the line, when aligned).
+ * @param[in] y      Y-axis position of the first line.
+ */
+void pdText_LayoutDraw(const PDTextLayout *layout, int32_t x, int32_t y);
+
+/**
+ * @brief Frees the text and the lines of the layout, leaving it empty.
+ *
+ * @param[in,out] layout Layout to release.
+ */
+void pdText_LayoutRelease(PDTextLayout *layout);
+
+/**
+ * @brief Prepares an empty rich text.
+ *
+ * Rich text is laid out like #PDTextLayout, with markup in the text to switch fonts and highlight words:
+ *
+ * - <tt>{f1}</tt> to <tt>{f7}</tt> switch to one of the fonts, <tt>{/f}</tt> or <tt>{f0}</tt> back to the first one.
+ * - <tt>{inv}</tt> starts drawing in white on a black box, <tt>{/inv}</tt> stops.
+ * - <tt>{{</tt> is a @c '{' . Anything else in braces is taken as text.
+ *
+ * @param[out] rich       Rich text to initialize.
+ * @param[in]  fonts      #Font objects, the first one being the font the text starts in. Must outlive the rich text.
+ * @param[in]  font_count Number of fonts, up to #PD_TEXT_RICH_MAX_FONTS.
+ * @param[in]  encoding   @c kASCIIEncoding or @c kUTF8Encoding ; @c k16BitLEEncoding text is taken without markup.
+ * @param[in]  max_width  Maximum width of the lines, also used for alignment.
+ * @param[in]  max_lines  Maximum number of lines; text after them is not shown.
+ * @param[in]  alignment  Horizontal alignment of the lines.
+ */
+void pdText_RichTextInit(
+    PDTextRichText *rich,
+    const Font *const *fonts,
+    uint8_t font_count,
+    PDStringEncoding encoding,
+    uint16_t max_width,
+    uint32_t max_lines,
+    PDTextAlignment alignment
+);
+
+/**
+ * @brief Parses, wraps and measures new text.
+ *
+ * Lines break like a #PDTextLayout, measuring each part of a line in its own font.
+ *
+ * @param[in,out] rich   Rich text to update.
+ * @param[in]     markup Text with markup.
+ * @param[in]     length Length of the text in bytes.
+ * @returns false if memory ran out; the rich text then shows as much of the text as it could keep.
+ */
+bool pdText_RichTextSetText(PDTextRichText *rich, const char *markup, size_t length);
+
+/**
+ * @brief Draws every run of the rich text.
+ *
+ * Only walks the runs: nothing is parsed, measured or allocated.
+ * Runs that are not inverted are drawn in the current draw mode, which is set back afterwards.
+ *
+ * @param[in] rich Rich text to draw.
+ * @param[in] x    X-axis position of the left edge of the text (of @c maxWidth when aligned).
+ * @param[in] y    Y-axis position of the top of the first line.
+ */
+void pdText_RichTextDraw(const PDTextRichText *rich, int32_t x, int32_t y);
+
+/**
+ * @brief Frees the text, runs and lines of the rich text, leaving it empty.
+ *
+ * @param[in,out] rich Rich text to release.
+ */
+void pdText_RichTextRelease(PDTextRichText *rich);
+
 /**
  * @brief Shorthand for @c playdate->graphics->drawText .
  *
@@ -102,6 +922,8 @@ uint32_t pdText_GetWrappedText(
  * this API takes all necessary parameters at once
  * and display the text at the given coordinates
  * while also making sure that the memory is properly freed.
+ * The text is formatted with pd_FormatV(char*, size_t, const char*, va_list), which prints like @c printf;
+ * strings shorter than 128 bytes are formatted on the stack, longer ones on the heap.
  *
  * @param[in] encoding @c PDStringEncoding value.
  * @param[in] x        X-axis position.
@@ -112,6 +934,19 @@ uint32_t pdText_GetWrappedText(
  */
 void pdText_DisplayString(PDStringEncoding encoding, int32_t x, int32_t y, const char *fmt, ...);
 
+/**
+ * @brief Shorthand for @c playdate->graphics->drawText, taking a #PDStrBuf.
+ *
+ * Same as pdText_DisplayString(PDStringEncoding, int32_t, int32_t, const char*, ...),
+ * but the text is already built, so nothing is formatted or allocated.
+ *
+ * @param[in] encoding @c PDStringEncoding value.
+ * @param[in] x        X-axis position.
+ * @param[in] y        Y-axis position.
+ * @param[in] buf      Text to display.
+ */
+void pdText_DisplayStringBuf(PDStringEncoding encoding, int32_t x, int32_t y, const PDStrBuf *buf);
+
 /**
  * @brief Shorthand for @c playdate->graphics->setFont and @c playdate->graphics->drawText .
  *
@@ -132,22 +967,711 @@ void pdText_DisplayString(PDStringEncoding encoding, int32_t x, int32_t y, const
 void pdText_DisplayStringWithFont(Font *font, uint32_t encoding, int32_t x, int32_t y, const char *fmt, ...);
 
 /**
- * @brief Calculates the string width of given text using the current tracking value.
+ * @brief Shorthand for @c playdate->graphics->setFont and @c playdate->graphics->drawText, taking a #PDStrBuf.
  *
- * There's a potential performance impact;
- * avoid calling this API like every frame.
- *
- * @param[in] font     #Font object.
- * @param[in] encoding @c PDStringEncoding value.
- * @param[in] text     string to display.
+ * Same as pdText_DisplayStringWithFont(Font*, uint32_t, int32_t, int32_t, const char*, ...),
+ * but the text is already built, so nothing is formatted or allocated.
+ *
+ * @param[in] font     @c Font object.
+ * @param[in] encoding PDStringEncoding value.
+ * @param[in] x        X-axis position.
+ * @param[in] y        Y-axis position.
+ * @param[in] buf      Text to display.
+ */
+void pdText_DisplayStringWithFontBuf(Font *font, uint32_t encoding, int32_t x, int32_t y, const PDStrBuf *buf);
+
+/**
+ * @brief Calculates the string width of given text using the current tracking value.
+ *
+ * If the font has a glyph cache, the width is summed up from cached advances and kerning pairs,
+ * so calling this every frame is fine once the glyphs have been seen.
+ * Without a cache, this asks @c playdate->graphics->getTextWidth every time.
+ *
+ * @param[in] font     #Font object.
+ * @param[in] encoding @c PDStringEncoding value.
+ * @param[in] text     string to display.
  *
  * @warning This API will use the current Text Tracking value.
  */
 uint16_t pdText_GetStringWidth(const Font *font, uint32_t encoding, const char *text);
 
+/**
+ * @brief Calculates the width of the first @c length bytes of @c text using the current tracking value.
+ *
+ * Same as pdText_GetStringWidth(const Font*, uint32_t, const char*),
+ * but the text does not need to be NUL-terminated, which allows measuring parts of a string without copying.
+ * Measurement stops early at a NUL character.
+ *
+ * Text containing line breaks, malformed UTF-8, or non-ASCII bytes in @c kASCIIEncoding
+ * is handed to @c playdate->graphics->getTextWidth as-is, as is @c k16BitLEEncoding text.
+ *
+ * @param[in] font     #Font object.
+ * @param[in] encoding @c PDStringEncoding value.
+ * @param[in] text     Text to measure.
+ * @param[in] length   Length of the text in bytes.
+ * @returns Width of the text in pixels.
+ */
+int pdText_GetTextWidthN(const Font *font, PDStringEncoding encoding, const char *text, size_t length);
+
+/**
+ * @brief Finds how much of the text fits in @c max_width pixels.
+ *
+ * With a glyph cache, this is one pass over the text that stops as soon as it is too wide.
+ * Text the glyph cache cannot measure (see pdText_MeasureAppend(PDTextMeasure*, const char*, size_t))
+ * is binary-searched with @c playdate->graphics->getTextWidth instead.
+ *
+ * @param[in] font      #Font object.
+ * @param[in] encoding  @c PDStringEncoding value.
+ * @param[in] text      Single line of text; need not be NUL-terminated.
+ * @param[in] length    Length of the text in bytes.
+ * @param[in] max_width Width to fit in, in pixels.
+ * @returns Length in bytes of the longest prefix that fits, which always ends at a character boundary;
+ *          @c length if the whole text fits.
+ */
+size_t pdText_FitLength(const Font *font, PDStringEncoding encoding, const char *text, size_t length, int max_width);
+
+/**
+ * @brief Appends as much of the text as fits in @c max_width pixels, followed by an ellipsis if it was cut.
+ *
+ * The ellipsis counts towards the width, and spaces before it are dropped.
+ * If not even the ellipsis fits, only the ellipsis is appended.
+ *
+ * @param[in]     font      #Font object.
+ * @param[in]     encoding  @c PDStringEncoding value.
+ * @param[in]     text      Single line of text; need not be NUL-terminated.
+ * @param[in]     length    Length of the text in bytes.
+ * @param[in]     max_width Width to fit in, in pixels.
+ * @param[in]     ellipsis  Appended when the text is cut, e.g. @c "..." ; NULL to cut without one.
+ * @param[in,out] out       Buffer the result is appended to.
+ * @returns Number of bytes of @c text that were kept; @c length if the whole text fits.
+ */
+size_t pdText_Truncate(
+    const Font *font,
+    PDStringEncoding encoding,
+    const char *text,
+    size_t length,
+    int max_width,
+    const char *ellipsis,
+    PDStrBuf *out
+);
+
+/**
+ * @brief Picks the first font in which the text fits in a box.
+ *
+ * Text is split at line breaks (except @c k16BitLEEncoding text); every line must fit in @c max_width
+ * and the lines, @c Font::height apart, in @c max_height . Text is not wrapped.
+ *
+ * @param[in] fonts      Candidates, usually from the largest to the smallest.
+ * @param[in] font_count Number of candidates.
+ * @param[in] encoding   @c PDStringEncoding value.
+ * @param[in] text       Text to fit; need not be NUL-terminated.
+ * @param[in] length     Length of the text in bytes.
+ * @param[in] max_width  Width of the box in pixels.
+ * @param[in] max_height Height of the box in pixels.
+ * @returns The first font that fits, or NULL if none does.
+ */
+const Font *pdText_FitFont(
+    const Font *const *fonts,
+    size_t font_count,
+    PDStringEncoding encoding,
+    const char *text,
+    size_t length,
+    int max_width,
+    int max_height
+);
+
+/**
+ * @brief Starts measuring text with the current tracking value.
+ *
+ * @param[out] measure  Measure to initialize.
+ * @param[in]  font     #Font object.
+ * @param[in]  encoding @c PDStringEncoding value.
+ */
+void pdText_MeasureBegin(PDTextMeasure *measure, const Font *font, PDStringEncoding encoding);
+
+/**
+ * @brief Adds @c length more bytes of text to the measure.
+ *
+ * Kerning between the end of the previous text and the start of this one is taken into account.
+ *
+ * @param[in,out] measure Measure started with pdText_MeasureBegin(PDTextMeasure*, const Font*, PDStringEncoding).
+ * @param[in]     text    Text to add; need not be NUL-terminated.
+ * @param[in]     length  Length of the text in bytes.
+ * @returns false if the text cannot be measured piece by piece:
+ *          the font has no glyph cache, or the text contains a line break, a NUL character or bytes
+ *          that pdText_GetTextWidthN(const Font*, PDStringEncoding, const char*, size_t) leaves to the SDK.
+ *          From then on the measure stays invalid; measure the whole text with pdText_GetTextWidthN instead.
+ */
+bool pdText_MeasureAppend(PDTextMeasure *measure, const char *text, size_t length);
+
+/**
+ * @brief Width of everything appended so far, including tracking.
+ *
+ * Only meaningful while every pdText_MeasureAppend(PDTextMeasure*, const char*, size_t) call has succeeded.
+ *
+ * @param[in] measure Measure to read.
+ * @returns Width in pixels.
+ */
+int pdText_MeasureGetWidth(const PDTextMeasure *measure);
+
+/**
+ * @brief Attaches a glyph metrics cache to the font.
+ *
+ * The cache starts empty. The advance of each character and the kerning of each pair of characters
+ * is measured with @c playdate->graphics->getTextWidth the first time it is needed and reused afterwards,
+ * so the cached widths are the same as what the SDK would return.
+ * The tracking value is not cached; it is read on every measurement.
+ *
+ * pdText_LoadFont(const char*, uint8_t, Font*, const char**) calls this for you.
+ * Does nothing if the font already has a cache.
+ *
+ * @param[in,out] font #Font object. @c font->font must be set.
+ * @returns true on success, false if @c font->font is NULL or memory ran out.
+ */
+bool pdText_CreateGlyphCache(Font *font);
+
+/**
+ * @brief Fills the glyph cache with the characters and pairs used by @c text .
+ *
+ * Call this at load time with the text (or the character set) you are going to measure
+ * so that measuring never hits the SDK during gameplay.
+ *
+ * @param[in] font     #Font object with a glyph cache.
+ * @param[in] encoding @c PDStringEncoding value.
+ * @param[in] text     NUL-terminated text.
+ */
+void pdText_WarmGlyphCache(const Font *font, PDStringEncoding encoding, const char *text);
+
+/**
+ * @brief Releases the glyph cache of the font, if any.
+ *
+ * pdText_FreeFont(Font*) calls this for you.
+ *
+ * @param[in,out] font #Font object.
+ */
+void pdText_FreeGlyphCache(Font *font);
+
+/**
+ * @brief Prepares an empty typewriter.
+ *
+ * The text is laid out once (see pdText_LayoutInit()) and revealed by pdText_TypewriterUpdate(),
+ * which only draws the characters revealed since the previous frame.
+ * Reveals one character per frame and pauses 15 frames per marker until @c speed and @c pauseFrames are changed.
+ *
+ * @param[out] typewriter Typewriter to initialize.
+ * @param[in]  font       #Font object. Must outlive the typewriter.
+ * @param[in]  encoding   @c PDStringEncoding value.
+ * @param[in]  max_width  Maximum width of the lines, also used for alignment.
+ * @param[in]  max_lines  Maximum number of lines; text after them is not revealed.
+ * @param[in]  alignment  Horizontal alignment of the lines.
+ */
+void pdText_TypewriterInit(
+    PDTextTypewriter *typewriter,
+    const Font *font,
+    PDStringEncoding encoding,
+    uint16_t max_width,
+    uint32_t max_lines,
+    PDTextAlignment alignment
+);
+
+/**
+ * @brief Lays out new text and starts revealing it from the beginning.
+ *
+ * #PD_TEXT_TYPEWRITER_PAUSE markers are taken out of the text and remembered as pauses.
+ * Nothing is drawn until the next update; clear the box yourself if it shows older text.
+ *
+ * @param[in,out] typewriter Typewriter to update.
+ * @param[in]     text       New text.
+ * @param[in]     length     Length of the text in bytes.
+ * @returns false if memory ran out.
+ */
+bool pdText_TypewriterSetText(PDTextTypewriter *typewriter, const char *text, size_t length);
+
+/**
+ * @brief Reveals the characters due this frame and draws them, and only them.
+ *
+ * Each new character is drawn where it is in the laid-out text,
+ * so the text drawn by earlier updates must be left on the screen.
+ * PDTextTypewriter::dirty is set to the area that was drawn.
+ *
+ * @param[in,out] typewriter Typewriter to update.
+ * @param[in]     x          X-axis position of the left edge of the text; must not change between updates.
+ * @param[in]     y          Y-axis position of the first line; must not change between updates.
+ * @returns true if anything was drawn.
+ */
+bool pdText_TypewriterUpdate(PDTextTypewriter *typewriter, int32_t x, int32_t y);
+
+/**
+ * @brief Reveals and draws the rest of the text at once, skipping the pauses.
+ *
+ * @param[in,out] typewriter Typewriter to update.
+ * @param[in]     x          X-axis position of the left edge of the text.
+ * @param[in]     y          Y-axis position of the first line.
+ * @returns true if anything was drawn.
+ */
+bool pdText_TypewriterSkip(PDTextTypewriter *typewriter, int32_t x, int32_t y);
+
+/**
+ * @brief Draws everything revealed so far, e.g. after the screen has been cleared.
+ *
+ * @param[in] typewriter Typewriter to draw.
+ * @param[in] x          X-axis position of the left edge of the text.
+ * @param[in] y          Y-axis position of the first line.
+ */
+void pdText_TypewriterDraw(const PDTextTypewriter *typewriter, int32_t x, int32_t y);
+
+/**
+ * @brief Frees the text, lines and pauses of the typewriter, leaving it empty.
+ *
+ * @param[in,out] typewriter Typewriter to release.
+ */
+void pdText_TypewriterRelease(PDTextTypewriter *typewriter);
+
+/**
+ * @brief Opens an indexed script file made with the @c pd_script_index host tool.
+ *
+ * Only the header and the page table (8 bytes per page) are read and kept in memory.
+ * Pages are read when they are asked for, into a buffer as large as the longest page.
+ *
+ * @param[out] script Script to initialize.
+ * @param[in]  path   Path of the file, as taken by @c playdate->file->open .
+ * @param[out] err    Set to an error message on failure.
+ * @returns true on success.
+ */
+bool pdText_ScriptOpen(PDTextScript *script, const char *path, const char **err);
+
+/**
+ * @brief Reads a page, with a single seek and read unless it is the current or the prefetched page.
+ *
+ * @param[in,out] script Script to read from.
+ * @param[in]     page   Index of the page.
+ * @param[out]    length Set to the length of the page in bytes; may be NULL.
+ * @returns The NUL-terminated page, lines separated by @c '\n' , valid until the next call on the script;
+ *          NULL if the page does not exist or could not be read.
+ */
+const char *pdText_ScriptGetPage(PDTextScript *script, uint32_t page, size_t *length);
+
+/**
+ * @brief Reads the page containing a line and returns the line.
+ *
+ * Lines of the current page are returned without reading the file again.
+ *
+ * @param[in,out] script Script to read from.
+ * @param[in]     line   Index of the line in the whole script.
+ * @param[out]    length Set to the length of the line in bytes.
+ * @returns The line, which is @b not NUL-terminated, valid until the next call on the script;
+ *          NULL if the line does not exist or could not be read.
+ */
+const char *pdText_ScriptGetLine(PDTextScript *script, uint32_t line, size_t *length);
+
+/**
+ * @brief Finds the page a line is on.
+ *
+ * @param[in] script Script to look in.
+ * @param[in] line   Index of the line in the whole script.
+ * @returns Index of the page, or UINT32_MAX if the line does not exist.
+ */
+uint32_t pdText_ScriptGetPageOfLine(const PDTextScript *script, uint32_t line);
+
+/**
+ * @brief Reads a page now, so that asking for it later does not touch the file.
+ *
+ * Call it when there is time to spare, e.g. for the next page while the current one is being revealed.
+ * Only one page is kept ahead; prefetching another replaces it.
+ *
+ * @param[in,out] script Script to read from.
+ * @param[in]     page   Index of the page.
+ * @returns false if the page does not exist or could not be read.
+ */
+bool pdText_ScriptPrefetch(PDTextScript *script, uint32_t page);
+
+/**
+ * @brief Closes the file and frees the page table and buffers.
+ *
+ * @param[in,out] script Script to close.
+ */
+void pdText_ScriptClose(PDTextScript *script);
+
+/**
+ * @brief Loads the strings of one language from a string table made with the @c pd_strings_compile host tool.
+ *
+ * Reads the directory of the file, then the section of that language with a single seek and read,
+ * into one block of memory. The other languages are not read.
+ *
+ * @param[out] strings  String table to initialize.
+ * @param[in]  path     Path of the file, as taken by @c playdate->file->open .
+ * @param[in]  language Language code, as in the header of the source file (e.g. @c "en" ).
+ * @param[out] err      Set to an error message on failure.
+ * @returns true on success. On failure, the table is empty and pdText_GetString() returns empty strings.
+ */
+bool pdText_LoadStrings(PDTextStrings *strings, const char *path, const char *language, const char **err);
+
+/**
+ * @brief Looks up a string.
+ *
+ * @param[in] strings String table.
+ * @param[in] id      ID of the string, usually a constant from the header written by @c pd_strings_compile .
+ * @returns The NUL-terminated string inside the table, valid until pdText_FreeStrings(PDTextStrings*);
+ *          an empty string if the ID is out of range.
+ */
+const char *pdText_GetString(const PDTextStrings *strings, uint32_t id);
+
+/**
+ * @brief Looks up a string along with its length, for the functions taking one.
+ *
+ * @param[in]  strings String table.
+ * @param[in]  id      ID of the string.
+ * @param[out] length  Set to the length of the string in bytes.
+ * @returns Same as pdText_GetString(const PDTextStrings*, uint32_t).
+ */
+const char *pdText_GetStringN(const PDTextStrings *strings, uint32_t id, size_t *length);
+
+/**
+ * @brief Frees the strings, e.g. before loading another language.
+ *
+ * @param[in,out] strings String table to free.
+ */
+void pdText_FreeStrings(PDTextStrings *strings);
+
+/**
+ * @brief Loads the line breaks of one language from a break table made with the @c pd_prewrap host tool.
+ *
+ * The breaks are the ones pdText_GetWrappedText(char**, const Font*, uint32_t, uint16_t, PDStringEncoding, const char*, ...)
+ * would find for the strings of a string table (see pdText_LoadStrings()), so wrapping them takes no measuring.
+ * Only the section of the language is read, with a single seek and read.
+ *
+ * @param[out] breaks   Break table to initialize.
+ * @param[in]  path     Path of the file, as taken by @c playdate->file->open .
+ * @param[in]  language Language code, as in the string table.
+ * @param[out] err      Set to an error message on failure.
+ * @returns true on success. On failure, the table is empty and every string has no break.
+ */
+bool pdText_LoadBreaks(PDTextBreaks *breaks, const char *path, const char *language, const char **err);
+
+/**
+ * @brief Returns the line breaks of a string.
+ *
+ * Decode each break with PD_TEXT_BREAK_END() and PD_TEXT_BREAK_NEXT(), e.g. to draw the lines one by one
+ * straight from the string table.
+ *
+ * @param[in]  breaks Break table.
+ * @param[in]  id     ID of the string.
+ * @param[out] count  Set to the number of breaks, that is the number of lines - 1; 0 if the ID is out of range.
+ * @returns The breaks, valid until pdText_FreeBreaks(PDTextBreaks*).
+ */
+const uint32_t *pdText_GetBreaks(const PDTextBreaks *breaks, uint32_t id, size_t *count);
+
+/**
+ * @brief Writes a string with its precomputed line breaks, as pdText_WrapTextToBuf() would without measuring it.
+ *
+ * @param[out] out    Buffer the wrapped text is appended to.
+ * @param[in]  breaks Break table.
+ * @param[in]  id     ID of the string.
+ * @param[in]  text   The string, usually from pdText_GetStringN(const PDTextStrings*, uint32_t, size_t*).
+ * @param[in]  length Length of @c text in bytes.
+ * @returns Number of lines, the same as pdText_WrapTextToBuf() returns;
+ *          0 if the breaks were computed for a string of another length, in which case
+ *          the text is appended unwrapped and a warning is logged (the table is out of date).
+ */
+uint32_t pdText_WrapWithBreaks(PDStrBuf *out, const PDTextBreaks *breaks, uint32_t id, const char *text, size_t length);
+
+/**
+ * @brief Frees a break table.
+ *
+ * @param[in,out] breaks Break table to free.
+ */
+void pdText_FreeBreaks(PDTextBreaks *breaks);
+
+/**
+ * @brief Prepares a counter. Nothing is drawn until pdText_CounterUpdate() is called.
+ *
+ * @param[out] counter   Counter to initialize.
+ * @param[in]  font      #Font object. Must outlive the counter.
+ * @param[in]  x         X-axis position of the anchor (see PDTextCounter::x).
+ * @param[in]  y         Y-axis position of the top of the text.
+ * @param[in]  alignment Which edge of the text is at @c x .
+ */
+void pdText_CounterInit(PDTextCounter *counter, const Font *font, int32_t x, int32_t y, PDTextAlignment alignment);
+
+/**
+ * @brief Draws the value if it differs from the one on the screen.
+ *
+ * Formats the value into the counter without @c printf,
+ * erases the previous text by filling its bounding box with PDTextCounter::background, and draws the new text.
+ * When the value has not changed, this only compares two integers.
+ *
+ * @param[in,out] counter Counter to update.
+ * @param[in]     value   Value to show; a fixed-point value if PDTextCounter::decimals is set.
+ * @returns true if the counter was drawn.
+ */
+bool pdText_CounterUpdate(PDTextCounter *counter, int32_t value);
+
+/**
+ * @brief Makes the next pdText_CounterUpdate() draw the counter again, e.g. after the screen has been cleared.
+ *
+ * Nothing is erased by the next update.
+ *
+ * @param[in,out] counter Counter to invalidate.
+ */
+void pdText_CounterInvalidate(PDTextCounter *counter);
+
+/**
+ * @brief Gets a shared font, loading it only if no one has it yet.
+ *
+ * Fonts are shared by path and height margin: every call with the same ones returns the same #Font
+ * and adds a reference to it. Release each reference with pdText_ReleaseFont(const Font*).
+ * Fonts nobody refers to stay loaded until pdText_TrimFonts(void) is called,
+ * so a font used by two scenes in a row is not loaded again in between.
+ *
+ * @param[in]  font_path     Path to the font.
+ * @param[in]  height_margin This value will be added to the actual font height.
+ * @param[out] err           Should an error occur, this string will be populated.
+ * @returns The shared font, or NULL if it could not be loaded. Do not pass it to pdText_FreeFont(Font*).
+ */
+Font *pdText_AcquireFont(const char *font_path, uint8_t height_margin, const char **err);
+
+/**
+ * @brief Drops a reference taken with pdText_AcquireFont(const char*, uint8_t, const char**).
+ *
+ * @param[in] font Shared font.
+ */
+void pdText_ReleaseFont(const Font *font);
+
+/**
+ * @brief Adds a reference to each font of the list, to be loaded a few at a time by pdText_UpdateFontPreload(uint32_t).
+ *
+ * Call this before a scene needs its fonts (e.g. on a loading screen or a title card),
+ * so that the pdText_AcquireFont(const char*, uint8_t, const char**) calls of the scene find them loaded.
+ * Fonts that are already loaded are only referenced.
+ * Drop the references with pdText_ReleaseFonts(const PDTextFontSpec*, size_t) when the scene is done with them.
+ *
+ * @param[in] fonts Fonts to preload.
+ * @param[in] count Number of fonts in @c fonts .
+ */
+void pdText_PreloadFonts(const PDTextFontSpec *fonts, size_t count);
+
+/**
+ * @brief Loads up to @c max_loads fonts queued by pdText_PreloadFonts(const PDTextFontSpec*, size_t).
+ *
+ * Call this once per frame to spread the loading over several frames.
+ * Fonts that fail to load are logged and not retried until they are acquired.
+ *
+ * @param[in] max_loads Maximum number of fonts to load in this call.
+ * @returns Number of fonts still waiting to be loaded.
+ */
+uint32_t pdText_UpdateFontPreload(uint32_t max_loads);
+
+/**
+ * @brief Drops the references taken by pdText_PreloadFonts(const PDTextFontSpec*, size_t).
+ *
+ * @param[in] fonts Fonts that were preloaded.
+ * @param[in] count Number of fonts in @c fonts .
+ */
+void pdText_ReleaseFonts(const PDTextFontSpec *fonts, size_t count);
+
+/**
+ * @brief Frees the shared fonts that nobody refers to anymore.
+ *
+ * Call this once the next scene has acquired its fonts, e.g. at the end of its init function.
+ *
+ * @returns Number of fonts freed.
+ */
+uint32_t pdText_TrimFonts(void);
+
+/**
+ * @brief Frees every shared font, referenced or not.
+ *
+ * pdText_Finalize(void) calls this for you. Fonts that are still referenced are logged.
+ */
+void pdText_ClearFontRegistry(void);
+
+/**
+ * @brief Initializes a draw queue.
+ *
+ * The entries and the text are kept in the storage you provide (usually static arrays),
+ * and move to the heap if a frame needs more. Either storage can be NULL with a capacity of 0.
+ *
+ * @param[out] queue          Queue to initialize.
+ * @param[in]  entry_storage  Storage for the entries.
+ * @param[in]  entry_capacity Number of entries @c entry_storage can hold.
+ * @param[in]  text_storage   Storage for the text.
+ * @param[in]  text_capacity  Size of @c text_storage in bytes.
+ */
+void pdText_DrawQueueInit(
+    PDTextDrawQueue *queue,
+    PDTextDrawEntry *entry_storage,
+    uint32_t entry_capacity,
+    char *text_storage,
+    size_t text_capacity
+);
+
+/**
+ * @brief Queues text to be drawn by pdText_DrawQueueFlush(PDTextDrawQueue*).
+ *
+ * The text is copied, so it does not need to outlive the call.
+ * Text that would be entirely off the screen is left out right away (see @c culled ).
+ *
+ * @param[in,out] queue    Queue to add to.
+ * @param[in]     font     #Font object.
+ * @param[in]     encoding @c PDStringEncoding value.
+ * @param[in]     x        X-axis position.
+ * @param[in]     y        Y-axis position.
+ * @param[in]     text     Text to draw; need not be NUL-terminated.
+ * @param[in]     length   Length of the text in bytes.
+ * @returns false if memory ran out; the text is then not queued.
+ */
+bool pdText_DrawQueueAdd(
+    PDTextDrawQueue *queue,
+    const Font *font,
+    PDStringEncoding encoding,
+    int32_t x,
+    int32_t y,
+    const char *text,
+    size_t length
+);
+
+/**
+ * @brief Formats text (as in pd_Format()) straight into the queue.
+ *
+ * Same as pdText_DrawQueueAdd(PDTextDrawQueue*, const Font*, PDStringEncoding, int32_t, int32_t, const char*, size_t),
+ * without formatting into a buffer first.
+ *
+ * @param[in,out] queue    Queue to add to.
+ * @param[in]     font     #Font object.
+ * @param[in]     encoding @c PDStringEncoding value.
+ * @param[in]     x        X-axis position.
+ * @param[in]     y        Y-axis position.
+ * @param[in]     fmt      Format string.
+ * @param[in]     ...      Variadic arguments, used to format @c fmt .
+ * @returns false if memory ran out; the text is then not queued.
+ */
+bool pdText_DrawQueueAddF(
+    PDTextDrawQueue *queue,
+    const Font *font,
+    PDStringEncoding encoding,
+    int32_t x,
+    int32_t y,
+    const char *fmt,
+    ...
+);
+
+/**
+ * @brief Draws every queued text, then empties the queue.
+ *
+ * Texts are drawn font by font: each font is set once,
+ * and texts in the same font are drawn in the order they were added.
+ * The storage is kept for the next frame.
+ *
+ * @param[in,out] queue Queue to draw.
+ * @returns Number of texts drawn.
+ */
+uint32_t pdText_DrawQueueFlush(PDTextDrawQueue *queue);
+
+/**
+ * @brief Empties the queue without drawing anything.
+ *
+ * @param[in,out] queue Queue to empty.
+ */
+void pdText_DrawQueueClear(PDTextDrawQueue *queue);
+
+/**
+ * @brief Frees the heap blocks of the queue, if any, and empties it.
+ *
+ * @param[in,out] queue Queue to release.
+ */
+void pdText_DrawQueueRelease(PDTextDrawQueue *queue);
+
+/**
+ * @brief Draws text from a cached bitmap, rendering it only the first time.
+ *
+ * The text is drawn once with @c playdate->graphics->drawText into an @c LCDBitmap,
+ * which is then drawn with @c playdate->graphics->drawBitmap (and the current draw mode) every time
+ * the same text is drawn with the same font, encoding and tracking.
+ * Use this for text that is drawn every frame but rarely changes, such as labels and menu items.
+ *
+ * Line feeds start a new line, @c font->height pixels below.
+ * Least recently drawn bitmaps are freed when the cache goes over its budget
+ * (see pdText_SetBitmapCacheBudget(size_t)).
+ * Text that does not fit in the budget on its own is drawn directly with @c playdate->graphics->drawText,
+ * after setting the font.
+ *
+ * The draw mode and the text tracking are left as they were,
+ * but rendering the text (or drawing it directly) leaves @c font as the current font,
+ * as pdText_DisplayStringWithFont(Font*, uint32_t, int32_t, int32_t, const char*, ...) does.
+ * Set the font again before drawing text with @c playdate->graphics->drawText after this.
+ *
+ * @param[in] font     #Font object.
+ * @param[in] encoding @c PDStringEncoding value.
+ * @param[in] x        X-axis position.
+ * @param[in] y        Y-axis position.
+ * @param[in] text     Text to draw; need not be NUL-terminated.
+ * @param[in] length   Length of the text in bytes.
+ */
+void pdText_DisplayCachedText(
+    const Font *font,
+    PDStringEncoding encoding,
+    int32_t x,
+    int32_t y,
+    const char *text,
+    size_t length
+);
+
+/**
+ * @brief Returns the cached bitmap of the text, rendering it if needed.
+ *
+ * Same as pdText_DisplayCachedText(const Font*, PDStringEncoding, int32_t, int32_t, const char*, size_t),
+ * but leaves the drawing to you (e.g. to scale or rotate it).
+ * Rendering the text leaves @c font as the current font as well.
+ * The bitmap belongs to the cache: do not free it,
+ * and do not use it after the next call to a text bitmap cache function.
+ *
+ * @param[in] font     #Font object.
+ * @param[in] encoding @c PDStringEncoding value.
+ * @param[in] text     Text to render; need not be NUL-terminated.
+ * @param[in] length   Length of the text in bytes.
+ * @returns The bitmap, or NULL if the text is empty, does not fit in the budget or memory ran out.
+ */
+LCDBitmap *pdText_GetCachedTextBitmap(const Font *font, PDStringEncoding encoding, const char *text, size_t length);
+
+/**
+ * @brief Sets how many bytes of bitmaps the text bitmap cache may keep.
+ *
+ * Least recently drawn bitmaps are freed right away if the cache is over the new budget.
+ * A budget of 0 disables the cache.
+ * Until this is called, the budget is #PD_TEXT_BITMAP_CACHE_DEFAULT_BUDGET.
+ *
+ * @param[in] bytes Budget in bytes, counting the bitmaps, their masks and their keys.
+ */
+void pdText_SetBitmapCacheBudget(size_t bytes);
+
+/**
+ * @brief Frees the cached bitmaps of a font, or all of them.
+ *
+ * pdText_FreeFont(Font*) calls this for you.
+ * Call it yourself if you change how a font looks to the SDK without reloading it.
+ *
+ * @param[in] font #Font object whose bitmaps are freed, or NULL to free every bitmap.
+ */
+void pdText_InvalidateBitmapCache(const Font *font);
+
+/**
+ * @brief Writes the current statistics of the text bitmap cache to @c stats .
+ *
+ * @param[out] stats Statistics.
+ */
+void pdText_GetBitmapCacheStats(PDTextBitmapCacheStats *stats);
+
+/**
+ * @brief Resets the hit, miss and eviction counters of the text bitmap cache.
+ */
+void pdText_ResetBitmapCacheStats(void);
+
 /**
  * @brief Frees the font loaded by pdText_LoadFont(const char*, uint8_t, Font*, const char**).
  *
+ * Fonts from pdText_AcquireFont(const char*, uint8_t, const char**) are shared;
+ * release them with pdText_ReleaseFont(const Font*) instead.
+ *
  * @param[in] font #Font struct to free.
  */
 void pdText_FreeFont(Font *font);
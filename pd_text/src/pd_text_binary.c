@@ -0,0 +1,20 @@
+#include "pd_text_binary.h"
+
+#include <pd_api.h>
+#include <pd_shorthand.h>
+
+bool pdText_FindLanguageSection(
+    void *file,
+    uint32_t languageCount,
+    const char *language,
+    uint32_t *offset,
+    uint32_t *size
+) {
+    PlaydateAPI *pd = pd_getPd();
+    uint8_t entry[PD_TEXT_LANGUAGE_ENTRY_SIZE];
+    for (uint32_t i = 0; i < languageCount; i++) {
+        if (pd->file->read(file, entry, sizeof(entry)) != (int) sizeof(entry)) return false;
+        if (pdText_MatchLanguageEntry(entry, language, offset, size)) return true;
+    }
+    return false;
+}
@@ -0,0 +1,96 @@
+/**
+ * @file pd_text_binary.h
+ *
+ * @brief Little-endian integers and language directories of the binary files of the text library.
+ *
+ * Script files, string tables and break tables are written by host-side tools and read on device,
+ * and both sides use these helpers, so this header does not depend on the Playdate SDK.
+ *
+ * Files holding one section per language start, after their own header, with a language directory:
+ * one #PD_TEXT_LANGUAGE_ENTRY_SIZE-byte entry per language, holding the language code
+ * (#PD_TEXT_LANGUAGE_CODE_SIZE bytes, NUL-padded), the u32 offset of the section of the language
+ * from the start of the file and the u32 size of the section.
+ */
+
+#ifndef PD_TEXT_BINARY_H
+#define PD_TEXT_BINARY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define PD_TEXT_LANGUAGE_CODE_SIZE 8
+#define PD_TEXT_LANGUAGE_ENTRY_SIZE 16
+
+static inline uint32_t pdText_GetU16(const uint8_t *in) {
+    return (uint32_t) in[0] | ((uint32_t) in[1] << 8);
+}
+
+static inline uint32_t pdText_GetU32(const uint8_t *in) {
+    return pdText_GetU16(in) | (pdText_GetU16(in + 2) << 16);
+}
+
+static inline void pdText_PutU16(uint8_t *out, uint32_t value) {
+    out[0] = (uint8_t) value;
+    out[1] = (uint8_t) (value >> 8);
+}
+
+static inline void pdText_PutU32(uint8_t *out, uint32_t value) {
+    pdText_PutU16(out, value & 0xFFFF);
+    pdText_PutU16(out + 2, value >> 16);
+}
+
+/**
+ * @brief Writes a language directory entry.
+ *
+ * @param[out] entry  #PD_TEXT_LANGUAGE_ENTRY_SIZE bytes.
+ * @param[in]  code   Language code, at most #PD_TEXT_LANGUAGE_CODE_SIZE bytes.
+ * @param[in]  offset Offset of the section of the language from the start of the file.
+ * @param[in]  size   Size of the section in bytes.
+ */
+static inline void pdText_PutLanguageEntry(uint8_t *entry, const char *code, uint32_t offset, uint32_t size) {
+    memset(entry, 0, PD_TEXT_LANGUAGE_CODE_SIZE);
+    for (size_t i = 0; i < PD_TEXT_LANGUAGE_CODE_SIZE && code[i] != '\0'; i++) {
+        entry[i] = (uint8_t) code[i];
+    }
+    pdText_PutU32(entry + PD_TEXT_LANGUAGE_CODE_SIZE, offset);
+    pdText_PutU32(entry + PD_TEXT_LANGUAGE_CODE_SIZE + 4, size);
+}
+
+/**
+ * @brief Reads a language directory entry if it is the one of @c language.
+ *
+ * @returns true, with the offset and size of the section, if the entry is the one of @c language.
+ */
+static inline bool pdText_MatchLanguageEntry(
+    const uint8_t *entry,
+    const char *language,
+    uint32_t *offset,
+    uint32_t *size
+) {
+    if (strncmp((const char *) entry, language, PD_TEXT_LANGUAGE_CODE_SIZE) != 0) return false;
+    *offset = pdText_GetU32(entry + PD_TEXT_LANGUAGE_CODE_SIZE);
+    *size = pdText_GetU32(entry + PD_TEXT_LANGUAGE_CODE_SIZE + 4);
+    return true;
+}
+
+/**
+ * @brief Finds the section of a language by reading a language directory (device side only).
+ *
+ * @param[in]  file          @c SDFile positioned at the start of the directory.
+ * @param[in]  languageCount Number of entries in the directory.
+ * @param[in]  language      Language code to look for.
+ * @param[out] offset        Offset of the section from the start of the file.
+ * @param[out] size          Size of the section in bytes.
+ * @returns false if the language isn't in the directory or the directory can't be read.
+ */
+bool pdText_FindLanguageSection(
+    void *file,
+    uint32_t languageCount,
+    const char *language,
+    uint32_t *offset,
+    uint32_t *size
+);
+
+#endif /* PD_TEXT_BINARY_H */
@@ -0,0 +1,291 @@
+#include "pd_text.h"
+
+#include <pd_api.h>
+#include <pd_shorthand.h>
+#include <string.h>
+
+#define BITMAP_CACHE_INITIAL_BUCKETS 32
+
+typedef struct TextBitmapTag {
+    /* Next entry in the same bucket */
+    struct TextBitmapTag *hashNext;
+    /* Neighbours in least-recently-drawn order */
+    struct TextBitmapTag *newer;
+    struct TextBitmapTag *older;
+    LCDBitmap *bitmap;
+    LCDFont *font;
+    uint32_t hash;
+    int32_t tracking;
+    PDStringEncoding encoding;
+    uint8_t lineHeight;
+    size_t bytes;
+    size_t length;
+    /* Copy of the text, so that two texts with the same hash never share a bitmap */
+    char text[];
+} TextBitmap;
+
+static TextBitmap **s_buckets;
+static uint32_t s_bucket_count;
+static TextBitmap *s_newest;
+static TextBitmap *s_oldest;
+static PDTextBitmapCacheStats s_stats = {0, 0, 0, 0, 0, PD_TEXT_BITMAP_CACHE_DEFAULT_BUDGET};
+
+static uint32_t hash_key(const Font *font, PDStringEncoding encoding, int32_t tracking, const char *text, size_t length) {
+    /* FNV-1a */
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ (uint8_t) text[i]) * 16777619u;
+    }
+    hash = (hash ^ (uint32_t) (uintptr_t) font->font) * 16777619u;
+    hash = (hash ^ (uint32_t) tracking) * 16777619u;
+    hash = (hash ^ ((uint32_t) encoding << 8 | font->height)) * 16777619u;
+    return hash;
+}
+
+static size_t count_characters(PDStringEncoding encoding, const char *text, size_t length) {
+    if (encoding == k16BitLEEncoding) return length / 2;
+    if (encoding != kUTF8Encoding) return length;
+    size_t count = 0;
+    for (size_t i = 0; i < length; i++) {
+        count += ((uint8_t) text[i] & 0xC0) != 0x80 ? 1 : 0;
+    }
+    return count;
+}
+
+/* Length of the first line of the text; 16-bit text is never split. */
+static size_t line_length(PDStringEncoding encoding, const char *text, size_t length) {
+    if (encoding == k16BitLEEncoding) return length;
+    const char *end = memchr(text, '\n', length);
+    return end == NULL ? length : (size_t) (end - text);
+}
+
+static void draw_lines(const Font *font, PDStringEncoding encoding, const char *text, size_t length, int x, int y) {
+    PlaydateAPI *pd = pd_getPd();
+    size_t start = 0;
+    for (;;) {
+        size_t line = line_length(encoding, text + start, length - start);
+        pd->graphics->drawText(text + start, count_characters(encoding, text + start, line), encoding, x, y);
+        start += line + 1;
+        if (start > length) break;
+        y += font->height;
+    }
+}
+
+static void unlink_entry(TextBitmap *entry) {
+    TextBitmap **link = &s_buckets[entry->hash & (s_bucket_count - 1)];
+    while (*link != entry) {
+        link = &(*link)->hashNext;
+    }
+    *link = entry->hashNext;
+
+    if (entry->newer != NULL) {
+        entry->newer->older = entry->older;
+    } else {
+        s_newest = entry->older;
+    }
+    if (entry->older != NULL) {
+        entry->older->newer = entry->newer;
+    } else {
+        s_oldest = entry->newer;
+    }
+}
+
+static void free_entry(TextBitmap *entry) {
+    unlink_entry(entry);
+    s_stats.entryCount--;
+    s_stats.bytes -= entry->bytes;
+    pd_getPd()->graphics->freeBitmap(entry->bitmap);
+    pd_Free(entry);
+}
+
+static void push_newest(TextBitmap *entry) {
+    entry->newer = NULL;
+    entry->older = s_newest;
+    if (s_newest != NULL) {
+        s_newest->newer = entry;
+    } else {
+        s_oldest = entry;
+    }
+    s_newest = entry;
+}
+
+static void evict_until(size_t bytes) {
+    while (s_oldest != NULL && s_stats.bytes > bytes) {
+        free_entry(s_oldest);
+        s_stats.evictions++;
+    }
+}
+
+static bool grow_buckets(void) {
+    uint32_t count = s_bucket_count == 0 ? BITMAP_CACHE_INITIAL_BUCKETS : s_bucket_count * 2;
+    TextBitmap **buckets = pd_Malloc(sizeof(TextBitmap *) * count);
+    if (buckets == NULL) return false;
+    memset(buckets, 0, sizeof(TextBitmap *) * count);
+    for (uint32_t i = 0; i < s_bucket_count; i++) {
+        TextBitmap *entry = s_buckets[i];
+        while (entry != NULL) {
+            TextBitmap *next = entry->hashNext;
+            entry->hashNext = buckets[entry->hash & (count - 1)];
+            buckets[entry->hash & (count - 1)] = entry;
+            entry = next;
+        }
+    }
+    pd_Free(s_buckets);
+    s_buckets = buckets;
+    s_bucket_count = count;
+    return true;
+}
+
+static TextBitmap *find(
+    const Font *font,
+    PDStringEncoding encoding,
+    int32_t tracking,
+    const char *text,
+    size_t length,
+    uint32_t hash
+) {
+    if (s_bucket_count == 0) return NULL;
+    for (TextBitmap *entry = s_buckets[hash & (s_bucket_count - 1)]; entry != NULL; entry = entry->hashNext) {
+        if (entry->hash == hash && entry->length == length && entry->font == font->font
+            && entry->tracking == tracking && entry->encoding == encoding && entry->lineHeight == font->height
+            && memcmp(entry->text, text, length) == 0) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+static TextBitmap *render(
+    const Font *font,
+    PDStringEncoding encoding,
+    int32_t tracking,
+    const char *text,
+    size_t length,
+    uint32_t hash
+) {
+    PlaydateAPI *pd = pd_getPd();
+    int width = 0;
+    int height = pd->graphics->getFontHeight(font->font);
+    size_t start = 0;
+    for (;;) {
+        size_t line = line_length(encoding, text + start, length - start);
+        int lineWidth = pdText_GetTextWidthN(font, encoding, text + start, line);
+        width = lineWidth > width ? lineWidth : width;
+        start += line + 1;
+        if (start > length) break;
+        height += font->height;
+    }
+    if (width <= 0 || height <= 0) return NULL;
+
+    /* Rows are padded to 32 bits; a clear background comes with a mask of the same size. */
+    size_t bytes = sizeof(TextBitmap) + length + (size_t) (width + 31) / 32 * 4 * (size_t) height * 2;
+    if (bytes > s_stats.budget) return NULL;
+    evict_until(s_stats.budget - bytes);
+    if (s_stats.entryCount >= s_bucket_count && !grow_buckets()) return NULL;
+
+    TextBitmap *entry = pd_Malloc(sizeof(TextBitmap) + length);
+    if (entry == NULL) return NULL;
+    entry->bitmap = pd->graphics->newBitmap(width, height, kColorClear);
+    if (entry->bitmap == NULL) {
+        pd_Free(entry);
+        return NULL;
+    }
+    /* The draw mode is the caller's, so it is put back; the tracking is already the caller's. */
+    pd->graphics->pushContext(entry->bitmap);
+    LCDBitmapDrawMode previousMode = pd->graphics->setDrawMode(kDrawModeCopy);
+    pd->graphics->setFont(font->font);
+    pd->graphics->setTextTracking(tracking);
+    draw_lines(font, encoding, text, length, 0, 0);
+    pd->graphics->setDrawMode(previousMode);
+    pd->graphics->popContext();
+
+    entry->font = font->font;
+    entry->hash = hash;
+    entry->tracking = tracking;
+    entry->encoding = encoding;
+    entry->lineHeight = font->height;
+    entry->bytes = bytes;
+    entry->length = length;
+    memcpy(entry->text, text, length);
+    entry->hashNext = s_buckets[hash & (s_bucket_count - 1)];
+    s_buckets[hash & (s_bucket_count - 1)] = entry;
+    push_newest(entry);
+    s_stats.entryCount++;
+    s_stats.bytes += bytes;
+    return entry;
+}
+
+LCDBitmap *pdText_GetCachedTextBitmap(const Font *font, PDStringEncoding encoding, const char *text, size_t length) {
+    if (font == NULL || font->font == NULL) {
+        pd_Error("PDText Error: NULL font passed.");
+        return NULL;
+    }
+    if (length == 0) return NULL;
+
+    int32_t tracking = pd_getPd()->graphics->getTextTracking();
+    uint32_t hash = hash_key(font, encoding, tracking, text, length);
+    TextBitmap *entry = find(font, encoding, tracking, text, length, hash);
+    if (entry != NULL) {
+        s_stats.hits++;
+        if (entry != s_newest) {
+            unlink_entry(entry);
+            entry->hashNext = s_buckets[hash & (s_bucket_count - 1)];
+            s_buckets[hash & (s_bucket_count - 1)] = entry;
+            push_newest(entry);
+        }
+        return entry->bitmap;
+    }
+
+    s_stats.misses++;
+    entry = render(font, encoding, tracking, text, length, hash);
+    return entry == NULL ? NULL : entry->bitmap;
+}
+
+void pdText_DisplayCachedText(
+    const Font *font,
+    PDStringEncoding encoding,
+    int32_t x,
+    int32_t y,
+    const char *text,
+    size_t length
+) {
+    LCDBitmap *bitmap = pdText_GetCachedTextBitmap(font, encoding, text, length);
+    if (bitmap != NULL) {
+        pd_getPd()->graphics->drawBitmap(bitmap, x, y, kBitmapUnflipped);
+    } else if (font != NULL && font->font != NULL && length > 0) {
+        /* Too large for the budget, or out of memory */
+        pd_getPd()->graphics->setFont(font->font);
+        draw_lines(font, encoding, text, length, x, y);
+    }
+}
+
+void pdText_SetBitmapCacheBudget(size_t bytes) {
+    s_stats.budget = bytes;
+    evict_until(bytes);
+}
+
+void pdText_InvalidateBitmapCache(const Font *font) {
+    TextBitmap *entry = s_oldest;
+    while (entry != NULL) {
+        TextBitmap *newer = entry->newer;
+        if (font == NULL || entry->font == font->font) {
+            free_entry(entry);
+        }
+        entry = newer;
+    }
+    if (font == NULL) {
+        pd_Free(s_buckets);
+        s_buckets = NULL;
+        s_bucket_count = 0;
+    }
+}
+
+void pdText_GetBitmapCacheStats(PDTextBitmapCacheStats *stats) {
+    *stats = s_stats;
+}
+
+void pdText_ResetBitmapCacheStats(void) {
+    s_stats.hits = 0;
+    s_stats.misses = 0;
+    s_stats.evictions = 0;
+}
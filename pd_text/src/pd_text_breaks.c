@@ -0,0 +1,136 @@
+#include "pd_text.h"
+#include "pd_text_binary.h"
+#include "pd_text_breaks_format.h"
+
+#include <pd_api.h>
+#include <pd_shorthand.h>
+#include <stdio.h>
+#include <string.h>
+
+static void reset(PDTextBreaks *breaks) {
+    breaks->entries = NULL;
+    breaks->breaks = NULL;
+    breaks->count = 0;
+    breaks->maxWidth = 0;
+    breaks->maxLines = 0;
+    breaks->language[0] = '\0';
+}
+
+/* Decodes the entries and breaks in place, checking that every string's breaks lie within the section and its text. */
+static bool decode_section(PDTextBreaks *breaks, uint32_t count, uint32_t size) {
+    uint32_t *words = breaks->entries;
+    const uint8_t *raw = (const uint8_t *) words;
+    size_t entryWords = ((size_t) count + 1) * 3;
+    size_t breakCount = size / 4 - entryWords;
+    for (size_t i = 0; i < size / 4; i++) {
+        words[i] = pdText_GetU32(raw + i * 4);
+    }
+    if (words[count * 3] != breakCount) return false;
+    uint32_t *decoded = words + entryWords;
+    for (uint32_t id = 0; id < count; id++) {
+        uint32_t first = words[id * 3];
+        uint32_t last = words[id * 3 + 3];
+        size_t previous = 0;
+        if (first > last || last > breakCount || words[id * 3 + 2] <= last - first) return false;
+        for (uint32_t i = first; i < last; i++) {
+            /* Lines follow each other within the text. */
+            if (PD_TEXT_BREAK_END(decoded[i]) < previous || PD_TEXT_BREAK_NEXT(decoded[i]) > words[id * 3 + 1]) {
+                return false;
+            }
+            previous = PD_TEXT_BREAK_NEXT(decoded[i]);
+        }
+    }
+    breaks->breaks = decoded;
+    return true;
+}
+
+bool pdText_LoadBreaks(PDTextBreaks *breaks, const char *path, const char *language, const char **err) {
+    PlaydateAPI *pd = pd_getPd();
+    reset(breaks);
+    SDFile *file = pd->file->open(path, kFileRead | kFileReadData);
+    if (file == NULL) {
+        *err = pd->file->geterr();
+        return false;
+    }
+
+    uint8_t header[PD_TEXT_BREAKS_HEADER_SIZE];
+    uint32_t offset = 0;
+    uint32_t size = 0;
+    *err = NULL;
+    if (pd->file->read(file, header, sizeof(header)) != (int) sizeof(header)
+        || memcmp(header, PD_TEXT_BREAKS_MAGIC, 4) != 0) {
+        *err = "not a break table";
+    } else if (pdText_GetU16(header + 4) != PD_TEXT_BREAKS_VERSION) {
+        *err = "unsupported break table version";
+    } else if (!pdText_FindLanguageSection(file, pdText_GetU16(header + 6), language, &offset, &size)) {
+        *err = "language not found";
+    }
+    uint32_t count = pdText_GetU32(header + 8);
+    if (*err == NULL && (count >= UINT32_MAX / PD_TEXT_BREAKS_ENTRY_SIZE || size % 4 != 0
+                         || size < (count + 1) * PD_TEXT_BREAKS_ENTRY_SIZE)) {
+        *err = "malformed break table";
+    }
+    if (*err == NULL) {
+        breaks->entries = pd_Malloc(size);
+        if (breaks->entries == NULL) {
+            *err = "out of memory";
+        } else if (pd->file->seek(file, (int) offset, SEEK_SET) != 0
+                   || pd->file->read(file, breaks->entries, size) != (int) size) {
+            *err = pd->file->geterr();
+        } else if (!decode_section(breaks, count, size)) {
+            *err = "malformed break table";
+        }
+    }
+    pd->file->close(file);
+
+    if (*err != NULL) {
+        pdText_FreeBreaks(breaks);
+        return false;
+    }
+    breaks->count = count;
+    breaks->maxWidth = (uint16_t) pdText_GetU16(header + 12);
+    breaks->maxLines = (uint16_t) pdText_GetU16(header + 14);
+    strncpy(breaks->language, language, sizeof(breaks->language) - 1);
+    breaks->language[sizeof(breaks->language) - 1] = '\0';
+    return true;
+}
+
+const uint32_t *pdText_GetBreaks(const PDTextBreaks *breaks, uint32_t id, size_t *count) {
+    if (id >= breaks->count) {
+        *count = 0;
+        return breaks->breaks;
+    }
+    *count = breaks->entries[id * 3 + 3] - breaks->entries[id * 3];
+    return breaks->breaks + breaks->entries[id * 3];
+}
+
+uint32_t pdText_WrapWithBreaks(
+    PDStrBuf *out,
+    const PDTextBreaks *breaks,
+    uint32_t id,
+    const char *text,
+    size_t length
+) {
+    if (id >= breaks->count || breaks->entries[id * 3 + 1] != length) {
+        pd_LogWarn("PDText: no line breaks for string %u of this length; is the break table up to date?",
+                   (unsigned) id);
+        pd_StrBufAppendN(out, text, length);
+        return 0;
+    }
+    size_t count;
+    const uint32_t *lineBreaks = pdText_GetBreaks(breaks, id, &count);
+    size_t copied = 0;
+    for (size_t i = 0; i < count; i++) {
+        pd_StrBufAppendN(out, text + copied, PD_TEXT_BREAK_END(lineBreaks[i]) - copied);
+        pd_StrBufAppendChar(out, '\n');
+        copied = PD_TEXT_BREAK_NEXT(lineBreaks[i]);
+    }
+    pd_StrBufAppendN(out, text + copied, length - copied);
+    /* Lines whose first word did not fit count as well, without a break. */
+    return breaks->entries[id * 3 + 2];
+}
+
+void pdText_FreeBreaks(PDTextBreaks *breaks) {
+    pd_Free(breaks->entries);
+    reset(breaks);
+}
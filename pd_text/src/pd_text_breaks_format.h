@@ -0,0 +1,37 @@
+/**
+ * @file pd_text_breaks_format.h
+ *
+ * @brief Binary format of the line break tables read by pdText_LoadBreaks.
+ *
+ * This header does not depend on the Playdate SDK,
+ * so that host-side tools can write break tables with it.
+ *
+ * @par Layout:
+ * All integers are little-endian.
+ * @li File header (#PD_TEXT_BREAKS_HEADER_SIZE bytes): magic "PDBK", u16 version, u16 language count,
+ *     u32 string count, u16 maximum width, u16 maximum number of lines the strings were wrapped for.
+ * @li Language directory (language count entries of #PD_TEXT_LANGUAGE_ENTRY_SIZE bytes):
+ *     language code (#PD_TEXT_LANGUAGE_CODE_SIZE bytes, NUL-padded), u32 offset of the section
+ *     of the language from the start of the file, u32 size of the section.
+ * @li One section per language: string count + 1 entries of #PD_TEXT_BREAKS_ENTRY_SIZE bytes
+ *     (u32 index of the first break of the string, u32 length in bytes of the string that was wrapped,
+ *     u32 number of lines as counted by the line breaker; the last entry holds the total number of breaks and zeros),
+ *     then the breaks, one u32 each.
+ *
+ * A break is the end of a line shifted left by #PD_TEXT_BREAKS_SKIP_BITS,
+ * or'ed with the number of bytes between the end of the line and the start of the next one (0 to 2).
+ * String IDs are the ones of the string table the breaks were computed from.
+ */
+
+#ifndef PD_TEXT_BREAKS_FORMAT_H
+#define PD_TEXT_BREAKS_FORMAT_H
+
+#include "pd_text_binary.h"
+
+#define PD_TEXT_BREAKS_MAGIC "PDBK"
+#define PD_TEXT_BREAKS_VERSION 1
+#define PD_TEXT_BREAKS_HEADER_SIZE 16
+#define PD_TEXT_BREAKS_ENTRY_SIZE 12
+#define PD_TEXT_BREAKS_SKIP_BITS 2
+
+#endif /* PD_TEXT_BREAKS_FORMAT_H */
@@ -0,0 +1,120 @@
+#include "pd_text.h"
+
+#include <pd_api.h>
+#include <pd_shorthand.h>
+#include <string.h>
+
+/* Digits of UINT32_MAX */
+#define COUNTER_MAX_DIGITS 10
+
+static void append(PDTextCounter *counter, const char *text, size_t length) {
+    size_t room = sizeof(counter->text) - counter->length;
+    if (length > room) {
+        length = room;
+        /* Never cut a UTF-8 character in half */
+        while (length > 0 && ((uint8_t) text[length] & 0xC0) == 0x80) {
+            length--;
+        }
+    }
+    memcpy(counter->text + counter->length, text, length);
+    counter->length += (uint8_t) length;
+}
+
+/* Writes the digits right-to-left, so that they never have to be reversed. */
+static void format(PDTextCounter *counter, int32_t value) {
+    char digits[COUNTER_MAX_DIGITS * 2 + 2];
+    char *cursor = digits + sizeof(digits);
+    uint32_t magnitude = value < 0 ? 0u - (uint32_t) value : (uint32_t) value;
+    uint32_t decimals = counter->decimals < COUNTER_MAX_DIGITS ? counter->decimals : COUNTER_MAX_DIGITS;
+    uint32_t minDigits = counter->minDigits < COUNTER_MAX_DIGITS ? counter->minDigits : COUNTER_MAX_DIGITS;
+    for (uint32_t i = 0; i < decimals; i++) {
+        *--cursor = (char) ('0' + magnitude % 10);
+        magnitude /= 10;
+    }
+    if (decimals > 0) {
+        *--cursor = '.';
+    }
+    uint32_t whole = 0;
+    do {
+        *--cursor = (char) ('0' + magnitude % 10);
+        magnitude /= 10;
+        whole++;
+    } while (magnitude > 0);
+    while (whole < minDigits) {
+        *--cursor = '0';
+        whole++;
+    }
+    if (value < 0) {
+        *--cursor = '-';
+    }
+
+    counter->length = 0;
+    if (counter->prefix != NULL) {
+        append(counter, counter->prefix, strlen(counter->prefix));
+    }
+    append(counter, cursor, (size_t) (digits + sizeof(digits) - cursor));
+    if (counter->suffix != NULL) {
+        append(counter, counter->suffix, strlen(counter->suffix));
+    }
+}
+
+static uint32_t count_characters(const char *text, size_t length) {
+    uint32_t count = 0;
+    for (size_t i = 0; i < length; i++) {
+        count += ((uint8_t) text[i] & 0xC0) != 0x80 ? 1 : 0;
+    }
+    return count;
+}
+
+void pdText_CounterInit(PDTextCounter *counter, const Font *font, int32_t x, int32_t y, PDTextAlignment alignment) {
+    counter->font = font;
+    counter->x = x;
+    counter->y = y;
+    counter->alignment = alignment;
+    counter->prefix = NULL;
+    counter->suffix = NULL;
+    counter->decimals = 0;
+    counter->minDigits = 0;
+    counter->background = kColorWhite;
+    counter->drawn = false;
+    counter->value = 0;
+    memset(&counter->bounds, 0, sizeof(counter->bounds));
+    counter->length = 0;
+}
+
+bool pdText_CounterUpdate(PDTextCounter *counter, int32_t value) {
+    if (counter->drawn && counter->value == value) return false;
+
+    PlaydateAPI *pd = pd_getPd();
+    if (counter->drawn && counter->background != kColorClear && counter->bounds.width > 0) {
+        pd->graphics->fillRect(
+            counter->bounds.x, counter->bounds.y, counter->bounds.width, counter->bounds.height, counter->background
+        );
+    }
+
+    format(counter, value);
+    /* Prefixes and suffixes may be UTF-8; the digits are ASCII either way. */
+    int width = pdText_GetTextWidthN(counter->font, kUTF8Encoding, counter->text, counter->length);
+    int32_t left = counter->x;
+    if (counter->alignment == kPDTextAlignCenter) {
+        left -= width / 2;
+    } else if (counter->alignment == kPDTextAlignRight) {
+        left -= width;
+    }
+    pd->graphics->setFont(counter->font->font);
+    pd->graphics->drawText(
+        counter->text, count_characters(counter->text, counter->length), kUTF8Encoding, left, counter->y
+    );
+
+    counter->bounds.x = left;
+    counter->bounds.y = counter->y;
+    counter->bounds.width = width;
+    counter->bounds.height = counter->font->height;
+    counter->value = value;
+    counter->drawn = true;
+    return true;
+}
+
+void pdText_CounterInvalidate(PDTextCounter *counter) {
+    counter->drawn = false;
+}
@@ -0,0 +1,196 @@
+#include "pd_text.h"
+
+#include <pd_api.h>
+#include <pd_shorthand.h>
+#include <stdarg.h>
+#include <string.h>
+
+#define DRAW_QUEUE_MIN_CAPACITY 16
+
+static uint32_t count_characters(PDStringEncoding encoding, const char *text, size_t length) {
+    if (encoding == k16BitLEEncoding) return (uint32_t) (length / 2);
+    if (encoding != kUTF8Encoding) return (uint32_t) length;
+    uint32_t count = 0;
+    for (size_t i = 0; i < length; i++) {
+        count += ((uint8_t) text[i] & 0xC0) != 0x80 ? 1 : 0;
+    }
+    return count;
+}
+
+static bool is_off_screen(
+    const Font *font,
+    PDStringEncoding encoding,
+    int32_t x,
+    int32_t y,
+    const char *text,
+    size_t length
+) {
+    if (x >= LCD_WIDTH || y >= LCD_HEIGHT) return true;
+    int32_t lines = 1;
+    if (encoding != k16BitLEEncoding) {
+        const char *end = text + length;
+        for (const char *cursor = text; (cursor = memchr(cursor, '\n', (size_t) (end - cursor))) != NULL; cursor++) {
+            lines++;
+        }
+    }
+    if (y + lines * font->height <= 0) return true;
+    /* Only text that starts left of the screen needs measuring. */
+    return x < 0 && x + pdText_GetTextWidthN(font, encoding, text, length) <= 0;
+}
+
+static bool add_entry(PDTextDrawQueue *queue, const Font *font, PDStringEncoding encoding, int32_t x, int32_t y) {
+    if (queue->count == queue->capacity) {
+        uint32_t capacity = queue->capacity * 2;
+        if (capacity < DRAW_QUEUE_MIN_CAPACITY) {
+            capacity = DRAW_QUEUE_MIN_CAPACITY;
+        }
+        PDTextDrawEntry *entries = pd_Realloc(queue->owned ? queue->entries : NULL, sizeof(PDTextDrawEntry) * capacity);
+        if (entries == NULL) return false;
+        if (!queue->owned && queue->count > 0) {
+            memcpy(entries, queue->entries, sizeof(PDTextDrawEntry) * queue->count);
+        }
+        queue->entries = entries;
+        queue->capacity = capacity;
+        queue->owned = true;
+    }
+
+    PDTextDrawEntry *entry = &queue->entries[queue->count++];
+    entry->font = font->font;
+    entry->x = x;
+    entry->y = y;
+    entry->encoding = encoding;
+    return true;
+}
+
+/* Turns the text appended to the queue since @c offset into an entry, or takes it back. */
+static bool finish_entry(
+    PDTextDrawQueue *queue,
+    const Font *font,
+    PDStringEncoding encoding,
+    int32_t x,
+    int32_t y,
+    size_t offset
+) {
+    if (!add_entry(queue, font, encoding, x, y)) {
+        pd_StrBufTruncate(&queue->text, offset);
+        return false;
+    }
+    PDTextDrawEntry *entry = &queue->entries[queue->count - 1];
+    entry->offset = (uint32_t) offset;
+    entry->characters = count_characters(encoding, pd_StrBufCStr(&queue->text) + offset, queue->text.length - offset);
+    return true;
+}
+
+void pdText_DrawQueueInit(
+    PDTextDrawQueue *queue,
+    PDTextDrawEntry *entry_storage,
+    uint32_t entry_capacity,
+    char *text_storage,
+    size_t text_capacity
+) {
+    queue->storage = entry_storage;
+    queue->storageCapacity = entry_storage == NULL ? 0 : entry_capacity;
+    queue->entries = queue->storage;
+    queue->capacity = queue->storageCapacity;
+    queue->count = 0;
+    queue->owned = false;
+    queue->culled = 0;
+    pd_StrBufInit(&queue->text, text_storage, text_capacity);
+}
+
+bool pdText_DrawQueueAdd(
+    PDTextDrawQueue *queue,
+    const Font *font,
+    PDStringEncoding encoding,
+    int32_t x,
+    int32_t y,
+    const char *text,
+    size_t length
+) {
+    if (font == NULL) {
+        pd_Error("PDText Error: NULL font passed.");
+        return false;
+    }
+    /* Culling first saves copying text that is not going to be drawn. */
+    if (is_off_screen(font, encoding, x, y, text, length)) {
+        queue->culled++;
+        return true;
+    }
+    size_t offset = queue->text.length;
+    if (!pd_StrBufAppendN(&queue->text, text, length)) {
+        pd_StrBufTruncate(&queue->text, offset);
+        return false;
+    }
+    return finish_entry(queue, font, encoding, x, y, offset);
+}
+
+bool pdText_DrawQueueAddF(
+    PDTextDrawQueue *queue,
+    const Font *font,
+    PDStringEncoding encoding,
+    int32_t x,
+    int32_t y,
+    const char *fmt,
+    ...
+) {
+    if (font == NULL) {
+        pd_Error("PDText Error: NULL font passed.");
+        return false;
+    }
+    size_t offset = queue->text.length;
+    va_list v_list;
+    va_start(v_list, fmt);
+    bool appended = pd_StrBufAppendFV(&queue->text, fmt, v_list);
+    va_end(v_list);
+    const char *text = pd_StrBufCStr(&queue->text) + offset;
+    if (!appended || is_off_screen(font, encoding, x, y, text, queue->text.length - offset)) {
+        queue->culled += appended ? 1 : 0;
+        pd_StrBufTruncate(&queue->text, offset);
+        return appended;
+    }
+    return finish_entry(queue, font, encoding, x, y, offset);
+}
+
+uint32_t pdText_DrawQueueFlush(PDTextDrawQueue *queue) {
+    PlaydateAPI *pd = pd_getPd();
+    const char *text = pd_StrBufCStr(&queue->text);
+    uint32_t first = 0;
+    while (first < queue->count) {
+        /* Draw every entry in the font of the first one left, and find the first one in another font. */
+        LCDFont *font = queue->entries[first].font;
+        uint32_t next = queue->count;
+        pd->graphics->setFont(font);
+        for (uint32_t i = first; i < queue->count; i++) {
+            PDTextDrawEntry *entry = &queue->entries[i];
+            if (entry->font != font) {
+                if (entry->font != NULL && next == queue->count) {
+                    next = i;
+                }
+                continue;
+            }
+            pd->graphics->drawText(text + entry->offset, entry->characters, entry->encoding, entry->x, entry->y);
+            entry->font = NULL;
+        }
+        first = next;
+    }
+
+    uint32_t drawn = queue->count;
+    pdText_DrawQueueClear(queue);
+    return drawn;
+}
+
+void pdText_DrawQueueClear(PDTextDrawQueue *queue) {
+    queue->count = 0;
+    queue->culled = 0;
+    pd_StrBufClear(&queue->text);
+}
+
+void pdText_DrawQueueRelease(PDTextDrawQueue *queue) {
+    if (queue->owned) {
+        pd_Free(queue->entries);
+    }
+    pd_StrBufRelease(&queue->text);
+    pdText_DrawQueueInit(
+        queue, queue->storage, queue->storageCapacity, queue->text.storage, queue->text.storageCapacity
+    );
+}
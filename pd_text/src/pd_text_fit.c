@@ -0,0 +1,194 @@
+#include "pd_text.h"
+
+#include <pd_api.h>
+#include <pd_shorthand.h>
+#include <string.h>
+
+/* Text shorter than this is measured with its ellipsis without an extra heap block when the SDK measures it. */
+#define FIT_STORAGE_SIZE 128
+
+static size_t character_length(PDStringEncoding encoding, const char *text, size_t left) {
+    size_t length = 1;
+    if (encoding == k16BitLEEncoding) {
+        length = 2;
+    } else if (encoding == kUTF8Encoding) {
+        uint8_t lead = (uint8_t) text[0];
+        length = lead >= 0xF0 ? 4 : lead >= 0xE0 ? 3 : lead >= 0xC0 ? 2 : 1;
+    }
+    return length < left ? length : left;
+}
+
+/* Start of the character that @c position is in. */
+static size_t character_start(PDStringEncoding encoding, const char *text, size_t position) {
+    if (encoding == k16BitLEEncoding) return position & ~(size_t) 1;
+    if (encoding != kUTF8Encoding) return position;
+    while (position > 0 && ((uint8_t) text[position] & 0xC0) == 0x80) {
+        position--;
+    }
+    return position;
+}
+
+/* Width of the first @c prefix bytes of the text followed by the suffix, measured by the SDK in one piece. */
+static int uncached_width(
+    const Font *font,
+    PDStringEncoding encoding,
+    const char *text,
+    size_t prefix,
+    const char *suffix,
+    size_t suffix_length,
+    PDStrBuf *scratch
+) {
+    if (suffix_length == 0) return pdText_GetTextWidthN(font, encoding, text, prefix);
+    pd_StrBufClear(scratch);
+    if (!pd_StrBufAppendN(scratch, text, prefix) || !pd_StrBufAppendN(scratch, suffix, suffix_length)) {
+        /* Out of memory: measure the two apart, leaving out kerning and tracking between them. */
+        return pdText_GetTextWidthN(font, encoding, text, prefix)
+               + pdText_GetTextWidthN(font, encoding, suffix, suffix_length);
+    }
+    return pdText_GetTextWidthN(font, encoding, pd_StrBufCStr(scratch), scratch->length);
+}
+
+/*
+ * Binary search over character boundaries for the longest prefix that fits along with the suffix,
+ * for text the glyph cache cannot measure. Takes O(log n) calls to the SDK.
+ */
+static size_t search_prefix(
+    const Font *font,
+    PDStringEncoding encoding,
+    const char *text,
+    size_t length,
+    int max_width,
+    const char *suffix,
+    size_t suffix_length
+) {
+    char storage[FIT_STORAGE_SIZE];
+    PDStrBuf scratch;
+    pd_StrBufInit(&scratch, storage, sizeof(storage));
+    size_t result = length;
+    if (uncached_width(font, encoding, text, length, suffix, suffix_length, &scratch) > max_width) {
+        /* lo always fits (or is 0), hi never does. */
+        size_t lo = 0;
+        size_t hi = length;
+        for (;;) {
+            size_t next = lo + character_length(encoding, text + lo, length - lo);
+            if (next >= hi) break;
+            size_t mid = character_start(encoding, text, lo + (hi - lo) / 2);
+            if (mid <= lo) {
+                mid = next;
+            }
+            if (uncached_width(font, encoding, text, mid, suffix, suffix_length, &scratch) <= max_width) {
+                lo = mid;
+            } else {
+                hi = mid;
+            }
+        }
+        result = lo;
+    }
+    pd_StrBufRelease(&scratch);
+    return result;
+}
+
+/*
+ * Longest prefix, at a character boundary, that is at most @c max_width wide when followed by the suffix.
+ * With a glyph cache, the width of each prefix is the running width of one pass over the text,
+ * which stops at the first prefix that is too wide.
+ */
+static size_t fit_prefix(
+    const Font *font,
+    PDStringEncoding encoding,
+    const char *text,
+    size_t length,
+    int max_width,
+    const char *suffix,
+    size_t suffix_length
+) {
+    PDTextMeasure measure;
+    pdText_MeasureBegin(&measure, font, encoding);
+    size_t fit = 0;
+    while (fit < length) {
+        size_t next = fit + character_length(encoding, text + fit, length - fit);
+        if (!pdText_MeasureAppend(&measure, text + fit, next - fit)) {
+            return search_prefix(font, encoding, text, length, max_width, suffix, suffix_length);
+        }
+        int width = pdText_MeasureGetWidth(&measure);
+        if (suffix_length > 0) {
+            PDTextMeasure withSuffix = measure;
+            if (!pdText_MeasureAppend(&withSuffix, suffix, suffix_length)) {
+                return search_prefix(font, encoding, text, length, max_width, suffix, suffix_length);
+            }
+            width = pdText_MeasureGetWidth(&withSuffix);
+        }
+        if (width > max_width) break;
+        fit = next;
+    }
+    return fit;
+}
+
+size_t pdText_FitLength(const Font *font, PDStringEncoding encoding, const char *text, size_t length, int max_width) {
+    if (font == NULL || font->font == NULL) {
+        pd_Error("PDText Error: NULL font passed.");
+        return 0;
+    }
+    return fit_prefix(font, encoding, text, length, max_width, NULL, 0);
+}
+
+size_t pdText_Truncate(
+    const Font *font,
+    PDStringEncoding encoding,
+    const char *text,
+    size_t length,
+    int max_width,
+    const char *ellipsis,
+    PDStrBuf *out
+) {
+    if (font == NULL || font->font == NULL) {
+        pd_Error("PDText Error: NULL font passed.");
+        return 0;
+    }
+    size_t fit = fit_prefix(font, encoding, text, length, max_width, NULL, 0);
+    size_t ellipsisLength = ellipsis != NULL ? strlen(ellipsis) : 0;
+    if (fit < length && ellipsisLength > 0) {
+        fit = fit_prefix(font, encoding, text, fit, max_width, ellipsis, ellipsisLength);
+        /* "Hello…" rather than "Hello …" */
+        while (encoding != k16BitLEEncoding && fit > 0 && text[fit - 1] == ' ') {
+            fit--;
+        }
+    }
+    pd_StrBufAppendN(out, text, fit);
+    if (fit < length && ellipsisLength > 0) {
+        pd_StrBufAppendN(out, ellipsis, ellipsisLength);
+    }
+    return fit;
+}
+
+const Font *pdText_FitFont(
+    const Font *const *fonts,
+    size_t font_count,
+    PDStringEncoding encoding,
+    const char *text,
+    size_t length,
+    int max_width,
+    int max_height
+) {
+    for (size_t i = 0; i < font_count; i++) {
+        const Font *font = fonts[i];
+        if (font == NULL || font->font == NULL) continue;
+        bool fits = true;
+        int height = 0;
+        size_t start = 0;
+        for (;;) {
+            /* 16-bit text is never split. */
+            const char *newline = encoding != k16BitLEEncoding ? memchr(text + start, '\n', length - start) : NULL;
+            size_t line = newline == NULL ? length - start : (size_t) (newline - (text + start));
+            height += font->height;
+            if (height > max_height || pdText_GetTextWidthN(font, encoding, text + start, line) > max_width) {
+                fits = false;
+                break;
+            }
+            start += line + 1;
+            if (start > length) break;
+        }
+        if (fits) return font;
+    }
+    return NULL;
+}
@@ -0,0 +1,167 @@
+#include "pd_text.h"
+
+#include <pd_api.h>
+#include <pd_shorthand.h>
+#include <string.h>
+
+#define FONT_REGISTRY_MIN_CAPACITY 8
+
+typedef struct SharedFontTag {
+    /* First, so that a Font handed out is also a pointer to its entry */
+    Font font;
+    uint32_t refCount;
+    uint8_t heightMargin;
+    /* Loading failed during preloading; left for pdText_AcquireFont to retry */
+    bool failed;
+    char path[];
+} SharedFont;
+
+/* In order of creation, so that fonts are preloaded in the order they were asked for */
+static SharedFont **s_fonts;
+static uint32_t s_font_count;
+static uint32_t s_font_capacity;
+
+static SharedFont *find(const char *path, uint8_t height_margin) {
+    for (uint32_t i = 0; i < s_font_count; i++) {
+        if (s_fonts[i]->heightMargin == height_margin && strcmp(s_fonts[i]->path, path) == 0) {
+            return s_fonts[i];
+        }
+    }
+    return NULL;
+}
+
+static SharedFont *find_or_add(const char *path, uint8_t height_margin) {
+    SharedFont *shared = find(path, height_margin);
+    if (shared != NULL) return shared;
+
+    if (s_font_count == s_font_capacity) {
+        uint32_t capacity = s_font_capacity * 2;
+        if (capacity < FONT_REGISTRY_MIN_CAPACITY) {
+            capacity = FONT_REGISTRY_MIN_CAPACITY;
+        }
+        SharedFont **fonts = pd_Realloc(s_fonts, sizeof(SharedFont *) * capacity);
+        if (fonts == NULL) return NULL;
+        s_fonts = fonts;
+        s_font_capacity = capacity;
+    }
+    size_t length = strlen(path);
+    shared = pd_Malloc(sizeof(SharedFont) + length + 1);
+    if (shared == NULL) return NULL;
+    memset(&shared->font, 0, sizeof(shared->font));
+    shared->refCount = 0;
+    shared->heightMargin = height_margin;
+    shared->failed = false;
+    memcpy(shared->path, path, length + 1);
+    s_fonts[s_font_count++] = shared;
+    return shared;
+}
+
+static void remove_at(uint32_t index) {
+    SharedFont *shared = s_fonts[index];
+    pdText_FreeFont(&shared->font);
+    pd_Free(shared);
+    memmove(&s_fonts[index], &s_fonts[index + 1], sizeof(SharedFont *) * (s_font_count - index - 1));
+    s_font_count--;
+}
+
+static void release(SharedFont *shared) {
+    if (shared->refCount == 0) {
+        pd_LogWarn("PDText: font %s released more often than it was acquired.", shared->path);
+        return;
+    }
+    shared->refCount--;
+}
+
+Font *pdText_AcquireFont(const char *font_path, uint8_t height_margin, const char **err) {
+    SharedFont *shared = find_or_add(font_path, height_margin);
+    if (shared == NULL) {
+        *err = "out of memory";
+        return NULL;
+    }
+    if (shared->font.font == NULL) {
+        if (!pdText_LoadFont(shared->path, height_margin, &shared->font, err) || shared->font.font == NULL) return NULL;
+        shared->failed = false;
+    } else {
+        *err = NULL;
+    }
+    shared->refCount++;
+    return &shared->font;
+}
+
+void pdText_ReleaseFont(const Font *font) {
+    for (uint32_t i = 0; i < s_font_count; i++) {
+        if (&s_fonts[i]->font == font) {
+            release(s_fonts[i]);
+            return;
+        }
+    }
+    pd_LogWarn("PDText: tried to release a font that does not come from pdText_AcquireFont.");
+}
+
+void pdText_PreloadFonts(const PDTextFontSpec *fonts, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        SharedFont *shared = find_or_add(fonts[i].path, fonts[i].heightMargin);
+        if (shared == NULL) {
+            pd_LogError("PDText: out of memory while preloading %s.", fonts[i].path);
+            continue;
+        }
+        shared->refCount++;
+    }
+}
+
+uint32_t pdText_UpdateFontPreload(uint32_t max_loads) {
+    uint32_t pending = 0;
+    for (uint32_t i = 0; i < s_font_count; i++) {
+        SharedFont *shared = s_fonts[i];
+        if (shared->font.font != NULL || shared->failed || shared->refCount == 0) continue;
+        if (max_loads == 0) {
+            pending++;
+            continue;
+        }
+        max_loads--;
+        const char *err = NULL;
+        if (!pdText_LoadFont(shared->path, shared->heightMargin, &shared->font, &err) || shared->font.font == NULL) {
+            pd_LogError("PDText: could not preload font %s: %s", shared->path, err != NULL ? err : "");
+            shared->failed = true;
+        }
+    }
+    return pending;
+}
+
+void pdText_ReleaseFonts(const PDTextFontSpec *fonts, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        SharedFont *shared = find(fonts[i].path, fonts[i].heightMargin);
+        if (shared != NULL) {
+            release(shared);
+        }
+    }
+}
+
+uint32_t pdText_TrimFonts(void) {
+    uint32_t freed = 0;
+    uint32_t i = 0;
+    while (i < s_font_count) {
+        if (s_fonts[i]->refCount == 0) {
+            remove_at(i);
+            freed++;
+        } else {
+            i++;
+        }
+    }
+    return freed;
+}
+
+void pdText_ClearFontRegistry(void) {
+    while (s_font_count > 0) {
+        if (s_fonts[s_font_count - 1]->refCount > 0) {
+            pd_LogWarn(
+                "PDText: font %s still has %u references.", s_fonts[s_font_count - 1]->path,
+                (unsigned) s_fonts[s_font_count - 1]->refCount
+            );
+        }
+        remove_at(s_font_count - 1);
+    }
+    pd_Free(s_fonts);
+    s_fonts = NULL;
+    s_font_capacity = 0;
+}
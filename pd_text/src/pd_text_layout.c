@@ -0,0 +1,185 @@
+#include "pd_text.h"
+
+#include <pd_api.h>
+#include <pd_shorthand.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <string.h>
+
+#define LAYOUT_MIN_LINE_CAPACITY 8
+/* Formatted text shorter than this is laid out without an extra heap block. */
+#define LAYOUT_FORMAT_STORAGE_SIZE 128
+
+static bool add_line(PDTextLayout *layout, size_t start, size_t end, const PDTextLineBreakerState *breakState) {
+    if (layout->lineCount == layout->lineCapacity) {
+        uint32_t capacity = layout->lineCapacity * 2;
+        if (capacity < LAYOUT_MIN_LINE_CAPACITY) {
+            capacity = LAYOUT_MIN_LINE_CAPACITY;
+        }
+        PDTextLine *lines = pd_Realloc(layout->lines, sizeof(PDTextLine) * capacity);
+        if (lines == NULL) return false;
+        layout->lines = lines;
+        layout->lineCapacity = capacity;
+    }
+
+    const char *text = pd_StrBufCStr(&layout->text);
+    PDTextLine *line = &layout->lines[layout->lineCount++];
+    line->start = (uint32_t) start;
+    line->length = (uint32_t) (end - start);
+    line->characters = line->length;
+    if (layout->encoding == kUTF8Encoding) {
+        line->characters = 0;
+        for (size_t i = start; i < end; i++) {
+            line->characters += ((uint8_t) text[i] & 0xC0) != 0x80 ? 1 : 0;
+        }
+    } else if (layout->encoding == k16BitLEEncoding) {
+        line->characters = line->length / 2;
+    }
+    int width = pdText_GetTextWidthN(layout->font, layout->encoding, text + start, end - start);
+    line->width = (uint16_t) (width < 0 ? 0 : width > UINT16_MAX ? UINT16_MAX : width);
+    if (breakState != NULL) {
+        line->breakState = *breakState;
+    } else {
+        memset(&line->breakState, 0, sizeof(line->breakState));
+    }
+    return true;
+}
+
+/* Lays the text out again, keeping the lines that only depend on its first unchanged bytes. */
+static bool layout_from(PDTextLayout *layout, size_t unchanged) {
+    const char *text = pd_StrBufCStr(&layout->text);
+    size_t length = layout->text.length;
+    PDTextLineBreaker breaker;
+    pdText_LineBreakerInit(
+        &breaker, text, length, layout->font, UINT32_MAX, layout->maxWidth, layout->encoding,
+        kPDTextLineBreakUnicode | kPDTextLineBreakNewlines | kPDTextLineBreakWrapLast
+    );
+
+    /* The break after a line can be reused if the breaker had not read past the change when it got there. */
+    uint32_t kept = layout->lineCount > 0 ? layout->lineCount - 1 : 0;
+    while (kept > 0) {
+        const PDTextLineBreakerState *state = &layout->lines[kept - 1].breakState;
+        if (state->hasCurrent && state->scanPosition <= unchanged) break;
+        kept--;
+    }
+    size_t lineStart = 0;
+    if (kept > 0) {
+        pdText_LineBreakerResume(&breaker, text, length, &layout->lines[kept - 1].breakState);
+        lineStart = breaker.state.lineStart;
+    }
+    layout->lineCount = kept;
+    layout->truncated = false;
+
+    bool result = true;
+    size_t lineEnd;
+    size_t nextLineStart;
+    while (pdText_LineBreakerNext(&breaker, &lineEnd, &nextLineStart)) {
+        if (layout->lineCount == layout->maxLines) {
+            layout->truncated = true;
+            break;
+        }
+        if (!add_line(layout, lineStart, lineEnd, &breaker.state)) {
+            result = false;
+            break;
+        }
+        lineStart = nextLineStart;
+    }
+    if (result && !layout->truncated && length > 0) {
+        if (layout->lineCount == layout->maxLines) {
+            layout->truncated = true;
+        } else {
+            result = add_line(layout, lineStart, length, NULL);
+        }
+    }
+
+    layout->width = 0;
+    for (uint32_t i = 0; i < layout->lineCount; i++) {
+        if (layout->lines[i].width > layout->width) {
+            layout->width = layout->lines[i].width;
+        }
+    }
+    layout->height = layout->lineCount * layout->font->height;
+    return result;
+}
+
+void pdText_LayoutInit(
+    PDTextLayout *layout,
+    const Font *font,
+    PDStringEncoding encoding,
+    uint16_t max_width,
+    uint32_t max_lines,
+    PDTextAlignment alignment
+) {
+    layout->font = font;
+    layout->encoding = encoding;
+    layout->alignment = alignment;
+    layout->maxWidth = max_width;
+    layout->maxLines = max_lines;
+    pd_StrBufInit(&layout->text, NULL, 0);
+    layout->lines = NULL;
+    layout->lineCount = 0;
+    layout->lineCapacity = 0;
+    layout->width = 0;
+    layout->height = 0;
+    layout->truncated = false;
+}
+
+bool pdText_LayoutSetText(PDTextLayout *layout, const char *text, size_t length) {
+    const char *current = pd_StrBufCStr(&layout->text);
+    size_t unchanged = 0;
+    size_t common = length < layout->text.length ? length : layout->text.length;
+    while (unchanged < common && current[unchanged] == text[unchanged]) {
+        unchanged++;
+    }
+    if (unchanged == length && unchanged == layout->text.length) return true;
+
+    pd_StrBufTruncate(&layout->text, unchanged);
+    bool appended = pd_StrBufAppendN(&layout->text, text + unchanged, length - unchanged);
+    return layout_from(layout, unchanged) && appended;
+}
+
+bool pdText_LayoutSetTextF(PDTextLayout *layout, const char *fmt, ...) {
+    char storage[LAYOUT_FORMAT_STORAGE_SIZE];
+    PDStrBuf sb;
+    pd_StrBufInit(&sb, storage, sizeof(storage));
+    va_list v_list;
+    va_start(v_list, fmt);
+    bool formatted = pd_StrBufAppendFV(&sb, fmt, v_list);
+    va_end(v_list);
+    bool result = pdText_LayoutSetText(layout, pd_StrBufCStr(&sb), sb.length) && formatted;
+    pd_StrBufRelease(&sb);
+    return result;
+}
+
+bool pdText_LayoutAppend(PDTextLayout *layout, const char *text, size_t length) {
+    size_t unchanged = layout->text.length;
+    bool appended = pd_StrBufAppendN(&layout->text, text, length);
+    return layout_from(layout, unchanged) && appended;
+}
+
+void pdText_LayoutDraw(const PDTextLayout *layout, int32_t x, int32_t y) {
+    if (layout->lineCount == 0) return;
+    PlaydateAPI *pd = pd_getPd();
+    const char *text = pd_StrBufCStr(&layout->text);
+    pd->graphics->setFont(layout->font->font);
+    for (uint32_t i = 0; i < layout->lineCount; i++) {
+        const PDTextLine *line = &layout->lines[i];
+        int32_t offset = 0;
+        if (layout->alignment == kPDTextAlignCenter) {
+            offset = ((int32_t) layout->maxWidth - line->width) / 2;
+        } else if (layout->alignment == kPDTextAlignRight) {
+            offset = (int32_t) layout->maxWidth - line->width;
+        }
+        pd->graphics->drawText(
+            text + line->start, line->characters, layout->encoding, x + offset, y + (int32_t) (i * layout->font->height)
+        );
+    }
+}
+
+void pdText_LayoutRelease(PDTextLayout *layout) {
+    pd_StrBufRelease(&layout->text);
+    pd_Free(layout->lines);
+    pdText_LayoutInit(
+        layout, layout->font, layout->encoding, layout->maxWidth, layout->maxLines, layout->alignment
+    );
+}
@@ -0,0 +1,419 @@
+#include "pd_text.h"
+
+#include <pd_api.h>
+#include <pd_shorthand.h>
+#include <stdint.h>
+#include <string.h>
+
+/*
+ * Line break classes, a small subset of UAX #14.
+ * Classes the rules below treat alike are merged: NS and EX into CL, HY into BA, GL and control characters into XX.
+ */
+#define LB_AL 0 /* Letters and anything not listed: no break inside a word */
+#define LB_ID 1 /* Ideographs, kana, Hangul: break before and after */
+#define LB_CL 2 /* Closing punctuation and small kana: never at the start of a line (kinsoku) */
+#define LB_OP 3 /* Opening punctuation: never at the end of a line (kinsoku) */
+#define LB_BA 4 /* Hyphens: break after */
+#define LB_NU 5 /* Digits: no break after a hyphen */
+#define LB_SP 6 /* Space: the line breaks instead of the space */
+#define LB_XX 7 /* Line feeds, controls and non-breaking characters: never break next to them */
+#define LB_NONE 8 /* Start of text */
+#define LB_CLW 9 /* LB_CL of CJK text: may also come right before an opening mark, as in 」「 */
+#define LB_OPW 10 /* LB_OP of CJK text: may also come right after a closing mark */
+
+/* Each entry starts a range that lasts until the next entry: the codepoint in the upper bits, the class below. */
+#define RANGE(first, lineBreakClass) (((uint32_t) (first) << 4) | (lineBreakClass))
+
+static const uint8_t s_ascii_classes[128] = {
+    /* 0x00 - 0x1F */
+    LB_XX, LB_XX, LB_XX, LB_XX, LB_XX, LB_XX, LB_XX, LB_XX, LB_XX, LB_XX, LB_XX, LB_XX, LB_XX, LB_XX, LB_XX, LB_XX,
+    LB_XX, LB_XX, LB_XX, LB_XX, LB_XX, LB_XX, LB_XX, LB_XX, LB_XX, LB_XX, LB_XX, LB_XX, LB_XX, LB_XX, LB_XX, LB_XX,
+    /*  ' '    '!'    '"'    '#'    '$'    '%'    '&'    '''    '('    ')'    '*'    '+'    ','    '-'    '.'    '/' */
+    LB_SP, LB_CL, LB_AL, LB_AL, LB_AL, LB_AL, LB_AL, LB_AL, LB_OP, LB_CL, LB_AL, LB_AL, LB_CL, LB_BA, LB_CL, LB_AL,
+    /*  '0' - '9'                                                           ':'    ';'    '<'    '='    '>'    '?' */
+    LB_NU, LB_NU, LB_NU, LB_NU, LB_NU, LB_NU, LB_NU, LB_NU, LB_NU, LB_NU, LB_CL, LB_CL, LB_AL, LB_AL, LB_AL, LB_CL,
+    /* '@', 'A' - 'O' */
+    LB_AL, LB_AL, LB_AL, LB_AL, LB_AL, LB_AL, LB_AL, LB_AL, LB_AL, LB_AL, LB_AL, LB_AL, LB_AL, LB_AL, LB_AL, LB_AL,
+    /* 'P' - 'Z'                                                     '['    '\'    ']'    '^'    '_' */
+    LB_AL, LB_AL, LB_AL, LB_AL, LB_AL, LB_AL, LB_AL, LB_AL, LB_AL, LB_AL, LB_AL, LB_OP, LB_AL, LB_CL, LB_AL, LB_AL,
+    /* '`', 'a' - 'o' */
+    LB_AL, LB_AL, LB_AL, LB_AL, LB_AL, LB_AL, LB_AL, LB_AL, LB_AL, LB_AL, LB_AL, LB_AL, LB_AL, LB_AL, LB_AL, LB_AL,
+    /* 'p' - 'z'                                                     '{'    '|'    '}'    '~'    DEL */
+    LB_AL, LB_AL, LB_AL, LB_AL, LB_AL, LB_AL, LB_AL, LB_AL, LB_AL, LB_AL, LB_AL, LB_OP, LB_AL, LB_CL, LB_AL, LB_XX,
+};
+
+/* Sorted by codepoint; everything from U+0080 on. */
+static const uint32_t s_ranges[] = {
+    RANGE(0x0080, LB_XX), RANGE(0x00A0, LB_XX), RANGE(0x00A1, LB_AL), RANGE(0x00AD, LB_BA), RANGE(0x00AE, LB_AL),
+    /* General punctuation */
+    RANGE(0x2010, LB_BA), RANGE(0x2011, LB_XX), RANGE(0x2012, LB_BA), RANGE(0x2015, LB_AL), RANGE(0x2018, LB_OP),
+    RANGE(0x2019, LB_CL), RANGE(0x201A, LB_AL), RANGE(0x201C, LB_OP), RANGE(0x201D, LB_CL), RANGE(0x201E, LB_AL),
+    RANGE(0x2024, LB_CL), RANGE(0x2027, LB_AL), RANGE(0x203C, LB_CL), RANGE(0x203E, LB_AL), RANGE(0x2047, LB_CL),
+    RANGE(0x204A, LB_AL), RANGE(0x2060, LB_XX), RANGE(0x2061, LB_AL),
+    /* CJK radicals, symbols and punctuation */
+    RANGE(0x2E80, LB_ID), RANGE(0x3000, LB_BA), RANGE(0x3001, LB_CLW), RANGE(0x3003, LB_ID), RANGE(0x3005, LB_CLW),
+    RANGE(0x3006, LB_ID), RANGE(0x3008, LB_OPW), RANGE(0x3009, LB_CLW), RANGE(0x300A, LB_OPW), RANGE(0x300B, LB_CLW),
+    RANGE(0x300C, LB_OPW), RANGE(0x300D, LB_CLW), RANGE(0x300E, LB_OPW), RANGE(0x300F, LB_CLW), RANGE(0x3010, LB_OPW),
+    RANGE(0x3011, LB_CLW), RANGE(0x3012, LB_ID), RANGE(0x3014, LB_OPW), RANGE(0x3015, LB_CLW), RANGE(0x3016, LB_OPW),
+    RANGE(0x3017, LB_CLW), RANGE(0x3018, LB_OPW), RANGE(0x3019, LB_CLW), RANGE(0x301A, LB_OPW), RANGE(0x301B, LB_CLW),
+    RANGE(0x301D, LB_OPW), RANGE(0x301E, LB_CLW), RANGE(0x3020, LB_ID), RANGE(0x303B, LB_CLW), RANGE(0x303C, LB_ID),
+    /* Hiragana; small kana and iteration marks are CL */
+    RANGE(0x3041, LB_CLW), RANGE(0x3042, LB_ID), RANGE(0x3043, LB_CLW), RANGE(0x3044, LB_ID), RANGE(0x3045, LB_CLW),
+    RANGE(0x3046, LB_ID), RANGE(0x3047, LB_CLW), RANGE(0x3048, LB_ID), RANGE(0x3049, LB_CLW), RANGE(0x304A, LB_ID),
+    RANGE(0x3063, LB_CLW), RANGE(0x3064, LB_ID), RANGE(0x3083, LB_CLW), RANGE(0x3084, LB_ID), RANGE(0x3085, LB_CLW),
+    RANGE(0x3086, LB_ID), RANGE(0x3087, LB_CLW), RANGE(0x3088, LB_ID), RANGE(0x308E, LB_CLW), RANGE(0x308F, LB_ID),
+    RANGE(0x3095, LB_CLW), RANGE(0x309F, LB_ID),
+    /* Katakana */
+    RANGE(0x30A0, LB_CLW), RANGE(0x30A2, LB_ID), RANGE(0x30A3, LB_CLW), RANGE(0x30A4, LB_ID), RANGE(0x30A5, LB_CLW),
+    RANGE(0x30A6, LB_ID), RANGE(0x30A7, LB_CLW), RANGE(0x30A8, LB_ID), RANGE(0x30A9, LB_CLW), RANGE(0x30AA, LB_ID),
+    RANGE(0x30C3, LB_CLW), RANGE(0x30C4, LB_ID), RANGE(0x30E3, LB_CLW), RANGE(0x30E4, LB_ID), RANGE(0x30E5, LB_CLW),
+    RANGE(0x30E6, LB_ID), RANGE(0x30E7, LB_CLW), RANGE(0x30E8, LB_ID), RANGE(0x30EE, LB_CLW), RANGE(0x30EF, LB_ID),
+    RANGE(0x30F5, LB_CLW), RANGE(0x30F7, LB_ID), RANGE(0x30FB, LB_CLW), RANGE(0x30FF, LB_ID),
+    /* Bopomofo, Kanbun, small katakana extension, CJK ideographs, Yi */
+    RANGE(0x31F0, LB_CLW), RANGE(0x3200, LB_ID), RANGE(0xA4D0, LB_AL),
+    /* Hangul syllables, CJK compatibility ideographs */
+    RANGE(0xAC00, LB_ID), RANGE(0xD7A4, LB_AL), RANGE(0xF900, LB_ID), RANGE(0xFB00, LB_AL),
+    /* Fullwidth and halfwidth forms */
+    RANGE(0xFEFF, LB_XX), RANGE(0xFF00, LB_AL), RANGE(0xFF01, LB_CLW), RANGE(0xFF02, LB_ID), RANGE(0xFF08, LB_OPW),
+    RANGE(0xFF09, LB_CLW), RANGE(0xFF0A, LB_ID), RANGE(0xFF0C, LB_CLW), RANGE(0xFF0D, LB_ID), RANGE(0xFF0E, LB_CLW),
+    RANGE(0xFF0F, LB_ID), RANGE(0xFF1A, LB_CLW), RANGE(0xFF1C, LB_ID), RANGE(0xFF1F, LB_CLW), RANGE(0xFF20, LB_ID),
+    RANGE(0xFF3B, LB_OPW), RANGE(0xFF3C, LB_ID), RANGE(0xFF3D, LB_CLW), RANGE(0xFF3E, LB_ID), RANGE(0xFF5B, LB_OPW),
+    RANGE(0xFF5C, LB_ID), RANGE(0xFF5D, LB_CLW), RANGE(0xFF5E, LB_ID), RANGE(0xFF5F, LB_OPW), RANGE(0xFF60, LB_CLW),
+    RANGE(0xFF62, LB_OPW), RANGE(0xFF63, LB_CLW), RANGE(0xFF66, LB_ID), RANGE(0xFF67, LB_CLW), RANGE(0xFF71, LB_ID),
+    RANGE(0xFF9E, LB_CLW), RANGE(0xFFA0, LB_AL),
+    /* Emoji and pictographs, supplementary ideographic planes */
+    RANGE(0x1F300, LB_ID), RANGE(0x1FB00, LB_AL), RANGE(0x20000, LB_ID), RANGE(0x3FFFE, LB_AL),
+};
+
+static uint8_t classify(uint32_t codepoint) {
+    if (codepoint < 0x80) return s_ascii_classes[codepoint];
+    /* Find the last range starting at or before the codepoint. */
+    uint32_t key = RANGE(codepoint, 0xF);
+    size_t low = 0;
+    size_t high = sizeof(s_ranges) / sizeof(s_ranges[0]);
+    while (low < high) {
+        size_t middle = (low + high) / 2;
+        if (s_ranges[middle] <= key) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low == 0 ? LB_AL : (uint8_t) (s_ranges[low - 1] & 0xF);
+}
+
+static bool is_closing(uint8_t lineBreakClass) {
+    return lineBreakClass == LB_CL || lineBreakClass == LB_CLW;
+}
+
+static bool is_opening(uint8_t lineBreakClass) {
+    return lineBreakClass == LB_OP || lineBreakClass == LB_OPW;
+}
+
+/* Whether the line may break between two adjacent characters, neither of them a space. */
+static bool can_break_between(uint8_t before, uint8_t after) {
+    if (before == LB_NONE || before == LB_XX || after == LB_XX) return false;
+    /* Kinsoku: nothing may start a line with a closing mark, or end one with an opening mark. */
+    if (is_closing(after) || is_opening(before)) return false;
+    if (before == LB_BA) return after != LB_NU;
+    /* Between CJK brackets only: UAX #14 keeps ASCII such as "a,(b" or "end.(x" together. */
+    if (is_closing(before) && is_opening(after)) return before == LB_CLW || after == LB_OPW;
+    return before == LB_ID || after == LB_ID;
+}
+
+/* Decodes one character; malformed bytes are taken one at a time, as letters. */
+static uint8_t next_class(const uint8_t *bytes, size_t length, size_t at, size_t *size) {
+    uint32_t codepoint = bytes[at];
+    *size = 1;
+    if (codepoint < 0x80) return s_ascii_classes[codepoint];
+    if (codepoint < 0xC0) return LB_AL;
+    size_t expected = codepoint >= 0xF0 ? 4 : codepoint >= 0xE0 ? 3 : 2;
+    if (expected > length - at) return LB_AL;
+    uint32_t value = codepoint & (0x7Fu >> expected);
+    for (size_t i = 1; i < expected; i++) {
+        if ((bytes[at + i] & 0xC0) != 0x80) return LB_AL;
+        value = (value << 6) | (bytes[at + i] & 0x3F);
+    }
+    *size = expected;
+    return classify(value);
+}
+
+/* Finds the next break opportunity, carrying on where the previous call stopped. */
+static bool scan_next(PDTextLineBreaker *breaker, PDTextBreakOpportunity *opportunity) {
+    PDTextLineBreakerState *state = &breaker->state;
+    opportunity->forced = false;
+    if (state->scanPosition > breaker->length) return false;
+    if (state->scanPosition == breaker->length && breaker->wrapLast) {
+        /* The end of the text, so that the last line gets measured as well. */
+        opportunity->end = breaker->length;
+        opportunity->next = breaker->length;
+        opportunity->forced = true;
+        state->scanPosition = breaker->length + 1;
+        return true;
+    }
+    if (!breaker->unicode && !breaker->newlines) {
+        /* Spaces only */
+        const char *space = memchr(breaker->text + state->scanPosition, ' ', breaker->length - state->scanPosition);
+        if (space == NULL) {
+            state->scanPosition = breaker->length;
+            return breaker->wrapLast && scan_next(breaker, opportunity);
+        }
+        opportunity->end = (size_t) (space - breaker->text);
+        opportunity->next = opportunity->end + 1;
+        state->scanPosition = opportunity->next;
+        return true;
+    }
+
+    const uint8_t *bytes = (const uint8_t *) breaker->text;
+    while (state->scanPosition < breaker->length) {
+        size_t at = state->scanPosition;
+        size_t size = 1;
+        uint8_t lineBreakClass;
+        if (breaker->unicode) {
+            lineBreakClass = next_class(bytes, breaker->length, at, &size);
+        } else {
+            lineBreakClass = bytes[at] == ' ' ? LB_SP : LB_AL;
+        }
+        uint8_t previousClass = state->previousClass;
+        state->scanPosition += size;
+        state->previousClass = lineBreakClass;
+
+        if (breaker->newlines && bytes[at] == '\n') {
+            opportunity->end = at;
+            opportunity->next = at + 1;
+            opportunity->forced = true;
+            /* The next line starts like a new text. */
+            state->previousClass = LB_NONE;
+            return true;
+        }
+        if (lineBreakClass == LB_SP) {
+            opportunity->end = at;
+            opportunity->next = at + 1;
+            return true;
+        }
+        /* Right after a space, the space itself is the opportunity. */
+        if (previousClass != LB_SP && can_break_between(previousClass, lineBreakClass)) {
+            opportunity->end = at;
+            opportunity->next = at;
+            return true;
+        }
+    }
+    return breaker->wrapLast && scan_next(breaker, opportunity);
+}
+
+/* The end of the text, found with #kPDTextLineBreakWrapLast. */
+static bool is_end(const PDTextBreakOpportunity *opportunity) {
+    return opportunity->forced && opportunity->next == opportunity->end;
+}
+
+/* Width of the current line up to end, carrying on from the previous call while the line start stays the same. */
+static int measure_line(PDTextLineBreaker *breaker, size_t end) {
+    size_t start = breaker->state.lineStart;
+    if (breaker->widthFunction != NULL) return breaker->widthFunction(breaker->widthUserdata, start, end);
+    if (breaker->measuredStart != start) {
+        pdText_MeasureBegin(&breaker->measure, breaker->font, breaker->encoding);
+        breaker->measuredStart = start;
+        breaker->measuredEnd = start;
+    }
+    const char *text = breaker->text;
+    if (pdText_MeasureAppend(&breaker->measure, text + breaker->measuredEnd, end - breaker->measuredEnd)) {
+        breaker->measuredEnd = end;
+        return pdText_MeasureGetWidth(&breaker->measure);
+    }
+    /* Not measurable piece by piece (no glyph cache, line breaks, ...): measure the whole line instead. */
+    breaker->measuredEnd = end;
+    return pdText_GetTextWidthN(breaker->font, breaker->encoding, text + start, end - start);
+}
+
+/* After a forced break, the next line starts over as if it were the start of the text. */
+static void start_over(PDTextLineBreaker *breaker) {
+    PDTextLineBreakerState *state = &breaker->state;
+    state->hasCurrent = scan_next(breaker, &state->current);
+    state->previous = state->current;
+}
+
+void pdText_LineBreakerInit(
+    PDTextLineBreaker *breaker,
+    const char *text,
+    size_t length,
+    const Font *font,
+    uint32_t max_lines,
+    uint16_t max_width,
+    PDStringEncoding encoding,
+    PDTextLineBreakRules rules
+) {
+    breaker->text = text;
+    breaker->length = length;
+    breaker->font = font;
+    breaker->maxLines = max_lines;
+    breaker->maxWidth = max_width;
+    breaker->encoding = encoding;
+    breaker->unicode = (rules & kPDTextLineBreakUnicode) != 0 && encoding == kUTF8Encoding;
+    breaker->newlines = (rules & kPDTextLineBreakNewlines) != 0;
+    breaker->wrapLast = (rules & kPDTextLineBreakWrapLast) != 0;
+    breaker->measuredStart = SIZE_MAX;
+    breaker->measuredEnd = 0;
+    breaker->widthFunction = NULL;
+    breaker->widthUserdata = NULL;
+    memset(&breaker->state, 0, sizeof(breaker->state));
+    breaker->state.previousClass = LB_NONE;
+    /* With a single line there is nothing to find. */
+    if (max_lines > 1) {
+        start_over(breaker);
+    }
+}
+
+void pdText_LineBreakerResume(
+    PDTextLineBreaker *breaker,
+    const char *text,
+    size_t length,
+    const PDTextLineBreakerState *state
+) {
+    breaker->text = text;
+    breaker->length = length;
+    breaker->state = *state;
+    breaker->measuredStart = SIZE_MAX;
+}
+
+void pdText_LineBreakerSetWidthFunction(PDTextLineBreaker *breaker, PDTextWidthFunction function, void *userdata) {
+    breaker->widthFunction = function;
+    breaker->widthUserdata = userdata;
+}
+
+bool pdText_LineBreakerNext(PDTextLineBreaker *breaker, size_t *line_end, size_t *next_line_start) {
+    PDTextLineBreakerState *state = &breaker->state;
+    while (state->lineCount < breaker->maxLines) {
+        while (state->hasCurrent) {
+            /* Expand this line until we go over the maximum width allowed */
+            uint32_t text_width = measure_line(breaker, state->current.end);
+            if (text_width > breaker->maxWidth) break;
+            if (state->current.forced) {
+                if (is_end(&state->current)) {
+                    state->hasCurrent = false;
+                    return false;
+                }
+                *line_end = state->current.end;
+                *next_line_start = state->current.next;
+                state->lineStart = state->current.next;
+                state->lineCount++;
+                start_over(breaker);
+                return true;
+            }
+            state->previous = state->current;
+            state->hasCurrent = scan_next(breaker, &state->current);
+        }
+        /* If we go over the splittable locations, then we don't need to do anything further. */
+        if (!state->hasCurrent) return false;
+        if (state->current.forced && state->previous.next == state->current.end
+            && state->previous.next != state->lineStart) {
+            /* Only a space is left before the line feed: break at the line feed, without the space. */
+            if (is_end(&state->current)) {
+                state->hasCurrent = false;
+                return false;
+            }
+            *line_end = state->previous.end;
+            *next_line_start = state->current.next;
+            state->lineStart = state->current.next;
+            state->lineCount++;
+            start_over(breaker);
+            return true;
+        }
+        if (is_end(&state->previous)) {
+            /* The last word does not fit on its own line either. */
+            state->hasCurrent = false;
+            return false;
+        }
+        /*
+         * Break at the last opportunity that fitted.
+         * If the very first word is super long, this is the first opportunity,
+         * and if the second word is super long as well, it is the break we already made, which still counts as a line.
+         */
+        bool broken = state->previous.next != state->lineStart;
+        if (broken) {
+            *line_end = state->previous.end;
+            *next_line_start = state->previous.next;
+            state->lineStart = state->previous.next;
+        }
+        state->lineCount++;
+        if (state->previous.forced) {
+            start_over(breaker);
+        } else if (state->current.forced) {
+            /* The line feed still has to break the new line; until then, the line can break there. */
+            state->previous = state->current;
+        } else {
+            state->previous = state->current;
+            state->hasCurrent = scan_next(breaker, &state->current);
+        }
+        if (broken) return true;
+    }
+    return false;
+}
+
+uint32_t pdText_BreakLines(
+    const char *text,
+    size_t length,
+    const Font *font,
+    uint32_t max_lines,
+    uint16_t max_width,
+    PDStringEncoding encoding,
+    PDTextLineBreakRules rules,
+    PDTextLineBreakFunction on_break,
+    void *userdata
+) {
+    PDTextLineBreaker breaker;
+    pdText_LineBreakerInit(&breaker, text, length, font, max_lines, max_width, encoding, rules);
+    size_t line_end;
+    size_t next_line_start;
+    while (pdText_LineBreakerNext(&breaker, &line_end, &next_line_start)) {
+        on_break(userdata, line_end, next_line_start);
+    }
+    return breaker.state.lineCount + 1;
+}
+
+static void break_in_place(void *userdata, size_t line_end, size_t next_line_start) {
+    (void) next_line_start;
+    ((char *) userdata)[line_end] = '\n';
+}
+
+uint32_t pdText_WrapText(
+    char *text,
+    size_t length,
+    const Font *font,
+    uint32_t max_lines,
+    uint16_t max_width,
+    PDStringEncoding encoding
+) {
+    return pdText_BreakLines(
+        text, length, font, max_lines, max_width, encoding, kPDTextLineBreakSpaces, break_in_place, text
+    );
+}
+
+typedef struct BufferWrapTag {
+    PDStrBuf *out;
+    const char *text;
+    size_t copied;
+} BufferWrap;
+
+static void break_into_buffer(void *userdata, size_t line_end, size_t next_line_start) {
+    BufferWrap *wrap = userdata;
+    pd_StrBufAppendN(wrap->out, wrap->text + wrap->copied, line_end - wrap->copied);
+    pd_StrBufAppendChar(wrap->out, '\n');
+    wrap->copied = next_line_start;
+}
+
+uint32_t pdText_WrapTextToBuf(
+    PDStrBuf *out,
+    const char *text,
+    size_t length,
+    const Font *font,
+    uint32_t max_lines,
+    uint16_t max_width,
+    PDStringEncoding encoding
+) {
+    BufferWrap wrap = {out, text, 0};
+    uint32_t lines = pdText_BreakLines(
+        text, length, font, max_lines, max_width, encoding, kPDTextLineBreakUnicode, break_into_buffer, &wrap
+    );
+    pd_StrBufAppendN(out, text + wrap.copied, length - wrap.copied);
+    return lines;
+}
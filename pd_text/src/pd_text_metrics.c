@@ -0,0 +1,351 @@
+#include "pd_text.h"
+
+#include <pd_api.h>
+#include <pd_shorthand.h>
+#include <string.h>
+
+/* Codepoints below this have their advance in a flat table. */
+#define ASCII_LIMIT 128
+/* Pairs of printable ASCII characters have their kerning in a flat table. */
+#define PAIR_FIRST 0x20
+#define PAIR_LAST 0x7E
+#define PAIR_RANGE (PAIR_LAST - PAIR_FIRST + 1)
+#define GLYPH_TABLE_INITIAL_CAPACITY 64
+#define KERNING_TABLE_INITIAL_CAPACITY 64
+#define UNKNOWN_ADVANCE INT16_MIN
+#define NO_CODEPOINT UINT32_MAX
+
+typedef struct GlyphEntryTag {
+    /* 0 marks an empty slot; NUL is never measured. */
+    uint32_t codepoint;
+    int16_t advance;
+} GlyphEntry;
+
+typedef struct KerningEntryTag {
+    uint32_t left;
+    uint32_t right;
+    int16_t kerning;
+    bool used;
+} KerningEntry;
+
+struct PDTextGlyphCacheTag {
+    LCDFont *font;
+    /* 1 if getTextWidth adds tracking between characters, 2 if after every character */
+    int32_t trackingUnitsForTwo;
+    int16_t asciiAdvances[ASCII_LIMIT];
+    /* Printable ASCII pairs; allocated on first use */
+    int8_t *asciiKerning;
+    uint8_t *asciiKerningKnown;
+    /* Open-addressed tables for everything else */
+    /* Capacities are powers of two; the shifts are 32 - log2(capacity). */
+    GlyphEntry *glyphs;
+    uint32_t glyphCount;
+    uint32_t glyphCapacity;
+    uint32_t glyphShift;
+    KerningEntry *kernings;
+    uint32_t kerningCount;
+    uint32_t kerningCapacity;
+    uint32_t kerningShift;
+};
+
+/* Fibonacci hashing: the top bits of the product are the best mixed, so they pick the slot. */
+static uint32_t hash_slot(uint32_t value, uint32_t shift) {
+    return (value * 2654435769u) >> shift;
+}
+
+static uint32_t shift_for(uint32_t capacity) {
+    uint32_t shift = 32;
+    while (capacity > 1) {
+        capacity >>= 1;
+        shift--;
+    }
+    return shift;
+}
+
+static size_t encode_utf8(uint32_t codepoint, char *out) {
+    if (codepoint < 0x80) {
+        out[0] = (char) codepoint;
+        return 1;
+    }
+    if (codepoint < 0x800) {
+        out[0] = (char) (0xC0 | (codepoint >> 6));
+        out[1] = (char) (0x80 | (codepoint & 0x3F));
+        return 2;
+    }
+    if (codepoint < 0x10000) {
+        out[0] = (char) (0xE0 | (codepoint >> 12));
+        out[1] = (char) (0x80 | ((codepoint >> 6) & 0x3F));
+        out[2] = (char) (0x80 | (codepoint & 0x3F));
+        return 3;
+    }
+    out[0] = (char) (0xF0 | (codepoint >> 18));
+    out[1] = (char) (0x80 | ((codepoint >> 12) & 0x3F));
+    out[2] = (char) (0x80 | ((codepoint >> 6) & 0x3F));
+    out[3] = (char) (0x80 | (codepoint & 0x3F));
+    return 4;
+}
+
+/*
+ * Measures one or two characters without tracking.
+ * Deriving everything from getTextWidth keeps the cached widths identical to what the SDK measures.
+ */
+static int measure_codepoints(const PDTextGlyphCache *cache, uint32_t first, uint32_t second) {
+    char text[9];
+    size_t length = encode_utf8(first, text);
+    size_t count = 1;
+    if (second != NO_CODEPOINT) {
+        length += encode_utf8(second, text + length);
+        count++;
+    }
+    text[length] = '\0';
+    return pd_getPd()->graphics->getTextWidth(cache->font, text, count, kUTF8Encoding, 0);
+}
+
+static bool grow_glyph_table(PDTextGlyphCache *cache) {
+    uint32_t capacity = cache->glyphCapacity == 0 ? GLYPH_TABLE_INITIAL_CAPACITY : cache->glyphCapacity * 2;
+    uint32_t shift = shift_for(capacity);
+    GlyphEntry *glyphs = pd_Malloc(sizeof(GlyphEntry) * capacity);
+    if (glyphs == NULL) return false;
+    memset(glyphs, 0, sizeof(GlyphEntry) * capacity);
+    for (uint32_t i = 0; i < cache->glyphCapacity; i++) {
+        if (cache->glyphs[i].codepoint == 0) continue;
+        uint32_t slot = hash_slot(cache->glyphs[i].codepoint, shift);
+        while (glyphs[slot].codepoint != 0) {
+            slot = (slot + 1) & (capacity - 1);
+        }
+        glyphs[slot] = cache->glyphs[i];
+    }
+    pd_Free(cache->glyphs);
+    cache->glyphs = glyphs;
+    cache->glyphCapacity = capacity;
+    cache->glyphShift = shift;
+    return true;
+}
+
+static int advance_of(PDTextGlyphCache *cache, uint32_t codepoint) {
+    if (codepoint < ASCII_LIMIT) {
+        if (cache->asciiAdvances[codepoint] == UNKNOWN_ADVANCE) {
+            cache->asciiAdvances[codepoint] = (int16_t) measure_codepoints(cache, codepoint, NO_CODEPOINT);
+        }
+        return cache->asciiAdvances[codepoint];
+    }
+
+    if (cache->glyphCapacity > 0) {
+        uint32_t slot = hash_slot(codepoint, cache->glyphShift);
+        while (cache->glyphs[slot].codepoint != 0) {
+            if (cache->glyphs[slot].codepoint == codepoint) return cache->glyphs[slot].advance;
+            slot = (slot + 1) & (cache->glyphCapacity - 1);
+        }
+    }
+
+    int advance = measure_codepoints(cache, codepoint, NO_CODEPOINT);
+    if ((cache->glyphCount + 1) * 4 > cache->glyphCapacity * 3 && !grow_glyph_table(cache)) {
+        /* Out of memory: still correct, just not cached. */
+        return advance;
+    }
+    uint32_t slot = hash_slot(codepoint, cache->glyphShift);
+    while (cache->glyphs[slot].codepoint != 0) {
+        slot = (slot + 1) & (cache->glyphCapacity - 1);
+    }
+    cache->glyphs[slot] = (GlyphEntry) {codepoint, (int16_t) advance};
+    cache->glyphCount++;
+    return advance;
+}
+
+static int measure_kerning(PDTextGlyphCache *cache, uint32_t left, uint32_t right) {
+    return measure_codepoints(cache, left, right) - advance_of(cache, left) - advance_of(cache, right);
+}
+
+static bool grow_kerning_table(PDTextGlyphCache *cache) {
+    uint32_t capacity = cache->kerningCapacity == 0 ? KERNING_TABLE_INITIAL_CAPACITY : cache->kerningCapacity * 2;
+    uint32_t shift = shift_for(capacity);
+    KerningEntry *kernings = pd_Malloc(sizeof(KerningEntry) * capacity);
+    if (kernings == NULL) return false;
+    memset(kernings, 0, sizeof(KerningEntry) * capacity);
+    for (uint32_t i = 0; i < cache->kerningCapacity; i++) {
+        const KerningEntry *entry = &cache->kernings[i];
+        if (!entry->used) continue;
+        uint32_t slot = hash_slot(entry->left * 31u + entry->right, shift);
+        while (kernings[slot].used) {
+            slot = (slot + 1) & (capacity - 1);
+        }
+        kernings[slot] = *entry;
+    }
+    pd_Free(cache->kernings);
+    cache->kernings = kernings;
+    cache->kerningCapacity = capacity;
+    cache->kerningShift = shift;
+    return true;
+}
+
+static int kerning_of(PDTextGlyphCache *cache, uint32_t left, uint32_t right) {
+    if (left >= PAIR_FIRST && left <= PAIR_LAST && right >= PAIR_FIRST && right <= PAIR_LAST) {
+        if (cache->asciiKerning == NULL) {
+            size_t pairs = PAIR_RANGE * PAIR_RANGE;
+            /* One block: the values, then one bit per pair telling whether it has been measured. */
+            cache->asciiKerning = pd_Malloc(pairs + (pairs + 7) / 8);
+            if (cache->asciiKerning == NULL) return measure_kerning(cache, left, right);
+            cache->asciiKerningKnown = (uint8_t *) cache->asciiKerning + pairs;
+            memset(cache->asciiKerningKnown, 0, (pairs + 7) / 8);
+        }
+        uint32_t pair = (left - PAIR_FIRST) * PAIR_RANGE + (right - PAIR_FIRST);
+        uint8_t bit = (uint8_t) (1u << (pair & 7));
+        if ((cache->asciiKerningKnown[pair >> 3] & bit) == 0) {
+            int kerning = measure_kerning(cache, left, right);
+            if (kerning < INT8_MIN || kerning > INT8_MAX) return kerning;
+            cache->asciiKerning[pair] = (int8_t) kerning;
+            cache->asciiKerningKnown[pair >> 3] |= bit;
+        }
+        return cache->asciiKerning[pair];
+    }
+
+    uint32_t key = left * 31u + right;
+    if (cache->kerningCapacity > 0) {
+        uint32_t slot = hash_slot(key, cache->kerningShift);
+        while (cache->kernings[slot].used) {
+            const KerningEntry *entry = &cache->kernings[slot];
+            if (entry->left == left && entry->right == right) return entry->kerning;
+            slot = (slot + 1) & (cache->kerningCapacity - 1);
+        }
+    }
+
+    int kerning = measure_kerning(cache, left, right);
+    if ((cache->kerningCount + 1) * 4 > cache->kerningCapacity * 3 && !grow_kerning_table(cache)) {
+        return kerning;
+    }
+    uint32_t slot = hash_slot(key, cache->kerningShift);
+    while (cache->kernings[slot].used) {
+        slot = (slot + 1) & (cache->kerningCapacity - 1);
+    }
+    cache->kernings[slot] = (KerningEntry) {left, right, (int16_t) kerning, true};
+    cache->kerningCount++;
+    return kerning;
+}
+
+/* Decodes one UTF-8 sequence; malformed sequences come out as NO_CODEPOINT so that the SDK gets to measure them. */
+static size_t decode_utf8(const uint8_t *text, size_t remaining, uint32_t *codepoint) {
+    uint8_t lead = text[0];
+    if (lead < 0x80) {
+        *codepoint = lead;
+        return 1;
+    }
+    size_t length = lead >= 0xF0 ? 4 : lead >= 0xE0 ? 3 : lead >= 0xC0 ? 2 : 0;
+    if (length == 0 || length > remaining) {
+        *codepoint = NO_CODEPOINT;
+        return 1;
+    }
+    uint32_t value = lead & (0x7Fu >> length);
+    for (size_t i = 1; i < length; i++) {
+        if ((text[i] & 0xC0) != 0x80) {
+            *codepoint = NO_CODEPOINT;
+            return 1;
+        }
+        value = (value << 6) | (text[i] & 0x3F);
+    }
+    *codepoint = value;
+    return length;
+}
+
+/* getTextWidth takes a number of characters, not bytes. */
+static size_t count_characters(PDStringEncoding encoding, const char *text, size_t length) {
+    if (encoding == k16BitLEEncoding) return length / 2;
+    if (encoding != kUTF8Encoding) return length;
+    size_t count = 0;
+    for (size_t i = 0; i < length; i++) {
+        count += ((uint8_t) text[i] & 0xC0) != 0x80 ? 1 : 0;
+    }
+    return count;
+}
+
+static int measure_uncached(const Font *font, PDStringEncoding encoding, const char *text, size_t length, int tracking) {
+    size_t count = count_characters(encoding, text, length);
+    return pd_getPd()->graphics->getTextWidth(font->font, text, count, encoding, tracking);
+}
+
+bool pdText_CreateGlyphCache(Font *font) {
+    if (font == NULL || font->font == NULL) return false;
+    if (font->glyphCache != NULL) return true;
+    PDTextGlyphCache *cache = pd_Malloc(sizeof(PDTextGlyphCache));
+    if (cache == NULL) return false;
+    memset(cache, 0, sizeof(PDTextGlyphCache));
+    cache->font = font->font;
+    for (uint32_t i = 0; i < ASCII_LIMIT; i++) {
+        cache->asciiAdvances[i] = UNKNOWN_ADVANCE;
+    }
+    /* Find out whether tracking goes between characters or after each of them. */
+    PlaydateAPI *pd = pd_getPd();
+    cache->trackingUnitsForTwo = pd->graphics->getTextWidth(font->font, "ii", 2, kASCIIEncoding, 1)
+                                 - pd->graphics->getTextWidth(font->font, "ii", 2, kASCIIEncoding, 0);
+    font->glyphCache = cache;
+    return true;
+}
+
+void pdText_WarmGlyphCache(const Font *font, PDStringEncoding encoding, const char *text) {
+    if (font == NULL || font->glyphCache == NULL) return;
+    /* Measuring fills the cache with every glyph and pair in the text. */
+    pdText_GetTextWidthN(font, encoding, text, strlen(text));
+}
+
+void pdText_FreeGlyphCache(Font *font) {
+    if (font == NULL || font->glyphCache == NULL) return;
+    PDTextGlyphCache *cache = font->glyphCache;
+    pd_Free(cache->asciiKerning);
+    pd_Free(cache->glyphs);
+    pd_Free(cache->kernings);
+    pd_Free(cache);
+    font->glyphCache = NULL;
+}
+
+void pdText_MeasureBegin(PDTextMeasure *measure, const Font *font, PDStringEncoding encoding) {
+    measure->font = font;
+    measure->encoding = encoding;
+    measure->tracking = pd_getPd()->graphics->getTextTracking();
+    measure->width = 0;
+    measure->count = 0;
+    measure->previous = NO_CODEPOINT;
+    measure->cached = font->glyphCache != NULL && encoding != k16BitLEEncoding;
+}
+
+bool pdText_MeasureAppend(PDTextMeasure *measure, const char *text, size_t length) {
+    if (!measure->cached) return false;
+    PDTextGlyphCache *cache = measure->font->glyphCache;
+    const uint8_t *bytes = (const uint8_t *) text;
+    size_t i = 0;
+    while (i < length) {
+        uint32_t codepoint;
+        if (bytes[i] < 0x80) {
+            codepoint = bytes[i++];
+        } else if (measure->encoding == kUTF8Encoding) {
+            i += decode_utf8(bytes + i, length - i, &codepoint);
+        } else {
+            codepoint = NO_CODEPOINT;
+        }
+        if (codepoint == '\0' || codepoint == '\n' || codepoint == NO_CODEPOINT) {
+            /* Early ends, multi-line text and non-ASCII bytes in ASCII text are left to the SDK. */
+            measure->cached = false;
+            return false;
+        }
+        measure->width += advance_of(cache, codepoint);
+        if (measure->previous != NO_CODEPOINT) {
+            measure->width += kerning_of(cache, measure->previous, codepoint);
+        }
+        measure->previous = codepoint;
+        measure->count++;
+    }
+    return true;
+}
+
+int pdText_MeasureGetWidth(const PDTextMeasure *measure) {
+    if (measure->count == 0) return 0;
+    int32_t trackingUnits = (int32_t) measure->count - 2 + measure->font->glyphCache->trackingUnitsForTwo;
+    return measure->width + measure->tracking * trackingUnits;
+}
+
+int pdText_GetTextWidthN(const Font *font, PDStringEncoding encoding, const char *text, size_t length) {
+    PDTextMeasure measure;
+    pdText_MeasureBegin(&measure, font, encoding);
+    if (pdText_MeasureAppend(&measure, text, length)) {
+        return pdText_MeasureGetWidth(&measure);
+    }
+    return measure_uncached(font, encoding, text, length, measure.tracking);
+}
@@ -0,0 +1,380 @@
+#include "pd_text.h"
+
+#include <pd_api.h>
+#include <pd_shorthand.h>
+#include <stdint.h>
+#include <string.h>
+
+#define RICH_MIN_CAPACITY 8
+
+typedef struct RichStyleTag {
+    uint8_t font;
+    bool inverted;
+} RichStyle;
+
+/* Width of the current line, carried on from one opportunity to the next like the line breaker does. */
+typedef struct RichMeasureTag {
+    const PDTextRichText *rich;
+    size_t start;
+    size_t end;
+    /* Width of the spans of the line before the current one */
+    int done;
+    uint32_t span;
+    PDTextMeasure measure;
+    bool cached;
+} RichMeasure;
+
+static bool reserve(void **items, uint32_t *capacity, uint32_t count, size_t item_size) {
+    if (count < *capacity) return true;
+    uint32_t newCapacity = *capacity * 2;
+    if (newCapacity < RICH_MIN_CAPACITY) {
+        newCapacity = RICH_MIN_CAPACITY;
+    }
+    void *grown = pd_Realloc(*items, item_size * newCapacity);
+    if (grown == NULL) return false;
+    *items = grown;
+    *capacity = newCapacity;
+    return true;
+}
+
+static uint32_t count_characters(PDStringEncoding encoding, const char *text, size_t length) {
+    if (encoding == k16BitLEEncoding) return (uint32_t) (length / 2);
+    if (encoding != kUTF8Encoding) return (uint32_t) length;
+    uint32_t count = 0;
+    for (size_t i = 0; i < length; i++) {
+        count += ((uint8_t) text[i] & 0xC0) != 0x80 ? 1 : 0;
+    }
+    return count;
+}
+
+/* Ends the span of the text added since @c start in the given style, merging it into the previous one if alike. */
+static bool close_span(PDTextRichText *rich, size_t start, RichStyle style) {
+    size_t end = rich->text.length;
+    if (end == start) return true;
+    if (rich->spanCount > 0) {
+        PDTextRun *last = &rich->spans[rich->spanCount - 1];
+        if (last->font == style.font && last->inverted == style.inverted) {
+            last->length += (uint32_t) (end - start);
+            return true;
+        }
+    }
+    if (!reserve((void **) &rich->spans, &rich->spanCapacity, rich->spanCount, sizeof(PDTextRun))) return false;
+    PDTextRun *span = &rich->spans[rich->spanCount++];
+    memset(span, 0, sizeof(PDTextRun));
+    span->start = (uint32_t) start;
+    span->length = (uint32_t) (end - start);
+    span->font = style.font;
+    span->inverted = style.inverted;
+    return true;
+}
+
+/* Reads the tag at the start of @c markup into @c style; returns its length, or 0 if it is not a tag. */
+static size_t parse_tag(const PDTextRichText *rich, const char *markup, size_t length, RichStyle *style) {
+    if (length >= 4 && markup[1] == 'f' && markup[2] >= '0' && markup[2] <= '9' && markup[3] == '}') {
+        uint8_t font = (uint8_t) (markup[2] - '0');
+        if (font >= rich->fontCount) return 0;
+        style->font = font;
+        return 4;
+    }
+    if (length >= 4 && memcmp(markup, "{/f}", 4) == 0) {
+        style->font = 0;
+        return 4;
+    }
+    if (length >= 5 && memcmp(markup, "{inv}", 5) == 0) {
+        style->inverted = true;
+        return 5;
+    }
+    if (length >= 6 && memcmp(markup, "{/inv}", 6) == 0) {
+        style->inverted = false;
+        return 6;
+    }
+    return 0;
+}
+
+/* Splits the markup into the plain text and the spans of the same style. */
+static bool parse(PDTextRichText *rich, const char *markup, size_t length) {
+    bool result = true;
+    RichStyle style = {0, false};
+    size_t spanStart = 0;
+    size_t at = 0;
+    const char *brace;
+    bool markers = rich->encoding != k16BitLEEncoding;
+    while (markers && (brace = memchr(markup + at, '{', length - at)) != NULL) {
+        size_t tag = (size_t) (brace - markup);
+        result = pd_StrBufAppendN(&rich->text, markup + at, tag - at) && result;
+        if (tag + 1 < length && markup[tag + 1] == '{') {
+            result = pd_StrBufAppendChar(&rich->text, '{') && result;
+            at = tag + 2;
+            continue;
+        }
+        RichStyle next = style;
+        size_t tagLength = parse_tag(rich, markup + tag, length - tag, &next);
+        if (tagLength == 0) {
+            result = pd_StrBufAppendChar(&rich->text, '{') && result;
+            at = tag + 1;
+            continue;
+        }
+        if (next.font != style.font || next.inverted != style.inverted) {
+            result = close_span(rich, spanStart, style) && result;
+            spanStart = rich->text.length;
+            style = next;
+        }
+        at = tag + tagLength;
+    }
+    result = pd_StrBufAppendN(&rich->text, markup + at, length - at) && result;
+    return close_span(rich, spanStart, style) && result;
+}
+
+/* Index of the span containing @c position, looking from @c hint on when it is not past it. */
+static uint32_t span_at(const PDTextRichText *rich, size_t position, uint32_t hint) {
+    uint32_t span = hint < rich->spanCount && rich->spans[hint].start <= position ? hint : 0;
+    while (span + 1 < rich->spanCount && rich->spans[span].start + rich->spans[span].length <= position) {
+        span++;
+    }
+    return span;
+}
+
+static int measure_piece(const PDTextRichText *rich, const PDTextRun *span, size_t start, size_t end) {
+    return pdText_GetTextWidthN(
+        rich->fonts[span->font], rich->encoding, pd_StrBufCStr(&rich->text) + start, end - start
+    );
+}
+
+/* Width of the text between the offsets, each span measured in its own font. */
+static int measure_spans(const PDTextRichText *rich, size_t start, size_t end) {
+    int width = 0;
+    uint32_t span = span_at(rich, start, 0);
+    while (start < end && span < rich->spanCount) {
+        size_t spanEnd = rich->spans[span].start + rich->spans[span].length;
+        size_t pieceEnd = spanEnd < end ? spanEnd : end;
+        width += measure_piece(rich, &rich->spans[span], start, pieceEnd);
+        start = pieceEnd;
+        span++;
+    }
+    return width;
+}
+
+static int measure_line(void *userdata, size_t start, size_t end) {
+    RichMeasure *measure = userdata;
+    const PDTextRichText *rich = measure->rich;
+    if (rich->spanCount == 0) return 0;
+    if (measure->start != start || end < measure->end || !measure->cached) {
+        measure->start = start;
+        measure->end = start;
+        measure->done = 0;
+        measure->span = span_at(rich, start, measure->span);
+        pdText_MeasureBegin(&measure->measure, rich->fonts[rich->spans[measure->span].font], rich->encoding);
+        measure->cached = true;
+    }
+    const char *text = pd_StrBufCStr(&rich->text);
+    while (measure->end < end) {
+        const PDTextRun *span = &rich->spans[measure->span];
+        size_t spanEnd = span->start + span->length;
+        if (measure->end == spanEnd) {
+            measure->done += pdText_MeasureGetWidth(&measure->measure);
+            measure->span++;
+            pdText_MeasureBegin(&measure->measure, rich->fonts[rich->spans[measure->span].font], rich->encoding);
+            continue;
+        }
+        size_t pieceEnd = spanEnd < end ? spanEnd : end;
+        if (!pdText_MeasureAppend(&measure->measure, text + measure->end, pieceEnd - measure->end)) {
+            /* Not measurable piece by piece: measure the whole line instead. */
+            measure->cached = false;
+            return measure_spans(rich, start, end);
+        }
+        measure->end = pieceEnd;
+    }
+    return measure->done + pdText_MeasureGetWidth(&measure->measure);
+}
+
+/* Splits the spans between the offsets into the runs of a new line, looking for them from @c span_hint on. */
+static bool add_line(PDTextRichText *rich, size_t start, size_t end, uint32_t *span_hint) {
+    if (!reserve((void **) &rich->lines, &rich->lineCapacity, rich->lineCount, sizeof(PDTextRichLine))) return false;
+    const char *text = pd_StrBufCStr(&rich->text);
+    PDTextRichLine *line = &rich->lines[rich->lineCount];
+    line->firstRun = rich->runCount;
+    line->runCount = 0;
+    line->y = rich->height;
+    line->width = 0;
+    line->height = 0;
+
+    uint32_t span = span_at(rich, start, *span_hint);
+    *span_hint = span;
+    int32_t x = 0;
+    size_t at = start;
+    while (at < end && span < rich->spanCount) {
+        const PDTextRun *source = &rich->spans[span];
+        size_t spanEnd = source->start + source->length;
+        size_t pieceEnd = spanEnd < end ? spanEnd : end;
+        if (!reserve((void **) &rich->runs, &rich->runCapacity, rich->runCount, sizeof(PDTextRun))) return false;
+        PDTextRun *run = &rich->runs[rich->runCount++];
+        int width = measure_piece(rich, source, at, pieceEnd);
+        run->start = (uint32_t) at;
+        run->length = (uint32_t) (pieceEnd - at);
+        run->characters = count_characters(rich->encoding, text + at, pieceEnd - at);
+        run->x = (uint16_t) (x > UINT16_MAX ? UINT16_MAX : x);
+        run->width = (uint16_t) (width < 0 ? 0 : width > UINT16_MAX ? UINT16_MAX : width);
+        run->font = source->font;
+        run->inverted = source->inverted;
+        x += run->width;
+        if (rich->fonts[run->font]->height > line->height) {
+            line->height = rich->fonts[run->font]->height;
+        }
+        line->runCount++;
+        at = pieceEnd;
+        span++;
+    }
+    if (line->runCount == 0) {
+        /* An empty line is as tall as the font it is in. */
+        uint8_t font = rich->spanCount > 0 ? rich->spans[span < rich->spanCount ? span : rich->spanCount - 1].font : 0;
+        line->height = rich->fonts[font]->height;
+    }
+    line->width = (uint16_t) (x > UINT16_MAX ? UINT16_MAX : x);
+    if (line->width > rich->width) {
+        rich->width = line->width;
+    }
+    rich->height += line->height;
+    rich->lineCount++;
+    return true;
+}
+
+static bool layout(PDTextRichText *rich) {
+    const char *text = pd_StrBufCStr(&rich->text);
+    size_t length = rich->text.length;
+    PDTextLineBreaker breaker;
+    pdText_LineBreakerInit(
+        &breaker, text, length, rich->fonts[0], UINT32_MAX, rich->maxWidth, rich->encoding,
+        kPDTextLineBreakUnicode | kPDTextLineBreakNewlines | kPDTextLineBreakWrapLast
+    );
+    RichMeasure measure;
+    measure.rich = rich;
+    measure.start = SIZE_MAX;
+    measure.end = 0;
+    measure.span = 0;
+    measure.cached = false;
+    pdText_LineBreakerSetWidthFunction(&breaker, measure_line, &measure);
+
+    uint32_t span = 0;
+    size_t lineStart = 0;
+    size_t lineEnd;
+    size_t nextLineStart;
+    while (pdText_LineBreakerNext(&breaker, &lineEnd, &nextLineStart)) {
+        if (rich->lineCount == rich->maxLines) {
+            rich->truncated = true;
+            return true;
+        }
+        if (!add_line(rich, lineStart, lineEnd, &span)) return false;
+        lineStart = nextLineStart;
+    }
+    if (length == 0) return true;
+    if (rich->lineCount == rich->maxLines) {
+        rich->truncated = true;
+        return true;
+    }
+    return add_line(rich, lineStart, length, &span);
+}
+
+void pdText_RichTextInit(
+    PDTextRichText *rich,
+    const Font *const *fonts,
+    uint8_t font_count,
+    PDStringEncoding encoding,
+    uint16_t max_width,
+    uint32_t max_lines,
+    PDTextAlignment alignment
+) {
+    if (font_count > PD_TEXT_RICH_MAX_FONTS) {
+        pd_LogWarn("PDText: rich text only takes %d fonts.", PD_TEXT_RICH_MAX_FONTS);
+        font_count = PD_TEXT_RICH_MAX_FONTS;
+    }
+    for (uint8_t i = 0; i < PD_TEXT_RICH_MAX_FONTS; i++) {
+        rich->fonts[i] = i < font_count ? fonts[i] : NULL;
+    }
+    rich->fontCount = font_count;
+    rich->encoding = encoding;
+    rich->alignment = alignment;
+    rich->maxWidth = max_width;
+    rich->maxLines = max_lines;
+    pd_StrBufInit(&rich->text, NULL, 0);
+    rich->spans = NULL;
+    rich->spanCount = 0;
+    rich->spanCapacity = 0;
+    rich->runs = NULL;
+    rich->runCount = 0;
+    rich->runCapacity = 0;
+    rich->lines = NULL;
+    rich->lineCount = 0;
+    rich->lineCapacity = 0;
+    rich->width = 0;
+    rich->height = 0;
+    rich->truncated = false;
+}
+
+bool pdText_RichTextSetText(PDTextRichText *rich, const char *markup, size_t length) {
+    if (rich->fontCount == 0 || rich->fonts[0] == NULL) {
+        pd_Error("PDText Error: NULL font passed.");
+        return false;
+    }
+    pd_StrBufClear(&rich->text);
+    rich->spanCount = 0;
+    rich->runCount = 0;
+    rich->lineCount = 0;
+    rich->width = 0;
+    rich->height = 0;
+    rich->truncated = false;
+    bool parsed = parse(rich, markup, length);
+    return layout(rich) && parsed;
+}
+
+void pdText_RichTextDraw(const PDTextRichText *rich, int32_t x, int32_t y) {
+    if (rich->lineCount == 0) return;
+    PlaydateAPI *pd = pd_getPd();
+    const char *text = pd_StrBufCStr(&rich->text);
+    int font = -1;
+    bool inverted = false;
+    LCDBitmapDrawMode mode = kDrawModeCopy;
+    for (uint32_t i = 0; i < rich->lineCount; i++) {
+        const PDTextRichLine *line = &rich->lines[i];
+        int32_t left = x;
+        if (rich->alignment == kPDTextAlignCenter) {
+            left += ((int32_t) rich->maxWidth - line->width) / 2;
+        } else if (rich->alignment == kPDTextAlignRight) {
+            left += (int32_t) rich->maxWidth - line->width;
+        }
+        int32_t top = y + (int32_t) line->y;
+        for (uint32_t r = line->firstRun; r < line->firstRun + line->runCount; r++) {
+            const PDTextRun *run = &rich->runs[r];
+            if (run->font != font) {
+                font = run->font;
+                pd->graphics->setFont(rich->fonts[font]->font);
+            }
+            if (run->inverted != inverted) {
+                LCDBitmapDrawMode previous = pd->graphics->setDrawMode(run->inverted ? kDrawModeFillWhite : mode);
+                if (run->inverted) {
+                    mode = previous;
+                }
+                inverted = run->inverted;
+            }
+            if (run->inverted) {
+                pd->graphics->fillRect(left + run->x, top, run->width, line->height, kColorBlack);
+            }
+            pd->graphics->drawText(
+                text + run->start, run->characters, rich->encoding, left + run->x,
+                top + line->height - rich->fonts[font]->height
+            );
+        }
+    }
+    if (inverted) {
+        pd->graphics->setDrawMode(mode);
+    }
+}
+
+void pdText_RichTextRelease(PDTextRichText *rich) {
+    pd_StrBufRelease(&rich->text);
+    pd_Free(rich->spans);
+    pd_Free(rich->runs);
+    pd_Free(rich->lines);
+    pdText_RichTextInit(
+        rich, rich->fonts, rich->fontCount, rich->encoding, rich->maxWidth, rich->maxLines, rich->alignment
+    );
+}
@@ -0,0 +1,191 @@
+#include "pd_text.h"
+#include "pd_text_binary.h"
+#include "pd_text_script_format.h"
+
+#include <pd_api.h>
+#include <pd_shorthand.h>
+#include <stdio.h>
+#include <string.h>
+
+#define NO_PAGE UINT32_MAX
+
+static void reset(PDTextScript *script) {
+    script->file = NULL;
+    script->pageCount = 0;
+    script->lineCount = 0;
+    script->offsets = NULL;
+    script->firstLines = NULL;
+    script->maxPageLength = 0;
+    script->page = NO_PAGE;
+    script->buffer = NULL;
+    script->prefetchPage = NO_PAGE;
+    script->prefetchBuffer = NULL;
+}
+
+/* Reads the page table and checks that the pages follow each other within the file. */
+static bool read_page_table(PDTextScript *script, uint32_t page_count) {
+    PlaydateAPI *pd = pd_getPd();
+    if (page_count >= UINT32_MAX / PD_TEXT_SCRIPT_ENTRY_SIZE) return false;
+    size_t entries = (size_t) page_count + 1;
+    size_t bytes = entries * PD_TEXT_SCRIPT_ENTRY_SIZE;
+    /* The raw entries are read into the block that ends up holding the first lines, decoded in place. */
+    uint32_t *table = pd_Malloc(bytes);
+    if (table == NULL) return false;
+    if (pd->file->read(script->file, table, (unsigned int) bytes) != (int) bytes) {
+        pd_Free(table);
+        return false;
+    }
+    uint32_t *offsets = pd_Malloc(sizeof(uint32_t) * entries);
+    if (offsets == NULL) {
+        pd_Free(table);
+        return false;
+    }
+    const uint8_t *raw = (const uint8_t *) table;
+    uint32_t expected = PD_TEXT_SCRIPT_HEADER_SIZE + (uint32_t) bytes;
+    bool valid = true;
+    for (size_t i = 0; i < entries; i++) {
+        offsets[i] = pdText_GetU32(raw + i * PD_TEXT_SCRIPT_ENTRY_SIZE);
+        /* Slot i only overwrites entries before entry i, which have been decoded already. */
+        table[i] = pdText_GetU32(raw + i * PD_TEXT_SCRIPT_ENTRY_SIZE + 4);
+        if (i == 0 ? offsets[i] != expected : offsets[i] < offsets[i - 1] || table[i] < table[i - 1]) {
+            valid = false;
+            break;
+        }
+        if (i > 0 && offsets[i] - offsets[i - 1] > script->maxPageLength) {
+            script->maxPageLength = offsets[i] - offsets[i - 1];
+        }
+    }
+    if (!valid || table[0] != 0 || table[page_count] != script->lineCount) {
+        pd_Free(offsets);
+        pd_Free(table);
+        return false;
+    }
+    script->offsets = offsets;
+    script->firstLines = table;
+    return true;
+}
+
+/* Reads a page into the buffer with one seek and one read, allocating the buffer the first time. */
+static bool read_page(PDTextScript *script, uint32_t page, char **buffer) {
+    if (*buffer == NULL) {
+        *buffer = pd_Malloc(script->maxPageLength + 1);
+        if (*buffer == NULL) return false;
+    }
+    PlaydateAPI *pd = pd_getPd();
+    uint32_t length = script->offsets[page + 1] - script->offsets[page];
+    if (pd->file->seek(script->file, (int) script->offsets[page], SEEK_SET) != 0
+        || pd->file->read(script->file, *buffer, length) != (int) length) {
+        pd_LogError("PDText: could not read page %u of a script: %s", (unsigned) page, pd->file->geterr());
+        return false;
+    }
+    (*buffer)[length] = '\0';
+    return true;
+}
+
+bool pdText_ScriptOpen(PDTextScript *script, const char *path, const char **err) {
+    PlaydateAPI *pd = pd_getPd();
+    reset(script);
+    script->file = pd->file->open(path, kFileRead | kFileReadData);
+    if (script->file == NULL) {
+        *err = pd->file->geterr();
+        return false;
+    }
+
+    uint8_t header[PD_TEXT_SCRIPT_HEADER_SIZE];
+    if (pd->file->read(script->file, header, sizeof(header)) != (int) sizeof(header)
+        || memcmp(header, PD_TEXT_SCRIPT_MAGIC, 4) != 0) {
+        *err = "not a script file";
+        pdText_ScriptClose(script);
+        return false;
+    }
+    if (pdText_GetU16(header + 4) != PD_TEXT_SCRIPT_VERSION) {
+        *err = "unsupported script version";
+        pdText_ScriptClose(script);
+        return false;
+    }
+    script->lineCount = pdText_GetU32(header + 12);
+    if (!read_page_table(script, pdText_GetU32(header + 8))) {
+        *err = "malformed page table, or out of memory";
+        pdText_ScriptClose(script);
+        return false;
+    }
+    script->pageCount = pdText_GetU32(header + 8);
+    *err = NULL;
+    return true;
+}
+
+const char *pdText_ScriptGetPage(PDTextScript *script, uint32_t page, size_t *length) {
+    if (page >= script->pageCount) return NULL;
+    if (page != script->page) {
+        if (page == script->prefetchPage) {
+            char *buffer = script->buffer;
+            script->buffer = script->prefetchBuffer;
+            script->prefetchBuffer = buffer;
+            script->prefetchPage = script->page;
+        } else if (!read_page(script, page, &script->buffer)) {
+            script->page = NO_PAGE;
+            return NULL;
+        }
+        script->page = page;
+    }
+    if (length != NULL) {
+        *length = script->offsets[page + 1] - script->offsets[page];
+    }
+    return script->buffer;
+}
+
+uint32_t pdText_ScriptGetPageOfLine(const PDTextScript *script, uint32_t line) {
+    if (line >= script->lineCount) return NO_PAGE;
+    /* Last page whose first line is at or before the line */
+    uint32_t low = 0;
+    uint32_t high = script->pageCount;
+    while (high - low > 1) {
+        uint32_t middle = low + (high - low) / 2;
+        if (script->firstLines[middle] <= line) {
+            low = middle;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+const char *pdText_ScriptGetLine(PDTextScript *script, uint32_t line, size_t *length) {
+    uint32_t page = pdText_ScriptGetPageOfLine(script, line);
+    if (page == NO_PAGE) return NULL;
+    size_t pageLength;
+    const char *text = pdText_ScriptGetPage(script, page, &pageLength);
+    if (text == NULL) return NULL;
+
+    const char *end = text + pageLength;
+    for (uint32_t i = script->firstLines[page]; i < line; i++) {
+        const char *newline = memchr(text, '\n', (size_t) (end - text));
+        if (newline == NULL) return NULL;
+        text = newline + 1;
+    }
+    const char *newline = memchr(text, '\n', (size_t) (end - text));
+    *length = (size_t) ((newline != NULL ? newline : end) - text);
+    return text;
+}
+
+bool pdText_ScriptPrefetch(PDTextScript *script, uint32_t page) {
+    if (page >= script->pageCount) return false;
+    if (page == script->page || page == script->prefetchPage) return true;
+    if (!read_page(script, page, &script->prefetchBuffer)) {
+        script->prefetchPage = NO_PAGE;
+        return false;
+    }
+    script->prefetchPage = page;
+    return true;
+}
+
+void pdText_ScriptClose(PDTextScript *script) {
+    if (script->file != NULL) {
+        pd_getPd()->file->close(script->file);
+    }
+    pd_Free(script->offsets);
+    pd_Free(script->firstLines);
+    pd_Free(script->buffer);
+    pd_Free(script->prefetchBuffer);
+    reset(script);
+}
@@ -0,0 +1,29 @@
+/**
+ * @file pd_text_script_format.h
+ *
+ * @brief Binary format of the indexed script files read by pdText_ScriptOpen.
+ *
+ * This header does not depend on the Playdate SDK,
+ * so that host-side tools can write script files with it.
+ *
+ * @par Layout:
+ * All integers are little-endian.
+ * @li File header (#PD_TEXT_SCRIPT_HEADER_SIZE bytes): magic "PDSC", u16 version, u16 reserved (0),
+ *     u32 page count, u32 line count.
+ * @li Page table (page count + 1 entries of #PD_TEXT_SCRIPT_ENTRY_SIZE bytes): u32 offset of the page
+ *     from the start of the file, u32 index of the first line of the page.
+ *     The last entry holds the end of the last page and the line count, so that page @c i
+ *     spans from entry @c i to entry <tt>i + 1</tt>.
+ * @li Pages, one after the other: the lines of the page separated by @c '\n' , without a final line feed
+ *     or a NUL terminator.
+ */
+
+#ifndef PD_TEXT_SCRIPT_FORMAT_H
+#define PD_TEXT_SCRIPT_FORMAT_H
+
+#define PD_TEXT_SCRIPT_MAGIC "PDSC"
+#define PD_TEXT_SCRIPT_VERSION 1
+#define PD_TEXT_SCRIPT_HEADER_SIZE 16
+#define PD_TEXT_SCRIPT_ENTRY_SIZE 8
+
+#endif /* PD_TEXT_SCRIPT_FORMAT_H */
@@ -0,0 +1,104 @@
+#include "pd_text.h"
+#include "pd_text_binary.h"
+#include "pd_text_strings_format.h"
+
+#include <pd_api.h>
+#include <pd_shorthand.h>
+#include <stdio.h>
+#include <string.h>
+
+static void reset(PDTextStrings *strings) {
+    strings->entries = NULL;
+    strings->blob = "";
+    strings->blobSize = 0;
+    strings->count = 0;
+    strings->language[0] = '\0';
+}
+
+/* Decodes the entries in place and checks that every string lies within the blob and ends with a NUL. */
+static bool decode_entries(PDTextStrings *strings) {
+    const uint8_t *raw = (const uint8_t *) strings->entries;
+    for (uint32_t i = 0; i < strings->count * 2; i += 2) {
+        uint32_t offset = pdText_GetU32(raw + i * 4);
+        uint32_t length = pdText_GetU32(raw + i * 4 + 4);
+        if (offset >= strings->blobSize || length >= strings->blobSize - offset
+            || strings->blob[offset + length] != '\0') {
+            return false;
+        }
+        strings->entries[i] = offset;
+        strings->entries[i + 1] = length;
+    }
+    return true;
+}
+
+bool pdText_LoadStrings(PDTextStrings *strings, const char *path, const char *language, const char **err) {
+    PlaydateAPI *pd = pd_getPd();
+    reset(strings);
+    SDFile *file = pd->file->open(path, kFileRead | kFileReadData);
+    if (file == NULL) {
+        *err = pd->file->geterr();
+        return false;
+    }
+
+    uint8_t header[PD_TEXT_STRINGS_HEADER_SIZE];
+    uint32_t offset = 0;
+    uint32_t size = 0;
+    *err = NULL;
+    if (pd->file->read(file, header, sizeof(header)) != (int) sizeof(header)
+        || memcmp(header, PD_TEXT_STRINGS_MAGIC, 4) != 0) {
+        *err = "not a string table";
+    } else if (pdText_GetU16(header + 4) != PD_TEXT_STRINGS_VERSION) {
+        *err = "unsupported string table version";
+    } else if (!pdText_FindLanguageSection(file, pdText_GetU16(header + 6), language, &offset, &size)) {
+        *err = "language not found";
+    }
+    uint32_t count = pdText_GetU32(header + 8);
+    if (*err == NULL
+        && (count > UINT32_MAX / PD_TEXT_STRINGS_ENTRY_SIZE || size <= count * PD_TEXT_STRINGS_ENTRY_SIZE)) {
+        *err = "malformed string table";
+    }
+    if (*err == NULL) {
+        strings->entries = pd_Malloc(size);
+        if (strings->entries == NULL) {
+            *err = "out of memory";
+        } else if (pd->file->seek(file, (int) offset, SEEK_SET) != 0
+                   || pd->file->read(file, strings->entries, size) != (int) size) {
+            *err = pd->file->geterr();
+        } else {
+            strings->count = count;
+            strings->blob = (const char *) strings->entries + count * PD_TEXT_STRINGS_ENTRY_SIZE;
+            strings->blobSize = size - count * PD_TEXT_STRINGS_ENTRY_SIZE;
+            if (!decode_entries(strings)) {
+                *err = "malformed string table";
+            }
+        }
+    }
+    pd->file->close(file);
+
+    if (*err != NULL) {
+        pdText_FreeStrings(strings);
+        return false;
+    }
+    strncpy(strings->language, language, sizeof(strings->language) - 1);
+    strings->language[sizeof(strings->language) - 1] = '\0';
+    return true;
+}
+
+const char *pdText_GetString(const PDTextStrings *strings, uint32_t id) {
+    if (id >= strings->count) return "";
+    return strings->blob + strings->entries[id * 2];
+}
+
+const char *pdText_GetStringN(const PDTextStrings *strings, uint32_t id, size_t *length) {
+    if (id >= strings->count) {
+        *length = 0;
+        return "";
+    }
+    *length = strings->entries[id * 2 + 1];
+    return strings->blob + strings->entries[id * 2];
+}
+
+void pdText_FreeStrings(PDTextStrings *strings) {
+    pd_Free(strings->entries);
+    reset(strings);
+}
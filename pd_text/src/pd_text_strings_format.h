@@ -0,0 +1,33 @@
+/**
+ * @file pd_text_strings_format.h
+ *
+ * @brief Binary format of the string tables read by pdText_LoadStrings.
+ *
+ * This header does not depend on the Playdate SDK,
+ * so that host-side tools can write string tables with it.
+ *
+ * @par Layout:
+ * All integers are little-endian.
+ * @li File header (#PD_TEXT_STRINGS_HEADER_SIZE bytes): magic "PDST", u16 version, u16 language count,
+ *     u32 string count, u32 reserved (0).
+ * @li Language directory (language count entries of #PD_TEXT_LANGUAGE_ENTRY_SIZE bytes):
+ *     language code (#PD_TEXT_LANGUAGE_CODE_SIZE bytes, NUL-padded), u32 offset of the section
+ *     of the language from the start of the file, u32 size of the section.
+ * @li One section per language: string count entries of #PD_TEXT_STRINGS_ENTRY_SIZE bytes
+ *     (u32 offset of the string in the blob, u32 length in bytes), then the blob:
+ *     the NUL-terminated UTF-8 strings of the language, each distinct string stored once.
+ *
+ * String IDs are indices in the entries, the same in every language.
+ */
+
+#ifndef PD_TEXT_STRINGS_FORMAT_H
+#define PD_TEXT_STRINGS_FORMAT_H
+
+#include "pd_text_binary.h"
+
+#define PD_TEXT_STRINGS_MAGIC "PDST"
+#define PD_TEXT_STRINGS_VERSION 1
+#define PD_TEXT_STRINGS_HEADER_SIZE 16
+#define PD_TEXT_STRINGS_ENTRY_SIZE 8
+
+#endif /* PD_TEXT_STRINGS_FORMAT_H */
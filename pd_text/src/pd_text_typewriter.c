@@ -0,0 +1,266 @@
+#include "pd_text.h"
+
+#include <pd_api.h>
+#include <pd_shorthand.h>
+#include <string.h>
+
+#define TYPEWRITER_DEFAULT_SPEED 1.0f
+#define TYPEWRITER_DEFAULT_PAUSE_FRAMES 15
+#define TYPEWRITER_MIN_PAUSE_CAPACITY 8
+/* Text shorter than this has its pause markers taken out without an extra heap block. */
+#define TYPEWRITER_STORAGE_SIZE 256
+
+static uint32_t character_length(PDStringEncoding encoding, const char *text, uint32_t left) {
+    uint32_t length = 1;
+    if (encoding == k16BitLEEncoding) {
+        length = 2;
+    } else if (encoding == kUTF8Encoding) {
+        uint8_t lead = (uint8_t) text[0];
+        length = lead >= 0xF0 ? 4 : lead >= 0xE0 ? 3 : lead >= 0xC0 ? 2 : 1;
+    }
+    return length < left ? length : left;
+}
+
+static uint32_t count_characters(PDStringEncoding encoding, const char *text, size_t length) {
+    if (encoding == k16BitLEEncoding) return (uint32_t) (length / 2);
+    if (encoding != kUTF8Encoding) return (uint32_t) length;
+    uint32_t count = 0;
+    for (size_t i = 0; i < length; i++) {
+        count += ((uint8_t) text[i] & 0xC0) != 0x80 ? 1 : 0;
+    }
+    return count;
+}
+
+static int32_t line_x(const PDTextLayout *layout, const PDTextLine *line, int32_t x) {
+    if (layout->alignment == kPDTextAlignCenter) return x + ((int32_t) layout->maxWidth - line->width) / 2;
+    if (layout->alignment == kPDTextAlignRight) return x + (int32_t) layout->maxWidth - line->width;
+    return x;
+}
+
+/* Width of the line up to @c end, measuring on from the revealed part when the glyph cache allows. */
+static int width_to(const PDTextTypewriter *typewriter, const char *line, uint32_t end) {
+    PDTextMeasure measure = typewriter->measure;
+    if (pdText_MeasureAppend(&measure, line + typewriter->lineOffset, end - typewriter->lineOffset)) {
+        return pdText_MeasureGetWidth(&measure);
+    }
+    return pdText_GetTextWidthN(typewriter->layout.font, typewriter->layout.encoding, line, end);
+}
+
+static void add_dirty(PDTextTypewriter *typewriter, int32_t x, int32_t y, int32_t width, int32_t height) {
+    PDTextRect *dirty = &typewriter->dirty;
+    if (dirty->width == 0 || dirty->height == 0) {
+        dirty->x = x;
+        dirty->y = y;
+        dirty->width = width;
+        dirty->height = height;
+        return;
+    }
+    int32_t right = dirty->x + dirty->width > x + width ? dirty->x + dirty->width : x + width;
+    int32_t bottom = dirty->y + dirty->height > y + height ? dirty->y + dirty->height : y + height;
+    dirty->x = dirty->x < x ? dirty->x : x;
+    dirty->y = dirty->y < y ? dirty->y : y;
+    dirty->width = right - dirty->x;
+    dirty->height = bottom - dirty->y;
+}
+
+/* Draws the next @c end - lineOffset bytes of the current line where they are in the whole line. */
+static void draw_segment(PDTextTypewriter *typewriter, const PDTextLine *line, uint32_t end, int32_t x, int32_t y) {
+    const PDTextLayout *layout = &typewriter->layout;
+    const char *text = pd_StrBufCStr(&layout->text) + line->start;
+    uint32_t offset = typewriter->lineOffset;
+    uint32_t first = character_length(layout->encoding, text + offset, end - offset);
+    /* Where the first new glyph starts: the width up to and including it, minus its own. */
+    int pen = width_to(typewriter, text, offset + first)
+        - pdText_GetTextWidthN(layout->font, layout->encoding, text + offset, first);
+    int after = width_to(typewriter, text, end);
+
+    int32_t left = line_x(layout, line, x) + pen;
+    int32_t top = y + (int32_t) (typewriter->line * layout->font->height);
+    pd_getPd()->graphics->drawText(
+        text + offset, count_characters(layout->encoding, text + offset, end - offset), layout->encoding, left, top
+    );
+    add_dirty(typewriter, left, top, after > pen ? after - pen : 0, layout->font->height);
+
+    /* Once this fails, width_to measures from the start of the line. */
+    pdText_MeasureAppend(&typewriter->measure, text + offset, end - offset);
+    typewriter->lineOffset = end;
+}
+
+/* Reveals up to @c count characters, stopping at the next pause unless @c skip_pauses is set. */
+static bool reveal(PDTextTypewriter *typewriter, uint32_t count, bool skip_pauses, int32_t x, int32_t y) {
+    PDTextLayout *layout = &typewriter->layout;
+    const char *text = pd_StrBufCStr(&layout->text);
+    bool fontSet = false;
+    while (count > 0 && typewriter->line < layout->lineCount) {
+        const PDTextLine *line = &layout->lines[typewriter->line];
+        if (typewriter->lineOffset == line->length) {
+            typewriter->line++;
+            typewriter->lineOffset = 0;
+            pdText_MeasureBegin(&typewriter->measure, layout->font, layout->encoding);
+            continue;
+        }
+
+        uint32_t position = line->start + typewriter->lineOffset;
+        if (!skip_pauses && typewriter->nextPause < typewriter->pauseCount
+            && typewriter->pauses[typewriter->nextPause] <= position) {
+            while (typewriter->nextPause < typewriter->pauseCount
+                   && typewriter->pauses[typewriter->nextPause] <= position) {
+                typewriter->pauseLeft += typewriter->pauseFrames;
+                typewriter->nextPause++;
+            }
+            typewriter->pending = 0;
+            break;
+        }
+
+        /* Everything up to the end of the line, the next pause or the last character due, in one draw call */
+        uint32_t limit = line->length;
+        if (!skip_pauses && typewriter->nextPause < typewriter->pauseCount
+            && typewriter->pauses[typewriter->nextPause] < line->start + limit) {
+            limit = typewriter->pauses[typewriter->nextPause] - line->start;
+        }
+        uint32_t end = typewriter->lineOffset;
+        while (count > 0 && end < limit) {
+            end += character_length(layout->encoding, text + line->start + end, limit - end);
+            count--;
+        }
+        if (!fontSet) {
+            pd_getPd()->graphics->setFont(layout->font->font);
+            fontSet = true;
+        }
+        draw_segment(typewriter, line, end, x, y);
+    }
+
+    /* Also moves past empty lines at the end, so that the typewriter finishes with its last character. */
+    while (typewriter->line < layout->lineCount && typewriter->lineOffset == layout->lines[typewriter->line].length) {
+        typewriter->line++;
+        typewriter->lineOffset = 0;
+        pdText_MeasureBegin(&typewriter->measure, layout->font, layout->encoding);
+    }
+    typewriter->finished = typewriter->line >= layout->lineCount;
+    return fontSet;
+}
+
+void pdText_TypewriterInit(
+    PDTextTypewriter *typewriter,
+    const Font *font,
+    PDStringEncoding encoding,
+    uint16_t max_width,
+    uint32_t max_lines,
+    PDTextAlignment alignment
+) {
+    pdText_LayoutInit(&typewriter->layout, font, encoding, max_width, max_lines, alignment);
+    typewriter->speed = TYPEWRITER_DEFAULT_SPEED;
+    typewriter->pauseFrames = TYPEWRITER_DEFAULT_PAUSE_FRAMES;
+    typewriter->pauses = NULL;
+    typewriter->pauseCount = 0;
+    typewriter->pauseCapacity = 0;
+    typewriter->nextPause = 0;
+    typewriter->pauseLeft = 0;
+    typewriter->pending = 0;
+    typewriter->line = 0;
+    typewriter->lineOffset = 0;
+    pdText_MeasureBegin(&typewriter->measure, font, encoding);
+    typewriter->finished = true;
+    memset(&typewriter->dirty, 0, sizeof(typewriter->dirty));
+}
+
+bool pdText_TypewriterSetText(PDTextTypewriter *typewriter, const char *text, size_t length) {
+    char storage[TYPEWRITER_STORAGE_SIZE];
+    PDStrBuf sb;
+    pd_StrBufInit(&sb, storage, sizeof(storage));
+    typewriter->pauseCount = 0;
+    bool result = true;
+
+    size_t start = 0;
+    const char *marker;
+    /* 16-bit text can contain the marker byte as half of a character, so it has no markers. */
+    bool markers = typewriter->layout.encoding != k16BitLEEncoding;
+    while (markers && (marker = memchr(text + start, PD_TEXT_TYPEWRITER_PAUSE[0], length - start)) != NULL) {
+        size_t at = (size_t) (marker - text);
+        result = pd_StrBufAppendN(&sb, text + start, at - start) && result;
+        if (typewriter->pauseCount == typewriter->pauseCapacity) {
+            uint32_t capacity = typewriter->pauseCapacity * 2;
+            if (capacity < TYPEWRITER_MIN_PAUSE_CAPACITY) {
+                capacity = TYPEWRITER_MIN_PAUSE_CAPACITY;
+            }
+            uint32_t *pauses = pd_Realloc(typewriter->pauses, sizeof(uint32_t) * capacity);
+            if (pauses != NULL) {
+                typewriter->pauses = pauses;
+                typewriter->pauseCapacity = capacity;
+            }
+        }
+        if (typewriter->pauseCount < typewriter->pauseCapacity) {
+            typewriter->pauses[typewriter->pauseCount++] = (uint32_t) sb.length;
+        } else {
+            result = false;
+        }
+        start = at + 1;
+    }
+    result = pd_StrBufAppendN(&sb, text + start, length - start) && result;
+    result = pdText_LayoutSetText(&typewriter->layout, pd_StrBufCStr(&sb), sb.length) && result;
+    pd_StrBufRelease(&sb);
+
+    typewriter->nextPause = 0;
+    typewriter->pauseLeft = 0;
+    typewriter->pending = 0;
+    typewriter->line = 0;
+    typewriter->lineOffset = 0;
+    pdText_MeasureBegin(&typewriter->measure, typewriter->layout.font, typewriter->layout.encoding);
+    typewriter->finished = typewriter->layout.lineCount == 0;
+    memset(&typewriter->dirty, 0, sizeof(typewriter->dirty));
+    return result;
+}
+
+bool pdText_TypewriterUpdate(PDTextTypewriter *typewriter, int32_t x, int32_t y) {
+    memset(&typewriter->dirty, 0, sizeof(typewriter->dirty));
+    if (typewriter->finished) return false;
+    if (typewriter->pauseLeft > 0) {
+        typewriter->pauseLeft--;
+        return false;
+    }
+    typewriter->pending += typewriter->speed;
+    uint32_t count = (uint32_t) typewriter->pending;
+    typewriter->pending -= (float) count;
+    return reveal(typewriter, count, false, x, y);
+}
+
+bool pdText_TypewriterSkip(PDTextTypewriter *typewriter, int32_t x, int32_t y) {
+    memset(&typewriter->dirty, 0, sizeof(typewriter->dirty));
+    typewriter->nextPause = typewriter->pauseCount;
+    typewriter->pauseLeft = 0;
+    typewriter->pending = 0;
+    return reveal(typewriter, UINT32_MAX, true, x, y);
+}
+
+void pdText_TypewriterDraw(const PDTextTypewriter *typewriter, int32_t x, int32_t y) {
+    const PDTextLayout *layout = &typewriter->layout;
+    if (layout->lineCount == 0) return;
+    PlaydateAPI *pd = pd_getPd();
+    const char *text = pd_StrBufCStr(&layout->text);
+    pd->graphics->setFont(layout->font->font);
+    for (uint32_t i = 0; i <= typewriter->line && i < layout->lineCount; i++) {
+        const PDTextLine *line = &layout->lines[i];
+        uint32_t characters = line->characters;
+        if (i == typewriter->line) {
+            characters = count_characters(layout->encoding, text + line->start, typewriter->lineOffset);
+        }
+        if (characters == 0) continue;
+        pd->graphics->drawText(
+            text + line->start, characters, layout->encoding, line_x(layout, line, x),
+            y + (int32_t) (i * layout->font->height)
+        );
+    }
+}
+
+void pdText_TypewriterRelease(PDTextTypewriter *typewriter) {
+    float speed = typewriter->speed;
+    uint32_t pauseFrames = typewriter->pauseFrames;
+    pdText_LayoutRelease(&typewriter->layout);
+    pd_Free(typewriter->pauses);
+    pdText_TypewriterInit(
+        typewriter, typewriter->layout.font, typewriter->layout.encoding, typewriter->layout.maxWidth,
+        typewriter->layout.maxLines, typewriter->layout.alignment
+    );
+    typewriter->speed = speed;
+    typewriter->pauseFrames = pauseFrames;
+}
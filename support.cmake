@@ -1,10 +1,11 @@
 # This file defines PD_UTILS_LIBS,
 # which has references to all the libraries included in this package.
+# Libraries come before the ones they depend on, so that static linking resolves them.
 set(PD_UTILS_LIBS
         support
-        pd_shorthand
         pd_scene_engine
         pd_text
+        pd_shorthand
 )
 
 set(PD_UTILS_LIBS_SIM)
@@ -0,0 +1,640 @@
+/**
+ * @file pd_prewrap.c
+ *
+ * @brief Host tool that computes the line breaks of a string table ahead of time, for pdText_LoadBreaks.
+ *
+ * Usage: pd_prewrap <string table> <break table> --font [LANG=]FILE ... --width N [--lines N] [--tracking N] [--jobs N]
+ *
+ * The strings are broken with the line breaker of the text library itself, given widths computed from
+ * the glyph widths, kerning and tracking of Playdate .fnt files, so the breaks are the ones
+ * pdText_GetWrappedText finds on device for the same font. Strings are processed in parallel, one thread per core.
+ * See pd_text_breaks_format.h for the output.
+ */
+
+#include <pd_text.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "pd_text_binary.h"
+#include "pd_text_breaks_format.h"
+#include "pd_text_strings_format.h"
+
+#define ASCII_LIMIT 128
+#define MAX_LANGUAGES 32
+#define MAX_FONTS 16
+#define NO_CODEPOINT UINT32_MAX
+#define MISSING_WIDTH INT32_MIN
+
+typedef struct GlyphTag {
+    uint32_t codepoint;
+    int32_t width;
+} Glyph;
+
+typedef struct KerningTag {
+    uint64_t pair;
+    int32_t kerning;
+} Kerning;
+
+/* Metrics of a .fnt file */
+typedef struct FontMetricsTag {
+    const char *path;
+    int32_t tracking;
+    int32_t asciiWidths[ASCII_LIMIT];
+    int16_t asciiKerning[ASCII_LIMIT][ASCII_LIMIT];
+    /* Sorted by codepoint / pair once the file is read */
+    Glyph *glyphs;
+    size_t glyphCount;
+    Kerning *kernings;
+    size_t kerningCount;
+} FontMetrics;
+
+typedef struct LanguageTag {
+    char code[PD_TEXT_LANGUAGE_CODE_SIZE + 1];
+    const uint8_t *entries;
+    const char *blob;
+    uint32_t blobSize;
+    const FontMetrics *font;
+} Language;
+
+typedef struct JobResultTag {
+    uint32_t *breaks;
+    uint32_t breakCount;
+    uint32_t length;
+    uint32_t lines;
+} JobResult;
+
+typedef struct PrewrapTag {
+    Language languages[MAX_LANGUAGES];
+    size_t languageCount;
+    uint32_t stringCount;
+    uint16_t maxWidth;
+    uint16_t maxLines;
+    /* Added to the tracking of the fonts, as set with playdate->graphics->setTextTracking */
+    int32_t tracking;
+    JobResult *results;
+    atomic_size_t nextJob;
+} Prewrap;
+
+/* Incremental measurement of the current line, as the line breaker asks for ever longer lines from the same start. */
+typedef struct LineWidthTag {
+    const FontMetrics *font;
+    int32_t tracking;
+    const char *text;
+    size_t start;
+    size_t end;
+    /* Width of the widest finished segment; lines containing line feeds measure as their widest part, as in the SDK */
+    int32_t widest;
+    int32_t width;
+    size_t count;
+    uint32_t previous;
+} LineWidth;
+
+static void *xrealloc(void *ptr, size_t size) {
+    ptr = realloc(ptr, size);
+    if (ptr == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        exit(1);
+    }
+    return ptr;
+}
+
+static char *read_file(const char *path, size_t *length) {
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        perror(path);
+        return NULL;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    char *data = xrealloc(NULL, size > 0 ? (size_t) size + 1 : 1);
+    *length = fread(data, 1, size > 0 ? (size_t) size : 0, file);
+    data[*length] = '\0';
+    fclose(file);
+    return data;
+}
+
+/* Decodes one UTF-8 sequence; malformed bytes come out one at a time as NO_CODEPOINT. */
+static size_t decode_utf8(const uint8_t *text, size_t remaining, uint32_t *codepoint) {
+    uint8_t lead = text[0];
+    if (lead < 0x80) {
+        *codepoint = lead;
+        return 1;
+    }
+    size_t length = lead >= 0xF0 ? 4 : lead >= 0xE0 ? 3 : lead >= 0xC0 ? 2 : 0;
+    if (length == 0 || length > remaining) {
+        *codepoint = NO_CODEPOINT;
+        return 1;
+    }
+    uint32_t value = lead & (0x7Fu >> length);
+    for (size_t i = 1; i < length; i++) {
+        if ((text[i] & 0xC0) != 0x80) {
+            *codepoint = NO_CODEPOINT;
+            return 1;
+        }
+        value = (value << 6) | (text[i] & 0x3F);
+    }
+    *codepoint = value;
+    return length;
+}
+
+/* ---- .fnt files ---- */
+
+/* Parses the characters of a glyph or kerning line: "space", "U+XXXX" or UTF-8 characters. Returns how many. */
+static size_t parse_characters(const char *token, size_t length, uint32_t codepoints[2]) {
+    if (length == 5 && memcmp(token, "space", 5) == 0) {
+        codepoints[0] = ' ';
+        return 1;
+    }
+    size_t count = 0;
+    size_t i = 0;
+    while (i < length) {
+        uint32_t codepoint;
+        size_t hex = 0;
+        if (length - i > 2 && token[i] == 'U' && token[i + 1] == '+') {
+            while (i + 2 + hex < length && hex < 6 && strchr("0123456789abcdefABCDEF", token[i + 2 + hex]) != NULL) {
+                hex++;
+            }
+        }
+        if (hex >= 4) {
+            /* Only the digits counted, in case a character that looks like a digit follows */
+            char digits[7] = {0};
+            memcpy(digits, token + i + 2, hex);
+            codepoint = (uint32_t) strtoul(digits, NULL, 16);
+            i += 2 + hex;
+        } else {
+            i += decode_utf8((const uint8_t *) token + i, length - i, &codepoint);
+            if (codepoint == NO_CODEPOINT) return 0;
+        }
+        if (count == 2) return 3;
+        codepoints[count++] = codepoint;
+    }
+    return count;
+}
+
+static int compare_glyphs(const void *a, const void *b) {
+    uint32_t left = ((const Glyph *) a)->codepoint;
+    uint32_t right = ((const Glyph *) b)->codepoint;
+    return left < right ? -1 : left > right;
+}
+
+static int compare_kernings(const void *a, const void *b) {
+    uint64_t left = ((const Kerning *) a)->pair;
+    uint64_t right = ((const Kerning *) b)->pair;
+    return left < right ? -1 : left > right;
+}
+
+static bool load_font(FontMetrics *font, const char *path) {
+    size_t length;
+    char *data = read_file(path, &length);
+    if (data == NULL) return false;
+    memset(font, 0, sizeof(FontMetrics));
+    font->path = path;
+    for (size_t i = 0; i < ASCII_LIMIT; i++) {
+        font->asciiWidths[i] = MISSING_WIDTH;
+    }
+    size_t glyphCapacity = 0;
+    size_t kerningCapacity = 0;
+
+    size_t lineNumber = 0;
+    for (char *line = data; line < data + length;) {
+        char *newline = memchr(line, '\n', (size_t) (data + length - line));
+        char *end = newline != NULL ? newline : data + length;
+        char *next = newline != NULL ? newline + 1 : data + length;
+        lineNumber++;
+        if (end > line && end[-1] == '\r') end--;
+        *end = '\0';
+
+        /* A token, then a number after white space for glyphs and kerning pairs; "name=value" for the rest */
+        size_t tokenLength = strcspn(line, " \t");
+        char *value = line + tokenLength;
+        value += strspn(value, " \t");
+        if (tokenLength == 0 || strncmp(line, "--", 2) == 0) {
+            /* Empty line or comment */
+        } else if (*value == '\0') {
+            if (strncmp(line, "tracking=", 9) == 0) {
+                font->tracking = (int32_t) strtol(line + 9, NULL, 10);
+            }
+        } else {
+            char *numberEnd;
+            long number = strtol(value, &numberEnd, 10);
+            uint32_t codepoints[2];
+            size_t count = parse_characters(line, tokenLength, codepoints);
+            if (numberEnd == value || *numberEnd != '\0' || count == 0 || count > 2) {
+                fprintf(stderr, "%s:%zu: skipped unrecognized line\n", path, lineNumber);
+            } else if (count == 1 && codepoints[0] < ASCII_LIMIT) {
+                font->asciiWidths[codepoints[0]] = (int32_t) number;
+            } else if (count == 1) {
+                if (font->glyphCount == glyphCapacity) {
+                    glyphCapacity = glyphCapacity == 0 ? 256 : glyphCapacity * 2;
+                    font->glyphs = xrealloc(font->glyphs, sizeof(Glyph) * glyphCapacity);
+                }
+                font->glyphs[font->glyphCount++] = (Glyph) {codepoints[0], (int32_t) number};
+            } else if (codepoints[0] < ASCII_LIMIT && codepoints[1] < ASCII_LIMIT) {
+                font->asciiKerning[codepoints[0]][codepoints[1]] = (int16_t) number;
+            } else {
+                if (font->kerningCount == kerningCapacity) {
+                    kerningCapacity = kerningCapacity == 0 ? 256 : kerningCapacity * 2;
+                    font->kernings = xrealloc(font->kernings, sizeof(Kerning) * kerningCapacity);
+                }
+                uint64_t pair = ((uint64_t) codepoints[0] << 32) | codepoints[1];
+                font->kernings[font->kerningCount++] = (Kerning) {pair, (int32_t) number};
+            }
+        }
+        line = next;
+    }
+    free(data);
+    if (font->glyphs != NULL) {
+        qsort(font->glyphs, font->glyphCount, sizeof(Glyph), compare_glyphs);
+    }
+    if (font->kernings != NULL) {
+        qsort(font->kernings, font->kerningCount, sizeof(Kerning), compare_kernings);
+    }
+    return true;
+}
+
+/* Width of a glyph; MISSING_WIDTH if the font does not have it. */
+static int32_t width_of(const FontMetrics *font, uint32_t codepoint) {
+    if (codepoint < ASCII_LIMIT) return font->asciiWidths[codepoint];
+    Glyph key = {codepoint, 0};
+    const Glyph *glyph = font->glyphCount > 0
+                         ? bsearch(&key, font->glyphs, font->glyphCount, sizeof(Glyph), compare_glyphs)
+                         : NULL;
+    return glyph != NULL ? glyph->width : MISSING_WIDTH;
+}
+
+static int32_t kerning_of(const FontMetrics *font, uint32_t left, uint32_t right) {
+    if (left < ASCII_LIMIT && right < ASCII_LIMIT) return font->asciiKerning[left][right];
+    Kerning key = {((uint64_t) left << 32) | right, 0};
+    const Kerning *kerning = font->kerningCount > 0
+                             ? bsearch(&key, font->kernings, font->kerningCount, sizeof(Kerning), compare_kernings)
+                             : NULL;
+    return kerning != NULL ? kerning->kerning : 0;
+}
+
+/* ---- Measuring and breaking ---- */
+
+static int line_width(void *userdata, size_t start, size_t end) {
+    LineWidth *line = userdata;
+    if (line->start != start || line->end > end) {
+        line->start = start;
+        line->end = start;
+        line->widest = 0;
+        line->width = 0;
+        line->count = 0;
+        line->previous = NO_CODEPOINT;
+    }
+    const uint8_t *bytes = (const uint8_t *) line->text;
+    int32_t tracking = line->font->tracking + line->tracking;
+    while (line->end < end) {
+        uint32_t codepoint;
+        line->end += decode_utf8(bytes + line->end, end - line->end, &codepoint);
+        if (codepoint == '\n') {
+            if (line->width > line->widest) {
+                line->widest = line->width;
+            }
+            line->width = 0;
+            line->count = 0;
+            line->previous = NO_CODEPOINT;
+            continue;
+        }
+        int32_t width = codepoint == NO_CODEPOINT ? MISSING_WIDTH : width_of(line->font, codepoint);
+        /* Glyphs missing from the font take no room; they have been reported already. */
+        line->width += width == MISSING_WIDTH ? 0 : width;
+        if (line->count > 0) {
+            line->width += tracking;
+            if (line->previous != NO_CODEPOINT && codepoint != NO_CODEPOINT) {
+                line->width += kerning_of(line->font, line->previous, codepoint);
+            }
+        }
+        line->previous = codepoint;
+        line->count++;
+    }
+    return line->width > line->widest ? line->width : line->widest;
+}
+
+typedef struct CollectTag {
+    uint32_t *breaks;
+    uint32_t count;
+    uint32_t capacity;
+} Collect;
+
+static void collect_break(void *userdata, size_t line_end, size_t next_line_start) {
+    Collect *collect = userdata;
+    if (collect->count == collect->capacity) {
+        collect->capacity = collect->capacity == 0 ? 8 : collect->capacity * 2;
+        collect->breaks = xrealloc(collect->breaks, sizeof(uint32_t) * collect->capacity);
+    }
+    uint32_t skip = (uint32_t) (next_line_start - line_end);
+    collect->breaks[collect->count++] = ((uint32_t) line_end << PD_TEXT_BREAKS_SKIP_BITS) | skip;
+}
+
+/* Breaks one string the way pdText_GetWrappedText does with UTF-8 text. */
+static void prewrap_string(const Prewrap *prewrap, const Language *language, uint32_t id, JobResult *result) {
+    const uint8_t *entry = language->entries + (size_t) id * PD_TEXT_STRINGS_ENTRY_SIZE;
+    const char *text = language->blob + pdText_GetU32(entry);
+    uint32_t length = pdText_GetU32(entry + 4);
+    Collect collect = {NULL, 0, 0};
+    uint32_t lines = 1;
+    /* With a single line allowed, pdText_GetWrappedText does not wrap at all. */
+    if (prewrap->maxLines > 1) {
+        LineWidth line = {language->font, prewrap->tracking, text, SIZE_MAX, 0, 0, 0, 0, NO_CODEPOINT};
+        PDTextLineBreaker breaker;
+        pdText_LineBreakerInit(
+            &breaker, text, length, NULL, prewrap->maxLines, prewrap->maxWidth, kUTF8Encoding, kPDTextLineBreakUnicode
+        );
+        pdText_LineBreakerSetWidthFunction(&breaker, line_width, &line);
+        size_t lineEnd;
+        size_t nextLineStart;
+        while (pdText_LineBreakerNext(&breaker, &lineEnd, &nextLineStart)) {
+            collect_break(&collect, lineEnd, nextLineStart);
+        }
+        lines = breaker.state.lineCount + 1;
+    }
+    result->breaks = collect.breaks;
+    result->breakCount = collect.count;
+    result->length = length;
+    result->lines = lines;
+}
+
+static void *worker(void *userdata) {
+    Prewrap *prewrap = userdata;
+    size_t jobCount = prewrap->languageCount * prewrap->stringCount;
+    for (;;) {
+        size_t job = atomic_fetch_add(&prewrap->nextJob, 1);
+        if (job >= jobCount) return NULL;
+        const Language *language = &prewrap->languages[job / prewrap->stringCount];
+        prewrap_string(prewrap, language, (uint32_t) (job % prewrap->stringCount), &prewrap->results[job]);
+    }
+}
+
+/* ---- Input and output ---- */
+
+static bool read_string_table(Prewrap *prewrap, const uint8_t *data, size_t size) {
+    if (size < PD_TEXT_STRINGS_HEADER_SIZE || memcmp(data, PD_TEXT_STRINGS_MAGIC, 4) != 0
+        || pdText_GetU16(data + 4) != PD_TEXT_STRINGS_VERSION) {
+        fprintf(stderr, "Not a string table, or an unsupported version\n");
+        return false;
+    }
+    size_t languageCount = pdText_GetU16(data + 6);
+    prewrap->stringCount = pdText_GetU32(data + 8);
+    if (languageCount > MAX_LANGUAGES
+        || size < PD_TEXT_STRINGS_HEADER_SIZE + languageCount * PD_TEXT_LANGUAGE_ENTRY_SIZE) {
+        fprintf(stderr, "Malformed string table\n");
+        return false;
+    }
+    for (size_t i = 0; i < languageCount; i++) {
+        const uint8_t *entry = data + PD_TEXT_STRINGS_HEADER_SIZE + i * PD_TEXT_LANGUAGE_ENTRY_SIZE;
+        Language *language = &prewrap->languages[i];
+        memcpy(language->code, entry, PD_TEXT_LANGUAGE_CODE_SIZE);
+        language->code[PD_TEXT_LANGUAGE_CODE_SIZE] = '\0';
+        uint32_t offset = pdText_GetU32(entry + PD_TEXT_LANGUAGE_CODE_SIZE);
+        uint32_t sectionSize = pdText_GetU32(entry + PD_TEXT_LANGUAGE_CODE_SIZE + 4);
+        size_t entriesSize = (size_t) prewrap->stringCount * PD_TEXT_STRINGS_ENTRY_SIZE;
+        if ((size_t) offset + sectionSize > size || sectionSize <= entriesSize) {
+            fprintf(stderr, "Malformed string table\n");
+            return false;
+        }
+        language->entries = data + offset;
+        language->blob = (const char *) data + offset + entriesSize;
+        language->blobSize = (uint32_t) (sectionSize - entriesSize);
+        for (uint32_t id = 0; id < prewrap->stringCount; id++) {
+            const uint8_t *string = language->entries + (size_t) id * PD_TEXT_STRINGS_ENTRY_SIZE;
+            uint32_t stringOffset = pdText_GetU32(string);
+            uint32_t length = pdText_GetU32(string + 4);
+            if (stringOffset >= language->blobSize || length >= language->blobSize - stringOffset) {
+                fprintf(stderr, "Malformed string table\n");
+                return false;
+            }
+        }
+    }
+    prewrap->languageCount = languageCount;
+    return true;
+}
+
+/* Lists the characters of the strings that the font of their language does not have. */
+static void report_missing_glyphs(const Prewrap *prewrap) {
+    for (size_t l = 0; l < prewrap->languageCount; l++) {
+        const Language *language = &prewrap->languages[l];
+        uint32_t reported[32];
+        size_t reportedCount = 0;
+        for (uint32_t id = 0; id < prewrap->stringCount; id++) {
+            const uint8_t *entry = language->entries + (size_t) id * PD_TEXT_STRINGS_ENTRY_SIZE;
+            const uint8_t *text = (const uint8_t *) language->blob + pdText_GetU32(entry);
+            size_t length = pdText_GetU32(entry + 4);
+            for (size_t i = 0; i < length;) {
+                uint32_t codepoint;
+                i += decode_utf8(text + i, length - i, &codepoint);
+                if (codepoint == '\n' || codepoint == NO_CODEPOINT) continue;
+                if (width_of(language->font, codepoint) != MISSING_WIDTH) continue;
+                bool known = false;
+                for (size_t r = 0; r < reportedCount && !known; r++) {
+                    known = reported[r] == codepoint;
+                }
+                if (known) continue;
+                if (reportedCount < sizeof(reported) / sizeof(reported[0])) {
+                    reported[reportedCount++] = codepoint;
+                    fprintf(stderr, "Warning: %s: U+%04X (string %u) is not in %s\n",
+                            language->code, (unsigned) codepoint, (unsigned) id, language->font->path);
+                }
+            }
+        }
+    }
+}
+
+static bool write_breaks(const Prewrap *prewrap, const char *path) {
+    size_t headSize = PD_TEXT_BREAKS_HEADER_SIZE + prewrap->languageCount * PD_TEXT_LANGUAGE_ENTRY_SIZE;
+    uint8_t *head = xrealloc(NULL, headSize);
+    memset(head, 0, headSize);
+    memcpy(head, PD_TEXT_BREAKS_MAGIC, 4);
+    pdText_PutU16(head + 4, PD_TEXT_BREAKS_VERSION);
+    pdText_PutU16(head + 6, (uint32_t) prewrap->languageCount);
+    pdText_PutU32(head + 8, prewrap->stringCount);
+    pdText_PutU16(head + 12, prewrap->maxWidth);
+    pdText_PutU16(head + 14, prewrap->maxLines);
+
+    /* Sections are built one after the other, each as a list of u32 */
+    uint32_t **sections = xrealloc(NULL, sizeof(uint32_t *) * (prewrap->languageCount + 1));
+    size_t *sectionWords = xrealloc(NULL, sizeof(size_t) * (prewrap->languageCount + 1));
+    size_t offset = headSize;
+    for (size_t l = 0; l < prewrap->languageCount; l++) {
+        const JobResult *results = prewrap->results + l * prewrap->stringCount;
+        size_t breakCount = 0;
+        for (uint32_t id = 0; id < prewrap->stringCount; id++) {
+            breakCount += results[id].breakCount;
+        }
+        size_t entryWords = ((size_t) prewrap->stringCount + 1) * 3;
+        uint32_t *words = xrealloc(NULL, sizeof(uint32_t) * (entryWords + breakCount));
+        size_t breakIndex = 0;
+        for (uint32_t id = 0; id < prewrap->stringCount; id++) {
+            words[id * 3] = (uint32_t) breakIndex;
+            words[id * 3 + 1] = results[id].length;
+            words[id * 3 + 2] = results[id].lines;
+            for (uint32_t i = 0; i < results[id].breakCount; i++) {
+                words[entryWords + breakIndex++] = results[id].breaks[i];
+            }
+        }
+        words[entryWords - 3] = (uint32_t) breakIndex;
+        words[entryWords - 2] = 0;
+        words[entryWords - 1] = 0;
+        sections[l] = words;
+        sectionWords[l] = entryWords + breakCount;
+
+        uint8_t *entry = head + PD_TEXT_BREAKS_HEADER_SIZE + l * PD_TEXT_LANGUAGE_ENTRY_SIZE;
+        pdText_PutLanguageEntry(entry, prewrap->languages[l].code, (uint32_t) offset, (uint32_t) (sectionWords[l] * 4));
+        offset += sectionWords[l] * 4;
+        printf("%s: %zu breaks, %zu bytes\n", prewrap->languages[l].code, breakCount, sectionWords[l] * 4);
+    }
+
+    FILE *file = fopen(path, "wb");
+    bool written = file != NULL && fwrite(head, 1, headSize, file) == headSize;
+    for (size_t l = 0; l < prewrap->languageCount && written; l++) {
+        for (size_t i = 0; i < sectionWords[l] && written; i++) {
+            uint8_t word[4];
+            pdText_PutU32(word, sections[l][i]);
+            written = fwrite(word, 1, 4, file) == 4;
+        }
+    }
+    if (file != NULL) {
+        written = fclose(file) == 0 && written;
+    }
+    if (!written) {
+        perror(path);
+    }
+    for (size_t l = 0; l < prewrap->languageCount; l++) {
+        free(sections[l]);
+    }
+    free(sections);
+    free(sectionWords);
+    free(head);
+    return written;
+}
+
+static void usage(const char *name) {
+    fprintf(stderr,
+            "Usage: %s <string table> <break table> --font [LANG=]FILE ... --width N [--lines N] [--tracking N] "
+            "[--jobs N]\n",
+            name);
+}
+
+int main(int argc, char **argv) {
+    static FontMetrics fonts[MAX_FONTS];
+    const char *fontLanguages[MAX_FONTS];
+    size_t fontCount = 0;
+    const char *paths[2] = {NULL, NULL};
+    int pathCount = 0;
+    long width = 0;
+    long lines = 0xFFFF;
+    long tracking = 0;
+    long jobs = sysconf(_SC_NPROCESSORS_ONLN);
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--font") == 0 && hasValue && fontCount < MAX_FONTS) {
+            char *spec = argv[++i];
+            char *equals = strchr(spec, '=');
+            fontLanguages[fontCount] = NULL;
+            if (equals != NULL) {
+                *equals = '\0';
+                fontLanguages[fontCount] = spec;
+                spec = equals + 1;
+            }
+            if (!load_font(&fonts[fontCount], spec)) return 1;
+            fontCount++;
+        } else if (strcmp(argv[i], "--width") == 0 && hasValue) {
+            width = strtol(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--lines") == 0 && hasValue) {
+            lines = strtol(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--tracking") == 0 && hasValue) {
+            tracking = strtol(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--jobs") == 0 && hasValue) {
+            jobs = strtol(argv[++i], NULL, 10);
+        } else if (argv[i][0] != '-' && pathCount < 2) {
+            paths[pathCount++] = argv[i];
+        } else {
+            pathCount = 0;
+            break;
+        }
+    }
+    if (pathCount != 2 || fontCount == 0 || width <= 0 || width > UINT16_MAX || lines <= 0 || lines > UINT16_MAX) {
+        usage(argv[0]);
+        return 2;
+    }
+    if (jobs < 1) {
+        jobs = 1;
+    }
+
+    size_t size;
+    char *data = read_file(paths[0], &size);
+    if (data == NULL) return 1;
+    static Prewrap prewrap;
+    prewrap.maxWidth = (uint16_t) width;
+    prewrap.maxLines = (uint16_t) lines;
+    prewrap.tracking = (int32_t) tracking;
+    if (!read_string_table(&prewrap, (const uint8_t *) data, size)) {
+        free(data);
+        return 1;
+    }
+
+    /* Each language takes the font named for it, or else the first font named without a language. */
+    for (size_t l = 0; l < prewrap.languageCount; l++) {
+        Language *language = &prewrap.languages[l];
+        for (size_t f = 0; f < fontCount && language->font == NULL; f++) {
+            if (fontLanguages[f] != NULL && strcmp(fontLanguages[f], language->code) == 0) {
+                language->font = &fonts[f];
+            }
+        }
+        for (size_t f = 0; f < fontCount && language->font == NULL; f++) {
+            if (fontLanguages[f] == NULL) {
+                language->font = &fonts[f];
+            }
+        }
+        if (language->font == NULL) {
+            fprintf(stderr, "No font for \"%s\"\n", language->code);
+            free(data);
+            return 2;
+        }
+    }
+    report_missing_glyphs(&prewrap);
+
+    size_t jobCount = prewrap.languageCount * prewrap.stringCount;
+    prewrap.results = xrealloc(NULL, sizeof(JobResult) * (jobCount > 0 ? jobCount : 1));
+    atomic_init(&prewrap.nextJob, 0);
+    if ((size_t) jobs > jobCount) {
+        jobs = jobCount > 0 ? (long) jobCount : 1;
+    }
+    pthread_t *threads = xrealloc(NULL, sizeof(pthread_t) * (size_t) jobs);
+    long started = 0;
+    while (started < jobs && pthread_create(&threads[started], NULL, worker, &prewrap) == 0) {
+        started++;
+    }
+    if (started == 0) {
+        /* No threads to be had; do the work here. */
+        worker(&prewrap);
+    }
+    for (long i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    free(threads);
+
+    bool written = write_breaks(&prewrap, paths[1]);
+    if (written) {
+        printf("%u strings in %zu languages, on %ld threads\n", prewrap.stringCount, prewrap.languageCount,
+               started > 0 ? started : 1);
+    }
+    for (size_t i = 0; i < jobCount; i++) {
+        free(prewrap.results[i].breaks);
+    }
+    free(prewrap.results);
+    for (size_t f = 0; f < fontCount; f++) {
+        free(fonts[f].glyphs);
+        free(fonts[f].kernings);
+    }
+    free(data);
+    return written ? 0 : 1;
+}
@@ -0,0 +1,168 @@
+/**
+ * @file pd_script_index.c
+ *
+ * @brief Host tool that turns a plain text script into an indexed script file for pdText_ScriptOpen.
+ *
+ * Usage: pd_script_index <text file> <script file>
+ *
+ * Pages are separated by one or more empty lines; the lines of a page are kept as they are,
+ * without their line feeds ("\r\n" is taken as "\n"). See pd_text_script_format.h for the output.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pd_text_binary.h"
+#include "pd_text_script_format.h"
+
+typedef struct PageTag {
+    uint32_t offset;
+    uint32_t firstLine;
+} Page;
+
+typedef struct ScriptTag {
+    /* Pages one after the other, as they are written after the page table */
+    char *text;
+    size_t length;
+    Page *pages;
+    size_t pageCount;
+    size_t pageCapacity;
+    uint32_t lineCount;
+    size_t longestPage;
+} Script;
+
+static void *xrealloc(void *ptr, size_t size) {
+    ptr = realloc(ptr, size);
+    if (ptr == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        exit(1);
+    }
+    return ptr;
+}
+
+/* Starts a page at the current end of the text; offsets are fixed up once the size of the table is known. */
+static void begin_page(Script *script) {
+    if (script->pageCount == script->pageCapacity) {
+        script->pageCapacity = script->pageCapacity == 0 ? 64 : script->pageCapacity * 2;
+        script->pages = xrealloc(script->pages, sizeof(Page) * script->pageCapacity);
+    }
+    script->pages[script->pageCount].offset = (uint32_t) script->length;
+    script->pages[script->pageCount].firstLine = script->lineCount;
+    script->pageCount++;
+}
+
+static void end_page(Script *script) {
+    if (script->pageCount == 0) return;
+    size_t length = script->length - script->pages[script->pageCount - 1].offset;
+    if (length > script->longestPage) {
+        script->longestPage = length;
+    }
+}
+
+static void build(Script *script, const char *input, size_t length) {
+    memset(script, 0, sizeof(Script));
+    script->text = xrealloc(NULL, length + 1);
+    bool inPage = false;
+    size_t start = 0;
+    while (start < length) {
+        const char *newline = memchr(input + start, '\n', length - start);
+        size_t end = newline == NULL ? length : (size_t) (newline - input);
+        size_t lineLength = end - start;
+        if (lineLength > 0 && input[start + lineLength - 1] == '\r') {
+            lineLength--;
+        }
+        if (lineLength == 0) {
+            /* An empty line ends the page. */
+            if (inPage) {
+                end_page(script);
+                inPage = false;
+            }
+        } else {
+            if (!inPage) {
+                begin_page(script);
+                inPage = true;
+            } else {
+                script->text[script->length++] = '\n';
+            }
+            memcpy(script->text + script->length, input + start, lineLength);
+            script->length += lineLength;
+            script->lineCount++;
+        }
+        start = end + 1;
+    }
+    if (inPage) {
+        end_page(script);
+    }
+}
+
+static bool write_script(const Script *script, const char *path) {
+    size_t tableSize = (script->pageCount + 1) * PD_TEXT_SCRIPT_ENTRY_SIZE;
+    size_t dataStart = PD_TEXT_SCRIPT_HEADER_SIZE + tableSize;
+    if (dataStart + script->length > UINT32_MAX) {
+        fprintf(stderr, "The script is too large\n");
+        return false;
+    }
+    uint8_t *head = xrealloc(NULL, dataStart);
+    memcpy(head, PD_TEXT_SCRIPT_MAGIC, 4);
+    pdText_PutU16(head + 4, PD_TEXT_SCRIPT_VERSION);
+    pdText_PutU16(head + 6, 0);
+    pdText_PutU32(head + 8, (uint32_t) script->pageCount);
+    pdText_PutU32(head + 12, script->lineCount);
+    for (size_t i = 0; i <= script->pageCount; i++) {
+        uint8_t *entry = head + PD_TEXT_SCRIPT_HEADER_SIZE + i * PD_TEXT_SCRIPT_ENTRY_SIZE;
+        bool last = i == script->pageCount;
+        pdText_PutU32(entry, (uint32_t) (dataStart + (last ? script->length : script->pages[i].offset)));
+        pdText_PutU32(entry + 4, last ? script->lineCount : script->pages[i].firstLine);
+    }
+
+    FILE *file = fopen(path, "wb");
+    if (file == NULL) {
+        perror(path);
+        free(head);
+        return false;
+    }
+    bool written = fwrite(head, 1, dataStart, file) == dataStart
+                   && fwrite(script->text, 1, script->length, file) == script->length;
+    written = fclose(file) == 0 && written;
+    free(head);
+    if (!written) {
+        perror(path);
+    }
+    return written;
+}
+
+int main(int argc, char **argv) {
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s <text file> <script file>\n", argv[0]);
+        return 2;
+    }
+
+    FILE *file = fopen(argv[1], "rb");
+    if (file == NULL) {
+        perror(argv[1]);
+        return 1;
+    }
+    fseek(file, 0, SEEK_END);
+    long length = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    char *input = xrealloc(NULL, length > 0 ? (size_t) length : 1);
+    size_t read = fread(input, 1, (size_t) length, file);
+    fclose(file);
+
+    Script script;
+    build(&script, input, read);
+    free(input);
+    bool written = write_script(&script, argv[2]);
+    if (written) {
+        printf(
+            "%zu pages, %u lines, %zu bytes of text; the longest page takes %zu bytes (twice that with prefetching)\n",
+            script.pageCount, script.lineCount, script.length, script.longestPage + 1
+        );
+    }
+    free(script.text);
+    free(script.pages);
+    return written ? 0 : 1;
+}
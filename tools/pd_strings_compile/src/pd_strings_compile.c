@@ -0,0 +1,675 @@
+/**
+ * @file pd_strings_compile.c
+ *
+ * @brief Host tool that compiles translated strings into a string table for pdText_LoadStrings.
+ *
+ * Usage: pd_strings_compile <CSV or JSON file> <string table> [--header FILE] [--prefix PREFIX]
+ *
+ * CSV input: the first row holds a header cell for the keys, then one language code per column;
+ * every other row holds a key and its strings. Fields may be quoted as in RFC 4180.
+ * JSON input: an object with one object per language code, mapping keys to strings.
+ *
+ * Keys are numbered in the order they first appear; a string missing in a language falls back to the first language.
+ * See pd_text_strings_format.h for the output.
+ */
+
+#include <ctype.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pd_text_binary.h"
+#include "pd_text_strings_format.h"
+
+#define MAX_LANGUAGES 32
+
+typedef struct TableTag {
+    char *languages[MAX_LANGUAGES];
+    size_t languageCount;
+    char **keys;
+    /* values[key * MAX_LANGUAGES + language]; NULL when missing */
+    char **values;
+    size_t keyCount;
+    size_t keyCapacity;
+} Table;
+
+typedef struct BufferTag {
+    char *data;
+    size_t length;
+    size_t capacity;
+} Buffer;
+
+static void *xrealloc(void *ptr, size_t size) {
+    ptr = realloc(ptr, size);
+    if (ptr == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        exit(1);
+    }
+    return ptr;
+}
+
+static void buffer_append(Buffer *buffer, const void *data, size_t length) {
+    if (buffer->length + length + 1 > buffer->capacity) {
+        while (buffer->length + length + 1 > buffer->capacity) {
+            buffer->capacity = buffer->capacity == 0 ? 256 : buffer->capacity * 2;
+        }
+        buffer->data = xrealloc(buffer->data, buffer->capacity);
+    }
+    memcpy(buffer->data + buffer->length, data, length);
+    buffer->length += length;
+    buffer->data[buffer->length] = '\0';
+}
+
+static void buffer_append_char(Buffer *buffer, char c) {
+    buffer_append(buffer, &c, 1);
+}
+
+/* Takes the contents of the buffer as a string and empties the buffer. */
+static char *buffer_take(Buffer *buffer) {
+    char *string = buffer->data != NULL ? buffer->data : strdup("");
+    if (string == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        exit(1);
+    }
+    memset(buffer, 0, sizeof(Buffer));
+    return string;
+}
+
+static bool add_language(Table *table, char *code) {
+    if (code[0] == '\0' || strlen(code) > PD_TEXT_LANGUAGE_CODE_SIZE) {
+        fprintf(stderr, "Invalid language code \"%s\" (1 to %d bytes)\n", code, PD_TEXT_LANGUAGE_CODE_SIZE);
+        return false;
+    }
+    for (size_t i = 0; i < table->languageCount; i++) {
+        if (strcmp(table->languages[i], code) == 0) {
+            fprintf(stderr, "Duplicate language \"%s\"\n", code);
+            return false;
+        }
+    }
+    if (table->languageCount == MAX_LANGUAGES) {
+        fprintf(stderr, "Too many languages (at most %d)\n", MAX_LANGUAGES);
+        return false;
+    }
+    table->languages[table->languageCount++] = code;
+    return true;
+}
+
+/* Returns the index of the key, adding it if it is new. */
+static size_t find_key(Table *table, const char *key, bool *added) {
+    for (size_t i = 0; i < table->keyCount; i++) {
+        if (strcmp(table->keys[i], key) == 0) {
+            *added = false;
+            return i;
+        }
+    }
+    if (table->keyCount == table->keyCapacity) {
+        table->keyCapacity = table->keyCapacity == 0 ? 64 : table->keyCapacity * 2;
+        table->keys = xrealloc(table->keys, sizeof(char *) * table->keyCapacity);
+        table->values = xrealloc(table->values, sizeof(char *) * table->keyCapacity * MAX_LANGUAGES);
+    }
+    table->keys[table->keyCount] = strdup(key);
+    if (table->keys[table->keyCount] == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        exit(1);
+    }
+    memset(table->values + table->keyCount * MAX_LANGUAGES, 0, sizeof(char *) * MAX_LANGUAGES);
+    *added = true;
+    return table->keyCount++;
+}
+
+/* ---- CSV ---- */
+
+/* Reads one field; returns false at the end of the input. Sets *end_of_row after the last field of a row. */
+static bool csv_field(const char **cursor, const char *end, Buffer *field, bool *end_of_row) {
+    const char *p = *cursor;
+    if (p >= end) return false;
+    if (*p == '"') {
+        p++;
+        while (p < end) {
+            if (*p == '"') {
+                if (p + 1 < end && p[1] == '"') {
+                    buffer_append_char(field, '"');
+                    p += 2;
+                    continue;
+                }
+                p++;
+                break;
+            }
+            buffer_append_char(field, *p++);
+        }
+    }
+    /* Unquoted part, or whatever follows the closing quote */
+    while (p < end && *p != ',' && *p != '\n' && *p != '\r') {
+        buffer_append_char(field, *p++);
+    }
+    *end_of_row = p >= end || *p != ',';
+    if (p < end && *p == '\r') p++;
+    if (p < end) p++;
+    *cursor = p;
+    return true;
+}
+
+static bool parse_csv(Table *table, const char *input, size_t length) {
+    const char *cursor = input;
+    const char *end = input + length;
+    Buffer field = {0};
+    bool endOfRow = false;
+
+    /* Header row; its first cell only names the key column. */
+    if (!csv_field(&cursor, end, &field, &endOfRow)) {
+        fprintf(stderr, "Empty input\n");
+        return false;
+    }
+    free(buffer_take(&field));
+    while (!endOfRow && csv_field(&cursor, end, &field, &endOfRow)) {
+        if (!add_language(table, buffer_take(&field))) return false;
+    }
+    if (table->languageCount == 0) {
+        fprintf(stderr, "The header row names no language\n");
+        return false;
+    }
+
+    size_t row = 1;
+    while (csv_field(&cursor, end, &field, &endOfRow)) {
+        row++;
+        char *key = buffer_take(&field);
+        if (key[0] == '\0' && endOfRow) {
+            /* Empty row */
+            free(key);
+            continue;
+        }
+        bool added;
+        size_t index = find_key(table, key, &added);
+        if (!added) {
+            fprintf(stderr, "Row %zu: duplicate key \"%s\"\n", row, key);
+            free(key);
+            return false;
+        }
+        free(key);
+        for (size_t column = 0; !endOfRow && csv_field(&cursor, end, &field, &endOfRow); column++) {
+            char *value = buffer_take(&field);
+            if (column >= table->languageCount || value[0] == '\0') {
+                free(value);
+                continue;
+            }
+            table->values[index * MAX_LANGUAGES + column] = value;
+        }
+    }
+    return true;
+}
+
+/* ---- JSON ---- */
+
+typedef struct JsonTag {
+    const char *p;
+    const char *end;
+} Json;
+
+static void json_skip_space(Json *json) {
+    while (json->p < json->end && isspace((unsigned char) *json->p)) {
+        json->p++;
+    }
+}
+
+static bool json_expect(Json *json, char c) {
+    json_skip_space(json);
+    if (json->p >= json->end || *json->p != c) {
+        fprintf(stderr, "JSON: expected '%c'\n", c);
+        return false;
+    }
+    json->p++;
+    return true;
+}
+
+static bool json_hex4(Json *json, uint32_t *value) {
+    if (json->end - json->p < 4) return false;
+    *value = 0;
+    for (int i = 0; i < 4; i++) {
+        char c = *json->p++;
+        *value <<= 4;
+        if (c >= '0' && c <= '9') *value |= (uint32_t) (c - '0');
+        else if (c >= 'a' && c <= 'f') *value |= (uint32_t) (c - 'a' + 10);
+        else if (c >= 'A' && c <= 'F') *value |= (uint32_t) (c - 'A' + 10);
+        else return false;
+    }
+    return true;
+}
+
+static void append_utf8(Buffer *buffer, uint32_t code_point) {
+    char out[4];
+    size_t length;
+    if (code_point < 0x80) {
+        out[0] = (char) code_point;
+        length = 1;
+    } else if (code_point < 0x800) {
+        out[0] = (char) (0xC0 | (code_point >> 6));
+        out[1] = (char) (0x80 | (code_point & 0x3F));
+        length = 2;
+    } else if (code_point < 0x10000) {
+        out[0] = (char) (0xE0 | (code_point >> 12));
+        out[1] = (char) (0x80 | ((code_point >> 6) & 0x3F));
+        out[2] = (char) (0x80 | (code_point & 0x3F));
+        length = 3;
+    } else {
+        out[0] = (char) (0xF0 | (code_point >> 18));
+        out[1] = (char) (0x80 | ((code_point >> 12) & 0x3F));
+        out[2] = (char) (0x80 | ((code_point >> 6) & 0x3F));
+        out[3] = (char) (0x80 | (code_point & 0x3F));
+        length = 4;
+    }
+    buffer_append(buffer, out, length);
+}
+
+static char *json_string(Json *json) {
+    if (!json_expect(json, '"')) return NULL;
+    Buffer buffer = {0};
+    while (json->p < json->end && *json->p != '"') {
+        char c = *json->p++;
+        if (c != '\\') {
+            buffer_append_char(&buffer, c);
+            continue;
+        }
+        if (json->p >= json->end) break;
+        c = *json->p++;
+        uint32_t code_point;
+        switch (c) {
+            case 'n': buffer_append_char(&buffer, '\n'); break;
+            case 't': buffer_append_char(&buffer, '\t'); break;
+            case 'r': buffer_append_char(&buffer, '\r'); break;
+            case 'b': buffer_append_char(&buffer, '\b'); break;
+            case 'f': buffer_append_char(&buffer, '\f'); break;
+            case 'u':
+                if (!json_hex4(json, &code_point)) {
+                    fprintf(stderr, "JSON: invalid \\u escape\n");
+                    free(buffer.data);
+                    return NULL;
+                }
+                if (code_point >= 0xD800 && code_point < 0xDC00) {
+                    /* High surrogate; the low one must follow. */
+                    uint32_t low;
+                    if (json->end - json->p < 2 || json->p[0] != '\\' || json->p[1] != 'u'
+                        || (json->p += 2, !json_hex4(json, &low)) || low < 0xDC00 || low >= 0xE000) {
+                        fprintf(stderr, "JSON: unpaired surrogate\n");
+                        free(buffer.data);
+                        return NULL;
+                    }
+                    code_point = 0x10000 + ((code_point - 0xD800) << 10) + (low - 0xDC00);
+                }
+                append_utf8(&buffer, code_point);
+                break;
+            default:
+                /* \" \\ \/ */
+                buffer_append_char(&buffer, c);
+                break;
+        }
+    }
+    if (json->p >= json->end) {
+        fprintf(stderr, "JSON: unterminated string\n");
+        free(buffer.data);
+        return NULL;
+    }
+    json->p++;
+    return buffer_take(&buffer);
+}
+
+/* Calls back for each member of an object, positioned at its value. */
+static bool json_object(Json *json, bool (*member)(Json *json, char *name, void *userdata), void *userdata) {
+    if (!json_expect(json, '{')) return false;
+    json_skip_space(json);
+    if (json->p < json->end && *json->p == '}') {
+        json->p++;
+        return true;
+    }
+    for (;;) {
+        char *name = json_string(json);
+        if (name == NULL || !json_expect(json, ':') || !member(json, name, userdata)) return false;
+        json_skip_space(json);
+        if (json->p < json->end && *json->p == ',') {
+            json->p++;
+            continue;
+        }
+        return json_expect(json, '}');
+    }
+}
+
+typedef struct LanguageMembersTag {
+    Table *table;
+    size_t language;
+} LanguageMembers;
+
+static bool json_string_member(Json *json, char *name, void *userdata) {
+    LanguageMembers *members = userdata;
+    bool added;
+    size_t index = find_key(members->table, name, &added);
+    char *value = json_string(json);
+    if (value == NULL) {
+        fprintf(stderr, "JSON: the value of \"%s\" is not a string\n", name);
+        free(name);
+        return false;
+    }
+    char **slot = &members->table->values[index * MAX_LANGUAGES + members->language];
+    if (*slot != NULL) {
+        fprintf(stderr, "JSON: duplicate key \"%s\" in \"%s\"\n", name, members->table->languages[members->language]);
+        free(name);
+        free(value);
+        return false;
+    }
+    free(name);
+    if (value[0] == '\0') {
+        free(value);
+    } else {
+        *slot = value;
+    }
+    return true;
+}
+
+static bool json_language_member(Json *json, char *name, void *userdata) {
+    Table *table = userdata;
+    if (!add_language(table, name)) return false;
+    LanguageMembers members = {table, table->languageCount - 1};
+    return json_object(json, json_string_member, &members);
+}
+
+static bool parse_json(Table *table, const char *input, size_t length) {
+    Json json = {input, input + length};
+    if (!json_object(&json, json_language_member, table)) return false;
+    if (table->languageCount == 0) {
+        fprintf(stderr, "JSON: no language\n");
+        return false;
+    }
+    return true;
+}
+
+/* ---- Output ---- */
+
+/* Builds the section of a language, storing each distinct string once. */
+static bool build_section(const Table *table, size_t language, Buffer *section) {
+    size_t entriesSize = table->keyCount * PD_TEXT_STRINGS_ENTRY_SIZE;
+    uint8_t *entries = xrealloc(NULL, entriesSize > 0 ? entriesSize : 1);
+    Buffer blob = {0};
+    /* Open addressing on a hash of the strings; slots hold key index + 1 */
+    size_t slotCount = 16;
+    while (slotCount < table->keyCount * 2) {
+        slotCount *= 2;
+    }
+    size_t *slots = calloc(slotCount, sizeof(size_t));
+    uint32_t *offsets = xrealloc(NULL, sizeof(uint32_t) * (table->keyCount > 0 ? table->keyCount : 1));
+    if (slots == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        exit(1);
+    }
+
+    for (size_t i = 0; i < table->keyCount; i++) {
+        const char *value = table->values[i * MAX_LANGUAGES + language];
+        if (value == NULL) {
+            value = table->values[i * MAX_LANGUAGES];
+        }
+        if (value == NULL) {
+            fprintf(stderr, "Warning: \"%s\" has no string in \"%s\"\n", table->keys[i], table->languages[0]);
+            value = "";
+        }
+        size_t length = strlen(value);
+        uint32_t hash = 2166136261u;
+        for (size_t c = 0; c < length; c++) {
+            hash = (hash ^ (uint8_t) value[c]) * 16777619u;
+        }
+        size_t slot = hash & (slotCount - 1);
+        while (slots[slot] != 0 && strcmp(blob.data + offsets[slots[slot] - 1], value) != 0) {
+            slot = (slot + 1) & (slotCount - 1);
+        }
+        if (slots[slot] == 0) {
+            if (blob.length + length + 1 > UINT32_MAX) {
+                fprintf(stderr, "The strings of \"%s\" are too large\n", table->languages[language]);
+                free(entries);
+                free(blob.data);
+                free(slots);
+                free(offsets);
+                return false;
+            }
+            offsets[i] = (uint32_t) blob.length;
+            buffer_append(&blob, value, length + 1);
+            slots[slot] = i + 1;
+        } else {
+            offsets[i] = offsets[slots[slot] - 1];
+        }
+        pdText_PutU32(entries + i * PD_TEXT_STRINGS_ENTRY_SIZE, offsets[i]);
+        pdText_PutU32(entries + i * PD_TEXT_STRINGS_ENTRY_SIZE + 4, (uint32_t) length);
+    }
+    if (blob.length == 0) {
+        /* The reader expects a blob of at least one byte. */
+        buffer_append(&blob, "", 1);
+    }
+
+    buffer_append(section, entries, entriesSize);
+    buffer_append(section, blob.data, blob.length);
+    free(entries);
+    free(blob.data);
+    free(slots);
+    free(offsets);
+    return true;
+}
+
+static bool write_table(const Table *table, const char *path) {
+    Buffer sections[MAX_LANGUAGES] = {0};
+    size_t offset = PD_TEXT_STRINGS_HEADER_SIZE + table->languageCount * PD_TEXT_LANGUAGE_ENTRY_SIZE;
+    uint8_t head[PD_TEXT_STRINGS_HEADER_SIZE + MAX_LANGUAGES * PD_TEXT_LANGUAGE_ENTRY_SIZE] = {0};
+    memcpy(head, PD_TEXT_STRINGS_MAGIC, 4);
+    pdText_PutU16(head + 4, PD_TEXT_STRINGS_VERSION);
+    pdText_PutU16(head + 6, (uint32_t) table->languageCount);
+    pdText_PutU32(head + 8, (uint32_t) table->keyCount);
+    bool built = true;
+    for (size_t i = 0; i < table->languageCount && built; i++) {
+        built = build_section(table, i, &sections[i]);
+        if (built && offset + sections[i].length > UINT32_MAX) {
+            fprintf(stderr, "The string table is too large\n");
+            built = false;
+        }
+        if (built) {
+            uint8_t *entry = head + PD_TEXT_STRINGS_HEADER_SIZE + i * PD_TEXT_LANGUAGE_ENTRY_SIZE;
+            pdText_PutLanguageEntry(entry, table->languages[i], (uint32_t) offset, (uint32_t) sections[i].length);
+            offset += sections[i].length;
+        }
+    }
+
+    FILE *file = built ? fopen(path, "wb") : NULL;
+    bool written = file != NULL;
+    if (file == NULL && built) {
+        perror(path);
+    }
+    if (file != NULL) {
+        size_t headSize = PD_TEXT_STRINGS_HEADER_SIZE + table->languageCount * PD_TEXT_LANGUAGE_ENTRY_SIZE;
+        written = fwrite(head, 1, headSize, file) == headSize;
+        for (size_t i = 0; i < table->languageCount && written; i++) {
+            written = fwrite(sections[i].data, 1, sections[i].length, file) == sections[i].length;
+        }
+        written = fclose(file) == 0 && written;
+        if (!written) {
+            perror(path);
+        }
+    }
+    for (size_t i = 0; i < table->languageCount; i++) {
+        if (written) {
+            printf("%s: %zu bytes\n", table->languages[i], sections[i].length);
+        }
+        free(sections[i].data);
+    }
+    return written;
+}
+
+/* Writes an enum naming the IDs: the prefix, then the key in upper case with other characters turned into '_'. */
+/* The identifier of a key in the header: the prefix, then the key in upper case with other characters as '_'. */
+static char *header_name(const char *prefix, const char *key) {
+    Buffer name = {0};
+    buffer_append(&name, prefix, strlen(prefix));
+    for (const char *c = key; *c != '\0'; c++) {
+        buffer_append_char(&name, isalnum((unsigned char) *c) ? (char) toupper((unsigned char) *c) : '_');
+    }
+    return buffer_take(&name);
+}
+
+static void free_header_names(char **names, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        free(names[i]);
+    }
+    free(names);
+}
+
+static int compare_names(const void *a, const void *b) {
+    return strcmp(**(char **const *) a, **(char **const *) b);
+}
+
+/**
+ * Names the keys in the header, followed by the names of the count and the include guard.
+ * Returns NULL, naming the keys at fault, when a name isn't a C identifier or two names are the same.
+ */
+static char **header_names(const Table *table, const char *prefix) {
+    for (const char *c = prefix; *c != '\0'; c++) {
+        if ((!isalnum((unsigned char) *c) && *c != '_') || (c == prefix && isdigit((unsigned char) *c))) {
+            fprintf(stderr, "The prefix \"%s\" doesn't start a C identifier\n", prefix);
+            return NULL;
+        }
+    }
+    size_t count = table->keyCount + 2;
+    char **names = xrealloc(NULL, sizeof(char *) * count);
+    for (size_t i = 0; i < table->keyCount; i++) {
+        names[i] = header_name(prefix, table->keys[i]);
+    }
+    names[table->keyCount] = header_name(prefix, "COUNT");
+    names[table->keyCount + 1] = header_name(prefix, "IDS_H");
+
+    bool valid = true;
+    for (size_t i = 0; i < table->keyCount && valid; i++) {
+        if (names[i][0] == '\0' || isdigit((unsigned char) names[i][0])) {
+            fprintf(stderr, "Key \"%s\" gives the invalid identifier \"%s\"; use --prefix\n", table->keys[i], names[i]);
+            valid = false;
+        }
+    }
+
+    /* Sorting pointers to the names keeps track of which key each one came from. */
+    char ***sorted = xrealloc(NULL, sizeof(char **) * count);
+    for (size_t i = 0; i < count; i++) {
+        sorted[i] = &names[i];
+    }
+    qsort(sorted, count, sizeof(char **), compare_names);
+    for (size_t i = 1; i < count && valid; i++) {
+        if (strcmp(*sorted[i - 1], *sorted[i]) != 0) continue;
+        size_t first = (size_t) (sorted[i - 1] - names);
+        size_t second = (size_t) (sorted[i] - names);
+        if (first > second) {
+            size_t swap = first;
+            first = second;
+            second = swap;
+        }
+        if (second >= table->keyCount) {
+            fprintf(stderr, "Key \"%s\" gives \"%s\", which the header defines itself; use another --prefix\n",
+                    table->keys[first], names[first]);
+        } else {
+            fprintf(stderr, "Keys \"%s\" and \"%s\" both give \"%s\" in the header\n",
+                    table->keys[first], table->keys[second], names[first]);
+        }
+        valid = false;
+    }
+    free(sorted);
+    if (!valid) {
+        free_header_names(names, count);
+        return NULL;
+    }
+    return names;
+}
+
+static bool write_header(const Table *table, const char *path, char **names) {
+    FILE *file = fopen(path, "w");
+    if (file == NULL) {
+        perror(path);
+        return false;
+    }
+    const char *guard = names[table->keyCount + 1];
+    fprintf(file, "/* Generated by pd_strings_compile; do not edit. */\n\n");
+    fprintf(file, "#ifndef %s\n#define %s\n\nenum {\n", guard, guard);
+    for (size_t i = 0; i < table->keyCount; i++) {
+        fprintf(file, "    %s = %zu,\n", names[i], i);
+    }
+    fprintf(file, "    %s = %zu\n};\n\n#endif\n", names[table->keyCount], table->keyCount);
+    bool written = fclose(file) == 0;
+    if (!written) {
+        perror(path);
+    }
+    return written;
+}
+
+int main(int argc, char **argv) {
+    const char *paths[2] = {NULL, NULL};
+    int pathCount = 0;
+    const char *headerPath = NULL;
+    const char *prefix = "STR_";
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--header") == 0 && i + 1 < argc) {
+            headerPath = argv[++i];
+        } else if (strcmp(argv[i], "--prefix") == 0 && i + 1 < argc) {
+            prefix = argv[++i];
+        } else if (argv[i][0] != '-' && pathCount < 2) {
+            paths[pathCount++] = argv[i];
+        } else {
+            pathCount = 0;
+            break;
+        }
+    }
+    if (pathCount != 2) {
+        fprintf(stderr, "Usage: %s <CSV or JSON file> <string table> [--header FILE] [--prefix PREFIX]\n", argv[0]);
+        return 2;
+    }
+
+    FILE *file = fopen(paths[0], "rb");
+    if (file == NULL) {
+        perror(paths[0]);
+        return 1;
+    }
+    fseek(file, 0, SEEK_END);
+    long length = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    char *input = xrealloc(NULL, length > 0 ? (size_t) length : 1);
+    size_t read = fread(input, 1, (size_t) length, file);
+    fclose(file);
+
+    /* Skip a UTF-8 byte order mark, as spreadsheet applications write one. */
+    const char *text = input;
+    if (read >= 3 && memcmp(text, "\xEF\xBB\xBF", 3) == 0) {
+        text += 3;
+        read -= 3;
+    }
+    size_t first = 0;
+    while (first < read && isspace((unsigned char) text[first])) {
+        first++;
+    }
+
+    Table table;
+    memset(&table, 0, sizeof(Table));
+    bool parsed = first < read && text[first] == '{' ? parse_json(&table, text, read)
+                                                     : parse_csv(&table, text, read);
+    free(input);
+    /* The names are checked before anything is written. */
+    char **names = parsed && headerPath != NULL ? header_names(&table, prefix) : NULL;
+    bool written = parsed && (headerPath == NULL || names != NULL) && write_table(&table, paths[1])
+                   && (headerPath == NULL || write_header(&table, headerPath, names));
+    if (names != NULL) {
+        free_header_names(names, table.keyCount + 2);
+    }
+    if (written) {
+        printf("%zu strings in %zu languages\n", table.keyCount, table.languageCount);
+    }
+
+    for (size_t i = 0; i < table.keyCount; i++) {
+        free(table.keys[i]);
+        for (size_t l = 0; l < MAX_LANGUAGES; l++) {
+            free(table.values[i * MAX_LANGUAGES + l]);
+        }
+    }
+    for (size_t i = 0; i < table.languageCount; i++) {
+        free(table.languages[i]);
+    }
+    free(table.keys);
+    free(table.values);
+    return written ? 0 : 1;
+}
@@ -0,0 +1,617 @@
+/**
+ * @file pd_trace_analyze.c
+ *
+ * @brief Host tool that replays an allocation trace recorded by pd_TraceBegin.
+ *
+ * Usage: pd_trace_analyze <trace file> [--heap-size BYTES] [--top N] [--map-width N] [--map-rows N]
+ *
+ * Reports peak usage, allocation lifetimes (in frames), churn per call site,
+ * and replays the allocations on a simulated first-fit heap to show how fragmented it gets.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pd_trace_format.h"
+
+#define MAX_SITES 65536
+#define LIFETIME_BUCKETS 12
+#define SIM_ALIGNMENT 8
+
+typedef struct SiteTag {
+    char *file;
+    char *func;
+    uint32_t line;
+    uint64_t allocations;
+    uint64_t frees;
+    uint64_t bytesAllocated;
+    uint64_t lifetimeFrames;
+    uint32_t live;
+} Site;
+
+typedef struct RecordTag {
+    uint8_t op;
+    uint16_t site;
+    uint32_t frame;
+    uint32_t size;
+    uint64_t ptr;
+} Record;
+
+typedef struct LiveBlockTag {
+    uint64_t ptr;
+    uint32_t size;
+    uint32_t frame;
+    uint16_t site;
+    /* Offset in the simulated heap, or UINT64_MAX if it didn't fit */
+    uint64_t simOffset;
+} LiveBlock;
+
+/* Open-addressed table of live blocks keyed on the pointer; ptr 0 marks an empty slot. */
+typedef struct LiveTableTag {
+    LiveBlock *slots;
+    size_t capacity;
+    size_t count;
+} LiveTable;
+
+typedef struct SegmentTag {
+    uint64_t offset;
+    uint64_t size;
+} Segment;
+
+/* First-fit heap with a free list sorted by offset. */
+typedef struct SimHeapTag {
+    Segment *free;
+    size_t count;
+    size_t capacity;
+    uint64_t size;
+    uint64_t highWater;
+    uint64_t failures;
+} SimHeap;
+
+typedef struct OptionsTag {
+    const char *path;
+    uint64_t heapSize;
+    uint32_t top;
+    uint32_t mapWidth;
+    uint32_t mapRows;
+} Options;
+
+typedef struct ReplayTag {
+    Site *sites;
+    LiveTable live;
+    SimHeap heap;
+    uint64_t currentBytes;
+    uint64_t peakBytes;
+    uint32_t peakFrame;
+    size_t peakRecord;
+    uint32_t lastFrame;
+    uint64_t records;
+    uint64_t lifetimes[LIFETIME_BUCKETS];
+    double worstFragmentation;
+    uint32_t worstFragmentationFrame;
+} Replay;
+
+static void *xcalloc(size_t count, size_t size) {
+    void *ptr = calloc(count, size);
+    if (ptr == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        exit(1);
+    }
+    return ptr;
+}
+
+static uint16_t get_u16(const uint8_t *in) {
+    return (uint16_t) (in[0] | (in[1] << 8));
+}
+
+static uint32_t get_u32(const uint8_t *in) {
+    return (uint32_t) get_u16(in) | ((uint32_t) get_u16(in + 2) << 16);
+}
+
+static uint64_t get_u64(const uint8_t *in) {
+    return (uint64_t) get_u32(in) | ((uint64_t) get_u32(in + 4) << 32);
+}
+
+static size_t live_hash(uint64_t ptr, size_t mask) {
+    return (size_t) ((ptr >> 3) * 0x9E3779B97F4A7C15ull >> 16) & mask;
+}
+
+static void live_insert(LiveTable *table, const LiveBlock *block);
+
+static void live_grow(LiveTable *table) {
+    LiveTable grown = {xcalloc(table->capacity * 2, sizeof(LiveBlock)), table->capacity * 2, 0};
+    for (size_t i = 0; i < table->capacity; i++) {
+        if (table->slots[i].ptr != 0) {
+            live_insert(&grown, &table->slots[i]);
+        }
+    }
+    free(table->slots);
+    *table = grown;
+}
+
+static void live_insert(LiveTable *table, const LiveBlock *block) {
+    if ((table->count + 1) * 2 > table->capacity) {
+        live_grow(table);
+    }
+    size_t mask = table->capacity - 1;
+    size_t i = live_hash(block->ptr, mask);
+    while (table->slots[i].ptr != 0 && table->slots[i].ptr != block->ptr) {
+        i = (i + 1) & mask;
+    }
+    if (table->slots[i].ptr == 0) {
+        table->count++;
+    }
+    table->slots[i] = *block;
+}
+
+static bool live_remove(LiveTable *table, uint64_t ptr, LiveBlock *out) {
+    size_t mask = table->capacity - 1;
+    size_t i = live_hash(ptr, mask);
+    while (table->slots[i].ptr != ptr) {
+        if (table->slots[i].ptr == 0) return false;
+        i = (i + 1) & mask;
+    }
+    *out = table->slots[i];
+    table->count--;
+    /* Backward-shift deletion keeps probe sequences intact without tombstones. */
+    size_t j = i;
+    for (;;) {
+        j = (j + 1) & mask;
+        if (table->slots[j].ptr == 0) break;
+        size_t home = live_hash(table->slots[j].ptr, mask);
+        bool between = i <= j ? (home > i && home <= j) : (home > i || home <= j);
+        if (between) continue;
+        table->slots[i] = table->slots[j];
+        i = j;
+    }
+    table->slots[i].ptr = 0;
+    return true;
+}
+
+static void heap_init(SimHeap *heap, uint64_t size) {
+    heap->capacity = 64;
+    heap->free = xcalloc(heap->capacity, sizeof(Segment));
+    heap->free[0].offset = 0;
+    heap->free[0].size = size;
+    heap->count = 1;
+    heap->size = size;
+    heap->highWater = 0;
+    heap->failures = 0;
+}
+
+static uint64_t heap_alloc(SimHeap *heap, uint64_t size) {
+    size = (size + SIM_ALIGNMENT - 1) & ~(uint64_t) (SIM_ALIGNMENT - 1);
+    if (size == 0) {
+        size = SIM_ALIGNMENT;
+    }
+    for (size_t i = 0; i < heap->count; i++) {
+        Segment *segment = &heap->free[i];
+        if (segment->size < size) continue;
+        uint64_t offset = segment->offset;
+        segment->offset += size;
+        segment->size -= size;
+        if (segment->size == 0) {
+            memmove(segment, segment + 1, sizeof(Segment) * (heap->count - i - 1));
+            heap->count--;
+        }
+        if (offset + size > heap->highWater) {
+            heap->highWater = offset + size;
+        }
+        return offset;
+    }
+    heap->failures++;
+    return UINT64_MAX;
+}
+
+static void heap_free(SimHeap *heap, uint64_t offset, uint64_t size) {
+    if (offset == UINT64_MAX) return;
+    size = (size + SIM_ALIGNMENT - 1) & ~(uint64_t) (SIM_ALIGNMENT - 1);
+    if (size == 0) {
+        size = SIM_ALIGNMENT;
+    }
+
+    size_t lo = 0;
+    size_t hi = heap->count;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (heap->free[mid].offset < offset) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    bool mergePrev = lo > 0 && heap->free[lo - 1].offset + heap->free[lo - 1].size == offset;
+    bool mergeNext = lo < heap->count && offset + size == heap->free[lo].offset;
+    if (mergePrev && mergeNext) {
+        heap->free[lo - 1].size += size + heap->free[lo].size;
+        memmove(&heap->free[lo], &heap->free[lo + 1], sizeof(Segment) * (heap->count - lo - 1));
+        heap->count--;
+    } else if (mergePrev) {
+        heap->free[lo - 1].size += size;
+    } else if (mergeNext) {
+        heap->free[lo].offset = offset;
+        heap->free[lo].size += size;
+    } else {
+        if (heap->count == heap->capacity) {
+            heap->capacity *= 2;
+            heap->free = realloc(heap->free, sizeof(Segment) * heap->capacity);
+            if (heap->free == NULL) {
+                fprintf(stderr, "Out of memory\n");
+                exit(1);
+            }
+        }
+        memmove(&heap->free[lo + 1], &heap->free[lo], sizeof(Segment) * (heap->count - lo));
+        heap->free[lo].offset = offset;
+        heap->free[lo].size = size;
+        heap->count++;
+    }
+}
+
+/**
+ * @brief 1 - (largest free segment / total free space), only counting space below the high-water mark.
+ */
+static double heap_fragmentation(const SimHeap *heap) {
+    uint64_t total = 0;
+    uint64_t largest = 0;
+    for (size_t i = 0; i < heap->count; i++) {
+        if (heap->free[i].offset >= heap->highWater) break;
+        uint64_t size = heap->free[i].size;
+        if (heap->free[i].offset + size > heap->highWater) {
+            size = heap->highWater - heap->free[i].offset;
+        }
+        total += size;
+        if (size > largest) {
+            largest = size;
+        }
+    }
+    return total == 0 ? 0.0 : 1.0 - (double) largest / (double) total;
+}
+
+static uint32_t lifetime_bucket(uint32_t frames) {
+    uint32_t bucket = 0;
+    while (frames > 0 && bucket < LIFETIME_BUCKETS - 2) {
+        frames >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+static void on_alloc(Replay *replay, uint64_t ptr, uint32_t size, uint32_t frame, uint16_t site) {
+    LiveBlock block = {ptr, size, frame, site, heap_alloc(&replay->heap, size)};
+    live_insert(&replay->live, &block);
+    replay->currentBytes += size;
+    replay->sites[site].allocations++;
+    replay->sites[site].bytesAllocated += size;
+    replay->sites[site].live++;
+}
+
+static bool on_free(Replay *replay, uint64_t ptr, uint32_t frame, bool countAsFree, LiveBlock *freed) {
+    LiveBlock block;
+    if (!live_remove(&replay->live, ptr, &block)) return false;
+    heap_free(&replay->heap, block.simOffset, block.size);
+    replay->currentBytes -= block.size;
+    replay->sites[block.site].live--;
+    if (countAsFree) {
+        uint32_t lifetime = frame - block.frame;
+        replay->sites[block.site].frees++;
+        replay->sites[block.site].lifetimeFrames += lifetime;
+        replay->lifetimes[lifetime_bucket(lifetime)]++;
+    }
+    if (freed != NULL) {
+        *freed = block;
+    }
+    return true;
+}
+
+static char *read_string(const uint8_t **cursor, const uint8_t *end) {
+    if (end - *cursor < 2) return NULL;
+    uint16_t length = get_u16(*cursor);
+    *cursor += 2;
+    if (end - *cursor < length) return NULL;
+    char *str = xcalloc(length + 1u, 1);
+    memcpy(str, *cursor, length);
+    *cursor += length;
+    return str;
+}
+
+/**
+ * @brief Replays the trace, stopping after @c stopAt records (or at the end).
+ *
+ * @returns false if the trace is malformed.
+ */
+static bool replay_trace(Replay *replay, const uint8_t *data, size_t length, uint64_t heapSize, size_t stopAt) {
+    memset(replay, 0, sizeof(*replay));
+    replay->sites = xcalloc(MAX_SITES, sizeof(Site));
+    replay->live.capacity = 1024;
+    replay->live.slots = xcalloc(replay->live.capacity, sizeof(LiveBlock));
+    heap_init(&replay->heap, heapSize);
+
+    const uint8_t *cursor = data + PD_TRACE_HEADER_SIZE;
+    const uint8_t *end = data + length;
+    LiveBlock reallocated = {0};
+    bool hasReallocated = false;
+    while (end - cursor >= PD_TRACE_RECORD_SIZE && replay->records < stopAt) {
+        Record record = {
+            cursor[0], get_u16(cursor + 2), get_u32(cursor + 4), get_u32(cursor + 8), get_u64(cursor + 12)
+        };
+        cursor += PD_TRACE_RECORD_SIZE;
+        replay->records++;
+        replay->lastFrame = record.frame;
+
+        switch (record.op) {
+            case kPDTraceOpSite: {
+                Site *site = &replay->sites[record.site];
+                free(site->file);
+                free(site->func);
+                site->line = record.size;
+                site->file = read_string(&cursor, end);
+                site->func = read_string(&cursor, end);
+                if (site->file == NULL || site->func == NULL) return false;
+                continue;
+            }
+            case kPDTraceOpAlloc:
+                on_alloc(replay, record.ptr, record.size, record.frame, record.site);
+                break;
+            case kPDTraceOpFree:
+                on_free(replay, record.ptr, record.frame, true, NULL);
+                break;
+            case kPDTraceOpReallocFrom:
+                hasReallocated = on_free(replay, record.ptr, record.frame, false, &reallocated);
+                break;
+            case kPDTraceOpReallocTo:
+                if (hasReallocated) {
+                    /* A re-allocated block keeps its original birth frame and call site... */
+                    LiveBlock block = {
+                        record.ptr, record.size, reallocated.frame, reallocated.site,
+                        heap_alloc(&replay->heap, record.size)
+                    };
+                    live_insert(&replay->live, &block);
+                    replay->currentBytes += record.size;
+                    replay->sites[block.site].live++;
+                    /* ...but the bytes count as churn at the site that re-allocated it. */
+                    replay->sites[record.site != 0 ? record.site : block.site].bytesAllocated += record.size;
+                } else {
+                    on_alloc(replay, record.ptr, record.size, record.frame, record.site);
+                }
+                hasReallocated = false;
+                break;
+            default:
+                fprintf(stderr, "Unknown record type %d at offset %zu\n", record.op, (size_t) (cursor - data));
+                return false;
+        }
+
+        if (replay->currentBytes > replay->peakBytes) {
+            replay->peakBytes = replay->currentBytes;
+            replay->peakFrame = record.frame;
+            replay->peakRecord = replay->records;
+        }
+        double fragmentation = heap_fragmentation(&replay->heap);
+        if (fragmentation > replay->worstFragmentation) {
+            replay->worstFragmentation = fragmentation;
+            replay->worstFragmentationFrame = record.frame;
+        }
+    }
+    return true;
+}
+
+static void replay_free(Replay *replay) {
+    for (size_t i = 0; i < MAX_SITES; i++) {
+        free(replay->sites[i].file);
+        free(replay->sites[i].func);
+    }
+    free(replay->sites);
+    free(replay->live.slots);
+    free(replay->heap.free);
+}
+
+static void print_site_name(const Replay *replay, uint16_t id) {
+    const Site *site = &replay->sites[id];
+    if (id == 0 || site->file == NULL) {
+        printf("(unknown call site)");
+    } else {
+        printf("%s:%u (%s)", site->file, site->line, site->func);
+    }
+}
+
+/* qsort has no context argument, so the replay being sorted is passed through here. */
+static const Replay *s_sort_replay;
+
+static int compare_sites(const void *a, const void *b) {
+    uint64_t left = s_sort_replay->sites[*(const uint16_t *) a].allocations;
+    uint64_t right = s_sort_replay->sites[*(const uint16_t *) b].allocations;
+    return left < right ? 1 : (left > right ? -1 : 0);
+}
+
+static void print_summary(const Replay *replay) {
+    printf("== Summary ==\n");
+    printf("Records:              %llu\n", (unsigned long long) replay->records);
+    printf("Frames:               %u\n", replay->lastFrame + 1);
+    printf("Peak usage:           %llu bytes (frame %u)\n", (unsigned long long) replay->peakBytes, replay->peakFrame);
+    printf("Still allocated:      %llu bytes in %zu blocks\n",
+           (unsigned long long) replay->currentBytes, replay->live.count);
+    printf("\n");
+}
+
+static void print_lifetimes(const Replay *replay) {
+    printf("== Lifetimes (frames between allocation and free) ==\n");
+    uint64_t total = 0;
+    for (int i = 0; i < LIFETIME_BUCKETS - 1; i++) {
+        total += replay->lifetimes[i];
+    }
+    for (int i = 0; i < LIFETIME_BUCKETS - 1; i++) {
+        char label[32];
+        if (i == 0) {
+            snprintf(label, sizeof(label), "same frame");
+        } else if (i == LIFETIME_BUCKETS - 2) {
+            snprintf(label, sizeof(label), ">= %u", 1u << (i - 1));
+        } else if (i == 1) {
+            snprintf(label, sizeof(label), "1");
+        } else {
+            snprintf(label, sizeof(label), "%u-%u", 1u << (i - 1), (1u << i) - 1);
+        }
+        double ratio = total == 0 ? 0.0 : (double) replay->lifetimes[i] / (double) total;
+        printf("%-12s %10llu  %5.1f%%  ", label, (unsigned long long) replay->lifetimes[i], ratio * 100.0);
+        for (int bar = 0; bar < (int) (ratio * 40.0 + 0.5); bar++) {
+            putchar('#');
+        }
+        putchar('\n');
+    }
+    printf("%-12s %10zu\n\n", "never freed", replay->live.count);
+}
+
+static void print_sites(const Replay *replay, uint32_t top) {
+    uint16_t *ids = xcalloc(MAX_SITES, sizeof(uint16_t));
+    size_t count = 0;
+    for (size_t i = 0; i < MAX_SITES; i++) {
+        if (replay->sites[i].allocations > 0) {
+            ids[count++] = (uint16_t) i;
+        }
+    }
+    s_sort_replay = replay;
+    qsort(ids, count, sizeof(uint16_t), compare_sites);
+
+    printf("== Churn per call site (top %u by allocation count) ==\n", top);
+    printf("%10s %10s %14s %12s %6s  %s\n", "allocs", "frees", "bytes", "avg life", "live", "call site");
+    for (size_t i = 0; i < count && i < top; i++) {
+        const Site *site = &replay->sites[ids[i]];
+        double averageLife = site->frees == 0 ? 0.0 : (double) site->lifetimeFrames / (double) site->frees;
+        printf(
+            "%10llu %10llu %14llu %12.1f %6u  ",
+            (unsigned long long) site->allocations,
+            (unsigned long long) site->frees,
+            (unsigned long long) site->bytesAllocated,
+            averageLife,
+            site->live
+        );
+        print_site_name(replay, ids[i]);
+        putchar('\n');
+    }
+    putchar('\n');
+    free(ids);
+}
+
+static void print_map(const Replay *replay, const char *title, const Options *options) {
+    const SimHeap *heap = &replay->heap;
+    size_t cells = (size_t) options->mapWidth * options->mapRows;
+    uint64_t span = heap->highWater == 0 ? 1 : heap->highWater;
+    uint64_t cellSize = (span + cells - 1) / cells;
+    if (cellSize == 0) {
+        cellSize = 1;
+    }
+    uint64_t *used = xcalloc(cells, sizeof(uint64_t));
+
+    for (size_t i = 0; i < replay->live.capacity; i++) {
+        const LiveBlock *block = &replay->live.slots[i];
+        if (block->ptr == 0 || block->simOffset == UINT64_MAX) continue;
+        uint64_t start = block->simOffset;
+        uint64_t stop = start + ((block->size + SIM_ALIGNMENT - 1) & ~(uint64_t) (SIM_ALIGNMENT - 1));
+        while (start < stop) {
+            size_t cell = (size_t) (start / cellSize);
+            uint64_t cellEnd = (cell + 1) * cellSize;
+            uint64_t chunk = (stop < cellEnd ? stop : cellEnd) - start;
+            if (cell < cells) {
+                used[cell] += chunk;
+            }
+            start += chunk;
+        }
+    }
+
+    printf("== Simulated heap %s ==\n", title);
+    printf("First-fit, %u-byte alignment, %llu-byte heap. High-water mark: %llu bytes, ",
+           SIM_ALIGNMENT, (unsigned long long) heap->size, (unsigned long long) heap->highWater);
+    printf("fragmentation: %.1f%%, failed allocations: %llu\n",
+           heap_fragmentation(heap) * 100.0, (unsigned long long) heap->failures);
+    printf("Each cell is %llu bytes ('#' full, '+' partially used, '.' free)\n", (unsigned long long) cellSize);
+    for (uint32_t row = 0; row < options->mapRows; row++) {
+        for (uint32_t column = 0; column < options->mapWidth; column++) {
+            uint64_t value = used[row * options->mapWidth + column];
+            putchar(value == 0 ? '.' : (value >= cellSize ? '#' : '+'));
+        }
+        putchar('\n');
+    }
+    putchar('\n');
+    free(used);
+}
+
+static bool parse_options(int argc, char **argv, Options *options) {
+    options->path = NULL;
+    options->heapSize = 16u * 1024u * 1024u;
+    options->top = 20;
+    options->mapWidth = 64;
+    options->mapRows = 16;
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--heap-size") == 0 && hasValue) {
+            options->heapSize = strtoull(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--top") == 0 && hasValue) {
+            options->top = (uint32_t) strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--map-width") == 0 && hasValue) {
+            options->mapWidth = (uint32_t) strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--map-rows") == 0 && hasValue) {
+            options->mapRows = (uint32_t) strtoul(argv[++i], NULL, 0);
+        } else if (argv[i][0] != '-' && options->path == NULL) {
+            options->path = argv[i];
+        } else {
+            return false;
+        }
+    }
+    return options->path != NULL && options->heapSize > 0 && options->mapWidth > 0 && options->mapRows > 0;
+}
+
+int main(int argc, char **argv) {
+    Options options;
+    if (!parse_options(argc, argv, &options)) {
+        fprintf(
+            stderr,
+            "Usage: %s <trace file> [--heap-size BYTES] [--top N] [--map-width N] [--map-rows N]\n",
+            argv[0]
+        );
+        return 2;
+    }
+
+    FILE *file = fopen(options.path, "rb");
+    if (file == NULL) {
+        perror(options.path);
+        return 1;
+    }
+    fseek(file, 0, SEEK_END);
+    long length = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    uint8_t *data = xcalloc(length > 0 ? (size_t) length : 1, 1);
+    size_t read = fread(data, 1, (size_t) length, file);
+    fclose(file);
+
+    if (read < PD_TRACE_HEADER_SIZE || memcmp(data, PD_TRACE_MAGIC, 4) != 0) {
+        fprintf(stderr, "%s is not an allocation trace\n", options.path);
+        return 1;
+    }
+    if (get_u16(data + 4) != PD_TRACE_VERSION || get_u16(data + 6) != PD_TRACE_RECORD_SIZE) {
+        fprintf(stderr, "Unsupported trace version %u\n", get_u16(data + 4));
+        return 1;
+    }
+
+    Replay replay;
+    if (!replay_trace(&replay, data, read, options.heapSize, SIZE_MAX)) {
+        fprintf(stderr, "The trace is malformed (truncated?); the report covers what could be read.\n");
+    }
+    print_summary(&replay);
+    print_lifetimes(&replay);
+    print_sites(&replay, options.top);
+    printf("Worst simulated fragmentation: %.1f%% (frame %u)\n\n",
+           replay.worstFragmentation * 100.0, replay.worstFragmentationFrame);
+    print_map(&replay, "at the end of the trace", &options);
+    size_t peakRecord = replay.peakRecord;
+    replay_free(&replay);
+
+    /* Replay again up to the peak to show the heap at its fullest. */
+    replay_trace(&replay, data, read, options.heapSize, peakRecord);
+    print_map(&replay, "at peak usage", &options);
+    replay_free(&replay);
+
+    free(data);
+    return 0;
+}